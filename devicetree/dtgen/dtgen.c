@@ -0,0 +1,858 @@
+/**
+ * @file dtgen.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Device tree blob -> C header with board pins, registers and interrupts.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details Usage: dtgen [-g gpio_irq_base] [-s gpio_sysfs_base] [-p prefix] [-o header] board.dtb
+ *          Compile the dts with symbols first (dtc -@ -I dts -O dtb), labels then name the macros.
+ *          For every enabled node that has a label, GPIO properties (xxx-gpio(s)) or interrupts
+ *          on a GPIO controller, emits:
+ *              <PREFIX><NAME>_BASE/_SIZE       reg, translated through the parent ranges
+ *              <PREFIX><NAME>_IRQ[n]           GIC: SPI n -> 32 + n, PPI n -> 16 + n
+ *                                              GPIO controller: gpio_irq_base + pin
+ *              <PREFIX><NAME>[_<STEM>]_GPIO[n] pin, _FLAGS, _ACTIVE_LOW, _NUM/_STR (gpio_sysfs_base
+ *                                              + pin), and on the Zynq controller _BANK, _BIT, _MASK
+ *          Linux 3.8 (linux-xlnx-xilinx-v14.5) maps GIC interrupts 1:1 and allocates the GPIO
+ *          interrupts after the 256 GIC ones, hence -g 256 (default); the kernel GPIO base is 0.
+ *          The header is plain #defines: no parsing at run time, and bank/mask expressions such
+ *          as ZYNQ_GPIO_DATA(BOARD_LED_GPIO_BANK) are folded by the compiler.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <strings.h>
+
+#define FDT_MAGIC           0xd00dfeed
+#define FDT_BEGIN_NODE      1
+#define FDT_END_NODE        2
+#define FDT_PROP            3
+#define FDT_NOP             4
+#define FDT_END             9
+
+#define DT_NAME_MAX         64
+#define DT_PATH_MAX         512
+
+struct dt_prop {
+    const char *name;
+    const uint8_t *data;
+    uint32_t len;
+    struct dt_prop *next;
+};
+
+struct dt_node {
+    char name[DT_NAME_MAX];         /* With unit address */
+    char path[DT_PATH_MAX];
+    const char *label;              /* From __symbols__, NULL: none */
+    uint32_t phandle;
+    struct dt_prop *props;
+    struct dt_node *parent;
+    struct dt_node *child;
+    struct dt_node *next;           /* Next sibling */
+};
+
+struct dtgen {
+    uint8_t *blob;
+    size_t size;
+    struct dt_node *root;
+    unsigned int gpio_irq_base;
+    unsigned int gpio_sysfs_base;
+    const char *prefix;
+    FILE *out;
+    char block[DT_PATH_MAX * 2];    /* Node comment, printed before its first macro */
+};
+
+static uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void *dt_zalloc(size_t size)
+{
+    void *p = calloc(1, size);
+
+    if (!p)
+    {
+        fprintf(stderr, "Error: out of memory!\n");
+        exit(1);
+    }
+
+    return p;
+}
+
+/*
+ * Blob parsing.
+ */
+
+static int dt_parse(struct dtgen *g)
+{
+    const uint8_t *b = g->blob;
+    struct dt_node *cur = NULL;
+    struct dt_node *node = NULL;
+    struct dt_node **link = NULL;
+    struct dt_prop *prop = NULL;
+    uint32_t off_struct = 0;
+    uint32_t off_strings = 0;
+    uint32_t size_struct = 0;
+    uint32_t off = 0;
+    uint32_t end = 0;
+    uint32_t token = 0;
+    uint32_t len = 0;
+    size_t name_len = 0;
+
+    if (g->size < 40 || be32(b) != FDT_MAGIC || be32(b + 4) > g->size || be32(b + 20) < 16)
+    {
+        fprintf(stderr, "Error: not a device tree blob (version >= 16)!\n");
+        return -1;
+    }
+
+    off_struct = be32(b + 8);
+    off_strings = be32(b + 12);
+    size_struct = be32(b + 36);
+    end = off_struct + size_struct;
+    if (end > g->size || off_strings > g->size)
+    {
+        fprintf(stderr, "Error: truncated device tree blob!\n");
+        return -1;
+    }
+
+    off = off_struct;
+    while (off + 4 <= end)
+    {
+        token = be32(b + off);
+        off += 4;
+
+        switch (token)
+        {
+        case FDT_BEGIN_NODE:
+            name_len = strnlen((const char *)b + off, end - off);
+            node = dt_zalloc(sizeof(*node));
+            snprintf(node->name, sizeof(node->name), "%s", (const char *)b + off);
+            node->parent = cur;
+            if (!cur)
+            {
+                g->root = node;
+                snprintf(node->path, sizeof(node->path), "/");
+            }
+            else
+            {
+                if (snprintf(node->path, sizeof(node->path), "%s/%s", cur->parent ? cur->path : "",
+                             node->name) >= (int)sizeof(node->path))
+                {
+                    fprintf(stderr, "Error: node path too long <%s>!\n", node->name);
+                    return -1;
+                }
+                for (link = &cur->child; *link; link = &(*link)->next)
+                {
+                    ;
+                }
+                *link = node;
+            }
+            cur = node;
+            off += (name_len + 1 + 3) & ~3U;
+            break;
+        case FDT_END_NODE:
+            if (!cur)
+            {
+                fprintf(stderr, "Error: unbalanced nodes in device tree blob!\n");
+                return -1;
+            }
+            cur = cur->parent;
+            break;
+        case FDT_PROP:
+            if (!cur || off + 8 > end)
+            {
+                fprintf(stderr, "Error: bad property in device tree blob!\n");
+                return -1;
+            }
+            len = be32(b + off);
+            prop = dt_zalloc(sizeof(*prop));
+            prop->name = (const char *)b + off_strings + be32(b + off + 4);
+            prop->data = b + off + 8;
+            prop->len = len;
+            prop->next = cur->props;
+            cur->props = prop;
+            if ((!strcmp(prop->name, "phandle") || !strcmp(prop->name, "linux,phandle")) && len == 4)
+            {
+                cur->phandle = be32(prop->data);
+            }
+            off += 8 + ((len + 3) & ~3U);
+            break;
+        case FDT_NOP:
+            break;
+        case FDT_END:
+            return g->root ? 0 : -1;
+        default:
+            fprintf(stderr, "Error: bad token 0x%x in device tree blob!\n", token);
+            return -1;
+        }
+    }
+
+    fprintf(stderr, "Error: device tree blob without FDT_END!\n");
+    return -1;
+}
+
+static struct dt_prop *dt_prop(const struct dt_node *node, const char *name)
+{
+    struct dt_prop *prop = NULL;
+
+    for (prop = node->props; prop; prop = prop->next)
+    {
+        if (!strcmp(prop->name, name))
+        {
+            return prop;
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t dt_u32(const struct dt_node *node, const char *name, uint32_t def)
+{
+    struct dt_prop *prop = dt_prop(node, name);
+
+    return (prop && prop->len >= 4) ? be32(prop->data) : def;
+}
+
+static const char *dt_string(const struct dt_node *node, const char *name)
+{
+    struct dt_prop *prop = dt_prop(node, name);
+
+    return (prop && prop->len && !prop->data[prop->len - 1]) ? (const char *)prop->data : NULL;
+}
+
+static struct dt_node *dt_walk_next(struct dt_node *node)
+{
+    if (node->child)
+    {
+        return node->child;
+    }
+    while (node)
+    {
+        if (node->next)
+        {
+            return node->next;
+        }
+        node = node->parent;
+    }
+
+    return NULL;
+}
+
+static struct dt_node *dt_find_phandle(struct dtgen *g, uint32_t phandle)
+{
+    struct dt_node *node = NULL;
+
+    for (node = g->root; node && phandle; node = dt_walk_next(node))
+    {
+        if (node->phandle == phandle)
+        {
+            return node;
+        }
+    }
+
+    return NULL;
+}
+
+static struct dt_node *dt_find_path(struct dtgen *g, const char *path)
+{
+    struct dt_node *node = NULL;
+
+    for (node = g->root; node; node = dt_walk_next(node))
+    {
+        if (!strcmp(node->path, path))
+        {
+            return node;
+        }
+    }
+
+    return NULL;
+}
+
+/* Labels come from __symbols__ (dtc -@): "label = path". */
+static void dt_labels(struct dtgen *g)
+{
+    struct dt_node *symbols = NULL;
+    struct dt_node *node = NULL;
+    struct dt_prop *prop = NULL;
+
+    for (symbols = g->root->child; symbols; symbols = symbols->next)
+    {
+        if (!strcmp(symbols->name, "__symbols__"))
+        {
+            break;
+        }
+    }
+    if (!symbols)
+    {
+        fprintf(stderr, "Warning: no __symbols__ (compile with dtc -@), using node names.\n");
+        return;
+    }
+
+    /* Properties are linked newest first: the last one written wins, i.e. the first label. */
+    for (prop = symbols->props; prop; prop = prop->next)
+    {
+        if (!prop->len || prop->data[prop->len - 1])
+        {
+            continue;
+        }
+        node = dt_find_path(g, (const char *)prop->data);
+        if (node)
+        {
+            node->label = prop->name;
+        }
+    }
+}
+
+static int dt_enabled(const struct dt_node *node)
+{
+    const char *status = dt_string(node, "status");
+
+    return !status || !strcmp(status, "okay") || !strcmp(status, "ok");
+}
+
+static int dt_compatible(const struct dt_node *node, const char *sub)
+{
+    struct dt_prop *prop = dt_prop(node, "compatible");
+    uint32_t off = 0;
+
+    while (prop && off < prop->len)
+    {
+        if (strstr((const char *)prop->data + off, sub))
+        {
+            return 1;
+        }
+        off += strlen((const char *)prop->data + off) + 1;
+    }
+
+    return 0;
+}
+
+static uint64_t dt_read_cells(const uint8_t *p, uint32_t cells)
+{
+    uint64_t v = 0;
+
+    while (cells--)
+    {
+        v = (v << 32) | be32(p);
+        p += 4;
+    }
+
+    return v;
+}
+
+/*
+ * Child bus address -> CPU address through the ranges of every ancestor bus.
+ * Returns -1 when a bus has no ranges (e.g. reg of clocks or I2C devices).
+ */
+static int dt_translate(const struct dt_node *node, uint64_t *addr)
+{
+    const struct dt_node *bus = node->parent;
+    struct dt_prop *ranges = NULL;
+    uint32_t ac = 0;
+    uint32_t pac = 0;
+    uint32_t sc = 0;
+    uint32_t entry = 0;
+    uint32_t off = 0;
+    uint64_t child = 0;
+    uint64_t parent = 0;
+    uint64_t size = 0;
+    int found = 0;
+
+    for (; bus && bus->parent; bus = bus->parent)
+    {
+        ranges = dt_prop(bus, "ranges");
+        if (!ranges)
+        {
+            return -1;
+        }
+        if (!ranges->len)
+        {
+            continue;
+        }
+
+        ac = dt_u32(bus, "#address-cells", 2);
+        sc = dt_u32(bus, "#size-cells", 1);
+        pac = dt_u32(bus->parent, "#address-cells", 2);
+        entry = (ac + pac + sc) * 4;
+        found = 0;
+        for (off = 0; entry && off + entry <= ranges->len; off += entry)
+        {
+            child = dt_read_cells(ranges->data + off, ac);
+            parent = dt_read_cells(ranges->data + off + ac * 4, pac);
+            size = dt_read_cells(ranges->data + off + (ac + pac) * 4, sc);
+            if (*addr >= child && *addr - child < size)
+            {
+                *addr = *addr - child + parent;
+                found = 1;
+                break;
+            }
+        }
+        if (!found)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static struct dt_node *dt_irq_parent(struct dtgen *g, const struct dt_node *node)
+{
+    for (; node; node = node->parent)
+    {
+        if (dt_prop(node, "interrupt-parent"))
+        {
+            return dt_find_phandle(g, dt_u32(node, "interrupt-parent", 0));
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Header output.
+ */
+
+/* Label, or node name without unit address, as a macro name part. */
+static void dt_macro_name(const char *in, size_t len, char *out, size_t size)
+{
+    size_t i = 0;
+
+    for (i = 0; i < len && in[i] && i + 1 < size; i++)
+    {
+        out[i] = isalnum((unsigned char)in[i]) ? toupper((unsigned char)in[i]) : '_';
+    }
+    out[i] = '\0';
+}
+
+static void dt_node_macro(const struct dt_node *node, char *out, size_t size)
+{
+    const char *name = node->label ? node->label : node->name;
+
+    dt_macro_name(name, node->label ? strlen(name) : strcspn(name, "@"), out, size);
+}
+
+static void dt_index(char *buf, size_t size, const char *base, unsigned int i)
+{
+    if (i)
+    {
+        snprintf(buf, size, "%s%u", base, i);
+    }
+    else
+    {
+        snprintf(buf, size, "%s", base);
+    }
+}
+
+static void emit(struct dtgen *g, const char *name, const char *suffix, const char *value, const char *comment)
+{
+    char macro[160];
+
+    if (g->block[0])
+    {
+        fprintf(g->out, "\n/* %s */\n", g->block);
+        g->block[0] = '\0';
+    }
+
+    snprintf(macro, sizeof(macro), "%s%s%s", g->prefix, name, suffix);
+    if (comment && *comment)
+    {
+        fprintf(g->out, "#define %-40s %-12s /* %s */\n", macro, value, comment);
+    }
+    else
+    {
+        fprintf(g->out, "#define %-40s %s\n", macro, value);
+    }
+}
+
+static int dt_is_gpio_prop(const char *name)
+{
+    size_t len = strlen(name);
+
+    if (!strcmp(name, "gpio") || !strcmp(name, "gpios"))
+    {
+        return 1;
+    }
+
+    return (len > 5 && !strcmp(name + len - 5, "-gpio")) || (len > 6 && !strcmp(name + len - 6, "-gpios"));
+}
+
+static int dt_has_gpio_props(const struct dt_node *node)
+{
+    struct dt_prop *prop = NULL;
+
+    for (prop = node->props; prop; prop = prop->next)
+    {
+        if (dt_is_gpio_prop(prop->name))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void dt_emit_reg(struct dtgen *g, const struct dt_node *node, const char *name)
+{
+    struct dt_prop *reg = dt_prop(node, "reg");
+    uint32_t ac = node->parent ? dt_u32(node->parent, "#address-cells", 2) : 2;
+    uint32_t sc = node->parent ? dt_u32(node->parent, "#size-cells", 1) : 1;
+    uint64_t addr = 0;
+    uint64_t size = 0;
+    char value[32];
+
+    if (!reg || !ac || !sc || reg->len < (ac + sc) * 4)
+    {
+        return;
+    }
+
+    addr = dt_read_cells(reg->data, ac);
+    size = dt_read_cells(reg->data + ac * 4, sc);
+    if (dt_translate(node, &addr))
+    {
+        return;
+    }
+
+    snprintf(value, sizeof(value), "0x%08llx", (unsigned long long)addr);
+    emit(g, name, "_BASE", value, NULL);
+    snprintf(value, sizeof(value), "0x%llx", (unsigned long long)size);
+    emit(g, name, "_SIZE", value, NULL);
+}
+
+static const char *dt_irq_type_name(uint32_t type)
+{
+    switch (type & 0xf)
+    {
+    case 1:
+        return "IRQ_TYPE_EDGE_RISING";
+    case 2:
+        return "IRQ_TYPE_EDGE_FALLING";
+    case 3:
+        return "IRQ_TYPE_EDGE_BOTH";
+    case 4:
+        return "IRQ_TYPE_LEVEL_HIGH";
+    case 8:
+        return "IRQ_TYPE_LEVEL_LOW";
+    default:
+        return "IRQ_TYPE_NONE";
+    }
+}
+
+/* Returns 1 if anything was emitted. */
+static int dt_emit_irqs(struct dtgen *g, const struct dt_node *node, const char *name, int gpio_only)
+{
+    struct dt_prop *irqs = dt_prop(node, "interrupts");
+    struct dt_node *parent = dt_irq_parent(g, node);
+    char parent_name[DT_NAME_MAX];
+    char suffix[16];
+    char value[32];
+    char comment[96];
+    uint32_t cells = 0;
+    uint32_t i = 0;
+    uint32_t n = 0;
+    uint32_t irq = 0;
+    int gpio = 0;
+
+    if (!irqs || !parent)
+    {
+        return 0;
+    }
+
+    cells = dt_u32(parent, "#interrupt-cells", 0);
+    gpio = dt_prop(parent, "gpio-controller") != NULL;
+    if (!cells || (gpio_only && !gpio))
+    {
+        return 0;
+    }
+
+    snprintf(parent_name, sizeof(parent_name), "%s", parent->label ? parent->label : parent->name);
+    n = irqs->len / (cells * 4);
+    for (i = 0; i < n; i++)
+    {
+        const uint8_t *p = irqs->data + i * cells * 4;
+
+        if (gpio && cells >= 2)
+        {
+            irq = g->gpio_irq_base + be32(p);
+            snprintf(comment, sizeof(comment), "%s pin %u, %s", parent_name, be32(p), dt_irq_type_name(be32(p + 4)));
+        }
+        else if (dt_compatible(parent, "gic") && cells == 3)
+        {
+            irq = be32(p + 4) + (be32(p) ? 16 : 32);
+            snprintf(comment, sizeof(comment), "GIC %s %u, %s", be32(p) ? "PPI" : "SPI", be32(p + 4),
+                     dt_irq_type_name(be32(p + 8)));
+        }
+        else
+        {
+            irq = be32(p);
+            snprintf(comment, sizeof(comment), "%s hwirq", parent_name);
+        }
+
+        dt_index(suffix, sizeof(suffix), "_IRQ", i);
+        snprintf(value, sizeof(value), "%u", irq);
+        emit(g, name, suffix, value, comment);
+        if (gpio && cells >= 2)
+        {
+            strcat(suffix, "_TYPE");
+            snprintf(value, sizeof(value), "%u", be32(p + 4));
+            emit(g, name, suffix, value, NULL);
+        }
+    }
+
+    return n != 0;
+}
+
+static void dt_emit_gpio(struct dtgen *g, const struct dt_node *node, const char *name, const struct dt_prop *prop)
+{
+    struct dt_node *chip = NULL;
+    char base[DT_NAME_MAX * 3];
+    char chip_name[DT_NAME_MAX];
+    char stem[DT_NAME_MAX];
+    char macro[DT_NAME_MAX * 3 + 16];
+    char value[32];
+    char comment[DT_NAME_MAX + 32];
+    uint32_t off = 0;
+    uint32_t cells = 0;
+    uint32_t pin = 0;
+    uint32_t flags = 0;
+    unsigned int bank = 0;
+    unsigned int bit = 0;
+    unsigned int i = 0;
+    size_t len = strcspn(prop->name, "-");
+
+    /* "key-gpio" on node "key" -> KEY_GPIO, "reset-gpios" on "phy" -> PHY_RESET_GPIO */
+    dt_macro_name(prop->name, len, stem, sizeof(stem));
+    if (!strcmp(prop->name, "gpio") || !strcmp(prop->name, "gpios") || !strcasecmp(stem, name))
+    {
+        snprintf(base, sizeof(base), "%s_GPIO", name);
+    }
+    else
+    {
+        snprintf(base, sizeof(base), "%s_%s_GPIO", name, stem);
+    }
+
+    for (off = 0, i = 0; off + 4 <= prop->len; i++)
+    {
+        chip = dt_find_phandle(g, be32(prop->data + off));
+        cells = chip ? dt_u32(chip, "#gpio-cells", 2) : 0;
+        if (!chip || !cells || off + 4 + cells * 4 > prop->len)
+        {
+            fprintf(stderr, "Warning: %s: bad %s entry %u, skipped.\n", node->path, prop->name, i);
+            return;
+        }
+
+        pin = be32(prop->data + off + 4);
+        flags = cells >= 2 ? be32(prop->data + off + 8) : 0;
+        off += 4 + cells * 4;
+
+        snprintf(chip_name, sizeof(chip_name), "%s", chip->label ? chip->label : chip->name);
+        dt_index(macro, sizeof(macro), base, i);
+        snprintf(value, sizeof(value), "%u", pin);
+        if (dt_compatible(chip, "ps7-gpio") || dt_compatible(chip, "zynq-gpio"))
+        {
+            snprintf(comment, sizeof(comment), "%s %s%u", chip_name, pin < 54 ? "MIO" : "EMIO",
+                     pin < 54 ? pin : pin - 54);
+        }
+        else
+        {
+            snprintf(comment, sizeof(comment), "%s", chip_name);
+        }
+        emit(g, macro, "", value, comment);
+
+        snprintf(value, sizeof(value), "%u", flags);
+        emit(g, macro, "_FLAGS", value, NULL);
+        emit(g, macro, "_ACTIVE_LOW", (flags & 1) ? "1" : "0", NULL);
+        snprintf(value, sizeof(value), "%u", g->gpio_sysfs_base + pin);
+        emit(g, macro, "_NUM", value, "sysfs/legacy GPIO number");
+        snprintf(value, sizeof(value), "\"%u\"", g->gpio_sysfs_base + pin);
+        emit(g, macro, "_STR", value, NULL);
+
+        /* Zynq: bank 0 MIO[31:0], bank 1 MIO[53:32], bank 2/3 EMIO[31:0]/[63:32] (zynq_gpio.h) */
+        if (dt_compatible(chip, "ps7-gpio") || dt_compatible(chip, "zynq-gpio"))
+        {
+            bank = pin < 32 ? 0 : pin < 54 ? 1 : pin < 86 ? 2 : 3;
+            bit = pin - (bank == 0 ? 0 : bank == 1 ? 32 : bank == 2 ? 54 : 86);
+            snprintf(value, sizeof(value), "%u", bank);
+            emit(g, macro, "_BANK", value, NULL);
+            snprintf(value, sizeof(value), "%u", bit);
+            emit(g, macro, "_BIT", value, NULL);
+            snprintf(value, sizeof(value), "0x%08xU", 1U << bit);
+            emit(g, macro, "_MASK", value, NULL);
+        }
+    }
+}
+
+static void dt_emit(struct dtgen *g, const char *src, const char *file, const char *guard)
+{
+    struct dt_node *node = NULL;
+    struct dt_node *irq_parent = NULL;
+    struct dt_prop *prop = NULL;
+    struct dt_prop *props[32];
+    const char *compatible = NULL;
+    char name[DT_NAME_MAX];
+    unsigned int nr = 0;
+    int gpio_user = 0;
+
+    fprintf(g->out,
+            "/**\n"
+            " * @file %s\n"
+            " * @brief Board pins, registers and interrupts from %s.\n"
+            " * @details Generated by devicetree/dtgen (-g %u -s %u), do not edit.\n"
+            " */\n\n"
+            "#ifndef %s\n"
+            "#define %s\n",
+            file, src, g->gpio_irq_base, g->gpio_sysfs_base, guard, guard);
+
+    for (node = g->root->child; node; node = dt_walk_next(node))
+    {
+        if (!strncmp(node->path, "/__", 3) || !dt_enabled(node))
+        {
+            continue;
+        }
+
+        irq_parent = dt_irq_parent(g, node);
+        gpio_user = dt_has_gpio_props(node) ||
+                    (dt_prop(node, "interrupts") && irq_parent && dt_prop(irq_parent, "gpio-controller"));
+        if (!node->label && !gpio_user)
+        {
+            continue;
+        }
+
+        compatible = dt_string(node, "compatible");
+        dt_node_macro(node, name, sizeof(name));
+        snprintf(g->block, sizeof(g->block), "%s%s%s%s%s", node->label ? node->label : "",
+                 node->label ? ": " : "", node->path, compatible ? ", " : "", compatible ? compatible : "");
+
+        dt_emit_reg(g, node, name);
+        dt_emit_irqs(g, node, name, 0);
+
+        /* Properties are linked newest first, emit them in source order. */
+        for (prop = node->props, nr = 0; prop && nr < sizeof(props) / sizeof(props[0]); prop = prop->next)
+        {
+            if (dt_is_gpio_prop(prop->name))
+            {
+                props[nr++] = prop;
+            }
+        }
+        while (nr--)
+        {
+            dt_emit_gpio(g, node, name, props[nr]);
+        }
+    }
+
+    fprintf(g->out, "\n#endif /* %s */\n", guard);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-g gpio_irq_base] [-s gpio_sysfs_base] [-p prefix] [-o header] board.dtb\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    struct dtgen g;
+    const char *out_path = NULL;
+    const char *base = NULL;
+    const char *file = NULL;
+    char guard[128];
+    FILE *fp = NULL;
+    long size = 0;
+    int opt = 0;
+    int ret = 1;
+
+    memset(&g, 0, sizeof(g));
+    g.gpio_irq_base = 256;
+    g.prefix = "BOARD_";
+    g.out = stdout;
+
+    while ((opt = getopt(argc, argv, "g:s:p:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'g':
+            g.gpio_irq_base = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            g.gpio_sysfs_base = strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            g.prefix = optarg;
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind + 1 != argc)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    fp = fopen(argv[optind], "rb");
+    if (!fp || fseek(fp, 0, SEEK_END) || (size = ftell(fp)) <= 0 || fseek(fp, 0, SEEK_SET))
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", argv[optind], errno);
+        goto out;
+    }
+
+    g.size = size;
+    g.blob = dt_zalloc(g.size);
+    if (fread(g.blob, 1, g.size, fp) != g.size)
+    {
+        fprintf(stderr, "Error: failed to read file <%s>!\n", argv[optind]);
+        goto out;
+    }
+
+    if (dt_parse(&g))
+    {
+        goto out;
+    }
+    dt_labels(&g);
+
+    /* zynq_board.h -> __ZYNQ_BOARD_H__ */
+    base = out_path ? strrchr(out_path, '/') : NULL;
+    file = base ? base + 1 : (out_path ? out_path : "board.h");
+    snprintf(guard, sizeof(guard), "__");
+    dt_macro_name(file, strlen(file), guard + 2, sizeof(guard) - 4);
+    strcat(guard, "__");
+
+    if (out_path)
+    {
+        g.out = fopen(out_path, "w");
+        if (!g.out)
+        {
+            fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", out_path, errno);
+            goto out;
+        }
+    }
+
+    base = strrchr(argv[optind], '/');
+    dt_emit(&g, base ? base + 1 : argv[optind], file, guard);
+    ret = 0;
+
+out:
+    if (g.out && g.out != stdout)
+    {
+        fclose(g.out);
+    }
+    if (fp)
+    {
+        fclose(fp);
+    }
+    free(g.blob);
+
+    return ret;
+}
@@ -5,6 +5,11 @@
  * @version 0.1
  * @date 2023-12-08
  *       Create this file.
+ * @date 2026-10-18
+ *       Module parameters gpio/gpio_b/mode/debounce_ms (no device tree needed, e.g. a gpio-sim
+ *       line on x86), debounce from a work item on sleeping GPIO chips, KEY_IOC_GET_STATS/
+ *       KEY_IOC_CLEAR_STATS for key_irq_bench, builds on newer kernels, quadrature mode on
+ *       sleeping GPIO chips (decoded in a threaded irq handler).
  * @copyright Copyright (c) 2023
  * @note HW: 
  *          - zynq 7020(正点原子领航者开发板)
@@ -17,13 +22,21 @@
 #include <linux/types.h>
 #include <linux/kernel.h>
 #include <linux/delay.h>
-#include <linux/ide.h>
 #include <linux/init.h>
 #include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/version.h>
 #include <linux/errno.h>
 #include <linux/gpio.h>
-#include <asm/mach/map.h>
-#include <asm/uaccess.h>
+#include <linux/uaccess.h>
+#include <linux/interrupt.h>
+#include <linux/device.h>
+#include <linux/timer.h>
+#include <linux/workqueue.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/poll.h>
 #include <asm/io.h>
 #include <linux/cdev.h>
 #include <linux/of.h>
@@ -31,14 +44,105 @@
 #include <linux/of_gpio.h>
 #include <linux/of_irq.h>
 #include <linux/irq.h>
+#include <linux/fs.h>
+#include <linux/eventfd.h>
+#include <linux/err.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/kfifo.h>
+#include <linux/seqlock.h>
+#include <linux/math64.h>
+
+#include "key_irq.h"
 
 #define KEY_CNT		1		/* 设备号个数 */
 #define KEY_NAME	"key"	/* 名字 */
+#define KEY_FIFO_SIZE	64		/* 事件队列长度，必须为2的幂 */
+
+/* 手势识别默认参数(ms)，可通过设备树及sysfs修改 */
+#define KEY_LONG_PRESS_MS	1000
+#define KEY_MULTI_CLICK_MS	300
+#define KEY_REPEAT_MS		0		/* 0: 不自动重复 */
+
+/* 计数模式下平均周期的统计窗口(边沿数)，必须为2的幂 */
+#define KEY_COUNTER_WINDOW_SHIFT	6
+#define KEY_COUNTER_WINDOW			(1 << KEY_COUNTER_WINDOW_SHIFT)
+
+/* 内核版本兼容 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 13, 0)
+#define key_kfifo_put(fifo, val)	kfifo_put(fifo, *(val))
+#else
+#define key_kfifo_put(fifo, val)	kfifo_put(fifo, val)
+#endif
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+#define key_eventfd_signal(ctx)		eventfd_signal(ctx)
+#else
+#define key_eventfd_signal(ctx)		eventfd_signal(ctx, 1)
+#endif
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 4, 0)
+#define key_class_create(name)		class_create(name)
+#else
+#define key_class_create(name)		class_create(THIS_MODULE, name)
+#endif
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 2, 0)
+#define key_timer_delete_sync(t)	timer_delete_sync(t)
+#else
+#define key_timer_delete_sync(t)	del_timer_sync(t)
+#endif
+
+/*
+ * 不使用设备树时由模块参数指定，如x86上的gpio-sim：
+ *     insmod key_irq.ko gpio=512 debounce_ms=15
+ */
+static int gpio = -1;
+module_param(gpio, int, 0444);
+MODULE_PARM_DESC(gpio, "Key GPIO number, -1: key-gpio of the /key device tree node");
+
+static int gpio_b = -1;
+module_param(gpio_b, int, 0444);
+MODULE_PARM_DESC(gpio_b, "Phase B GPIO number in quadrature mode (with gpio=)");
+
+static char *mode = "key";
+module_param(mode, charp, 0444);
+MODULE_PARM_DESC(mode, "key, counter or quadrature (with gpio=)");
 
-enum key_status {
-	KEY_PRESS = 0,
-	KEY_RELEASE,
-	KEY_KEEP,		// 按键状态保持
+static unsigned int debounce_ms = 15;
+module_param(debounce_ms, uint, 0644);
+MODULE_PARM_DESC(debounce_ms, "Key mode debounce delay");
+
+/* 手势状态机 */
+enum key_gesture_state {
+	GESTURE_IDLE = 0,		/* 松开，无待定手势 */
+	GESTURE_PRESSED,		/* 按下，等待长按阈值 */
+	GESTURE_HELD,			/* 已长按，等待松开 */
+	GESTURE_REPEAT,			/* 已长按，自动重复中 */
+	GESTURE_WAIT_CLICK,		/* 已松开，等待连击窗口结束 */
+};
+
+/* 按键手势识别 */
+struct key_gesture {
+	enum key_gesture_state state;
+	struct hrtimer timer;		/* 手势定时器 */
+	s64 deadline_ns;			/* 当前定时器的到期时间，用于过滤过期回调 */
+	unsigned int clicks;		/* 连击次数 */
+	unsigned int long_press_ms;	/* 长按阈值 */
+	unsigned int multi_click_ms;/* 连击窗口，0表示不识别连击 */
+	unsigned int repeat_ms;		/* 长按后自动重复周期，0表示不重复 */
+};
+
+/* 边沿计数，counter/quadrature模式下在中断上半部中更新 */
+struct key_count {
+	seqlock_t lock;				/* 保证快照的一致性 */
+	s64 count;					/* 计数值 */
+	u64 edges;					/* 边沿总数 */
+	u64 errors;					/* 正交解码非法跳变次数 */
+	s64 last_ns;				/* 最后一个边沿的时间 */
+	s64 window_ns;				/* 当前统计窗口的起始时间 */
+	u64 period_ns;				/* 上一个统计窗口的平均边沿间隔 */
+	unsigned int qstate;		/* 正交解码的上一状态(A << 1 | B) */
 };
 
 /* 按键设备结构体 */
@@ -49,14 +153,28 @@ struct key_dev {
 	struct device *device;	/* 设备 */
 	int key_gpio;			/* GPIO编号 */
 	int irq_num;			/* 中断号 */
+	int key_gpio_b;			/* 正交模式下B相GPIO编号 */
+	int irq_num_b;			/* 正交模式下B相中断号 */
+	enum key_mode mode;		/* 工作模式 */
+	struct key_count counter;		/* 边沿计数 */
 	struct timer_list timer;/* 定时器 */
+	struct work_struct work;		/* 会睡眠的GPIO芯片上读电平 */
+	int cansleep;			/* 读GPIO可能睡眠(I2C扩展、gpio-sim) */
+	struct mutex qlock;		/* 会睡眠的GPIO上正交解码的A、B相中断线程互斥 */
+	seqlock_t stats_lock;	/* 保护stats */
+	struct key_stats stats;			/* 性能统计 */
 	spinlock_t spinlock;	/* 自旋锁 */
+	struct fasync_struct *fasync;	/* 异步通知(SIGIO)队列 */
+	struct eventfd_ctx *evfd;		/* 注册的eventfd，受spinlock保护 */
+	struct file *evfd_owner;		/* 注册eventfd的文件 */
+	struct key_gesture gesture;		/* 手势识别，受spinlock保护 */
+	unsigned int event_mask;		/* 上报的事件，bit n对应enum key_status中的n */
+	DECLARE_KFIFO(fifo, int, KEY_FIFO_SIZE);	/* 事件队列，受spinlock保护 */
 };
 
 static struct key_dev key;
-static int status = KEY_KEEP;
 
-static inline u32 irq_get_trigger_type(unsigned int irq)
+static inline u32 key_irq_trigger_type(unsigned int irq)
 {
     struct irq_data *d = irq_get_irq_data(irq);
     return d ? irqd_get_trigger_type(d) : 0;
@@ -71,15 +189,17 @@ static ssize_t key_read(struct file *filp, char __user *buf,
 			size_t cnt, loff_t *offt)
 {
 	unsigned long flags;
+	int event;
 	int ret;
 
 	spin_lock_irqsave(&key.spinlock, flags);
-
-	ret = copy_to_user(buf, &status, sizeof(int));
-	/* 状态重置 */
-	status = KEY_KEEP;
+	/* 队列为空时返回状态保持 */
+	if (!kfifo_out(&key.fifo, &event, 1))
+		event = KEY_KEEP;
 	spin_unlock_irqrestore(&key.spinlock, flags);
 
+	ret = copy_to_user(buf, &event, sizeof(int));
+
 	return ret;
 }
 
@@ -89,39 +209,599 @@ static ssize_t key_write(struct file *filp, const char __user *buf,
 	return 0;
 }
 
+static int key_set_eventfd(struct file *filp, int fd)
+{
+	struct eventfd_ctx *ctx = NULL;
+	struct eventfd_ctx *old;
+	unsigned long flags;
+
+	if (fd >= 0)
+	{
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+	}
+
+	spin_lock_irqsave(&key.spinlock, flags);
+	/* 只能替换或注销本文件的注册，与key_drop_eventfd()相同 */
+	if (key.evfd_owner && key.evfd_owner != filp)
+	{
+		spin_unlock_irqrestore(&key.spinlock, flags);
+		if (ctx)
+			eventfd_ctx_put(ctx);
+		return -EBUSY;
+	}
+	old = key.evfd;
+	key.evfd = ctx;
+	key.evfd_owner = ctx ? filp : NULL;
+	spin_unlock_irqrestore(&key.spinlock, flags);
+
+	/* 旧的eventfd在锁外释放 */
+	if (old)
+		eventfd_ctx_put(old);
+
+	return 0;
+}
+
+static void key_drop_eventfd(struct file *filp)
+{
+	struct eventfd_ctx *old = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&key.spinlock, flags);
+	if (key.evfd_owner == filp)
+	{
+		old = key.evfd;
+		key.evfd = NULL;
+		key.evfd_owner = NULL;
+	}
+	spin_unlock_irqrestore(&key.spinlock, flags);
+
+	if (old)
+		eventfd_ctx_put(old);
+}
+
+static int key_get_counter(struct key_counter __user *arg)
+{
+	struct key_counter snap;
+	unsigned int seq;
+
+	if (KEY_MODE_KEY == key.mode)
+		return -EINVAL;
+
+	memset(&snap, 0, sizeof(snap));
+	do {
+		seq = read_seqbegin(&key.counter.lock);
+		snap.count = key.counter.count;
+		snap.edges = key.counter.edges;
+		snap.errors = key.counter.errors;
+		snap.last_edge_ns = key.counter.last_ns;
+		snap.period_ns = key.counter.period_ns;
+	} while (read_seqretry(&key.counter.lock, seq));
+
+	snap.timestamp_ns = ktime_to_ns(ktime_get());
+	snap.mode = key.mode;
+	if (snap.period_ns)
+		snap.freq_mhz = div64_u64(1000000000000ULL, snap.period_ns);
+
+	if (copy_to_user(arg, &snap, sizeof(snap)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int key_get_stats(struct key_stats __user *arg)
+{
+	struct key_stats snap;
+	unsigned int seq;
+
+	do {
+		seq = read_seqbegin(&key.stats_lock);
+		snap = key.stats;
+	} while (read_seqretry(&key.stats_lock, seq));
+
+	snap.timestamp_ns = ktime_to_ns(ktime_get());
+
+	if (copy_to_user(arg, &snap, sizeof(snap)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int key_clear_stats(void)
+{
+	unsigned long flags;
+
+	write_seqlock_irqsave(&key.stats_lock, flags);
+	memset(&key.stats, 0, sizeof(key.stats));
+	write_sequnlock_irqrestore(&key.stats_lock, flags);
+
+	return 0;
+}
+
+/* 中断上半部的次数及耗时，start为进入中断的时间 */
+static inline void key_stats_irq(s64 start)
+{
+	u64 ns = ktime_to_ns(ktime_get()) - start;
+
+	write_seqlock(&key.stats_lock);
+	key.stats.irqs++;
+	key.stats.irq_ns += ns;
+	if (ns > key.stats.irq_ns_max)
+		key.stats.irq_ns_max = ns;
+	key.stats.last_irq_ns = start;
+	write_sequnlock(&key.stats_lock);
+}
+
+static unsigned int key_quadrature_state(void)
+{
+	if (key.cansleep)
+		return (gpio_get_value_cansleep(key.key_gpio) ? 2 : 0) |
+			(gpio_get_value_cansleep(key.key_gpio_b) ? 1 : 0);
+
+	return (gpio_get_value(key.key_gpio) ? 2 : 0) | (gpio_get_value(key.key_gpio_b) ? 1 : 0);
+}
+
+static int key_clear_counter(void)
+{
+	int qsleep = KEY_MODE_QUADRATURE == key.mode && key.cansleep;
+	unsigned int state = 0;
+	unsigned long flags;
+
+	if (KEY_MODE_KEY == key.mode)
+		return -EINVAL;
+
+	/* 会睡眠的GPIO不能在seqlock中读，由qlock与中断线程互斥 */
+	if (qsleep)
+	{
+		mutex_lock(&key.qlock);
+		state = key_quadrature_state();
+	}
+
+	write_seqlock_irqsave(&key.counter.lock, flags);
+	key.counter.count = 0;
+	key.counter.edges = 0;
+	key.counter.errors = 0;
+	key.counter.last_ns = 0;
+	key.counter.window_ns = 0;
+	key.counter.period_ns = 0;
+	if (KEY_MODE_QUADRATURE == key.mode)
+		key.counter.qstate = qsleep ? state : key_quadrature_state();
+	write_sequnlock_irqrestore(&key.counter.lock, flags);
+
+	if (qsleep)
+		mutex_unlock(&key.qlock);
+
+	return 0;
+}
+
+static long key_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
+{
+	int fd;
+
+	switch (cmd) {
+	case KEY_IOC_SET_EVENTFD:
+		if (get_user(fd, (int __user *)arg))
+			return -EFAULT;
+		return key_set_eventfd(filp, fd);
+	case KEY_IOC_GET_COUNTER:
+		return key_get_counter((struct key_counter __user *)arg);
+	case KEY_IOC_CLEAR_COUNTER:
+		return key_clear_counter();
+	case KEY_IOC_GET_STATS:
+		return key_get_stats((struct key_stats __user *)arg);
+	case KEY_IOC_CLEAR_STATS:
+		return key_clear_stats();
+	default:
+		return -ENOTTY;
+	}
+}
+
+static int key_fasync(int fd, struct file *filp, int on)
+{
+	return fasync_helper(fd, filp, on, &key.fasync);
+}
+
 static int key_release(struct inode *inode, struct file *filp)
 {
+	/* 注销该文件的异步通知及eventfd */
+	key_fasync(-1, filp, 0);
+	key_drop_eventfd(filp);
+
 	return 0;
 }
 
-static void key_timer_function(unsigned long arg)
+/*
+ * 事件入队并通知eventfd，需持有spinlock。
+ * 返回1表示事件已入队，调用者解锁后需发送SIGIO。
+ */
+static int key_queue_event(int event)
+{
+	if (!(key.event_mask & (1U << event)))
+		return 0;
+
+	/* 队列满时丢弃新事件 */
+	if (!key_kfifo_put(&key.fifo, &event))
+	{
+		write_seqlock(&key.stats_lock);
+		key.stats.dropped++;
+		write_sequnlock(&key.stats_lock);
+		return 0;
+	}
+
+	write_seqlock(&key.stats_lock);
+	key.stats.events++;
+	key.stats.last_event_ns = ktime_to_ns(ktime_get());
+	write_sequnlock(&key.stats_lock);
+
+	if (key.evfd)
+		key_eventfd_signal(key.evfd);
+
+	return 1;
+}
+
+/* 启动手势定时器，需持有spinlock */
+static void key_gesture_arm(unsigned int ms)
+{
+	ktime_t kt = ktime_set(ms / MSEC_PER_SEC, (ms % MSEC_PER_SEC) * NSEC_PER_MSEC);
+
+	key.gesture.deadline_ns = ktime_to_ns(ktime_get()) + ktime_to_ns(kt);
+	hrtimer_start(&key.gesture.timer, kt, HRTIMER_MODE_REL);
+}
+
+/*
+ * 停止手势定时器，需持有spinlock。
+ * 回调可能正在其他CPU上等待spinlock，因此不能调用hrtimer_cancel()，
+ * 过期的回调由状态及deadline_ns过滤。
+ */
+static void key_gesture_disarm(void)
+{
+	key.gesture.deadline_ns = 0;
+	hrtimer_try_to_cancel(&key.gesture.timer);
+}
+
+/* 连击窗口结束，根据次数上报单击/双击/多击 */
+static int key_gesture_clicks_done(void)
+{
+	struct key_gesture *g = &key.gesture;
+	int event;
+
+	if (g->clicks >= 3)
+		event = KEY_MULTI_CLICK;
+	else if (2 == g->clicks)
+		event = KEY_DOUBLE_CLICK;
+	else
+		event = KEY_CLICK;
+
+	g->clicks = 0;
+	g->state = GESTURE_IDLE;
+
+	return key_queue_event(event);
+}
+
+/* 消抖后的按键边沿，需持有spinlock */
+static int key_gesture_edge(int pressed)
+{
+	struct key_gesture *g = &key.gesture;
+	int queued;
+
+	if (pressed)
+	{
+		queued = key_queue_event(KEY_PRESS);
+
+		key_gesture_disarm();
+		if (GESTURE_WAIT_CLICK != g->state)
+			g->clicks = 0;
+		g->state = GESTURE_PRESSED;
+		key_gesture_arm(g->long_press_ms);
+
+		return queued;
+	}
+
+	queued = key_queue_event(KEY_RELEASE);
+
+	switch (g->state) {
+	case GESTURE_PRESSED:
+		key_gesture_disarm();
+		g->clicks++;
+		if (g->multi_click_ms)
+		{
+			g->state = GESTURE_WAIT_CLICK;
+			key_gesture_arm(g->multi_click_ms);
+		}
+		else
+		{
+			queued |= key_gesture_clicks_done();
+		}
+		break;
+	case GESTURE_HELD:
+	case GESTURE_REPEAT:
+		key_gesture_disarm();
+		g->clicks = 0;
+		g->state = GESTURE_IDLE;
+		break;
+	default:
+		break;
+	}
+
+	return queued;
+}
+
+static enum hrtimer_restart key_gesture_timer_function(struct hrtimer *timer)
+{
+	struct key_gesture *g = &key.gesture;
+	unsigned long flags;
+	int queued = 0;
+
+	spin_lock_irqsave(&key.spinlock, flags);
+
+	/* 定时器已被取消或重新启动 */
+	if (!g->deadline_ns || ktime_to_ns(ktime_get()) < g->deadline_ns)
+		goto out;
+
+	g->deadline_ns = 0;
+
+	switch (g->state) {
+	case GESTURE_PRESSED:
+		queued = key_queue_event(KEY_LONG_PRESS);
+		g->clicks = 0;
+		if (g->repeat_ms)
+		{
+			g->state = GESTURE_REPEAT;
+			key_gesture_arm(g->repeat_ms);
+		}
+		else
+		{
+			g->state = GESTURE_HELD;
+		}
+		break;
+	case GESTURE_REPEAT:
+		queued = key_queue_event(KEY_REPEAT);
+		/* repeat_ms可能在自动重复中被sysfs改为0，0周期重新启动会在回调中无限循环 */
+		if (g->repeat_ms)
+			key_gesture_arm(g->repeat_ms);
+		else
+			g->state = GESTURE_HELD;
+		break;
+	case GESTURE_WAIT_CLICK:
+		queued = key_gesture_clicks_done();
+		break;
+	default:
+		break;
+	}
+
+out:
+	spin_unlock_irqrestore(&key.spinlock, flags);
+
+	if (queued)
+		kill_fasync(&key.fasync, SIGIO, POLL_IN);
+
+	/* 需要时已在回调中通过hrtimer_start()重新启动 */
+	return HRTIMER_NORESTART;
+}
+
+/* 消抖结束，current_val为按键电平 */
+static void key_debounce(int current_val, s64 start)
 {
 	static int last_val = 1;
 	unsigned long flags;
-	int current_val;
+	int queued = 0;
+	u64 ns;
 
 	spin_lock_irqsave(&key.spinlock, flags);
 
-	current_val = gpio_get_value(key.key_gpio);
 	if (0 == current_val && last_val)	// 按下
-		status = KEY_PRESS;
+		queued = key_gesture_edge(1);
 	else if (1 == current_val && !last_val)
-		status = KEY_RELEASE;	// 松开
-	else
-		status = KEY_KEEP;		// 状态保持
+		queued = key_gesture_edge(0);	// 松开
+	/* 否则状态保持 */
 
 	last_val = current_val;
 
+	ns = ktime_to_ns(ktime_get()) - start;
+	write_seqlock(&key.stats_lock);
+	key.stats.debounces++;
+	key.stats.bh_ns += ns;
+	if (ns > key.stats.bh_ns_max)
+		key.stats.bh_ns_max = ns;
+	write_sequnlock(&key.stats_lock);
+
 	spin_unlock_irqrestore(&key.spinlock, flags);
+
+	/* 发送SIGIO */
+	if (queued)
+		kill_fasync(&key.fasync, SIGIO, POLL_IN);
+}
+
+static void key_work_function(struct work_struct *work)
+{
+	s64 start = ktime_to_ns(ktime_get());
+
+	key_debounce(gpio_get_value_cansleep(key.key_gpio), start);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+static void key_timer_function(struct timer_list *t)
+#else
+static void key_timer_function(unsigned long arg)
+#endif
+{
+	s64 start = ktime_to_ns(ktime_get());
+
+	/* 定时器中不能睡眠，交给工作队列读电平 */
+	if (key.cansleep)
+	{
+		schedule_work(&key.work);
+		return;
+	}
+
+	key_debounce(gpio_get_value(key.key_gpio), start);
 }
 
 static irqreturn_t key_interrupt(int irq, void *dev_id)
 {
-	/* 按键防抖处理，开启定时器延时15ms */
-	mod_timer(&key.timer, jiffies + msecs_to_jiffies(15));
+	s64 start = ktime_to_ns(ktime_get());
+
+	/* 按键防抖处理，开启定时器延时debounce_ms(缺省15ms) */
+	mod_timer(&key.timer, jiffies + msecs_to_jiffies(debounce_ms));
+	key_stats_irq(start);
+
+	return IRQ_HANDLED;
+}
+
+/*
+ * 正交解码表，下标为(上一状态 << 2 | 当前状态)，状态为(A << 1 | B)。
+ * A超前B时为正方向，0表示无变化或非法跳变(A、B同时变化)。
+ */
+static const signed char key_qdec_table[16] = {
+	 0, -1, +1,  0,
+	+1,  0,  0, -1,
+	-1,  0,  0, +1,
+	 0, +1, -1,  0,
+};
+
+/* 记录一个边沿，需持有counter.lock */
+static inline void key_counter_edge(s64 now)
+{
+	struct key_count *c = &key.counter;
+
+	c->edges++;
+	c->last_ns = now;
+
+	/* 每KEY_COUNTER_WINDOW个边沿更新一次平均周期，避免在中断中做除法 */
+	if (1 == c->edges)
+	{
+		c->window_ns = now;
+	}
+	else if (0 == ((c->edges - 1) & (KEY_COUNTER_WINDOW - 1)))
+	{
+		c->period_ns = (u64)(now - c->window_ns) >> KEY_COUNTER_WINDOW_SHIFT;
+		c->window_ns = now;
+	}
+}
+
+/* counter模式：每个边沿计数，无消抖 */
+static irqreturn_t key_counter_interrupt(int irq, void *dev_id)
+{
+	s64 now = ktime_to_ns(ktime_get());
+
+	write_seqlock(&key.counter.lock);
+	key.counter.count++;
+	key_counter_edge(now);
+	write_sequnlock(&key.counter.lock);
+
+	key_stats_irq(now);
+
 	return IRQ_HANDLED;
 }
 
+/* 正交解码一个新状态，需持有counter.lock */
+static inline void key_quadrature_decode(unsigned int state, s64 now)
+{
+	int delta = key_qdec_table[(key.counter.qstate << 2) | state];
+
+	if (!delta && state != key.counter.qstate)
+		key.counter.errors++;
+	key.counter.count += delta;
+	key.counter.qstate = state;
+	key_counter_edge(now);
+}
+
+/* quadrature模式：A、B相共用此中断处理函数 */
+static irqreturn_t key_quadrature_interrupt(int irq, void *dev_id)
+{
+	s64 now = ktime_to_ns(ktime_get());
+
+	write_seqlock(&key.counter.lock);
+	key_quadrature_decode(key_quadrature_state(), now);
+	write_sequnlock(&key.counter.lock);
+
+	key_stats_irq(now);
+
+	return IRQ_HANDLED;
+}
+
+/*
+ * quadrature模式，会睡眠的GPIO芯片(I2C扩展、gpio-sim)：在中断线程中读A、B相电平。
+ * 两相的中断线程可能同时运行，由qlock保证读电平与解码的顺序一致。
+ * 线程运行前两相都已变化时记为非法跳变，与上半部解码时漏掉边沿的效果相同。
+ */
+static irqreturn_t key_quadrature_thread(int irq, void *dev_id)
+{
+	s64 now = ktime_to_ns(ktime_get());
+	unsigned int state;
+
+	mutex_lock(&key.qlock);
+	state = key_quadrature_state();
+	write_seqlock_irq(&key.counter.lock);
+	key_quadrature_decode(state, now);
+	write_sequnlock_irq(&key.counter.lock);
+	mutex_unlock(&key.qlock);
+
+	key_stats_irq(now);
+
+	return IRQ_HANDLED;
+}
+
+static int key_parse_mode(const char *str)
+{
+	if (!strcmp(str, "counter"))
+		key.mode = KEY_MODE_COUNTER;
+	else if (!strcmp(str, "quadrature"))
+		key.mode = KEY_MODE_QUADRATURE;
+	else if (!strcmp(str, "key"))
+		key.mode = KEY_MODE_KEY;
+	else
+    {
+		printk(KERN_ERR "key: Invalid key-mode %s\n", str);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* 由模块参数gpio、gpio_b、mode指定，手势参数使用缺省值 */
+static int key_parse_param(void)
+{
+	int ret;
+
+	ret = key_parse_mode(mode);
+	if (ret)
+		return ret;
+
+	key.key_gpio = gpio;
+	if (!gpio_is_valid(key.key_gpio))
+    {
+		printk(KERN_ERR "key: Invalid gpio %d\n", gpio);
+		return -EINVAL;
+	}
+
+	key.irq_num = gpio_to_irq(key.key_gpio);
+	if (key.irq_num <= 0)
+    {
+		printk(KERN_ERR "key: gpio %d has no irq\n", gpio);
+		return -EINVAL;
+	}
+
+	if (KEY_MODE_QUADRATURE == key.mode)
+    {
+		key.key_gpio_b = gpio_b;
+		if (!gpio_is_valid(key.key_gpio_b))
+        {
+			printk(KERN_ERR "key: Invalid gpio_b %d\n", gpio_b);
+			return -EINVAL;
+		}
+
+		key.irq_num_b = gpio_to_irq(key.key_gpio_b);
+		if (key.irq_num_b <= 0)
+        {
+            return -EINVAL;
+        }
+	}
+
+	return 0;
+}
+
 static int key_parse_dt(void)
 {
 	struct device_node *nd;
@@ -171,12 +851,69 @@ static int key_parse_dt(void)
         return -EINVAL;
     }
 
+	/* 工作模式，缺省为按键 */
+	key.mode = KEY_MODE_KEY;
+	ret = of_property_read_string(nd, "key-mode", &str);
+	if (!ret)
+    {
+		ret = key_parse_mode(str);
+		if (ret)
+			return ret;
+	}
+
+	/* 正交模式需要B相GPIO及中断 */
+	if (KEY_MODE_QUADRATURE == key.mode)
+    {
+		key.key_gpio_b = of_get_named_gpio(nd, "key-gpio", 1);
+		if (!gpio_is_valid(key.key_gpio_b))
+        {
+			printk(KERN_ERR "key: Failed to get key-gpio B\n");
+			return -EINVAL;
+		}
+
+		key.irq_num_b = irq_of_parse_and_map(nd, 1);
+		if (!key.irq_num_b)
+        {
+            return -EINVAL;
+        }
+	}
+
+	/* 手势识别参数，可选 */
+	of_property_read_u32(nd, "long-press-ms", &key.gesture.long_press_ms);
+	of_property_read_u32(nd, "multi-click-ms", &key.gesture.multi_click_ms);
+	of_property_read_u32(nd, "repeat-ms", &key.gesture.repeat_ms);
+	if (!key.gesture.long_press_ms)
+    {
+		printk(KERN_ERR "key: Invalid long-press-ms\n");
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
-static int key_gpio_init(void)
+/* thread_fn不为NULL时使用中断线程(handler可为NULL) */
+static int key_request_irq(unsigned int irq, irq_handler_t handler,
+			irq_handler_t thread_fn, const char *name)
 {
 	unsigned long irq_flags;
+
+	/* 获取设备树中指定的中断触发类型 */
+	irq_flags = key_irq_trigger_type(irq);
+	if (IRQF_TRIGGER_NONE == irq_flags)
+    {
+        irq_flags = IRQF_TRIGGER_FALLING | IRQF_TRIGGER_RISING;
+    }
+
+	if (thread_fn)
+		return request_threaded_irq(irq, handler, thread_fn, irq_flags | IRQF_ONESHOT, name, NULL);
+
+	return request_irq(irq, handler, irq_flags, name, NULL);
+}
+
+static int key_gpio_init(void)
+{
+	irq_handler_t handler;
+	irq_handler_t thread_fn = NULL;
 	int ret;
 
 	ret = gpio_request(key.key_gpio, "Key Gpio");
@@ -186,29 +923,165 @@ static int key_gpio_init(void)
     }
 
 	gpio_direction_input(key.key_gpio);
+	key.cansleep = gpio_cansleep(key.key_gpio);
 
-	/* 获取设备树中指定的中断触发类型 */
-	irq_flags = irq_get_trigger_type(key.irq_num);
-	if (IRQF_TRIGGER_NONE == irq_flags)
-    {
-        irq_flags = IRQF_TRIGGER_FALLING | IRQF_TRIGGER_RISING;
-    }
+	switch (key.mode) {
+	case KEY_MODE_COUNTER:
+		handler = key_counter_interrupt;
+		break;
+	case KEY_MODE_QUADRATURE:
+		/* 正交解码在中断上半部中读A、B相电平，会睡眠的GPIO在中断线程中读 */
+		key.cansleep = key.cansleep || gpio_cansleep(key.key_gpio_b);
+		if (key.cansleep)
+        {
+			handler = NULL;
+			thread_fn = key_quadrature_thread;
+		}
+		else
+        {
+			handler = key_quadrature_interrupt;
+		}
+		ret = gpio_request(key.key_gpio_b, "Key Gpio B");
+		if (ret)
+        {
+			gpio_free(key.key_gpio);
+			return ret;
+		}
+		gpio_direction_input(key.key_gpio_b);
+		key.counter.qstate = key_quadrature_state();
+		break;
+	default:
+		handler = key_interrupt;
+		break;
+	}
 
-	ret = request_irq(key.irq_num, key_interrupt, irq_flags, "PS Key0 IRQ", NULL);
+	ret = key_request_irq(key.irq_num, handler, thread_fn, "PS Key0 IRQ");
 	if (ret)
+		goto err_gpio;
+
+	if (KEY_MODE_QUADRATURE == key.mode)
     {
-		gpio_free(key.key_gpio);
-		return ret;
+		ret = key_request_irq(key.irq_num_b, handler, thread_fn, "PS Key0 IRQ B");
+		if (ret)
+        {
+			free_irq(key.irq_num, NULL);
+			goto err_gpio;
+		}
 	}
 
 	return 0;
+
+err_gpio:
+	if (KEY_MODE_QUADRATURE == key.mode)
+		gpio_free(key.key_gpio_b);
+	gpio_free(key.key_gpio);
+	return ret;
+}
+
+static void key_gpio_exit(void)
+{
+	if (KEY_MODE_QUADRATURE == key.mode)
+    {
+		free_irq(key.irq_num_b, NULL);
+		gpio_free(key.key_gpio_b);
+	}
+	free_irq(key.irq_num, NULL);
+	gpio_free(key.key_gpio);
+}
+
+#define KEY_GESTURE_ATTR(_name)													\
+static ssize_t _name##_show(struct device *dev,									\
+			struct device_attribute *attr, char *buf)							\
+{																				\
+	return sprintf(buf, "%u\n", key.gesture._name);							\
+}																				\
+																				\
+static ssize_t _name##_store(struct device *dev,								\
+			struct device_attribute *attr, const char *buf, size_t count)		\
+{																				\
+	unsigned long flags;														\
+	unsigned int val;															\
+																				\
+	if (kstrtouint(buf, 0, &val))												\
+		return -EINVAL;															\
+																				\
+	spin_lock_irqsave(&key.spinlock, flags);									\
+	key.gesture._name = val;													\
+	spin_unlock_irqrestore(&key.spinlock, flags);								\
+																				\
+	return count;																\
+}																				\
+static DEVICE_ATTR(_name, S_IRUGO | S_IWUSR, _name##_show, _name##_store)
+
+KEY_GESTURE_ATTR(multi_click_ms);
+KEY_GESTURE_ATTR(repeat_ms);
+
+/* 长按阈值不能为0 */
+static ssize_t long_press_ms_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", key.gesture.long_press_ms);
 }
 
+static ssize_t long_press_ms_store(struct device *dev,
+			struct device_attribute *attr, const char *buf, size_t count)
+{
+	unsigned long flags;
+	unsigned int val;
+
+	if (kstrtouint(buf, 0, &val) || !val)
+		return -EINVAL;
+
+	spin_lock_irqsave(&key.spinlock, flags);
+	key.gesture.long_press_ms = val;
+	spin_unlock_irqrestore(&key.spinlock, flags);
+
+	return count;
+}
+static DEVICE_ATTR(long_press_ms, S_IRUGO | S_IWUSR, long_press_ms_show, long_press_ms_store);
+
+static ssize_t event_mask_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	return sprintf(buf, "0x%x\n", key.event_mask);
+}
+
+static ssize_t event_mask_store(struct device *dev,
+			struct device_attribute *attr, const char *buf, size_t count)
+{
+	unsigned long flags;
+	unsigned int val;
+
+	if (kstrtouint(buf, 0, &val))
+		return -EINVAL;
+
+	spin_lock_irqsave(&key.spinlock, flags);
+	key.event_mask = val & KEY_EVENT_MASK_ALL;
+	spin_unlock_irqrestore(&key.spinlock, flags);
+
+	return count;
+}
+static DEVICE_ATTR(event_mask, S_IRUGO | S_IWUSR, event_mask_show, event_mask_store);
+
+static struct attribute *key_attrs[] = {
+	&dev_attr_long_press_ms.attr,
+	&dev_attr_multi_click_ms.attr,
+	&dev_attr_repeat_ms.attr,
+	&dev_attr_event_mask.attr,
+	NULL,
+};
+
+static const struct attribute_group key_attr_group = {
+	.attrs = key_attrs,
+};
+
 static struct file_operations key_fops = {
 	.owner		= THIS_MODULE,
 	.open		= key_open,
 	.read		= key_read,
 	.write		= key_write,
+	.unlocked_ioctl	= key_ioctl,
+	.fasync		= key_fasync,
 	.release	= key_release,
 };
 
@@ -217,9 +1090,36 @@ static int __init mykey_init(void)
 	int ret;
 
 	spin_lock_init(&key.spinlock);
+	mutex_init(&key.qlock);
+	INIT_KFIFO(key.fifo);
+	key.event_mask = KEY_EVENT_MASK_ALL;
+	key.gesture.state = GESTURE_IDLE;
+	key.gesture.long_press_ms = KEY_LONG_PRESS_MS;
+	key.gesture.multi_click_ms = KEY_MULTI_CLICK_MS;
+	key.gesture.repeat_ms = KEY_REPEAT_MS;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+	hrtimer_setup(&key.gesture.timer, key_gesture_timer_function, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+#else
+	hrtimer_init(&key.gesture.timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	key.gesture.timer.function = key_gesture_timer_function;
+#endif
+	seqlock_init(&key.counter.lock);
+	seqlock_init(&key.stats_lock);
+
+	/* 消抖定时器须在申请中断前初始化 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+	timer_setup(&key.timer, key_timer_function, 0);
+#else
+	init_timer(&key.timer);
+	key.timer.function = key_timer_function;
+#endif
+	INIT_WORK(&key.work, key_work_function);
 
-	/* 设备树解析 */
-	ret = key_parse_dt();
+	/* 设备树解析，或使用模块参数 */
+	if (gpio >= 0)
+		ret = key_parse_param();
+	else
+		ret = key_parse_dt();
 	if (ret)
     {
 		return ret;
@@ -246,7 +1146,7 @@ static int __init mykey_init(void)
 		goto out2;
 
 	/* 创建类 */
-	key.class = class_create(THIS_MODULE, KEY_NAME);
+	key.class = key_class_create(KEY_NAME);
 	if (IS_ERR(key.class)) {
 		ret = PTR_ERR(key.class);
 		goto out3;
@@ -260,11 +1160,16 @@ static int __init mykey_init(void)
 		goto out4;
 	}
 
-	init_timer(&key.timer);
-	key.timer.function = key_timer_function;
+	/* 手势参数sysfs节点 */
+	ret = sysfs_create_group(&key.device->kobj, &key_attr_group);
+	if (ret)
+		goto out5;
 
 	return 0;
 
+out5:
+	device_destroy(key.class, key.devid);
+
 out4:
 	class_destroy(key.class);
 
@@ -275,21 +1180,30 @@ out2:
 	unregister_chrdev_region(key.devid, KEY_CNT);
 
 out1:
-	free_irq(key.irq_num, NULL);
-	gpio_free(key.key_gpio);
+	key_gpio_exit();
+	key_timer_delete_sync(&key.timer);
+	cancel_work_sync(&key.work);
 
 	return ret;
 }
 
 static void __exit mykey_exit(void)
 {
-	del_timer_sync(&key.timer);
+	/*
+	 * 先释放中断，再停止中断重新启动的消抖定时器、读电平的工作及手势定时器，
+	 * 顺序与mykey_init的出错处理相同，否则停止后的边沿会在模块卸载后触发定时器。
+	 */
+	key_gpio_exit();
+	key_timer_delete_sync(&key.timer);
+	cancel_work_sync(&key.work);
+	hrtimer_cancel(&key.gesture.timer);
+	sysfs_remove_group(&key.device->kobj, &key_attr_group);
 	device_destroy(key.class, key.devid);
 	class_destroy(key.class);
 	cdev_del(&key.cdev);
 	unregister_chrdev_region(key.devid, KEY_CNT);
-	free_irq(key.irq_num, NULL);
-	gpio_free(key.key_gpio);
+	if (key.evfd)
+		eventfd_ctx_put(key.evfd);
 }
 
 module_init(mykey_init);
@@ -297,4 +1211,5 @@ module_exit(mykey_exit);
 
 MODULE_AUTHOR("panxingyuan1@163.com");
 MODULE_DESCRIPTION("Key irq drv.");
+MODULE_VERSION("1.1");
 MODULE_LICENSE("GPL");
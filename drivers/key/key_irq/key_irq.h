@@ -0,0 +1,101 @@
+/**
+ * @file key_irq.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Key irq driver interface, shared by key_irq.ko and its applications.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       struct key_stats, KEY_IOC_GET_STATS, KEY_IOC_CLEAR_STATS.
+ * @copyright Copyright (c) 2026
+ */
+
+#ifndef __KEY_IRQ_H__
+#define __KEY_IRQ_H__
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/* read()返回的按键状态及手势事件 */
+enum key_status {
+	KEY_PRESS = 0,
+	KEY_RELEASE,
+	KEY_KEEP,		// 按键状态保持(无事件)
+	KEY_CLICK,			// 单击
+	KEY_DOUBLE_CLICK,	// 双击
+	KEY_MULTI_CLICK,	// 三击及以上
+	KEY_LONG_PRESS,		// 长按
+	KEY_REPEAT,			// 长按后自动重复
+};
+
+/*
+ * sysfs中event_mask的取值，bit n对应事件n。
+ * 只关心手势的应用可写入KEY_EVENT_MASK_GESTURE，每个手势只唤醒一次。
+ */
+#define KEY_EVENT_BIT(ev)			(1U << (ev))
+#define KEY_EVENT_MASK_EDGE			(KEY_EVENT_BIT(KEY_PRESS) | KEY_EVENT_BIT(KEY_RELEASE))
+#define KEY_EVENT_MASK_GESTURE		(KEY_EVENT_BIT(KEY_CLICK) | KEY_EVENT_BIT(KEY_DOUBLE_CLICK) | \
+									 KEY_EVENT_BIT(KEY_MULTI_CLICK) | KEY_EVENT_BIT(KEY_LONG_PRESS) | \
+									 KEY_EVENT_BIT(KEY_REPEAT))
+#define KEY_EVENT_MASK_ALL			(KEY_EVENT_MASK_EDGE | KEY_EVENT_MASK_GESTURE)
+
+/* 工作模式，由设备树key-mode属性指定 */
+enum key_mode {
+	KEY_MODE_KEY = 0,		// "key": 按键，消抖后上报事件
+	KEY_MODE_COUNTER,		// "counter": 边沿计数/测频，不消抖、不入队
+	KEY_MODE_QUADRATURE,	// "quadrature": 正交编码器，key-gpio依次为A、B相
+};
+
+/* 计数快照，KEY_IOC_GET_COUNTER返回 */
+struct key_counter {
+	__s64 count;			/* 计数值，正交模式下为带方向的位置 */
+	__u64 edges;			/* 边沿总数 */
+	__u64 errors;			/* 正交解码非法跳变次数 */
+	__u64 last_edge_ns;		/* 最后一个边沿的时间(CLOCK_MONOTONIC) */
+	__u64 period_ns;		/* 最近一个统计窗口内的平均边沿间隔，0表示尚未测得 */
+	__u64 freq_mhz;			/* 由period_ns换算的边沿频率(mHz) */
+	__u64 timestamp_ns;		/* 快照时间(CLOCK_MONOTONIC) */
+	__u32 mode;				/* enum key_mode */
+	__u32 reserved;
+};
+
+/*
+ * 驱动性能统计，KEY_IOC_GET_STATS返回，所有模式有效。
+ * 耗时为ktime_get()测得的处理函数执行时间，不含中断进入/退出的开销。
+ */
+struct key_stats {
+	__u64 irqs;				/* 中断上半部执行次数 */
+	__u64 debounces;		/* 消抖下半部执行次数(key模式) */
+	__u64 events;			/* 入队事件数 */
+	__u64 dropped;			/* 队列满丢弃的事件数 */
+	__u64 irq_ns;			/* 中断上半部累计耗时 */
+	__u64 irq_ns_max;
+	__u64 bh_ns;			/* 消抖下半部累计耗时 */
+	__u64 bh_ns_max;
+	__u64 last_irq_ns;		/* 最后一次中断的时间(CLOCK_MONOTONIC) */
+	__u64 last_event_ns;	/* 最后一个事件入队的时间(CLOCK_MONOTONIC) */
+	__u64 timestamp_ns;		/* 快照时间(CLOCK_MONOTONIC) */
+};
+
+#define KEY_IOC_MAGIC	'K'
+
+/*
+ * 注册eventfd，参数为指向eventfd文件描述符(int)的指针，-1表示注销。
+ * 每产生一个按键事件，驱动在定时器(下半部)中对该eventfd计数加1。
+ * 同一个eventfd可以注册到多个按键设备上，一次read即可唤醒所有设备的事件处理。
+ * 注册与打开该设备的文件绑定，文件关闭时自动注销；已由其他文件注册时
+ * 注册、注销都返回-EBUSY。
+ */
+#define KEY_IOC_SET_EVENTFD	_IOW(KEY_IOC_MAGIC, 0, int)
+
+/* 读取计数快照，仅counter/quadrature模式有效 */
+#define KEY_IOC_GET_COUNTER		_IOR(KEY_IOC_MAGIC, 1, struct key_counter)
+
+/* 计数清零，仅counter/quadrature模式有效 */
+#define KEY_IOC_CLEAR_COUNTER	_IO(KEY_IOC_MAGIC, 2)
+
+/* 读取/清零性能统计 */
+#define KEY_IOC_GET_STATS		_IOR(KEY_IOC_MAGIC, 3, struct key_stats)
+#define KEY_IOC_CLEAR_STATS		_IO(KEY_IOC_MAGIC, 4)
+
+#endif /* __KEY_IRQ_H__ */
@@ -5,6 +5,10 @@
  * @version 0.1
  * @date 2023-12-08
  *       Create this file.
+ * @date 2026-10-18
+ *       Run on user_apps/evloop: key events via the registered eventfd instead of a busy
+ *       read loop, counter snapshots from a 1 s timer, SIGINT/SIGTERM for a clean exit.
+ *       -t trace_file: key events go to the trace buffer (user_apps/trace) instead of printf().
  * @copyright Copyright (c) 2023
  * @note
  *       Toolchain: arm-xilinx-linux-gnueabi-gcc (Sourcery CodeBench Lite 2012.09-104) 4.7.2
@@ -16,40 +20,218 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+
+#include "evloop.h"
+#include "trace.h"
+
+#include "key_irq.h"
+
+struct key_app {
+    int fd;
+    int efd;
+    uint64_t efd_count;             /* eventfd读缓冲 */
+    struct ev_io efd_io;
+    struct ev_timer counter_timer;
+    struct ev_signal sigint;
+    struct ev_signal sigterm;
+};
+
+/* 给出-t时按键事件写入trace文件(user_apps/trace)，否则打印 */
+static int key_trace = 0;
+
+#define KEY_LOG(msg)                    \
+    do {                                \
+        if (key_trace)                  \
+            TRACE(msg);                 \
+        else                            \
+            printf(msg "\n");           \
+    } while (0)
+
+static void key_print(int key_val)
+{
+    switch (key_val)
+    {
+    case KEY_PRESS:
+        KEY_LOG("Key Press");
+        break;
+    case KEY_RELEASE:
+        KEY_LOG("Key Release");
+        break;
+    case KEY_CLICK:
+        KEY_LOG("Key Click");
+        break;
+    case KEY_DOUBLE_CLICK:
+        KEY_LOG("Key Double Click");
+        break;
+    case KEY_MULTI_CLICK:
+        KEY_LOG("Key Multi Click");
+        break;
+    case KEY_LONG_PRESS:
+        KEY_LOG("Key Long Press");
+        break;
+    case KEY_REPEAT:
+        KEY_LOG("Key Repeat");
+        break;
+    default:
+        break;
+    }
+}
+
+/* eventfd计数到达：取空按键队列(读到KEY_KEEP为止) */
+static void key_events(struct ev_loop *loop, struct ev_io *io, uint32_t revents)
+{
+    struct key_app *app = io->data;
+    int key_val = KEY_KEEP;
+
+    if (revents != EPOLLIN)
+    {
+        fprintf(stderr, "Error: eventfd read failed, revents=0x%x!\n", revents);
+        ev_loop_break(loop);
+        return;
+    }
+
+    while (1)
+    {
+        key_val = KEY_KEEP;
+        read(app->fd, &key_val, sizeof(int));
+        if (key_val == KEY_KEEP)
+        {
+            break;
+        }
+        key_print(key_val);
+    }
+}
+
+/* counter/quadrature模式：每秒打印一次计数快照 */
+static void key_counter(struct ev_loop *loop, struct ev_timer *timer)
+{
+    struct key_app *app = timer->data;
+    struct key_counter cnt;
+
+    if (ioctl(app->fd, KEY_IOC_GET_COUNTER, &cnt))
+    {
+        perror("ioctl KEY_IOC_GET_COUNTER error!");
+        ev_loop_break(loop);
+        return;
+    }
+
+    printf("count: %lld, edges: %llu, errors: %llu, period: %llu ns, freq: %llu.%03llu Hz\n",
+           (long long)cnt.count, (unsigned long long)cnt.edges, (unsigned long long)cnt.errors,
+           (unsigned long long)cnt.period_ns, (unsigned long long)(cnt.freq_mhz / 1000),
+           (unsigned long long)(cnt.freq_mhz % 1000));
+}
+
+static void key_quit(struct ev_loop *loop, struct ev_signal *sig)
+{
+    ev_loop_break(loop);
+}
 
 int main(int argc, char *argv[])
 {
-	int fd = -1;
-	int key_val = 0;
+    struct key_app app = { .fd = -1, .efd = -1 };
+    struct ev_loop loop;
+    const char *trace_file = NULL;
+    int counter = 0;
+    int ret = -1;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "t:")) != -1)
+    {
+        if (opt != 't')
+        {
+            break;
+        }
+        trace_file = optarg;
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (2 != argc && !(3 == argc && !strcmp(argv[2], "counter")))
+    {
+        printf("Usage:\n\t./keyApp [-t trace_file] /dev/key [counter]\n");
+        return -1;
+    }
+    counter = (3 == argc);
+
+    app.fd = open(argv[1], O_RDONLY);
+    if (app.fd == -1)
+    {
+        fprintf(stderr, "ERROR: %s file open failed!\n", argv[1]);
+        return -1;
+    }
+
+    if (trace_file)
+    {
+        if (trace_init(trace_file, 0))
+        {
+            close(app.fd);
+            return -1;
+        }
+        key_trace = 1;
+    }
 
-    if (2 != argc)
+    if (ev_loop_init(&loop))
     {
-		printf("Usage:\n\t./keyApp /dev/key\n");
-		return -1;
-	}
+        trace_exit();
+        close(app.fd);
+        return -1;
+    }
 
-	fd = open(argv[1], O_RDONLY);
-	if(fd == -1)
+    if (ev_signal_start(&loop, &app.sigint, SIGINT, key_quit) ||
+        ev_signal_start(&loop, &app.sigterm, SIGTERM, key_quit))
     {
-		fprintf(stderr, "ERROR: %s file open failed!\n", argv[1]);
-		return -1;
-	}
+        goto out;
+    }
 
-	while (1)
+    if (counter)
     {
-		read(fd, &key_val, sizeof(int));
-		if (0 == key_val)
+        ev_timer_init(&app.counter_timer, key_counter);
+        app.counter_timer.data = &app;
+        ev_timer_start(&loop, &app.counter_timer, 0, 1000);
+    }
+    else
+    {
+        /* 驱动没有poll，事件经eventfd通知，空闲时进程不占CPU */
+        app.efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (app.efd == -1)
+        {
+            fprintf(stderr, "Error: eventfd() failed, errno=%d!\n", errno);
+            goto out;
+        }
+
+        if (ioctl(app.fd, KEY_IOC_SET_EVENTFD, &app.efd))
         {
-            printf("Key Press\n");
+            perror("ioctl KEY_IOC_SET_EVENTFD error!");
+            goto out;
         }
-		else if (1 == key_val)
+
+        ev_io_init(&app.efd_io, app.efd, EPOLLIN, key_events, &app.efd_count, sizeof(app.efd_count));
+        app.efd_io.data = &app;
+        if (ev_io_start(&loop, &app.efd_io))
         {
-            printf("Key Release\n");
+            goto out;
         }
-	}
 
-	close(fd);
+        /* 注册前已入队的事件 */
+        key_events(&loop, &app.efd_io, EPOLLIN);
+    }
 
-	return 0;
-}
+    ret = ev_loop_run(&loop);
 
+out:
+    ev_loop_exit(&loop);
+    trace_exit();
+    if (app.efd != -1)
+    {
+        close(app.efd);
+    }
+    close(app.fd);
+
+    return ret;
+}
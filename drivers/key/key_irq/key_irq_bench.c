@@ -0,0 +1,663 @@
+/**
+ * @file key_irq_bench.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief key_irq.ko throughput/latency benchmark with gpio-sim edge injection.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details key_irq_bench -p <gpio-sim pull attribute> [-d /dev/key] [-t periodic|burst|bounce]
+ *                        [-n groups] [-i interval_us] [-b edges] [-s spacing_us] [-S seed]
+ *                        [-c cpu] [-l label] [-o file]
+ *          The key line is driven by writing "pull-up"/"pull-down" to the gpio-sim line's
+ *          pull attribute (key_irq_bench.sh sets up the chip and loads the driver with gpio=).
+ *          Every interval_us a group of edges is injected:
+ *              periodic    one edge (alternating press/release)
+ *              burst       b edges spaced by spacing_us
+ *              bounce      b edges (odd) spaced by a random 1..spacing_us (seed -S)
+ *          key mode: a group with an odd number of edges is one debounced press or release.
+ *          Latency is measured from the write of the last edge of a group to the read() of its
+ *          event (eventfd wakeup), so it includes the debounce delay (debounce_ms).
+ *          counter mode: delivered = edges counted by the driver.
+ *          One JSON object per run is printed (stdout, or appended to -o file) with the expected
+ *          and delivered events, driver stats (KEY_IOC_GET_STATS), latency percentiles and the
+ *          irq/softirq CPU time from /proc/stat.
+ * @note Runs on x86 (VM) with CONFIG_GPIO_SIM, also builds for the board.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+
+#include "key_irq.h"
+
+#define BENCH_DEV               "/dev/key"
+#define BENCH_EVENT_MASK        "/sys/class/key/key/event_mask"
+#define BENCH_PARAM_DIR         "/sys/module/key_irq"
+#define BENCH_SPIN_NS           100000      /* 离目标时间不足100us时忙等 */
+
+enum bench_train {
+    TRAIN_PERIODIC = 0,
+    TRAIN_BURST,
+    TRAIN_BOUNCE,
+};
+
+static const char *train_names[] = { "periodic", "burst", "bounce" };
+
+struct bench_event {
+    uint64_t t;                 /* read()返回的时间 */
+    int event;
+};
+
+struct bench {
+    int fd;                     /* /dev/key */
+    int pull_fd;                /* gpio-sim pull属性 */
+    int efd;
+    int level;                  /* 当前注入的电平，1: 松开 */
+    int counter;                /* counter/quadrature模式 */
+    enum bench_train train;
+    unsigned int groups;
+    unsigned int edges;         /* 每组边沿数 */
+    unsigned int interval_us;
+    unsigned int spacing_us;
+    unsigned int seed;
+    unsigned int debounce_ms;
+    uint64_t *t_last;           /* 各组最后一个边沿的写入时间 */
+    int *level_last;            /* 各组结束后的电平 */
+    struct bench_event *events;
+    unsigned int nr_events;
+    unsigned int max_events;
+    volatile int stop;
+};
+
+struct bench_cpu {
+    unsigned long long irq;     /* /proc/stat，USER_HZ */
+    unsigned long long softirq;
+    struct rusage self;
+};
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* 睡到目标时间附近，最后一段忙等，微秒级间隔也能保持 */
+static void bench_wait_until(uint64_t t)
+{
+    struct timespec ts;
+    uint64_t now = bench_now_ns();
+
+    if (t > now + BENCH_SPIN_NS)
+    {
+        t -= BENCH_SPIN_NS;
+        ts.tv_sec = t / 1000000000ULL;
+        ts.tv_nsec = t % 1000000000ULL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        {
+            ;
+        }
+        t += BENCH_SPIN_NS;
+    }
+
+    while (bench_now_ns() < t)
+    {
+        ;
+    }
+}
+
+static int bench_read_file(const char *path, char *buf, size_t size)
+{
+    ssize_t n = 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    buf[0] = '\0';
+    if (fd == -1)
+    {
+        return -1;
+    }
+
+    n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0)
+    {
+        return -1;
+    }
+
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+
+    return 0;
+}
+
+static int bench_write_file(const char *path, const char *text)
+{
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    int ret = 0;
+
+    if (fd == -1)
+    {
+        return -1;
+    }
+
+    if (write(fd, text, strlen(text)) != (ssize_t)strlen(text))
+    {
+        ret = -1;
+    }
+    close(fd);
+
+    return ret;
+}
+
+/* 注入一个边沿，返回写入前的时间 */
+static uint64_t bench_edge(struct bench *b)
+{
+    const char *pull = NULL;
+    uint64_t t = 0;
+
+    b->level = !b->level;
+    pull = b->level ? "pull-up" : "pull-down";
+
+    t = bench_now_ns();
+    if (pwrite(b->pull_fd, pull, strlen(pull), 0) < 0)
+    {
+        fprintf(stderr, "Error: pwrite() pull failed, errno=%d!\n", errno);
+    }
+
+    return t;
+}
+
+static void bench_cpu_read(struct bench_cpu *cpu)
+{
+    unsigned long long user = 0, nice = 0, sys = 0, idle = 0, iowait = 0;
+    FILE *fp = fopen("/proc/stat", "r");
+
+    cpu->irq = cpu->softirq = 0;
+    if (fp)
+    {
+        if (fscanf(fp, "cpu %llu %llu %llu %llu %llu %llu %llu",
+                   &user, &nice, &sys, &idle, &iowait, &cpu->irq, &cpu->softirq) != 7)
+        {
+            cpu->irq = cpu->softirq = 0;
+        }
+        fclose(fp);
+    }
+
+    getrusage(RUSAGE_SELF, &cpu->self);
+}
+
+/* 接收线程：eventfd唤醒后读空按键队列，记录每个事件的时间 */
+static void *bench_receiver(void *arg)
+{
+    struct bench *b = arg;
+    uint64_t count = 0;
+    uint64_t t = 0;
+    int event = 0;
+
+    while (!b->stop)
+    {
+        if (read(b->efd, &count, sizeof(count)) != sizeof(count))
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        t = bench_now_ns();
+        while (1)
+        {
+            event = KEY_KEEP;
+            if (read(b->fd, &event, sizeof(event)) < 0 || event == KEY_KEEP)
+            {
+                break;
+            }
+            if (b->nr_events < b->max_events)
+            {
+                b->events[b->nr_events].t = t;
+                b->events[b->nr_events].event = event;
+                b->nr_events++;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* 注入全部边沿组，返回开始时间 */
+static uint64_t bench_inject(struct bench *b, uint64_t *t_end)
+{
+    uint64_t start = bench_now_ns() + 10000000ULL;
+    uint64_t t_group = 0;
+    uint64_t t = 0;
+    unsigned int g = 0;
+    unsigned int i = 0;
+    unsigned int spacing = 0;
+
+    srand(b->seed);
+
+    for (g = 0; g < b->groups; g++)
+    {
+        t_group = start + (uint64_t)g * b->interval_us * 1000ULL;
+        bench_wait_until(t_group);
+        t = t_group;
+
+        for (i = 0; i < b->edges; i++)
+        {
+            if (i)
+            {
+                spacing = b->spacing_us;
+                if (TRAIN_BOUNCE == b->train && b->spacing_us > 1)
+                {
+                    spacing = 1 + rand() % b->spacing_us;
+                }
+                t += (uint64_t)spacing * 1000ULL;
+                bench_wait_until(t);
+            }
+            b->t_last[g] = bench_edge(b);
+        }
+        b->level_last[g] = b->level;
+    }
+
+    *t_end = bench_now_ns();
+
+    return start;
+}
+
+static int bench_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static double bench_pct(const uint64_t *v, unsigned int n, unsigned int per_mille)
+{
+    unsigned int i = 0;
+
+    if (!n)
+    {
+        return 0;
+    }
+
+    i = (unsigned long long)(n - 1) * per_mille / 1000;
+
+    return v[i] / 1000.0;
+}
+
+/*
+ * 事件与边沿组按时间匹配：事件属于写入时间不晚于它的最后一组，且类型与该组结束后的电平一致。
+ * 返回匹配数，lat为各匹配的延迟(ns)。
+ */
+static unsigned int bench_match(struct bench *b, uint64_t *lat)
+{
+    unsigned int matched = 0;
+    unsigned int g = 0;
+    unsigned int e = 0;
+    int used = -1;
+    int level = 0;
+
+    for (e = 0; e < b->nr_events; e++)
+    {
+        if (KEY_PRESS != b->events[e].event && KEY_RELEASE != b->events[e].event)
+        {
+            continue;
+        }
+
+        while (g + 1 < b->groups && b->t_last[g + 1] <= b->events[e].t)
+        {
+            g++;
+        }
+        if (b->t_last[g] > b->events[e].t || (int)g == used)
+        {
+            continue;
+        }
+
+        level = (KEY_RELEASE == b->events[e].event);
+        if (level == b->level_last[g])
+        {
+            lat[matched++] = b->events[e].t - b->t_last[g];
+            used = g;
+        }
+    }
+
+    return matched;
+}
+
+static void bench_usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s -p <gpio-sim pull attribute> [-d dev] [-t periodic|burst|bounce]\n"
+            "\t[-n groups] [-i interval_us] [-b edges] [-s spacing_us] [-S seed] [-c cpu]\n"
+            "\t[-l label] [-o file]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench b;
+    struct bench_cpu cpu0;
+    struct bench_cpu cpu1;
+    struct key_stats stats;
+    struct key_counter cnt;
+    struct utsname uts;
+    pthread_t receiver;
+    const char *dev = BENCH_DEV;
+    const char *pull = NULL;
+    const char *label = "";
+    const char *out_path = NULL;
+    char old_mask[32] = "";
+    char version[64] = "";
+    char srcversion[64] = "";
+    char text[32];
+    uint64_t *lat = NULL;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    uint64_t expected = 0;
+    uint64_t delivered = 0;
+    uint64_t got = 0;
+    unsigned int matched = 0;
+    unsigned int i = 0;
+    long hz = sysconf(_SC_CLK_TCK);
+    double lat_sum = 0;
+    double cpu_self_ms = 0;
+    cpu_set_t set;
+    FILE *out = stdout;
+    int event = 0;
+    int cpu = -1;
+    int ret = -1;
+    int opt = 0;
+
+    memset(&b, 0, sizeof(b));
+    b.fd = b.pull_fd = b.efd = -1;
+    b.train = TRAIN_PERIODIC;
+    b.groups = 200;
+    b.interval_us = 50000;
+    b.spacing_us = 100;
+    b.seed = 1;
+    b.debounce_ms = 15;
+
+    while ((opt = getopt(argc, argv, "d:p:t:n:i:b:s:S:c:l:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            dev = optarg;
+            break;
+        case 'p':
+            pull = optarg;
+            break;
+        case 't':
+            for (i = 0; i < sizeof(train_names) / sizeof(train_names[0]); i++)
+            {
+                if (!strcmp(optarg, train_names[i]))
+                {
+                    break;
+                }
+            }
+            if (i == sizeof(train_names) / sizeof(train_names[0]))
+            {
+                bench_usage(argv[0]);
+                return -1;
+            }
+            b.train = i;
+            break;
+        case 'n':
+            b.groups = strtoul(optarg, NULL, 0);
+            break;
+        case 'i':
+            b.interval_us = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            b.edges = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            b.spacing_us = strtoul(optarg, NULL, 0);
+            break;
+        case 'S':
+            b.seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            cpu = strtol(optarg, NULL, 0);
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        default:
+            bench_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (!b.edges)
+    {
+        b.edges = TRAIN_PERIODIC == b.train ? 1 : TRAIN_BURST == b.train ? 5 : 7;
+    }
+    if (!pull || !b.groups || (TRAIN_PERIODIC == b.train && b.edges != 1))
+    {
+        bench_usage(argv[0]);
+        return -1;
+    }
+
+    b.fd = open(dev, O_RDONLY | O_CLOEXEC);
+    if (b.fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", dev, errno);
+        return -1;
+    }
+
+    b.pull_fd = open(pull, O_WRONLY | O_CLOEXEC);
+    if (b.pull_fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", pull, errno);
+        goto out;
+    }
+
+    /* 计数快照只在counter/quadrature模式下有效 */
+    b.counter = !ioctl(b.fd, KEY_IOC_GET_COUNTER, &cnt);
+    if (!b.counter && !(b.edges & 1))
+    {
+        fprintf(stderr, "Error: key mode needs an odd number of edges per group!\n");
+        goto out;
+    }
+
+    if (!bench_read_file(BENCH_PARAM_DIR "/parameters/debounce_ms", text, sizeof(text)))
+    {
+        b.debounce_ms = strtoul(text, NULL, 0);
+    }
+    bench_read_file(BENCH_PARAM_DIR "/version", version, sizeof(version));
+    bench_read_file(BENCH_PARAM_DIR "/srcversion", srcversion, sizeof(srcversion));
+    uname(&uts);
+
+    b.max_events = b.groups * 2 + 64;
+    b.t_last = calloc(b.groups, sizeof(*b.t_last));
+    b.level_last = calloc(b.groups, sizeof(*b.level_last));
+    b.events = calloc(b.max_events, sizeof(*b.events));
+    lat = calloc(b.groups, sizeof(*lat));
+    if (!b.t_last || !b.level_last || !b.events || !lat)
+    {
+        fprintf(stderr, "Error: out of memory!\n");
+        goto out;
+    }
+
+    /* 只关心按下/松开，手势事件不计入 */
+    if (!b.counter)
+    {
+        bench_read_file(BENCH_EVENT_MASK, old_mask, sizeof(old_mask));
+        snprintf(text, sizeof(text), "0x%x", KEY_EVENT_MASK_EDGE);
+        if (bench_write_file(BENCH_EVENT_MASK, text))
+        {
+            fprintf(stderr, "Error: failed to write <%s>, errno=%d!\n", BENCH_EVENT_MASK, errno);
+            goto out;
+        }
+    }
+
+    if (cpu >= 0)
+    {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set))
+        {
+            fprintf(stderr, "Error: sched_setaffinity() failed, errno=%d!\n", errno);
+        }
+    }
+
+    /* 松开状态开始，等消抖结束后清空队列和统计 */
+    b.level = 0;
+    bench_edge(&b);
+    usleep((b.debounce_ms * 3 + 100) * 1000);
+    do
+    {
+        event = KEY_KEEP;
+    } while (read(b.fd, &event, sizeof(event)) >= 0 && event != KEY_KEEP);
+
+    b.efd = eventfd(0, EFD_CLOEXEC);
+    if (b.efd == -1 || (!b.counter && ioctl(b.fd, KEY_IOC_SET_EVENTFD, &b.efd)))
+    {
+        fprintf(stderr, "Error: eventfd setup failed, errno=%d!\n", errno);
+        goto out;
+    }
+
+    ioctl(b.fd, KEY_IOC_CLEAR_STATS);
+    if (b.counter)
+    {
+        ioctl(b.fd, KEY_IOC_CLEAR_COUNTER);
+    }
+
+    if (pthread_create(&receiver, NULL, bench_receiver, &b))
+    {
+        fprintf(stderr, "Error: pthread_create() failed!\n");
+        goto out;
+    }
+
+    bench_cpu_read(&cpu0);
+    start = bench_inject(&b, &end);
+    usleep((b.debounce_ms * 3 + 100) * 1000);
+    bench_cpu_read(&cpu1);
+
+    b.stop = 1;
+    eventfd_write(b.efd, 1);
+    pthread_join(receiver, NULL);
+
+    if (ioctl(b.fd, KEY_IOC_GET_STATS, &stats))
+    {
+        fprintf(stderr, "Error: KEY_IOC_GET_STATS failed (old driver?), errno=%d!\n", errno);
+        goto out;
+    }
+
+    if (b.counter)
+    {
+        ioctl(b.fd, KEY_IOC_GET_COUNTER, &cnt);
+        expected = (uint64_t)b.groups * b.edges;
+        delivered = got = cnt.edges;
+        if (cnt.last_edge_ns > b.t_last[b.groups - 1])
+        {
+            lat[matched++] = cnt.last_edge_ns - b.t_last[b.groups - 1];
+        }
+    }
+    else
+    {
+        expected = b.groups;
+        delivered = b.nr_events;
+        matched = bench_match(&b, lat);
+        got = matched;
+    }
+
+    qsort(lat, matched, sizeof(*lat), bench_cmp_u64);
+    for (i = 0; i < matched; i++)
+    {
+        lat_sum += lat[i];
+    }
+
+    cpu_self_ms = (cpu1.self.ru_utime.tv_sec - cpu0.self.ru_utime.tv_sec +
+                   cpu1.self.ru_stime.tv_sec - cpu0.self.ru_stime.tv_sec) * 1000.0 +
+                  (cpu1.self.ru_utime.tv_usec - cpu0.self.ru_utime.tv_usec +
+                   cpu1.self.ru_stime.tv_usec - cpu0.self.ru_stime.tv_usec) / 1000.0;
+
+    if (out_path)
+    {
+        out = fopen(out_path, "a");
+        if (!out)
+        {
+            fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", out_path, errno);
+            goto out;
+        }
+    }
+
+    fprintf(out, "{\"bench\": \"key_irq\", \"label\": \"%s\", \"kernel\": \"%s\", \"machine\": \"%s\", "
+            "\"driver_version\": \"%s\", \"srcversion\": \"%s\", ",
+            label, uts.release, uts.machine, version, srcversion);
+    fprintf(out, "\"mode\": \"%s\", \"train\": \"%s\", \"groups\": %u, \"edges_per_group\": %u, "
+            "\"interval_us\": %u, \"spacing_us\": %u, \"seed\": %u, \"debounce_ms\": %u, ",
+            b.counter ? "counter" : "key", train_names[b.train], b.groups, b.edges,
+            b.interval_us, b.spacing_us, b.seed, b.debounce_ms);
+    fprintf(out, "\"duration_s\": %.6f, \"edges\": %llu, \"edge_rate\": %.1f, ",
+            (end - start) / 1e9, (unsigned long long)b.groups * b.edges,
+            end > start ? (double)b.groups * b.edges * 1e9 / (end - start) : 0.0);
+    fprintf(out, "\"expected\": %llu, \"delivered\": %llu, \"matched\": %llu, \"lost\": %lld, ",
+            (unsigned long long)expected, (unsigned long long)delivered, (unsigned long long)got,
+            (long long)expected - (long long)got);
+    fprintf(out, "\"driver\": {\"irqs\": %llu, \"debounces\": %llu, \"events\": %llu, \"dropped\": %llu, "
+            "\"irq_ns_avg\": %llu, \"irq_ns_max\": %llu, \"bh_ns_avg\": %llu, \"bh_ns_max\": %llu}, ",
+            (unsigned long long)stats.irqs, (unsigned long long)stats.debounces,
+            (unsigned long long)stats.events, (unsigned long long)stats.dropped,
+            (unsigned long long)(stats.irqs ? stats.irq_ns / stats.irqs : 0),
+            (unsigned long long)stats.irq_ns_max,
+            (unsigned long long)(stats.debounces ? stats.bh_ns / stats.debounces : 0),
+            (unsigned long long)stats.bh_ns_max);
+    fprintf(out, "\"latency_us\": {\"samples\": %u, \"min\": %.1f, \"mean\": %.1f, \"p50\": %.1f, "
+            "\"p90\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f}, ",
+            matched, bench_pct(lat, matched, 0), matched ? lat_sum / matched / 1000.0 : 0.0,
+            bench_pct(lat, matched, 500), bench_pct(lat, matched, 900), bench_pct(lat, matched, 990),
+            bench_pct(lat, matched, 999), bench_pct(lat, matched, 1000));
+    fprintf(out, "\"cpu_ms\": {\"irq\": %.1f, \"softirq\": %.1f, \"driver_irq\": %.3f, \"driver_bh\": %.3f, "
+            "\"bench\": %.1f}}\n",
+            (cpu1.irq - cpu0.irq) * 1000.0 / hz, (cpu1.softirq - cpu0.softirq) * 1000.0 / hz,
+            stats.irq_ns / 1e6, stats.bh_ns / 1e6, cpu_self_ms);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    ret = 0;
+
+out:
+    if (old_mask[0])
+    {
+        bench_write_file(BENCH_EVENT_MASK, old_mask);
+    }
+    if (b.efd != -1)
+    {
+        close(b.efd);
+    }
+    if (b.pull_fd != -1)
+    {
+        close(b.pull_fd);
+    }
+    close(b.fd);
+    free(b.t_last);
+    free(b.level_last);
+    free(b.events);
+    free(lat);
+
+    return ret;
+}
@@ -0,0 +1,138 @@
+###############################################################################
+# @file key_irq_bench.sh
+# @author panxingyuan (panxingyuan1@163.com)
+# @brief key_irq.ko benchmark suite on a gpio-sim line (x86 VM).
+# @version 0.1
+# @date 2026-10-18
+#       Create this file.
+# @copyright Copyright (c) 2026
+# @details key_irq_bench.sh [-o result.jsonl] [-l label]
+#          Needs root, CONFIG_GPIO_SIM, configfs, and key_irq.ko/key_irq_bench built in this
+#          directory (make KERN_DIR=/lib/modules/`uname -r`/build ARCH=x86 CROSS_COMPILE=; make bench).
+#          Creates a one-line gpio-sim chip, loads key_irq.ko on it (key mode, then counter mode),
+#          runs the edge trains below and appends one JSON object per run to the result file.
+#          Compare two driver versions by running it with each and diffing the files.
+#          Finally loads and unloads the driver RELOADS times while edges keep arriving (irq,
+#          debounce timer and gesture timer all active at rmmod) and fails on a kernel
+#          BUG/Oops/WARNING logged meanwhile.
+###############################################################################
+
+#!/bin/sh
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+OUT=key_irq_bench.jsonl
+LABEL=$(date +%Y%m%d-%H%M%S)
+SIM=/sys/kernel/config/gpio-sim/key_bench
+RELOADS=20
+LOAD=
+
+while getopts "o:l:" opt; do
+    case $opt in
+    o) OUT=$OPTARG ;;
+    l) LABEL=$OPTARG ;;
+    *) echo "Usage: $0 [-o result.jsonl] [-l label]"; exit 1 ;;
+    esac
+done
+
+cleanup()
+{
+    [ -n "$LOAD" ] && kill $LOAD 2>/dev/null
+    rmmod key_irq 2>/dev/null
+    if [ -d $SIM ]; then
+        echo 0 > $SIM/live
+        rmdir $SIM/bank0 $SIM 2>/dev/null
+    fi
+}
+
+die()
+{
+    echo "Error: $*" >&2
+    cleanup
+    exit 1
+}
+
+[ "$(id -u)" = 0 ] || die "must run as root"
+[ -f $DIR/key_irq.ko ] && [ -x $DIR/key_irq_bench ] || die "build key_irq.ko and key_irq_bench first"
+
+modprobe gpio-sim 2>/dev/null
+mountpoint -q /sys/kernel/config || mount -t configfs none /sys/kernel/config
+[ -d /sys/kernel/config/gpio-sim ] || die "no gpio-sim (CONFIG_GPIO_SIM)"
+
+# 一个GPIO的模拟芯片，line0即按键
+cleanup
+mkdir $SIM $SIM/bank0 || die "mkdir $SIM failed"
+echo 1 > $SIM/bank0/num_lines
+echo key_bench > $SIM/bank0/label
+echo 1 > $SIM/live || die "gpio-sim live failed"
+
+CHIP=$(cat $SIM/bank0/chip_name)
+PULL=/sys/devices/platform/$(cat $SIM/dev_name)/$CHIP/sim_gpio0/pull
+[ -f $PULL ] || die "no $PULL"
+echo pull-up > $PULL
+
+# 全局GPIO编号：sysfs gpio类，或debugfs
+BASE=
+for c in /sys/class/gpio/gpiochip*; do
+    [ "$(cat $c/label 2>/dev/null)" = key_bench ] && BASE=$(cat $c/base)
+done
+if [ -z "$BASE" ]; then
+    mountpoint -q /sys/kernel/debug || mount -t debugfs none /sys/kernel/debug
+    BASE=$(sed -n "s/^$CHIP: GPIOs \([0-9]*\)-.*/\1/p" /sys/kernel/debug/gpio)
+fi
+[ -n "$BASE" ] || die "gpio base of $CHIP not found"
+
+run()
+{
+    echo "$*" >&2
+    $DIR/key_irq_bench -p $PULL -l "$LABEL" -o "$OUT" "$@" || die "key_irq_bench $* failed"
+}
+
+# key模式：消抖后的按下/松开
+insmod $DIR/key_irq.ko gpio=$BASE mode=key debounce_ms=15 || die "insmod key mode failed"
+run -t periodic -n 200 -i 50000
+run -t burst -n 100 -b 5 -s 200 -i 60000
+run -t bounce -n 100 -b 7 -s 2000 -i 80000 -S 1
+run -t periodic -n 500 -i 5000
+echo 5 > /sys/module/key_irq/parameters/debounce_ms
+run -t periodic -n 200 -i 20000
+run -t bounce -n 100 -b 7 -s 500 -i 20000 -S 1
+rmmod key_irq
+
+# counter模式：每个边沿都进中断，测吞吐
+insmod $DIR/key_irq.ko gpio=$BASE mode=counter || die "insmod counter mode failed"
+for i in 1000 200 50 20 10; do
+    run -t periodic -n $((1000000 / i)) -i $i
+done
+run -t burst -n 50 -b 1000 -s 2 -i 20000
+rmmod key_irq
+
+# 负载下反复加载/卸载：长按后快速自动重复，卸载时中断、消抖定时器、手势定时器都在运行
+echo "insmod/rmmod under load x$RELOADS" >&2
+DMESG_LINES=$(dmesg | wc -l)
+(
+    while :; do
+        echo pull-down > $PULL
+        sleep 0.2
+        for j in 1 2 3 4 5; do
+            echo pull-up > $PULL
+            echo pull-down > $PULL
+        done
+        echo pull-up > $PULL
+        sleep 0.05
+    done
+) &
+LOAD=$!
+for i in $(seq $RELOADS); do
+    insmod $DIR/key_irq.ko gpio=$BASE mode=key debounce_ms=5 || die "insmod under load failed"
+    echo 50 > /sys/class/key/key/long_press_ms
+    echo 2 > /sys/class/key/key/repeat_ms
+    sleep 0.3
+    rmmod key_irq || die "rmmod under load failed"
+done
+kill $LOAD
+wait $LOAD 2>/dev/null
+LOAD=
+dmesg | tail -n +$((DMESG_LINES + 1)) | grep -E "BUG|Oops|WARNING|soft lockup" && die "kernel errors during insmod/rmmod"
+
+cleanup
+echo "results: $OUT"
@@ -0,0 +1,582 @@
+/**
+ * @file key_irq_test.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief key_irq.ko functional test with scripted gpio-sim edges.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details key_irq_test -p <gpio-sim pull attribute> [-P <phase B pull attribute>] [-d /dev/key]
+ *          Same edge injection as key_irq_bench (key_irq_test.sh sets up the chip and loads the
+ *          driver with gpio=), the cases depend on the driver mode:
+ *          key: each case sets the gesture parameters and the event mask through sysfs, plays a
+ *              press/release script and compares the events read from the queue with the
+ *              expected sequence. The script is a list of steps "P<ms>" (press, then hold for
+ *              ms) and "R<ms>" (release, then hold), timed from the start of the case.
+ *          quadrature: -p/-P drive phases A/B. Each case clears the counter, plays an A/B
+ *              script a number of times and checks count, errors and edges of
+ *              KEY_IOC_GET_COUNTER. "A"/"B" toggle one phase and wait until the driver has
+ *              decoded the edge, "X" toggles both back to back (an illegal A/B jump unless the
+ *              driver reads the levels in between, see quad_cases).
+ *          Prints one line per case, returns non-zero if any case failed.
+ * @note Runs on x86 (VM) with CONFIG_GPIO_SIM, also builds for the board.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdint.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+
+#include "key_irq.h"
+
+#define TEST_DEV                "/dev/key"
+#define TEST_SYSFS_DIR          "/sys/class/key/key"
+#define TEST_PARAM_DIR          "/sys/module/key_irq"
+#define TEST_SPIN_NS            100000      /* 离目标时间不足100us时忙等 */
+#define TEST_MAX_EVENTS         32
+#define TEST_EDGE_TIMEOUT_NS    1000000000ULL
+
+struct gesture_case {
+    const char *name;
+    unsigned int long_press_ms;
+    unsigned int multi_click_ms;
+    unsigned int repeat_ms;
+    unsigned int event_mask;
+    const char *script;
+    const char *expect;
+};
+
+/*
+ * debounce_ms为15时的时序余量均在50ms以上：
+ * 按下/松开在消抖后才进入手势状态机，长按、连击窗口从消抖结束时开始计时。
+ */
+static const struct gesture_case gesture_cases[] = {
+    { "click", 400, 200, 0, KEY_EVENT_MASK_ALL,
+      "P80 R", "PRESS RELEASE CLICK" },
+    { "double_click", 400, 200, 0, KEY_EVENT_MASK_ALL,
+      "P80 R80 P80 R", "PRESS RELEASE PRESS RELEASE DOUBLE_CLICK" },
+    { "multi_click", 400, 200, 0, KEY_EVENT_MASK_ALL,
+      "P80 R80 P80 R80 P80 R", "PRESS RELEASE PRESS RELEASE PRESS RELEASE MULTI_CLICK" },
+    { "slow_clicks", 400, 200, 0, KEY_EVENT_MASK_ALL,
+      "P80 R350 P80 R", "PRESS RELEASE CLICK PRESS RELEASE CLICK" },
+    { "long_press", 400, 200, 0, KEY_EVENT_MASK_ALL,
+      "P600 R", "PRESS LONG_PRESS RELEASE" },
+    { "click_long_press", 400, 200, 0, KEY_EVENT_MASK_ALL,
+      "P80 R80 P600 R", "PRESS RELEASE PRESS LONG_PRESS RELEASE" },
+    { "repeat", 400, 200, 100, KEY_EVENT_MASK_ALL,
+      "P950 R", "PRESS LONG_PRESS REPEAT REPEAT REPEAT REPEAT REPEAT RELEASE" },
+    { "bounce", 400, 200, 0, KEY_EVENT_MASK_ALL,
+      "P1 R1 P1 R1 P80 R1 P1 R1 P1 R", "PRESS RELEASE CLICK" },
+    { "no_multi_click", 400, 0, 0, KEY_EVENT_MASK_ALL,
+      "P80 R80 P80 R", "PRESS RELEASE CLICK PRESS RELEASE CLICK" },
+    { "gesture_mask", 400, 200, 100, KEY_EVENT_MASK_GESTURE,
+      "P80 R80 P80 R400 P550 R", "DOUBLE_CLICK LONG_PRESS REPEAT" },
+};
+
+struct quad_case {
+    const char *name;
+    const char *script;
+    unsigned int repeat;
+    int64_t count;
+    uint64_t errors;
+};
+
+/*
+ * 从A=B=0开始，A超前B为正方向，每个脚本结束时回到A=B=0。
+ * "X"两相背靠背翻转：gpio-sim上驱动在中断线程中读电平，线程在两次写之间运行时
+ * 是两个合法边沿(+2)，否则是一次非法跳变(count不变，errors+1)。
+ * 因此只检查count + 2 * errors不变，且至少出现一次非法跳变。
+ */
+static const struct quad_case quad_cases[] = {
+    { "forward", "ABAB", 100, 400, 0 },
+    { "backward", "BABA", 100, -400, 0 },
+    { "reverse", "ABBA", 100, 0, 0 },
+    { "jitter", "AA", 200, 0, 0 },
+    { "illegal", "X", 200, 0, 200 },
+};
+
+static const char *event_names[] = {
+    "PRESS", "RELEASE", "KEEP", "CLICK", "DOUBLE_CLICK", "MULTI_CLICK", "LONG_PRESS", "REPEAT",
+};
+
+struct test {
+    int fd;                     /* /dev/key */
+    int pull_fd;                /* gpio-sim pull属性 */
+    int pull_fd_b;              /* quadrature模式B相 */
+    int level[2];               /* quadrature模式A、B相电平 */
+    uint64_t edges;             /* quadrature模式已注入的边沿数 */
+    unsigned int debounce_ms;
+};
+
+static uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* 睡到目标时间附近，最后一段忙等 */
+static void test_wait_until(uint64_t t)
+{
+    struct timespec ts;
+    uint64_t now = test_now_ns();
+
+    if (t > now + TEST_SPIN_NS)
+    {
+        t -= TEST_SPIN_NS;
+        ts.tv_sec = t / 1000000000ULL;
+        ts.tv_nsec = t % 1000000000ULL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        {
+            ;
+        }
+        t += TEST_SPIN_NS;
+    }
+
+    while (test_now_ns() < t)
+    {
+        ;
+    }
+}
+
+static int test_read_file(const char *path, char *buf, size_t size)
+{
+    ssize_t n = 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    buf[0] = '\0';
+    if (fd == -1)
+    {
+        return -1;
+    }
+
+    n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0)
+    {
+        return -1;
+    }
+
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+
+    return 0;
+}
+
+static int test_read_attr(const char *name, char *buf, size_t size)
+{
+    char path[128];
+
+    snprintf(path, sizeof(path), TEST_SYSFS_DIR "/%s", name);
+
+    return test_read_file(path, buf, size);
+}
+
+static int test_write_attr(const char *name, unsigned int val)
+{
+    char path[128];
+    char text[32];
+    int fd = -1;
+    int ret = 0;
+
+    snprintf(path, sizeof(path), TEST_SYSFS_DIR "/%s", name);
+    snprintf(text, sizeof(text), "%u", val);
+
+    fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd == -1 || write(fd, text, strlen(text)) != (ssize_t)strlen(text))
+    {
+        fprintf(stderr, "Error: failed to write <%s>, errno=%d!\n", path, errno);
+        ret = -1;
+    }
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return ret;
+}
+
+static void test_level(int fd, int level)
+{
+    const char *pull = level ? "pull-up" : "pull-down";
+
+    if (pwrite(fd, pull, strlen(pull), 0) < 0)
+    {
+        fprintf(stderr, "Error: pwrite() pull failed, errno=%d!\n", errno);
+    }
+}
+
+static void test_drain(struct test *t)
+{
+    int event = 0;
+
+    do
+    {
+        event = KEY_KEEP;
+    } while (read(t->fd, &event, sizeof(event)) >= 0 && event != KEY_KEEP);
+}
+
+/* 按脚本注入边沿，返回最后一步的时间 */
+static int test_play(int fd, const char *script, uint64_t *t_end)
+{
+    const char *p = script;
+    char *end = NULL;
+    uint64_t t = test_now_ns();
+    unsigned long ms = 0;
+    int level = 0;
+
+    while (*p)
+    {
+        if (' ' == *p)
+        {
+            p++;
+            continue;
+        }
+        if ('P' != *p && 'R' != *p)
+        {
+            fprintf(stderr, "Error: bad script step <%s>!\n", p);
+            return -1;
+        }
+
+        level = ('R' == *p);    /* 1: 松开 */
+        ms = strtoul(p + 1, &end, 10);
+        p = end;
+
+        test_wait_until(t);
+        test_level(fd, level);
+        t += ms * 1000000ULL;
+    }
+
+    *t_end = t;
+
+    return 0;
+}
+
+static int test_gesture_case(struct test *t, const struct gesture_case *c)
+{
+    char got[256] = "";
+    uint64_t t_end = 0;
+    size_t len = 0;
+    unsigned int n = 0;
+    unsigned int settle_ms = 0;
+    int event = 0;
+
+    if (test_write_attr("long_press_ms", c->long_press_ms) ||
+        test_write_attr("multi_click_ms", c->multi_click_ms) ||
+        test_write_attr("repeat_ms", c->repeat_ms) ||
+        test_write_attr("event_mask", c->event_mask))
+    {
+        return -1;
+    }
+
+    test_drain(t);
+    if (test_play(t->pull_fd, c->script, &t_end))
+    {
+        return -1;
+    }
+
+    /* 等最后的松开消抖、连击窗口结束 */
+    settle_ms = t->debounce_ms * 3 + c->multi_click_ms + 100;
+    test_wait_until(t_end + settle_ms * 1000000ULL);
+
+    while (n++ < TEST_MAX_EVENTS)
+    {
+        event = KEY_KEEP;
+        if (read(t->fd, &event, sizeof(event)) < 0 || KEY_KEEP == event)
+        {
+            break;
+        }
+
+        len += snprintf(got + len, sizeof(got) - len, "%s%s", len ? " " : "",
+                        event >= 0 && event <= KEY_REPEAT ? event_names[event] : "?");
+        if (len >= sizeof(got))
+        {
+            break;
+        }
+    }
+
+    if (strcmp(got, c->expect))
+    {
+        printf("FAIL gesture %s: script \"%s\"\n\texpected: %s\n\tgot:      %s\n",
+               c->name, c->script, c->expect, got);
+        return -1;
+    }
+
+    printf("ok   gesture %s\n", c->name);
+
+    return 0;
+}
+
+static const char *gesture_attrs[] = {
+    "long_press_ms", "multi_click_ms", "repeat_ms", "event_mask",
+};
+
+static int test_gesture(struct test *t)
+{
+    char old[sizeof(gesture_attrs) / sizeof(gesture_attrs[0])][32];
+    unsigned int i = 0;
+    int failed = 0;
+
+    for (i = 0; i < sizeof(gesture_attrs) / sizeof(gesture_attrs[0]); i++)
+    {
+        if (test_read_attr(gesture_attrs[i], old[i], sizeof(old[i])))
+        {
+            fprintf(stderr, "Error: no <%s/%s>!\n", TEST_SYSFS_DIR, gesture_attrs[i]);
+            return 1;
+        }
+    }
+
+    /* 松开状态开始 */
+    test_level(t->pull_fd, 1);
+    usleep((t->debounce_ms * 3 + 100) * 1000);
+
+    for (i = 0; i < sizeof(gesture_cases) / sizeof(gesture_cases[0]); i++)
+    {
+        if (test_gesture_case(t, &gesture_cases[i]))
+        {
+            failed++;
+        }
+    }
+
+    /* 恢复原来的参数 */
+    for (i = 0; i < sizeof(gesture_attrs) / sizeof(gesture_attrs[0]); i++)
+    {
+        test_write_attr(gesture_attrs[i], strtoul(old[i], NULL, 0));
+    }
+
+    return failed;
+}
+
+/* 等驱动处理完前t->edges个边沿 */
+static int test_wait_edges(struct test *t, struct key_counter *cnt)
+{
+    uint64_t deadline = test_now_ns() + TEST_EDGE_TIMEOUT_NS;
+
+    while (1)
+    {
+        if (ioctl(t->fd, KEY_IOC_GET_COUNTER, cnt))
+        {
+            fprintf(stderr, "Error: KEY_IOC_GET_COUNTER failed, errno=%d!\n", errno);
+            return -1;
+        }
+        if (cnt->edges >= t->edges)
+        {
+            return 0;
+        }
+        if (test_now_ns() > deadline)
+        {
+            fprintf(stderr, "Error: driver saw %llu of %llu edges!\n",
+                    (unsigned long long)cnt->edges, (unsigned long long)t->edges);
+            return -1;
+        }
+        usleep(100);
+    }
+}
+
+static void test_toggle(struct test *t, int phase)
+{
+    t->level[phase] = !t->level[phase];
+    test_level(phase ? t->pull_fd_b : t->pull_fd, t->level[phase]);
+    t->edges++;
+}
+
+static int test_quad_case(struct test *t, const struct quad_case *c)
+{
+    struct key_counter cnt;
+    const char *p = NULL;
+    unsigned int i = 0;
+    int ok = 0;
+
+    if (ioctl(t->fd, KEY_IOC_CLEAR_COUNTER))
+    {
+        fprintf(stderr, "Error: KEY_IOC_CLEAR_COUNTER failed, errno=%d!\n", errno);
+        return -1;
+    }
+    t->edges = 0;
+
+    for (i = 0; i < c->repeat; i++)
+    {
+        for (p = c->script; *p; p++)
+        {
+            if ('A' == *p || 'X' == *p)
+            {
+                test_toggle(t, 0);
+            }
+            if ('B' == *p || 'X' == *p)
+            {
+                test_toggle(t, 1);
+            }
+            if (test_wait_edges(t, &cnt))
+            {
+                return -1;
+            }
+        }
+    }
+
+    if (strchr(c->script, 'X'))
+    {
+        ok = cnt.count + 2 * (int64_t)cnt.errors == c->count + 2 * (int64_t)c->errors && cnt.errors;
+    }
+    else
+    {
+        ok = cnt.count == c->count && cnt.errors == c->errors;
+    }
+    ok = ok && cnt.edges == t->edges;
+
+    printf("%s quadrature %s: count %lld errors %llu edges %llu (expected %lld/%llu/%llu)\n",
+           ok ? "ok  " : "FAIL", c->name, (long long)cnt.count, (unsigned long long)cnt.errors,
+           (unsigned long long)cnt.edges, (long long)c->count, (unsigned long long)c->errors,
+           (unsigned long long)t->edges);
+
+    return ok ? 0 : -1;
+}
+
+static int test_quadrature(struct test *t)
+{
+    struct sched_param param;
+    unsigned int i = 0;
+    int failed = 0;
+
+    /* 高于中断线程(SCHED_FIFO 50)，"X"的两次写之间不被同一CPU上的中断线程抢占 */
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    if (sched_setscheduler(0, SCHED_FIFO, &param))
+    {
+        fprintf(stderr, "Error: sched_setscheduler() failed, errno=%d!\n", errno);
+    }
+
+    /* A=B=0开始 */
+    t->level[0] = t->level[1] = 0;
+    test_level(t->pull_fd, 0);
+    test_level(t->pull_fd_b, 0);
+    usleep(10000);
+
+    for (i = 0; i < sizeof(quad_cases) / sizeof(quad_cases[0]); i++)
+    {
+        if (test_quad_case(t, &quad_cases[i]))
+        {
+            failed++;
+        }
+    }
+
+    return failed;
+}
+
+static void test_usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s -p <gpio-sim pull attribute> [-P <phase B pull attribute>] [-d dev]\n",
+            name);
+}
+
+int main(int argc, char *argv[])
+{
+    struct test t;
+    const char *dev = TEST_DEV;
+    const char *pull = NULL;
+    const char *pull_b = NULL;
+    struct key_counter cnt;
+    char text[32];
+    int failed = 0;
+    int ret = -1;
+    int opt = 0;
+
+    memset(&t, 0, sizeof(t));
+    t.fd = t.pull_fd = t.pull_fd_b = -1;
+    t.debounce_ms = 15;
+
+    while ((opt = getopt(argc, argv, "d:p:P:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            dev = optarg;
+            break;
+        case 'p':
+            pull = optarg;
+            break;
+        case 'P':
+            pull_b = optarg;
+            break;
+        default:
+            test_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (!pull)
+    {
+        test_usage(argv[0]);
+        return -1;
+    }
+
+    t.fd = open(dev, O_RDONLY | O_CLOEXEC);
+    if (t.fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", dev, errno);
+        return -1;
+    }
+
+    t.pull_fd = open(pull, O_WRONLY | O_CLOEXEC);
+    if (t.pull_fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", pull, errno);
+        goto out;
+    }
+
+    if (!test_read_file(TEST_PARAM_DIR "/parameters/debounce_ms", text, sizeof(text)))
+    {
+        t.debounce_ms = strtoul(text, NULL, 0);
+    }
+
+    /* 计数快照只在counter/quadrature模式下有效 */
+    if (ioctl(t.fd, KEY_IOC_GET_COUNTER, &cnt))
+    {
+        failed = test_gesture(&t);
+    }
+    else if (KEY_MODE_QUADRATURE == cnt.mode)
+    {
+        if (!pull_b)
+        {
+            test_usage(argv[0]);
+            goto out;
+        }
+        t.pull_fd_b = open(pull_b, O_WRONLY | O_CLOEXEC);
+        if (t.pull_fd_b == -1)
+        {
+            fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", pull_b, errno);
+            goto out;
+        }
+        failed = test_quadrature(&t);
+    }
+    else
+    {
+        fprintf(stderr, "Error: no test cases for counter mode (see key_irq_bench)!\n");
+        goto out;
+    }
+
+    printf("%s: %d failed\n", failed ? "FAILED" : "PASSED", failed);
+    ret = failed ? 1 : 0;
+
+out:
+    if (t.pull_fd_b != -1)
+    {
+        close(t.pull_fd_b);
+    }
+    if (t.pull_fd != -1)
+    {
+        close(t.pull_fd);
+    }
+    close(t.fd);
+
+    return ret;
+}
@@ -0,0 +1,86 @@
+###############################################################################
+# @file key_irq_test.sh
+# @author panxingyuan (panxingyuan1@163.com)
+# @brief key_irq.ko functional test on gpio-sim lines (x86 VM).
+# @version 0.1
+# @date 2026-10-18
+#       Create this file.
+# @copyright Copyright (c) 2026
+# @details key_irq_test.sh
+#          Needs root, CONFIG_GPIO_SIM, configfs, and key_irq.ko/key_irq_test built in this
+#          directory (make KERN_DIR=/lib/modules/`uname -r`/build ARCH=x86 CROSS_COMPILE=; make test).
+#          Creates a two-line gpio-sim chip and runs key_irq_test with key_irq.ko loaded in
+#          key mode on line0 (scripted gestures: click, double/multi click, long press, repeat,
+#          bounce, event mask), then in quadrature mode on line0/line1 (A/B sequences forward,
+#          backward, reversing, illegal jumps; count/errors/edges of KEY_IOC_GET_COUNTER).
+#          Exits non-zero if any case failed.
+###############################################################################
+
+#!/bin/sh
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+SIM=/sys/kernel/config/gpio-sim/key_test
+
+cleanup()
+{
+    rmmod key_irq 2>/dev/null
+    if [ -d $SIM ]; then
+        echo 0 > $SIM/live
+        rmdir $SIM/bank0 $SIM 2>/dev/null
+    fi
+}
+
+die()
+{
+    echo "Error: $*" >&2
+    cleanup
+    exit 1
+}
+
+[ "$(id -u)" = 0 ] || die "must run as root"
+[ -f $DIR/key_irq.ko ] && [ -x $DIR/key_irq_test ] || die "build key_irq.ko and key_irq_test first"
+
+modprobe gpio-sim 2>/dev/null
+mountpoint -q /sys/kernel/config || mount -t configfs none /sys/kernel/config
+[ -d /sys/kernel/config/gpio-sim ] || die "no gpio-sim (CONFIG_GPIO_SIM)"
+
+# 两个GPIO的模拟芯片，line0为按键或A相，line1为B相
+cleanup
+mkdir $SIM $SIM/bank0 || die "mkdir $SIM failed"
+echo 2 > $SIM/bank0/num_lines
+echo key_test > $SIM/bank0/label
+echo 1 > $SIM/live || die "gpio-sim live failed"
+
+CHIP=$(cat $SIM/bank0/chip_name)
+LINES=/sys/devices/platform/$(cat $SIM/dev_name)/$CHIP
+[ -f $LINES/sim_gpio0/pull ] && [ -f $LINES/sim_gpio1/pull ] || die "no $LINES/sim_gpio*/pull"
+echo pull-up > $LINES/sim_gpio0/pull
+
+# 全局GPIO编号：sysfs gpio类，或debugfs
+BASE=
+for c in /sys/class/gpio/gpiochip*; do
+    [ "$(cat $c/label 2>/dev/null)" = key_test ] && BASE=$(cat $c/base)
+done
+if [ -z "$BASE" ]; then
+    mountpoint -q /sys/kernel/debug || mount -t debugfs none /sys/kernel/debug
+    BASE=$(sed -n "s/^$CHIP: GPIOs \([0-9]*\)-.*/\1/p" /sys/kernel/debug/gpio)
+fi
+[ -n "$BASE" ] || die "gpio base of $CHIP not found"
+
+FAILED=0
+
+# key模式：手势识别
+insmod $DIR/key_irq.ko gpio=$BASE mode=key debounce_ms=15 || die "insmod key mode failed"
+$DIR/key_irq_test -p $LINES/sim_gpio0/pull || FAILED=1
+rmmod key_irq
+
+# quadrature模式：A=B=0开始
+echo pull-down > $LINES/sim_gpio0/pull
+echo pull-down > $LINES/sim_gpio1/pull
+insmod $DIR/key_irq.ko gpio=$BASE gpio_b=$((BASE + 1)) mode=quadrature || die "insmod quadrature mode failed"
+$DIR/key_irq_test -p $LINES/sim_gpio0/pull -P $LINES/sim_gpio1/pull || FAILED=1
+rmmod key_irq
+
+cleanup
+[ $FAILED = 0 ] && echo "key_irq_test: PASSED" || echo "key_irq_test: FAILED"
+exit $FAILED
@@ -0,0 +1,509 @@
+/**
+ * @file led_class.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Led class driver with kernel triggers.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       LINUX_VERSION_CODE compat (timer_setup, int activate, of_get_named_gpio_flags removal),
+ *       module parameters gpio/active_low/trigger for gpio-sim, sleeping GPIOs through
+ *       brightness_set_blocking, led_class_test.sh.
+ * @copyright Copyright (c) 2026
+ * @details 设备树中的LED注册为led_classdev，闪烁由内核触发器(定时器)完成，无需用户进程：
+ *          - timer/oneshot/heartbeat: 内核自带触发器(CONFIG_LEDS_TRIGGER_*)
+ *          - pattern: 本模块提供，按"亮度 毫秒"序列循环输出
+ *          用法：
+ *              echo timer > /sys/class/leds/ps_led0/trigger
+ *              echo pattern > /sys/class/leds/ps_led0/trigger
+ *              echo "1 100 0 100 1 100 0 700" > /sys/class/leds/ps_led0/pattern
+ *              echo -1 > /sys/class/leds/ps_led0/repeat
+ *          不使用设备树时由模块参数指定，如x86上的gpio-sim(见led_class_test.sh)：
+ *              insmod led_class.ko gpio=512 trigger=none
+ * @note HW:
+ *          - zynq 7020(正点原子领航者开发板)
+ *          - led: 核心板LED2(MIO0)
+ *       OS: linux-xlnx-xilinx-v14.5 + ipipe-core-3.8-arm-1.patch + xenomai-2.6.3
+ *       Toolchain: arm-xilinx-linux-gnueabi-gcc (Sourcery CodeBench Lite 2012.09-104) 4.7.2
+ *                  (需安装Xilinx SDK 2013.1)
+ */
+
+#include <linux/types.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/errno.h>
+#include <linux/gpio.h>
+#include <linux/of.h>
+#include <linux/of_gpio.h>
+#include <linux/leds.h>
+#include <linux/timer.h>
+#include <linux/slab.h>
+#include <linux/device.h>
+#include <linux/spinlock.h>
+#include <linux/version.h>
+#include <linux/moduleparam.h>
+
+#define LED_NAME			"ps_led0"	/* 缺省名字 */
+#define LED_PATTERN_MAX		16			/* pattern最大步数 */
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 16, 0)
+#define led_from_timer(var, t, field)	timer_container_of(var, t, field)
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+#define led_from_timer(var, t, field)	from_timer(var, t, field)
+#endif
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 2, 0)
+#define led_timer_delete_sync(t)	timer_delete_sync(t)
+#else
+#define led_timer_delete_sync(t)	del_timer_sync(t)
+#endif
+
+/*
+ * 不使用设备树时由模块参数指定，如x86上的gpio-sim：
+ *     insmod led_class.ko gpio=512 active_low=0 trigger=pattern
+ */
+static int gpio = -1;
+module_param(gpio, int, 0444);
+MODULE_PARM_DESC(gpio, "Led GPIO number, -1: led-gpio of the /led device tree node");
+
+static bool active_low;
+module_param(active_low, bool, 0444);
+MODULE_PARM_DESC(active_low, "Led on at low level (with gpio=)");
+
+static char *trigger;
+module_param(trigger, charp, 0444);
+MODULE_PARM_DESC(trigger, "Default trigger (with gpio=), none if not given");
+
+/* LED设备结构体 */
+struct led_dev {
+	struct led_classdev cdev;	/* led class设备 */
+	int led_gpio;				/* GPIO编号 */
+	int active_low;				/* 低电平点亮 */
+};
+
+static struct led_dev led;
+
+/* pattern触发器的一步 */
+struct led_pattern_step {
+	enum led_brightness brightness;
+	unsigned int delay_ms;
+};
+
+/* pattern触发器，每个LED一份 */
+struct led_pattern_data {
+	struct led_classdev *led_cdev;
+	struct timer_list timer;
+	spinlock_t lock;
+	struct led_pattern_step steps[LED_PATTERN_MAX];
+	int nr_steps;
+	int cur;					/* 下一步 */
+	int repeat;					/* 重复次数，-1表示无限 */
+	int remaining;				/* 剩余次数 */
+};
+
+static void led_brightness_set(struct led_classdev *led_cdev,
+			enum led_brightness value)
+{
+	struct led_dev *dev = container_of(led_cdev, struct led_dev, cdev);
+	int on = (LED_OFF != value);
+
+	gpio_set_value(dev->led_gpio, dev->active_low ? !on : on);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 5, 0)
+/* 可睡眠的GPIO(I2C扩展、gpio-sim)，LED核心在工作队列中调用 */
+static int led_brightness_set_blocking(struct led_classdev *led_cdev,
+			enum led_brightness value)
+{
+	struct led_dev *dev = container_of(led_cdev, struct led_dev, cdev);
+	int on = (LED_OFF != value);
+
+	gpio_set_value_cansleep(dev->led_gpio, dev->active_low ? !on : on);
+
+	return 0;
+}
+#endif
+
+/* 定时器中调用，不能睡眠 */
+static void led_pattern_set(struct led_classdev *led_cdev,
+			enum led_brightness value)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 5, 0)
+	led_set_brightness_nosleep(led_cdev, value);
+#else
+	led_cdev->brightness = value;
+	led_cdev->brightness_set(led_cdev, value);
+#endif
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+static void led_pattern_timer_function(struct timer_list *t)
+#else
+static void led_pattern_timer_function(unsigned long arg)
+#endif
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+	struct led_pattern_data *data = led_from_timer(data, t, timer);
+#else
+	struct led_pattern_data *data = (struct led_pattern_data *)arg;
+#endif
+	struct led_pattern_step step;
+	unsigned long flags;
+
+	spin_lock_irqsave(&data->lock, flags);
+
+	if (!data->nr_steps || !data->remaining)
+	{
+		spin_unlock_irqrestore(&data->lock, flags);
+		return;
+	}
+
+	step = data->steps[data->cur];
+	if (++data->cur >= data->nr_steps)
+	{
+		data->cur = 0;
+		/* 一轮结束 */
+		if (data->remaining > 0)
+			data->remaining--;
+	}
+
+	spin_unlock_irqrestore(&data->lock, flags);
+
+	led_pattern_set(data->led_cdev, step.brightness);
+	mod_timer(&data->timer, jiffies + msecs_to_jiffies(step.delay_ms));
+}
+
+/* 从头开始输出，需持有lock */
+static void led_pattern_restart(struct led_pattern_data *data)
+{
+	data->cur = 0;
+	data->remaining = data->repeat;
+	mod_timer(&data->timer, jiffies);
+}
+
+static ssize_t led_pattern_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct led_classdev *led_cdev = dev_get_drvdata(dev);
+	struct led_pattern_data *data = led_cdev->trigger_data;
+	unsigned long flags;
+	ssize_t len = 0;
+	int i;
+
+	spin_lock_irqsave(&data->lock, flags);
+	for (i = 0; i < data->nr_steps; i++)
+		len += sprintf(buf + len, "%d %u ", data->steps[i].brightness, data->steps[i].delay_ms);
+	spin_unlock_irqrestore(&data->lock, flags);
+
+	len += sprintf(buf + len, "\n");
+
+	return len;
+}
+
+/* 格式："亮度 毫秒 亮度 毫秒 ..."，空串停止输出 */
+static ssize_t led_pattern_store(struct device *dev,
+			struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct led_classdev *led_cdev = dev_get_drvdata(dev);
+	struct led_pattern_data *data = led_cdev->trigger_data;
+	struct led_pattern_step steps[LED_PATTERN_MAX];
+	unsigned int brightness, delay_ms;
+	unsigned long flags;
+	const char *p = buf;
+	int nr_steps = 0;
+	int n;
+
+	while (2 == sscanf(p, "%u %u%n", &brightness, &delay_ms, &n))
+	{
+		if (nr_steps >= LED_PATTERN_MAX || !delay_ms)
+			return -EINVAL;
+
+		steps[nr_steps].brightness = min_t(unsigned int, brightness, led_cdev->max_brightness);
+		steps[nr_steps].delay_ms = delay_ms;
+		nr_steps++;
+		p += n;
+	}
+
+	spin_lock_irqsave(&data->lock, flags);
+	memcpy(data->steps, steps, sizeof(steps[0]) * nr_steps);
+	data->nr_steps = nr_steps;
+	if (nr_steps)
+		led_pattern_restart(data);
+	spin_unlock_irqrestore(&data->lock, flags);
+
+	return count;
+}
+
+static DEVICE_ATTR(pattern, S_IRUGO | S_IWUSR, led_pattern_show, led_pattern_store);
+
+static ssize_t led_repeat_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct led_classdev *led_cdev = dev_get_drvdata(dev);
+	struct led_pattern_data *data = led_cdev->trigger_data;
+
+	return sprintf(buf, "%d\n", data->repeat);
+}
+
+/* -1: 无限循环，N: 输出N轮后停止 */
+static ssize_t led_repeat_store(struct device *dev,
+			struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct led_classdev *led_cdev = dev_get_drvdata(dev);
+	struct led_pattern_data *data = led_cdev->trigger_data;
+	unsigned long flags;
+	int repeat;
+
+	if (kstrtoint(buf, 0, &repeat) || repeat < -1 || !repeat)
+		return -EINVAL;
+
+	spin_lock_irqsave(&data->lock, flags);
+	data->repeat = repeat;
+	if (data->nr_steps)
+		led_pattern_restart(data);
+	spin_unlock_irqrestore(&data->lock, flags);
+
+	return count;
+}
+
+static DEVICE_ATTR(repeat, S_IRUGO | S_IWUSR, led_repeat_show, led_repeat_store);
+
+/* 4.19起activate返回错误码 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+static int led_pattern_activate(struct led_classdev *led_cdev)
+#else
+static void led_pattern_activate(struct led_classdev *led_cdev)
+#endif
+{
+	struct led_pattern_data *data;
+	int ret = -ENOMEM;
+
+	data = kzalloc(sizeof(*data), GFP_KERNEL);
+	if (!data)
+		goto out;
+
+	data->led_cdev = led_cdev;
+	data->repeat = -1;
+	spin_lock_init(&data->lock);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+	timer_setup(&data->timer, led_pattern_timer_function, 0);
+#else
+	setup_timer(&data->timer, led_pattern_timer_function, (unsigned long)data);
+#endif
+
+	led_cdev->trigger_data = data;
+
+	ret = device_create_file(led_cdev->dev, &dev_attr_pattern);
+	if (ret)
+		goto err_free;
+
+	ret = device_create_file(led_cdev->dev, &dev_attr_repeat);
+	if (ret)
+		goto err_pattern;
+
+	goto out;
+
+err_pattern:
+	device_remove_file(led_cdev->dev, &dev_attr_pattern);
+err_free:
+	led_cdev->trigger_data = NULL;
+	kfree(data);
+out:
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+	return ret;
+#else
+	return;
+#endif
+}
+
+static void led_pattern_deactivate(struct led_classdev *led_cdev)
+{
+	struct led_pattern_data *data = led_cdev->trigger_data;
+
+	if (!data)
+		return;
+
+	device_remove_file(led_cdev->dev, &dev_attr_repeat);
+	device_remove_file(led_cdev->dev, &dev_attr_pattern);
+
+	/* 定时器函数会重新启动定时器，先清空pattern */
+	spin_lock_irq(&data->lock);
+	data->nr_steps = 0;
+	spin_unlock_irq(&data->lock);
+	led_timer_delete_sync(&data->timer);
+
+	led_cdev->trigger_data = NULL;
+	kfree(data);
+
+	led_pattern_set(led_cdev, LED_OFF);
+}
+
+static struct led_trigger led_pattern_trigger = {
+	.name		= "pattern",
+	.activate	= led_pattern_activate,
+	.deactivate	= led_pattern_deactivate,
+};
+
+/* 由模块参数gpio、active_low、trigger指定 */
+static int led_parse_param(void)
+{
+	led.led_gpio = gpio;
+	if (!gpio_is_valid(led.led_gpio))
+    {
+		printk(KERN_ERR "led: Invalid gpio %d\n", gpio);
+		return -EINVAL;
+	}
+	led.active_low = active_low;
+
+	led.cdev.name = LED_NAME;
+	led.cdev.default_trigger = trigger;
+	led.cdev.brightness = LED_OFF;
+
+	return 0;
+}
+
+static int led_parse_dt(void)
+{
+	struct device_node *nd;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 2, 0)
+	struct of_phandle_args args;
+#else
+	enum of_gpio_flags flags;
+#endif
+	const char *str;
+	int ret;
+
+	nd = of_find_node_by_path("/led");
+	if (!nd)
+    {
+		printk(KERN_ERR "led: Failed to get led node\n");
+		return -EINVAL;
+	}
+
+	ret = of_property_read_string(nd, "status", &str);
+	if(!ret)
+    {
+		if (strcmp(str, "okay"))
+        {
+            return -EINVAL;
+        }
+	}
+
+	ret = of_property_read_string(nd, "compatible", &str);
+	if (ret)
+    {
+        return ret;
+    }
+
+	if (strcmp(str, "alientek,led"))
+    {
+		printk(KERN_ERR "led: Compatible match failed\n");
+		return -EINVAL;
+	}
+
+	/* 得到LED的GPIO编号及有效电平 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 2, 0)
+	/* of_get_named_gpio_flags()已移除，有效电平直接取第2个cell */
+	led.led_gpio = of_get_named_gpio(nd, "led-gpio", 0);
+	if (!gpio_is_valid(led.led_gpio))
+    {
+		printk(KERN_ERR "led: Failed to get led-gpio\n");
+		return -EINVAL;
+	}
+	led.active_low = 0;
+	if (!of_parse_phandle_with_args(nd, "led-gpio", "#gpio-cells", 0, &args))
+    {
+		if (args.args_count > 1)
+			led.active_low = args.args[1] & OF_GPIO_ACTIVE_LOW;
+		of_node_put(args.np);
+	}
+#else
+	led.led_gpio = of_get_named_gpio_flags(nd, "led-gpio", 0, &flags);
+	if (!gpio_is_valid(led.led_gpio))
+    {
+		printk(KERN_ERR "led: Failed to get led-gpio\n");
+		return -EINVAL;
+	}
+	led.active_low = flags & OF_GPIO_ACTIVE_LOW;
+#endif
+
+	led.cdev.name = LED_NAME;
+	of_property_read_string(nd, "label", &led.cdev.name);
+	led.cdev.default_trigger = NULL;
+	of_property_read_string(nd, "linux,default-trigger", &led.cdev.default_trigger);
+
+	led.cdev.brightness = LED_OFF;
+	if (!of_property_read_string(nd, "default-state", &str) && !strcmp(str, "on"))
+		led.cdev.brightness = LED_FULL;
+
+	return 0;
+}
+
+static int __init myled_init(void)
+{
+	int ret;
+
+	/* 设备树解析，或使用模块参数 */
+	if (gpio >= 0)
+		ret = led_parse_param();
+	else
+		ret = led_parse_dt();
+	if (ret)
+    {
+		return ret;
+    }
+
+	ret = gpio_request(led.led_gpio, "Led Gpio");
+	if (ret)
+    {
+        return ret;
+    }
+
+	ret = gpio_direction_output(led.led_gpio,
+			led.active_low ? LED_OFF == led.cdev.brightness : LED_OFF != led.cdev.brightness);
+	if (ret)
+		goto out1;
+
+	/* 触发器须在LED之前注册，default-trigger才能匹配 */
+	ret = led_trigger_register(&led_pattern_trigger);
+	if (ret)
+		goto out1;
+
+	led.cdev.max_brightness = LED_FULL;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 5, 0)
+	if (gpio_cansleep(led.led_gpio))
+		led.cdev.brightness_set_blocking = led_brightness_set_blocking;
+	else
+		led.cdev.brightness_set = led_brightness_set;
+#else
+	led.cdev.brightness_set = led_brightness_set;
+#endif
+	ret = led_classdev_register(NULL, &led.cdev);
+	if (ret)
+		goto out2;
+
+	return 0;
+
+out2:
+	led_trigger_unregister(&led_pattern_trigger);
+
+out1:
+	gpio_free(led.led_gpio);
+
+	return ret;
+}
+
+static void __exit myled_exit(void)
+{
+	led_classdev_unregister(&led.cdev);
+	led_trigger_unregister(&led_pattern_trigger);
+	gpio_free(led.led_gpio);
+}
+
+module_init(myled_init);
+module_exit(myled_exit);
+
+MODULE_AUTHOR("panxingyuan1@163.com");
+MODULE_DESCRIPTION("Led class drv.");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,142 @@
+###############################################################################
+# @file led_class_test.sh
+# @author panxingyuan (panxingyuan1@163.com)
+# @brief led_class.ko test on a gpio-sim line (x86 VM).
+# @version 0.1
+# @date 2026-10-18
+#       Create this file.
+# @copyright Copyright (c) 2026
+# @details led_class_test.sh
+#          Needs root, CONFIG_GPIO_SIM, configfs, and led_class.ko built in this directory
+#          (make KERN_DIR=/lib/modules/`uname -r`/build ARCH=x86 CROSS_COMPILE=).
+#          Loads led_class.ko on a one-line gpio-sim chip and checks the line level (gpio-sim
+#          sim_gpio0/value) for brightness, the pattern trigger (steps, repeat count, ends off),
+#          the timer trigger if the kernel has it, and active_low. Exit code 0: all passed.
+###############################################################################
+
+#!/bin/sh
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+SIM=/sys/kernel/config/gpio-sim/led_test
+LED=/sys/class/leds/ps_led0
+FAILED=0
+
+cleanup()
+{
+    rmmod led_class 2>/dev/null
+    if [ -d $SIM ]; then
+        echo 0 > $SIM/live
+        rmdir $SIM/bank0 $SIM 2>/dev/null
+    fi
+}
+
+die()
+{
+    echo "Error: $*" >&2
+    cleanup
+    exit 1
+}
+
+check()
+{
+    if [ "$2" = "$3" ]; then
+        echo "ok: $1"
+    else
+        echo "FAILED: $1, expected $3, got $2"
+        FAILED=1
+    fi
+}
+
+# 采样ms毫秒(每10ms)，输出上升沿个数
+rising_edges()
+{
+    n=0
+    last=$(cat $VALUE)
+    i=0
+    while [ $i -lt $(($1 / 10)) ]; do
+        sleep 0.01
+        v=$(cat $VALUE)
+        [ "$last" = 0 ] && [ "$v" = 1 ] && n=$((n + 1))
+        last=$v
+        i=$((i + 1))
+    done
+    echo $n
+}
+
+[ "$(id -u)" = 0 ] || die "must run as root"
+[ -f $DIR/led_class.ko ] || die "build led_class.ko first"
+
+modprobe gpio-sim 2>/dev/null
+mountpoint -q /sys/kernel/config || mount -t configfs none /sys/kernel/config
+[ -d /sys/kernel/config/gpio-sim ] || die "no gpio-sim (CONFIG_GPIO_SIM)"
+
+# 一个GPIO的模拟芯片，line0即LED
+cleanup
+mkdir $SIM $SIM/bank0 || die "mkdir $SIM failed"
+echo 1 > $SIM/bank0/num_lines
+echo led_test > $SIM/bank0/label
+echo 1 > $SIM/live || die "gpio-sim live failed"
+
+CHIP=$(cat $SIM/bank0/chip_name)
+VALUE=/sys/devices/platform/$(cat $SIM/dev_name)/$CHIP/sim_gpio0/value
+[ -f $VALUE ] || die "no $VALUE"
+
+# 全局GPIO编号：sysfs gpio类，或debugfs
+BASE=
+for c in /sys/class/gpio/gpiochip*; do
+    [ "$(cat $c/label 2>/dev/null)" = led_test ] && BASE=$(cat $c/base)
+done
+if [ -z "$BASE" ]; then
+    mountpoint -q /sys/kernel/debug || mount -t debugfs none /sys/kernel/debug
+    BASE=$(sed -n "s/^$CHIP: GPIOs \([0-9]*\)-.*/\1/p" /sys/kernel/debug/gpio)
+fi
+[ -n "$BASE" ] || die "gpio base of $CHIP not found"
+
+# 高电平点亮
+insmod $DIR/led_class.ko gpio=$BASE trigger=none || die "insmod failed"
+[ -d $LED ] || die "no $LED"
+check "initial off" "$(cat $VALUE)" 0
+echo 1 > $LED/brightness
+sleep 0.05
+check "brightness 1" "$(cat $VALUE)" 1
+echo 0 > $LED/brightness
+sleep 0.05
+check "brightness 0" "$(cat $VALUE)" 0
+
+# pattern：3轮"亮100ms 灭100ms"，之后保持最后一步(灭)
+grep -q pattern $LED/trigger || die "no pattern trigger"
+echo pattern > $LED/trigger
+echo 3 > $LED/repeat
+echo "1 100 0 100" > $LED/pattern
+check "pattern 3 rounds" "$(rising_edges 1000)" 3
+check "pattern ends off" "$(cat $VALUE)" 0
+check "pattern readback" "$(cat $LED/pattern | tr -s ' ' | sed 's/ $//')" "1 100 0 100"
+echo -1 > $LED/repeat
+check "pattern repeat -1" "$([ $(rising_edges 1000) -ge 3 ] && echo running)" running
+echo none > $LED/trigger
+sleep 0.05
+check "pattern off" "$(cat $VALUE)" 0
+
+# 内核自带timer触发器(CONFIG_LEDS_TRIGGER_TIMER)
+if grep -q timer $LED/trigger; then
+    echo timer > $LED/trigger
+    echo 50 > $LED/delay_on
+    echo 50 > $LED/delay_off
+    check "timer trigger" "$([ $(rising_edges 1000) -ge 3 ] && echo running)" running
+    echo none > $LED/trigger
+else
+    echo "skip: timer trigger"
+fi
+rmmod led_class
+
+# 低电平点亮
+insmod $DIR/led_class.ko gpio=$BASE active_low=1 trigger=none || die "insmod active_low failed"
+sleep 0.05
+check "active_low off" "$(cat $VALUE)" 1
+echo 1 > $LED/brightness
+sleep 0.05
+check "active_low on" "$(cat $VALUE)" 0
+
+cleanup
+[ $FAILED = 0 ] && echo "all passed"
+exit $FAILED
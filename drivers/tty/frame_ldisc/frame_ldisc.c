@@ -0,0 +1,605 @@
+/**
+ * @file frame_ldisc.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Frame line discipline: SLIP/COBS + CRC decoding in the kernel.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details N_TTY把收到的每一小段数据都交给用户态，高速遥测串口上唤醒次数约等于字节数/FIFO深度。
+ *          本线路规程在receive_buf中完成解帧和CRC校验，只把完整、正确的帧放入队列，
+ *          read()每次返回一帧，poll()只在有完整帧时可读，唤醒次数降为每帧一次。
+ *          使用：先用tcsetattr()设置波特率、raw模式，再ioctl(fd, TIOCSETD, N_FRAME)，
+ *          之后termios ioctl仍由n_tty_ioctl_helper()处理，FIONREAD返回下一帧的长度。
+ *          可以在x86上对pty的从端设置。
+ * @note OS: linux-xlnx-xilinx-v14.5，也可在较新内核(x86)上编译。
+ *       Toolchain: arm-xilinx-linux-gnueabi-gcc (Sourcery CodeBench Lite 2012.09-104) 4.7.2
+ *                  (需安装Xilinx SDK 2013.1)
+ */
+
+#include <linux/types.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/version.h>
+#include <linux/errno.h>
+#include <linux/slab.h>
+#include <linux/sched.h>
+#include <linux/wait.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/tty.h>
+#include <linux/tty_ldisc.h>
+#include <linux/kfifo.h>
+#include <linux/crc-ccitt.h>
+#include <linux/uaccess.h>
+
+#include "frame_ldisc.h"
+
+#define FRAME_NAME		"frame"
+#define FRAME_RAW_MAX	(FRAME_MAX + 2)				/* 帧+CRC */
+#define FRAME_ENC_MAX	(FRAME_RAW_MAX * 2 + 2)		/* SLIP最坏情况，COBS更短 */
+
+/* 接收帧错误标志 */
+#define FRAME_RX_ERROR		0x1		/* 编码错误或UART帧/校验错误 */
+#define FRAME_RX_OVERRUN	0x2		/* 帧超长 */
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 16, 0)
+typedef __poll_t frame_poll_t;
+#else
+typedef unsigned int frame_poll_t;
+#endif
+
+static int mode = FRAME_MODE_SLIP;
+module_param(mode, int, 0644);
+MODULE_PARM_DESC(mode, "Framing for newly attached ttys, 0: SLIP, 1: COBS");
+
+static bool crc = true;
+module_param(crc, bool, 0644);
+MODULE_PARM_DESC(crc, "Append/check CRC-16/CCITT on every frame");
+
+static unsigned int queue_size = 65536;
+module_param(queue_size, uint, 0444);
+MODULE_PARM_DESC(queue_size, "Bytes of complete frames queued per tty (power of 2)");
+
+struct frame_stats {
+	unsigned long frames;		/* 交给用户态的帧 */
+	unsigned long crc_errors;
+	unsigned long errors;		/* 编码错误、UART错误 */
+	unsigned long overruns;		/* 帧超长 */
+	unsigned long dropped;		/* 队列满丢弃 */
+	unsigned long truncated;	/* read()缓冲区不足截断 */
+};
+
+struct frame_ldisc {
+	struct tty_struct *tty;
+	int mode;
+	bool crc;
+
+	/* 解码状态，只在receive_buf中访问 */
+	unsigned char rbuf[FRAME_RAW_MAX];
+	unsigned int rlen;
+	unsigned int rflags;
+	bool slip_esc;
+	unsigned int cobs_code;		/* 当前COBS块的码字，0表示帧开始 */
+	unsigned int cobs_left;		/* 当前COBS块剩余字节 */
+
+	/* 完整帧队列，receive_buf单生产者，read单消费者 */
+	struct kfifo_rec_ptr_2 frames;
+
+	/* 正在读出的帧，read_lock保护，跨多次ldisc read调用时保持加锁 */
+	struct mutex read_lock;
+	unsigned char frame[FRAME_MAX];
+	unsigned int frame_len;
+	unsigned int frame_pos;
+
+	struct mutex write_lock;
+	unsigned char wraw[FRAME_RAW_MAX];
+	unsigned char wbuf[FRAME_ENC_MAX];
+
+	struct frame_stats stats;
+};
+
+/*
+ * 接收
+ */
+static void frame_put(struct frame_ldisc *fl, unsigned char c)
+{
+	if (fl->rlen < FRAME_RAW_MAX)
+		fl->rbuf[fl->rlen++] = c;
+	else
+		fl->rflags |= FRAME_RX_OVERRUN;
+}
+
+static void frame_end(struct frame_ldisc *fl)
+{
+	unsigned int len = fl->rlen;
+	u16 fcs;
+
+	fl->rlen = 0;
+
+	if (fl->rflags) {
+		if (fl->rflags & FRAME_RX_OVERRUN)
+			fl->stats.overruns++;
+		else
+			fl->stats.errors++;
+		fl->rflags = 0;
+		return;
+	}
+
+	/* 空帧：连续的分隔符，用于重新同步 */
+	if (!len)
+		return;
+
+	if (fl->crc) {
+		if (len < 3) {
+			fl->stats.crc_errors++;
+			return;
+		}
+		len -= 2;
+		fcs = fl->rbuf[len] | (fl->rbuf[len + 1] << 8);
+		if (crc_ccitt(0xffff, fl->rbuf, len) != fcs) {
+			fl->stats.crc_errors++;
+			return;
+		}
+	}
+
+	if (len > FRAME_MAX) {
+		fl->stats.overruns++;
+		return;
+	}
+
+	if (!kfifo_in(&fl->frames, fl->rbuf, len)) {
+		fl->stats.dropped++;
+		return;
+	}
+
+	fl->stats.frames++;
+	wake_up_interruptible(&fl->tty->read_wait);
+	kill_fasync(&fl->tty->fasync, SIGIO, POLL_IN);
+}
+
+static void frame_slip_byte(struct frame_ldisc *fl, unsigned char c)
+{
+	if (c == SLIP_END) {
+		if (fl->slip_esc)
+			fl->rflags |= FRAME_RX_ERROR;
+		fl->slip_esc = false;
+		frame_end(fl);
+		return;
+	}
+
+	if (fl->slip_esc) {
+		fl->slip_esc = false;
+		if (c == SLIP_ESC_END)
+			c = SLIP_END;
+		else if (c == SLIP_ESC_ESC)
+			c = SLIP_ESC;
+		else
+			fl->rflags |= FRAME_RX_ERROR;
+	} else if (c == SLIP_ESC) {
+		fl->slip_esc = true;
+		return;
+	}
+
+	frame_put(fl, c);
+}
+
+static void frame_cobs_byte(struct frame_ldisc *fl, unsigned char c)
+{
+	if (!c) {
+		/* 分隔符：最后一个块必须完整 */
+		if (fl->cobs_left)
+			fl->rflags |= FRAME_RX_ERROR;
+		fl->cobs_code = 0;
+		fl->cobs_left = 0;
+		frame_end(fl);
+		return;
+	}
+
+	if (fl->cobs_left) {
+		frame_put(fl, c);
+		fl->cobs_left--;
+		return;
+	}
+
+	/* 新块开始，上一个不满254字节的块后面隐含一个0 */
+	if (fl->cobs_code && fl->cobs_code != 0xFF)
+		frame_put(fl, 0);
+	fl->cobs_code = c;
+	fl->cobs_left = c - 1;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 6, 0)
+static void frame_receive_buf(struct tty_struct *tty, const u8 *cp, const u8 *fp, size_t count)
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0)
+static void frame_receive_buf(struct tty_struct *tty, const unsigned char *cp, const char *fp, int count)
+#else
+static void frame_receive_buf(struct tty_struct *tty, const unsigned char *cp, char *fp, int count)
+#endif
+{
+	struct frame_ldisc *fl = tty->disc_data;
+	size_t i;
+
+	if (!fl)
+		return;
+
+	for (i = 0; i < (size_t)count; i++) {
+		/* UART帧错误、校验错误、溢出：丢弃当前帧 */
+		if (fp && fp[i] != TTY_NORMAL)
+			fl->rflags |= FRAME_RX_ERROR;
+
+		if (fl->mode == FRAME_MODE_COBS)
+			frame_cobs_byte(fl, cp[i]);
+		else
+			frame_slip_byte(fl, cp[i]);
+	}
+}
+
+/*
+ * 等待并取出一帧到fl->frame
+ * 返回1：已取出，read_lock保持加锁；0：对端关闭或挂断；<0：错误
+ */
+static int frame_wait(struct tty_struct *tty, struct file *file, struct frame_ldisc *fl)
+{
+	if (mutex_lock_interruptible(&fl->read_lock))
+		return -ERESTARTSYS;
+
+	while (kfifo_is_empty(&fl->frames)) {
+		mutex_unlock(&fl->read_lock);
+
+		if (test_bit(TTY_OTHER_CLOSED, &tty->flags) || tty_hung_up_p(file))
+			return 0;
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		if (wait_event_interruptible(tty->read_wait,
+				!kfifo_is_empty(&fl->frames) ||
+				test_bit(TTY_OTHER_CLOSED, &tty->flags) ||
+				tty_hung_up_p(file)))
+			return -ERESTARTSYS;
+
+		if (mutex_lock_interruptible(&fl->read_lock))
+			return -ERESTARTSYS;
+	}
+
+	fl->frame_len = kfifo_out(&fl->frames, fl->frame, FRAME_MAX);
+	fl->frame_pos = 0;
+
+	return 1;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 11, 0)
+/*
+ * tty核心每次只给一个小的内核缓冲区，帧较长时通过cookie分多次拷贝，
+ * 期间保持read_lock，直到帧读完或用户缓冲区用完(nr == 0)。
+ */
+static ssize_t frame_read(struct tty_struct *tty, struct file *file, unsigned char *buf,
+			size_t nr, void **cookie, unsigned long offset)
+{
+	struct frame_ldisc *fl = tty->disc_data;
+	size_t n;
+	int ret;
+
+	if (!*cookie) {
+		ret = frame_wait(tty, file, fl);
+		if (ret <= 0)
+			return ret;
+	}
+
+	n = min_t(size_t, nr, fl->frame_len - fl->frame_pos);
+	memcpy(buf, fl->frame + fl->frame_pos, n);
+	fl->frame_pos += n;
+
+	if (n && fl->frame_pos < fl->frame_len) {
+		*cookie = fl;
+		return n;
+	}
+
+	if (fl->frame_pos < fl->frame_len)
+		fl->stats.truncated++;
+
+	*cookie = NULL;
+	mutex_unlock(&fl->read_lock);
+
+	return n;
+}
+#else
+static ssize_t frame_read(struct tty_struct *tty, struct file *file,
+			unsigned char __user *buf, size_t nr)
+{
+	struct frame_ldisc *fl = tty->disc_data;
+	size_t n;
+	int ret;
+
+	ret = frame_wait(tty, file, fl);
+	if (ret <= 0)
+		return ret;
+
+	n = min_t(size_t, nr, fl->frame_len);
+	if (n < fl->frame_len)
+		fl->stats.truncated++;
+
+	ret = copy_to_user(buf, fl->frame, n) ? -EFAULT : n;
+	mutex_unlock(&fl->read_lock);
+
+	return ret;
+}
+#endif
+
+/*
+ * 发送
+ */
+static unsigned int frame_slip_encode(const unsigned char *src, unsigned int len, unsigned char *dst)
+{
+	unsigned int out = 0;
+	unsigned int i;
+
+	/* 开头的END冲掉线路上的噪声 */
+	dst[out++] = SLIP_END;
+	for (i = 0; i < len; i++) {
+		if (src[i] == SLIP_END) {
+			dst[out++] = SLIP_ESC;
+			dst[out++] = SLIP_ESC_END;
+		} else if (src[i] == SLIP_ESC) {
+			dst[out++] = SLIP_ESC;
+			dst[out++] = SLIP_ESC_ESC;
+		} else {
+			dst[out++] = src[i];
+		}
+	}
+	dst[out++] = SLIP_END;
+
+	return out;
+}
+
+static unsigned int frame_cobs_encode(const unsigned char *src, unsigned int len, unsigned char *dst)
+{
+	unsigned int code_pos = 1;
+	unsigned int out = 2;
+	unsigned char code = 1;
+	unsigned int i;
+
+	dst[0] = 0;
+	for (i = 0; i < len; i++) {
+		if (src[i]) {
+			dst[out++] = src[i];
+			code++;
+		}
+		if (!src[i] || code == 0xFF) {
+			dst[code_pos] = code;
+			code_pos = out++;
+			code = 1;
+		}
+	}
+	dst[code_pos] = code;
+	dst[out++] = 0;
+
+	return out;
+}
+
+static unsigned int frame_encode(struct frame_ldisc *fl, const unsigned char *buf, unsigned int len)
+{
+	u16 fcs;
+
+	memcpy(fl->wraw, buf, len);
+	if (fl->crc) {
+		fcs = crc_ccitt(0xffff, buf, len);
+		fl->wraw[len++] = fcs & 0xFF;
+		fl->wraw[len++] = fcs >> 8;
+	}
+
+	if (fl->mode == FRAME_MODE_COBS)
+		return frame_cobs_encode(fl->wraw, len, fl->wbuf);
+
+	return frame_slip_encode(fl->wraw, len, fl->wbuf);
+}
+
+static ssize_t frame_write(struct tty_struct *tty, struct file *file,
+			const unsigned char *buf, size_t nr)
+{
+	struct frame_ldisc *fl = tty->disc_data;
+	unsigned int len;
+	unsigned int pos = 0;
+	ssize_t ret = 0;
+	int c;
+
+	if (!nr)
+		return 0;
+	if (nr > FRAME_MAX)
+		return -EMSGSIZE;
+
+	if (mutex_lock_interruptible(&fl->write_lock))
+		return -ERESTARTSYS;
+
+	len = frame_encode(fl, buf, nr);
+	while (pos < len) {
+		set_bit(TTY_DO_WRITE_WAKEUP, &tty->flags);
+		c = tty->ops->write(tty, fl->wbuf + pos, len - pos);
+		if (c < 0) {
+			ret = c;
+			break;
+		}
+		pos += c;
+		if (pos == len)
+			break;
+
+		if (!pos && (file->f_flags & O_NONBLOCK)) {
+			ret = -EAGAIN;
+			break;
+		}
+
+		/* 帧已开始发送，必须发完，否则对端收到半帧 */
+		if (wait_event_interruptible(tty->write_wait,
+				tty_write_room(tty) > 0 || tty_hung_up_p(file))) {
+			ret = -ERESTARTSYS;
+			break;
+		}
+		if (tty_hung_up_p(file)) {
+			ret = -EIO;
+			break;
+		}
+	}
+	clear_bit(TTY_DO_WRITE_WAKEUP, &tty->flags);
+
+	mutex_unlock(&fl->write_lock);
+
+	return ret ? ret : nr;
+}
+
+static void frame_write_wakeup(struct tty_struct *tty)
+{
+	/* tty_wakeup()随后会唤醒tty->write_wait */
+	clear_bit(TTY_DO_WRITE_WAKEUP, &tty->flags);
+}
+
+static frame_poll_t frame_poll(struct tty_struct *tty, struct file *file, poll_table *wait)
+{
+	struct frame_ldisc *fl = tty->disc_data;
+	frame_poll_t mask = 0;
+
+	poll_wait(file, &tty->read_wait, wait);
+	poll_wait(file, &tty->write_wait, wait);
+
+	if (!kfifo_is_empty(&fl->frames))
+		mask |= POLLIN | POLLRDNORM;
+	if (test_bit(TTY_OTHER_CLOSED, &tty->flags) || tty_hung_up_p(file))
+		mask |= POLLHUP;
+	if (tty_write_room(tty) > 0)
+		mask |= POLLOUT | POLLWRNORM;
+
+	return mask;
+}
+
+/* termios等ioctl交给n_tty_ioctl_helper()，与slip、ppp相同 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 17, 0)
+static int frame_ioctl(struct tty_struct *tty, unsigned int cmd, unsigned long arg)
+#else
+static int frame_ioctl(struct tty_struct *tty, struct file *file,
+			unsigned int cmd, unsigned long arg)
+#endif
+{
+	struct frame_ldisc *fl = tty->disc_data;
+	int len;
+
+	switch (cmd) {
+	case FIONREAD:
+		/* 下一帧的长度，没有完整帧时为0 */
+		if (mutex_lock_interruptible(&fl->read_lock))
+			return -ERESTARTSYS;
+		len = kfifo_is_empty(&fl->frames) ? 0 : kfifo_peek_len(&fl->frames);
+		mutex_unlock(&fl->read_lock);
+		return put_user(len, (int __user *)arg);
+	default:
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 17, 0)
+		return n_tty_ioctl_helper(tty, cmd, arg);
+#else
+		return n_tty_ioctl_helper(tty, file, cmd, arg);
+#endif
+	}
+}
+
+static int frame_open(struct tty_struct *tty)
+{
+	struct frame_ldisc *fl;
+	int ret;
+
+	if (!tty->ops->write)
+		return -EOPNOTSUPP;
+
+	if (mode != FRAME_MODE_SLIP && mode != FRAME_MODE_COBS)
+		return -EINVAL;
+
+	fl = kzalloc(sizeof(*fl), GFP_KERNEL);
+	if (!fl)
+		return -ENOMEM;
+
+	ret = kfifo_alloc(&fl->frames, queue_size, GFP_KERNEL);
+	if (ret) {
+		kfree(fl);
+		return ret;
+	}
+
+	fl->tty = tty;
+	fl->mode = mode;
+	fl->crc = crc;
+	mutex_init(&fl->read_lock);
+	mutex_init(&fl->write_lock);
+
+	tty->disc_data = fl;
+	tty->receive_room = 65536;
+	/* 一次write()不被tty核心拆成2KB的块，保证一次write()是一帧 */
+	set_bit(TTY_NO_WRITE_SPLIT, &tty->flags);
+
+	return 0;
+}
+
+static void frame_close(struct tty_struct *tty)
+{
+	struct frame_ldisc *fl = tty->disc_data;
+
+	if (!fl)
+		return;
+
+	/* 每次切换线路规程都会调用，统计只在打开动态调试时输出 */
+	pr_debug("frame_ldisc: %s: frames=%lu crc_errors=%lu errors=%lu overruns=%lu dropped=%lu truncated=%lu\n",
+		tty->name, fl->stats.frames, fl->stats.crc_errors, fl->stats.errors,
+		fl->stats.overruns, fl->stats.dropped, fl->stats.truncated);
+
+	clear_bit(TTY_NO_WRITE_SPLIT, &tty->flags);
+	tty->disc_data = NULL;
+	kfifo_free(&fl->frames);
+	kfree(fl);
+}
+
+static struct tty_ldisc_ops frame_ldisc_ops = {
+#ifdef TTY_LDISC_MAGIC
+	.magic			= TTY_LDISC_MAGIC,
+#endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0)
+	.num			= N_FRAME,
+#endif
+	.name			= FRAME_NAME,
+	.owner			= THIS_MODULE,
+	.open			= frame_open,
+	.close			= frame_close,
+	.read			= frame_read,
+	.write			= frame_write,
+	.ioctl			= frame_ioctl,
+	.poll			= frame_poll,
+	.receive_buf	= frame_receive_buf,
+	.write_wakeup	= frame_write_wakeup,
+};
+
+static int __init frame_ldisc_init(void)
+{
+	int ret;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0)
+	ret = tty_register_ldisc(&frame_ldisc_ops);
+#else
+	ret = tty_register_ldisc(N_FRAME, &frame_ldisc_ops);
+#endif
+	if (ret)
+		printk(KERN_ERR "frame_ldisc: Failed to register line discipline %d, ret=%d\n", N_FRAME, ret);
+
+	return ret;
+}
+
+static void __exit frame_ldisc_exit(void)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0)
+	tty_unregister_ldisc(&frame_ldisc_ops);
+#else
+	tty_unregister_ldisc(N_FRAME);
+#endif
+}
+
+module_init(frame_ldisc_init);
+module_exit(frame_ldisc_exit);
+
+MODULE_AUTHOR("panxingyuan1@163.com");
+MODULE_DESCRIPTION("SLIP/COBS frame line discipline.");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS_LDISC(N_FRAME);
@@ -0,0 +1,32 @@
+/**
+ * @file frame_ldisc.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Frame line discipline, shared by the driver and user space.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details 帧格式：payload + CRC-16/CCITT(crc_ccitt(0xffff, payload)，小端，可用crc=0关闭)，
+ *          再做SLIP(mode=0)或COBS(mode=1，0x00为帧分隔符)编码。
+ *          接收：每次read()返回一个完整且CRC正确的帧(不含CRC)，缓冲区不足时截断。
+ *          发送：每次write()的数据作为一个帧编码后发出。
+ */
+
+#ifndef __FRAME_LDISC_H__
+#define __FRAME_LDISC_H__
+
+/* 线路规程号，N_DEVELOPMENT(29)，通过TIOCSETD设置 */
+#define N_FRAME			29
+
+#define FRAME_MODE_SLIP		0
+#define FRAME_MODE_COBS		1
+
+#define FRAME_MAX		4096	/* 最大帧长(不含CRC) */
+
+/* SLIP特殊字符 */
+#define SLIP_END		0xC0
+#define SLIP_ESC		0xDB
+#define SLIP_ESC_END	0xDC
+#define SLIP_ESC_ESC	0xDD
+
+#endif /* __FRAME_LDISC_H__ */
@@ -5,6 +5,8 @@
 # @version 0.1
 # @date 2023-12-23
 #       Create this file.
+# @date 2026-10-18
+#       方法三：pty_expect(user_apps/pty_expect)，程序从终端读也可以，可批量并发。
 # @copyright Copyright (c) 2023
 ###############################################################################
 
@@ -15,3 +17,10 @@
 
 # 方法二：管道
 echo -e "1\nxxx\n" | ./please_input_no_name.sh
+
+# 方法三：pty(程序从终端读也可以，-n/-f可批量并发)
+PTY_EXPECT=../user_apps/pty_expect/pty_expect
+if [ -x $PTY_EXPECT ]; then
+    $PTY_EXPECT -v -e 'expect "enter number:"' -e 'send "1\n"' \
+        -e 'expect "enter name:"' -e 'send "xxx\n"' -e eof -- bash ./please_input_no_name.sh
+fi
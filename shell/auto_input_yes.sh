@@ -5,6 +5,8 @@
 # @version 0.1
 # @date 2023-12-23
 #       Create this file.
+# @date 2026-10-18
+#       cp -i从终端读时用pty_expect(user_apps/pty_expect)回答。
 # @copyright Copyright (c) 2023
 ###############################################################################
 
@@ -20,7 +22,13 @@ echo "--------------------------"
 echo "b.txt"
 cat b.txt
 
-echo -e "yes\n" | cp -i a.txt b.txt
+PTY_EXPECT=../user_apps/pty_expect/pty_expect
+if [ -x $PTY_EXPECT ]; then
+    # 提示出现时才回答，cp从终端读也可以
+    $PTY_EXPECT -q -e 'on "overwrite" "yes\n"' -e eof -- cp -i a.txt b.txt
+else
+    echo -e "yes\n" | cp -i a.txt b.txt
+fi
 
 echo ""
 echo "copy, file content:"
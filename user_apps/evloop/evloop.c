@@ -0,0 +1,540 @@
+/**
+ * @file evloop.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Small epoll event loop: fd sources, timer wheel, signals.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "evloop.h"
+
+#define EV_TICK_NS          ((uint64_t)EV_TICK_MS * 1000000ULL)
+#define EV_SLOT(tick)       ((tick) & (EV_TIMER_SLOTS - 1))
+
+static inline void ev_list_init(struct ev_list *head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+static inline int ev_list_empty(const struct ev_list *head)
+{
+    return head->next == head;
+}
+
+static inline void ev_list_add_tail(struct ev_list *node, struct ev_list *head)
+{
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+static inline void ev_list_del(struct ev_list *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = node;
+    node->prev = node;
+}
+
+#define ev_timer_of(n)      ((struct ev_timer *)((char *)(n) - offsetof(struct ev_timer, node)))
+
+static uint64_t ev_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t ev_now_tick(struct ev_loop *loop)
+{
+    return (ev_now_ns() - loop->base_ns) / EV_TICK_NS;
+}
+
+/*
+ * Arm the timerfd for @p tick (absolute), 0 disarms it.
+ */
+static void ev_timer_arm(struct ev_loop *loop, uint64_t tick)
+{
+    struct itimerspec its;
+    uint64_t ns = 0;
+
+    if (tick == loop->armed)
+    {
+        return;
+    }
+
+    memset(&its, 0, sizeof(its));
+    if (tick)
+    {
+        ns = loop->base_ns + tick * EV_TICK_NS;
+        its.it_value.tv_sec = ns / 1000000000ULL;
+        its.it_value.tv_nsec = ns % 1000000000ULL;
+    }
+
+    if (timerfd_settime(loop->tfd, TFD_TIMER_ABSTIME, &its, NULL))
+    {
+        fprintf(stderr, "Error: timerfd_settime() failed, errno=%d!\n", errno);
+        return;
+    }
+
+    loop->armed = tick;
+}
+
+/*
+ * Earliest expiry: the first slot from the wheel position holding a timer due in this revolution,
+ * otherwise the nearest timer of a later revolution.
+ */
+static void ev_timer_rearm(struct ev_loop *loop)
+{
+    struct ev_list *head = NULL;
+    struct ev_list *n = NULL;
+    uint64_t earliest = 0;
+    uint64_t tick = 0;
+    uint64_t i = 0;
+
+    if (!loop->nr_timers)
+    {
+        ev_timer_arm(loop, 0);
+        return;
+    }
+
+    for (i = 0; i < EV_TIMER_SLOTS; i++)
+    {
+        tick = loop->tick + i;
+        head = &loop->wheel[EV_SLOT(tick)];
+        for (n = head->next; n != head; n = n->next)
+        {
+            if (!earliest || ev_timer_of(n)->expire < earliest)
+            {
+                earliest = ev_timer_of(n)->expire;
+            }
+        }
+
+        if (earliest && earliest <= tick)
+        {
+            break;
+        }
+    }
+
+    ev_timer_arm(loop, earliest);
+}
+
+static void ev_timer_add(struct ev_loop *loop, struct ev_timer *timer)
+{
+    ev_list_add_tail(&timer->node, &loop->wheel[EV_SLOT(timer->expire)]);
+    timer->active = 1;
+    loop->nr_timers++;
+}
+
+/*
+ * Move every timer due at @p now from the wheel to @p pending.
+ */
+static void ev_timer_collect(struct ev_loop *loop, uint64_t now, struct ev_list *pending)
+{
+    struct ev_list *head = NULL;
+    struct ev_list *n = NULL;
+    struct ev_list *next = NULL;
+    uint64_t ticks = now - loop->tick + 1;
+    uint64_t i = 0;
+
+    if (ticks > EV_TIMER_SLOTS)
+    {
+        ticks = EV_TIMER_SLOTS;
+    }
+
+    for (i = 0; i < ticks; i++)
+    {
+        head = &loop->wheel[EV_SLOT(loop->tick + i)];
+        for (n = head->next; n != head; n = next)
+        {
+            next = n->next;
+            if (ev_timer_of(n)->expire <= now)
+            {
+                ev_list_del(n);
+                ev_list_add_tail(n, pending);
+            }
+        }
+    }
+
+    loop->tick = now + 1;
+}
+
+static void ev_timer_expired(struct ev_loop *loop, struct ev_io *io, uint32_t revents)
+{
+    struct ev_list pending;
+    struct ev_timer *timer = NULL;
+    uint64_t now = ev_now_tick(loop);
+
+    (void)io;
+    (void)revents;
+
+    loop->armed = 0;
+    if (now < loop->tick)
+    {
+        ev_timer_rearm(loop);
+        return;
+    }
+
+    ev_list_init(&pending);
+    ev_timer_collect(loop, now, &pending);
+
+    /* A callback may stop or restart any timer, including ones still pending. */
+    while (!ev_list_empty(&pending))
+    {
+        timer = ev_timer_of(pending.next);
+        ev_list_del(&timer->node);
+        loop->nr_timers--;
+        timer->active = 0;
+
+        if (timer->interval)
+        {
+            timer->expire += timer->interval;
+            if (timer->expire <= now)
+            {
+                /* Overran: skip the missed periods instead of firing them back to back. */
+                timer->expire += (now - timer->expire) / timer->interval * timer->interval + timer->interval;
+            }
+            ev_timer_add(loop, timer);
+        }
+
+        loop->dispatches++;
+        timer->cb(loop, timer);
+    }
+
+    ev_timer_rearm(loop);
+}
+
+static void ev_signal_received(struct ev_loop *loop, struct ev_io *io, uint32_t revents)
+{
+    struct ev_signal *sig = NULL;
+
+    (void)revents;
+
+    if (io->len != sizeof(loop->siginfo) || loop->siginfo.ssi_signo >= EV_NSIG)
+    {
+        return;
+    }
+
+    sig = loop->signals[loop->siginfo.ssi_signo];
+    if (sig && sig->cb)
+    {
+        loop->dispatches++;
+        sig->cb(loop, sig);
+    }
+}
+
+int ev_loop_init(struct ev_loop *loop)
+{
+    int i = 0;
+
+    memset(loop, 0, sizeof(*loop));
+    loop->tfd = -1;
+    loop->sfd = -1;
+    sigemptyset(&loop->sigmask);
+    for (i = 0; i < EV_TIMER_SLOTS; i++)
+    {
+        ev_list_init(&loop->wheel[i]);
+    }
+    loop->base_ns = ev_now_ns();
+
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epfd == -1)
+    {
+        fprintf(stderr, "Error: epoll_create1() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    loop->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (loop->tfd == -1)
+    {
+        fprintf(stderr, "Error: timerfd_create() failed, errno=%d!\n", errno);
+        goto err;
+    }
+
+    loop->sfd = signalfd(-1, &loop->sigmask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (loop->sfd == -1)
+    {
+        fprintf(stderr, "Error: signalfd() failed, errno=%d!\n", errno);
+        goto err;
+    }
+
+    ev_io_init(&loop->timer_io, loop->tfd, EPOLLIN, ev_timer_expired,
+               &loop->expirations, sizeof(loop->expirations));
+    ev_io_init(&loop->signal_io, loop->sfd, EPOLLIN, ev_signal_received,
+               &loop->siginfo, sizeof(loop->siginfo));
+    if (ev_io_start(loop, &loop->timer_io) || ev_io_start(loop, &loop->signal_io))
+    {
+        goto err;
+    }
+
+    return 0;
+
+err:
+    ev_loop_exit(loop);
+    return -1;
+}
+
+void ev_loop_exit(struct ev_loop *loop)
+{
+    if (!sigisemptyset(&loop->sigmask))
+    {
+        sigprocmask(SIG_UNBLOCK, &loop->sigmask, NULL);
+        sigemptyset(&loop->sigmask);
+    }
+
+    if (loop->sfd != -1)
+    {
+        close(loop->sfd);
+        loop->sfd = -1;
+    }
+
+    if (loop->tfd != -1)
+    {
+        close(loop->tfd);
+        loop->tfd = -1;
+    }
+
+    if (loop->epfd != -1)
+    {
+        close(loop->epfd);
+        loop->epfd = -1;
+    }
+}
+
+/*
+ * Read a fixed buffer source until EAGAIN, one callback per chunk.
+ */
+static void ev_io_drain(struct ev_loop *loop, struct ev_io *io)
+{
+    ssize_t ret = 0;
+
+    while (io->active)
+    {
+        ret = read(io->fd, io->buf, io->size);
+        if (ret > 0)
+        {
+            io->len = ret;
+            loop->dispatches++;
+            io->cb(loop, io, EPOLLIN);
+        }
+        else if (ret == 0)
+        {
+            io->len = 0;
+            loop->dispatches++;
+            io->cb(loop, io, EPOLLHUP);
+            return;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            if (errno != EAGAIN)
+            {
+                io->len = 0;
+                loop->dispatches++;
+                io->cb(loop, io, EPOLLERR);
+            }
+            return;
+        }
+    }
+}
+
+int ev_loop_run(struct ev_loop *loop)
+{
+    struct ev_io *io = NULL;
+    uint32_t revents = 0;
+    int n = 0;
+    int i = 0;
+
+    loop->stop = 0;
+    while (!loop->stop)
+    {
+        n = epoll_wait(loop->epfd, loop->evs, EV_MAX_EVENTS, -1);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "Error: epoll_wait() failed, errno=%d!\n", errno);
+            return -1;
+        }
+
+        loop->wakeups++;
+        loop->nevs = n;
+        for (i = 0; i < n; i++)
+        {
+            /* NULL: stopped by an earlier callback of this batch. */
+            io = loop->evs[i].data.ptr;
+            if (!io)
+            {
+                continue;
+            }
+            revents = loop->evs[i].events;
+
+            if (io->buf && (revents & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+            {
+                ev_io_drain(loop, io);
+                revents &= ~(EPOLLIN | EPOLLHUP | EPOLLERR);
+            }
+
+            if (revents && io->active)
+            {
+                loop->dispatches++;
+                io->cb(loop, io, revents);
+            }
+        }
+        loop->nevs = 0;
+    }
+
+    return 0;
+}
+
+void ev_loop_break(struct ev_loop *loop)
+{
+    loop->stop = 1;
+}
+
+void ev_io_init(struct ev_io *io, int fd, uint32_t events, ev_io_cb cb, void *buf, size_t size)
+{
+    memset(io, 0, sizeof(*io));
+    io->fd = fd;
+    io->events = events;
+    io->cb = cb;
+    io->buf = buf;
+    io->size = size;
+}
+
+int ev_io_start(struct ev_loop *loop, struct ev_io *io)
+{
+    struct epoll_event ev;
+
+    if (io->active)
+    {
+        return 0;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = io->events | EPOLLET;
+    ev.data.ptr = io;
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, io->fd, &ev))
+    {
+        fprintf(stderr, "Error: epoll_ctl() add fd %d failed, errno=%d!\n", io->fd, errno);
+        return -1;
+    }
+    io->active = 1;
+
+    return 0;
+}
+
+void ev_io_stop(struct ev_loop *loop, struct ev_io *io)
+{
+    int i = 0;
+
+    if (!io->active)
+    {
+        return;
+    }
+
+    epoll_ctl(loop->epfd, EPOLL_CTL_DEL, io->fd, NULL);
+    io->active = 0;
+
+    for (i = 0; i < loop->nevs; i++)
+    {
+        if (loop->evs[i].data.ptr == io)
+        {
+            loop->evs[i].data.ptr = NULL;
+        }
+    }
+}
+
+void ev_timer_init(struct ev_timer *timer, ev_timer_cb cb)
+{
+    memset(timer, 0, sizeof(*timer));
+    ev_list_init(&timer->node);
+    timer->cb = cb;
+}
+
+int ev_timer_start(struct ev_loop *loop, struct ev_timer *timer, uint32_t after_ms, uint32_t interval_ms)
+{
+    uint64_t ticks = (after_ms + EV_TICK_MS - 1) / EV_TICK_MS;
+
+    ev_timer_stop(loop, timer);
+
+    timer->expire = ev_now_tick(loop) + (ticks ? ticks : 1);
+    if (timer->expire < loop->tick)
+    {
+        timer->expire = loop->tick;
+    }
+    timer->interval = (interval_ms + EV_TICK_MS - 1) / EV_TICK_MS;
+    ev_timer_add(loop, timer);
+
+    if (!loop->armed || timer->expire < loop->armed)
+    {
+        ev_timer_arm(loop, timer->expire);
+    }
+
+    return 0;
+}
+
+void ev_timer_stop(struct ev_loop *loop, struct ev_timer *timer)
+{
+    if (!timer->active)
+    {
+        return;
+    }
+
+    /* The timerfd stays armed, the next expiry recomputes it. */
+    ev_list_del(&timer->node);
+    timer->active = 0;
+    loop->nr_timers--;
+}
+
+int ev_signal_start(struct ev_loop *loop, struct ev_signal *sig, int signo, ev_signal_cb cb)
+{
+    sigset_t mask;
+
+    if (signo <= 0 || signo >= EV_NSIG)
+    {
+        fprintf(stderr, "Error: Invalid argument, signo=%d!\n", signo);
+        return -1;
+    }
+
+    sigemptyset(&mask);
+    sigaddset(&mask, signo);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL))
+    {
+        fprintf(stderr, "Error: sigprocmask() failed, errno=%d!\n", errno);
+        return -1;
+    }
+    sigaddset(&loop->sigmask, signo);
+
+    if (signalfd(loop->sfd, &loop->sigmask, 0) == -1)
+    {
+        fprintf(stderr, "Error: signalfd() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    sig->signo = signo;
+    sig->cb = cb;
+    loop->signals[signo] = sig;
+
+    return 0;
+}
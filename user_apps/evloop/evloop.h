@@ -0,0 +1,137 @@
+/**
+ * @file evloop.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Small epoll event loop: fd sources, timer wheel, signals.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details One thread, one epoll fd, no allocation after ev_loop_init():
+ *          - ev_io: fds are registered edge-triggered. With a fixed buffer (buf/size) the loop
+ *            reads until EAGAIN and calls the callback once per chunk (io->len bytes in buf),
+ *            without one the callback gets the epoll events and must drain the fd itself.
+ *          - ev_timer: hashed timer wheel (EV_TIMER_SLOTS slots of EV_TICK_MS) behind one
+ *            timerfd, armed for the earliest expiry only, so idle timers cost no wakeups.
+ *            Adding and removing a timer is O(1).
+ *          - ev_signal: signals are blocked and read from one signalfd, the callback runs in
+ *            the loop, not in a signal handler.
+ *          Any source may be stopped from any callback.
+ */
+
+#ifndef __EVLOOP_H__
+#define __EVLOOP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+
+#define EV_MAX_EVENTS       64
+#define EV_TIMER_SLOTS      1024    /* Power of 2 */
+#define EV_TICK_MS          1
+#define EV_NSIG             65
+
+struct ev_loop;
+
+struct ev_list {
+    struct ev_list *next;
+    struct ev_list *prev;
+};
+
+struct ev_io;
+typedef void (*ev_io_cb)(struct ev_loop *loop, struct ev_io *io, uint32_t revents);
+
+struct ev_io {
+    int fd;
+    uint32_t events;            /* EPOLLIN, EPOLLOUT, EPOLLET is always added */
+    ev_io_cb cb;
+    void *data;
+    void *buf;                  /* Fixed read buffer, NULL: the callback reads */
+    size_t size;
+    size_t len;                 /* Bytes in buf for this callback */
+    int active;
+};
+
+struct ev_timer;
+typedef void (*ev_timer_cb)(struct ev_loop *loop, struct ev_timer *timer);
+
+struct ev_timer {
+    struct ev_list node;
+    uint64_t expire;            /* Tick */
+    uint64_t interval;          /* Ticks, 0: one shot */
+    ev_timer_cb cb;
+    void *data;
+    int active;
+};
+
+struct ev_signal;
+typedef void (*ev_signal_cb)(struct ev_loop *loop, struct ev_signal *sig);
+
+struct ev_signal {
+    int signo;
+    ev_signal_cb cb;
+    void *data;
+};
+
+struct ev_loop {
+    int epfd;
+    int stop;
+    struct epoll_event evs[EV_MAX_EVENTS];
+    int nevs;                   /* Events of the current batch, for ev_io_stop() */
+
+    int tfd;
+    struct ev_io timer_io;
+    uint64_t base_ns;           /* CLOCK_MONOTONIC of tick 0 */
+    uint64_t tick;              /* Wheel position: every tick before this one was processed */
+    uint64_t armed;             /* Tick the timerfd is armed for, 0: disarmed */
+    uint64_t expirations;       /* timerfd read buffer */
+    unsigned long nr_timers;
+    struct ev_list wheel[EV_TIMER_SLOTS];
+
+    int sfd;
+    struct ev_io signal_io;
+    sigset_t sigmask;
+    struct signalfd_siginfo siginfo;    /* signalfd read buffer */
+    struct ev_signal *signals[EV_NSIG];
+
+    unsigned long wakeups;      /* epoll_wait() returns */
+    unsigned long dispatches;   /* Callbacks run */
+};
+
+int ev_loop_init(struct ev_loop *loop);
+
+void ev_loop_exit(struct ev_loop *loop);
+
+/**
+ * @brief Run until ev_loop_break().
+ * @return 0, -1 on an epoll error.
+ */
+int ev_loop_run(struct ev_loop *loop);
+
+void ev_loop_break(struct ev_loop *loop);
+
+/**
+ * @brief Set up @p io. @p buf may be NULL (the callback reads the fd itself).
+ */
+void ev_io_init(struct ev_io *io, int fd, uint32_t events, ev_io_cb cb, void *buf, size_t size);
+
+int ev_io_start(struct ev_loop *loop, struct ev_io *io);
+
+void ev_io_stop(struct ev_loop *loop, struct ev_io *io);
+
+void ev_timer_init(struct ev_timer *timer, ev_timer_cb cb);
+
+/**
+ * @brief Fire after @p after_ms, then every @p interval_ms (0: once). Restarts an active timer.
+ */
+int ev_timer_start(struct ev_loop *loop, struct ev_timer *timer, uint32_t after_ms, uint32_t interval_ms);
+
+void ev_timer_stop(struct ev_loop *loop, struct ev_timer *timer);
+
+/**
+ * @brief Block @p signo and deliver it to @p sig->cb from the loop.
+ */
+int ev_signal_start(struct ev_loop *loop, struct ev_signal *sig, int signo, ev_signal_cb cb);
+
+#endif /* __EVLOOP_H__ */
@@ -0,0 +1,161 @@
+/**
+ * @file evloop_bench.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief evloop timer wheel load: many periodic timers on one timerfd.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details evloop_bench [-n timers] [-t seconds] [-i max_interval_ms]
+ *          Starts n periodic timers with intervals spread over 1..max_interval_ms, runs for the
+ *          given time and reports epoll wakeups, timer callbacks, the worst lateness seen by a
+ *          callback and the CPU time used (getrusage).
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "evloop.h"
+
+struct bench_timer {
+    struct ev_timer timer;
+    uint64_t due_ns;
+    uint64_t interval_ns;
+};
+
+static uint64_t fired = 0;
+static uint64_t late_max_ns = 0;
+static uint64_t late_sum_ns = 0;
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_fire(struct ev_loop *loop, struct ev_timer *timer)
+{
+    struct bench_timer *bt = timer->data;
+    uint64_t now = bench_now_ns();
+    uint64_t late = now > bt->due_ns ? now - bt->due_ns : 0;
+
+    fired++;
+    late_sum_ns += late;
+    if (late > late_max_ns)
+    {
+        late_max_ns = late;
+    }
+
+    bt->due_ns += bt->interval_ns;
+    while (bt->due_ns + bt->interval_ns <= now)
+    {
+        bt->due_ns += bt->interval_ns;
+    }
+}
+
+static void bench_stop(struct ev_loop *loop, struct ev_timer *timer)
+{
+    ev_loop_break(loop);
+}
+
+static void bench_quit(struct ev_loop *loop, struct ev_signal *sig)
+{
+    ev_loop_break(loop);
+}
+
+static double bench_tv(const struct timeval *tv)
+{
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_timer *timers = NULL;
+    struct ev_loop loop;
+    struct ev_timer stop;
+    struct ev_signal sigint;
+    struct rusage ru;
+    unsigned int nr = 10000;
+    unsigned int seconds = 5;
+    unsigned int max_ms = 1000;
+    unsigned int interval = 0;
+    unsigned int i = 0;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "n:t:i:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            nr = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            seconds = strtoul(optarg, NULL, 0);
+            break;
+        case 'i':
+            max_ms = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n timers] [-t seconds] [-i max_interval_ms]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (!nr || !seconds || !max_ms)
+    {
+        fprintf(stderr, "Error: Invalid argument!\n");
+        return -1;
+    }
+
+    timers = calloc(nr, sizeof(*timers));
+    if (!timers)
+    {
+        fprintf(stderr, "Error: calloc() failed!\n");
+        return -1;
+    }
+
+    if (ev_loop_init(&loop))
+    {
+        free(timers);
+        return -1;
+    }
+    ev_signal_start(&loop, &sigint, SIGINT, bench_quit);
+
+    srand(1);
+    for (i = 0; i < nr; i++)
+    {
+        interval = 1 + rand() % max_ms;
+        ev_timer_init(&timers[i].timer, bench_fire);
+        timers[i].timer.data = &timers[i];
+        timers[i].interval_ns = interval * 1000000ULL;
+        timers[i].due_ns = bench_now_ns() + timers[i].interval_ns;
+        ev_timer_start(&loop, &timers[i].timer, interval, interval);
+    }
+
+    ev_timer_init(&stop, bench_stop);
+    ev_timer_start(&loop, &stop, seconds * 1000, 0);
+
+    ev_loop_run(&loop);
+
+    getrusage(RUSAGE_SELF, &ru);
+    printf("timers: %u, seconds: %u, wakeups: %lu (%.1f/s), callbacks: %llu (%.1f per wakeup)\n",
+           nr, seconds, loop.wakeups, (double)loop.wakeups / seconds, (unsigned long long)fired,
+           loop.wakeups ? (double)fired / loop.wakeups : 0.0);
+    printf("late: avg %.1f us, max %.1f us, cpu: user %.3f s, sys %.3f s\n",
+           fired ? late_sum_ns / 1e3 / fired : 0.0, late_max_ns / 1e3,
+           bench_tv(&ru.ru_utime), bench_tv(&ru.ru_stime));
+
+    ev_loop_exit(&loop);
+    free(timers);
+
+    return 0;
+}
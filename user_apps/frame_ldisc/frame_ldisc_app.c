@@ -0,0 +1,528 @@
+/**
+ * @file frame_ldisc_app.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Frame line discipline test.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details Usage:
+ *              frame_ldisc_app [-m slip|cobs] [-c] [-N] tty      print the frames received on tty
+ *              frame_ldisc_app [-m slip|cobs] [-c] [-N] [-n frames] [-s size] pty
+ *                  self test: a child writes encoded frames into a pty master, this process
+ *                  reads the slave and checks every frame
+ *          -m and -c (no CRC) must match the module parameters mode/crc.
+ *          -N keeps N_TTY and decodes in user space, for comparison: the test prints read()
+ *          calls and context switches per frame for both.
+ * @note OS: linux-xlnx-xilinx-v14.5.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "serial.h"
+#include "frame_ldisc.h"
+
+#define FRAME_RAW_MAX   (FRAME_MAX + 2)
+#define FRAME_ENC_MAX   (FRAME_RAW_MAX * 2 + 2)
+
+struct frame_cfg {
+    int mode;
+    int crc;
+    int n_tty;
+    unsigned long frames;
+    unsigned int size;
+};
+
+/* User space decoder, same state machine as the line discipline (used with -N). */
+struct frame_dec {
+    const struct frame_cfg *cfg;
+    uint8_t buf[FRAME_RAW_MAX];
+    unsigned int len;
+    int bad;
+    int esc;
+    unsigned int cobs_code;
+    unsigned int cobs_left;
+};
+
+/* crc_ccitt() of the kernel: reflected polynomial 0x8408, no final XOR. */
+static uint16_t frame_crc(uint16_t crc, const uint8_t *buf, unsigned int len)
+{
+    unsigned int i = 0;
+
+    while (len--)
+    {
+        crc ^= *buf++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+    }
+
+    return crc;
+}
+
+static unsigned int frame_encode(const struct frame_cfg *cfg, const uint8_t *payload, unsigned int len,
+                                 uint8_t *dst)
+{
+    uint8_t raw[FRAME_RAW_MAX];
+    unsigned int code_pos = 1;
+    unsigned int out = 0;
+    uint8_t code = 1;
+    uint16_t fcs = 0;
+    unsigned int i = 0;
+
+    memcpy(raw, payload, len);
+    if (cfg->crc)
+    {
+        fcs = frame_crc(0xFFFF, payload, len);
+        raw[len++] = fcs & 0xFF;
+        raw[len++] = fcs >> 8;
+    }
+
+    if (cfg->mode == FRAME_MODE_SLIP)
+    {
+        dst[out++] = SLIP_END;
+        for (i = 0; i < len; i++)
+        {
+            if (raw[i] == SLIP_END || raw[i] == SLIP_ESC)
+            {
+                dst[out++] = SLIP_ESC;
+                dst[out++] = raw[i] == SLIP_END ? SLIP_ESC_END : SLIP_ESC_ESC;
+            }
+            else
+            {
+                dst[out++] = raw[i];
+            }
+        }
+        dst[out++] = SLIP_END;
+        return out;
+    }
+
+    dst[0] = 0;
+    out = 2;
+    for (i = 0; i < len; i++)
+    {
+        if (raw[i])
+        {
+            dst[out++] = raw[i];
+            code++;
+        }
+        if (!raw[i] || code == 0xFF)
+        {
+            dst[code_pos] = code;
+            code_pos = out++;
+            code = 1;
+        }
+    }
+    dst[code_pos] = code;
+    dst[out++] = 0;
+
+    return out;
+}
+
+static void frame_dec_put(struct frame_dec *dec, uint8_t c)
+{
+    if (dec->len < FRAME_RAW_MAX)
+    {
+        dec->buf[dec->len++] = c;
+    }
+    else
+    {
+        dec->bad = 1;
+    }
+}
+
+/*
+ * Feed one byte. Return the payload length of a complete, valid frame in dec->buf, else -1.
+ */
+static int frame_dec_byte(struct frame_dec *dec, uint8_t c)
+{
+    unsigned int len = 0;
+    int end = 0;
+
+    if (dec->cfg->mode == FRAME_MODE_SLIP)
+    {
+        if (c == SLIP_END)
+        {
+            end = 1;
+            dec->bad |= dec->esc;
+            dec->esc = 0;
+        }
+        else if (dec->esc)
+        {
+            dec->esc = 0;
+            if (c != SLIP_ESC_END && c != SLIP_ESC_ESC)
+            {
+                dec->bad = 1;
+            }
+            frame_dec_put(dec, c == SLIP_ESC_END ? SLIP_END : SLIP_ESC);
+        }
+        else if (c == SLIP_ESC)
+        {
+            dec->esc = 1;
+        }
+        else
+        {
+            frame_dec_put(dec, c);
+        }
+    }
+    else
+    {
+        if (!c)
+        {
+            end = 1;
+            dec->bad |= dec->cobs_left != 0;
+            dec->cobs_code = 0;
+            dec->cobs_left = 0;
+        }
+        else if (dec->cobs_left)
+        {
+            frame_dec_put(dec, c);
+            dec->cobs_left--;
+        }
+        else
+        {
+            if (dec->cobs_code && dec->cobs_code != 0xFF)
+            {
+                frame_dec_put(dec, 0);
+            }
+            dec->cobs_code = c;
+            dec->cobs_left = c - 1;
+        }
+    }
+
+    if (!end)
+    {
+        return -1;
+    }
+
+    len = dec->len;
+    dec->len = 0;
+    if (dec->bad || !len)
+    {
+        dec->bad = 0;
+        return -1;
+    }
+
+    if (dec->cfg->crc)
+    {
+        if (len < 3)
+        {
+            return -1;
+        }
+        len -= 2;
+        if (frame_crc(0xFFFF, dec->buf, len) != (dec->buf[len] | (dec->buf[len + 1] << 8)))
+        {
+            return -1;
+        }
+    }
+
+    return len;
+}
+
+static int frame_attach(int fd, const struct frame_cfg *cfg)
+{
+    int ldisc = N_FRAME;
+
+    if (serial_set_raw(fd))
+    {
+        return -1;
+    }
+
+    if (cfg->n_tty)
+    {
+        return 0;
+    }
+
+    if (ioctl(fd, TIOCSETD, &ldisc))
+    {
+        fprintf(stderr, "Error: TIOCSETD N_FRAME failed, errno=%d (modprobe frame_ldisc?)!\n", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Read one frame into @p frame. With N_FRAME this is one read(), with N_TTY bytes are read
+ * and decoded until a frame is complete.
+ * Return the frame length, 0 on end of file, -1 on error.
+ */
+static int frame_recv(int fd, const struct frame_cfg *cfg, struct frame_dec *dec,
+                      uint8_t *frame, unsigned long *reads)
+{
+    static uint8_t chunk[4096];
+    static unsigned int chunk_len = 0;
+    static unsigned int chunk_pos = 0;
+    ssize_t len = 0;
+    int ret = 0;
+
+    if (!cfg->n_tty)
+    {
+        len = read(fd, frame, FRAME_MAX);
+        (*reads)++;
+        return len < 0 ? -1 : (int)len;
+    }
+
+    while (1)
+    {
+        while (chunk_pos < chunk_len)
+        {
+            ret = frame_dec_byte(dec, chunk[chunk_pos++]);
+            if (ret >= 0)
+            {
+                memcpy(frame, dec->buf, ret);
+                return ret;
+            }
+        }
+
+        len = read(fd, chunk, sizeof(chunk));
+        (*reads)++;
+        if (len <= 0)
+        {
+            return len < 0 && errno != EIO ? -1 : 0;
+        }
+        chunk_len = len;
+        chunk_pos = 0;
+    }
+}
+
+static void frame_fill(uint8_t *payload, unsigned int size, uint32_t seq)
+{
+    unsigned int i = 0;
+
+    memcpy(payload, &seq, sizeof(seq));
+    for (i = sizeof(seq); i < size; i++)
+    {
+        payload[i] = (uint8_t)(seq + i);
+    }
+}
+
+static void frame_writer(int fd, const struct frame_cfg *cfg)
+{
+    static uint8_t payload[FRAME_MAX];
+    static uint8_t enc[FRAME_ENC_MAX];
+    unsigned int len = 0;
+    unsigned int pos = 0;
+    unsigned long seq = 0;
+    ssize_t ret = 0;
+
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+    for (seq = 0; seq < cfg->frames; seq++)
+    {
+        frame_fill(payload, cfg->size, (uint32_t)seq);
+        len = frame_encode(cfg, payload, cfg->size, enc);
+        for (pos = 0; pos < len; pos += ret)
+        {
+            ret = write(fd, enc + pos, len - pos);
+            if (ret < 0)
+            {
+                _exit(1);
+            }
+        }
+    }
+
+    /* Let the reader drain the pty before the master closes. */
+    sleep(1);
+    _exit(0);
+}
+
+static int frame_self_test(const struct frame_cfg *cfg)
+{
+    static uint8_t frame[FRAME_MAX];
+    static uint8_t expect[FRAME_MAX];
+    struct frame_dec dec;
+    struct timespec t0;
+    struct timespec t1;
+    struct rusage ru0;
+    struct rusage ru1;
+    unsigned long reads = 0;
+    unsigned long good = 0;
+    unsigned long bad = 0;
+    char name[64];
+    double seconds = 0;
+    long switches = 0;
+    pid_t child = -1;
+    int master = -1;
+    int slave = -1;
+    int len = 0;
+
+    memset(&dec, 0, sizeof(dec));
+    dec.cfg = cfg;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master == -1 || grantpt(master) || unlockpt(master) || ptsname_r(master, name, sizeof(name)))
+    {
+        fprintf(stderr, "Error: posix_openpt() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    slave = open(name, O_RDWR | O_NOCTTY);
+    if (slave == -1 || serial_set_raw(master) || frame_attach(slave, cfg))
+    {
+        close(master);
+        return -1;
+    }
+
+    getrusage(RUSAGE_SELF, &ru0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    child = fork();
+    if (child == 0)
+    {
+        close(slave);
+        frame_writer(master, cfg);
+    }
+
+    while (good + bad < cfg->frames)
+    {
+        len = frame_recv(slave, cfg, &dec, frame, &reads);
+        if (len <= 0)
+        {
+            break;
+        }
+
+        frame_fill(expect, cfg->size, (uint32_t)(good + bad));
+        if ((unsigned int)len == cfg->size && !memcmp(frame, expect, len))
+        {
+            good++;
+        }
+        else
+        {
+            bad++;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    getrusage(RUSAGE_SELF, &ru1);
+
+    kill(child, SIGTERM);
+    waitpid(child, NULL, 0);
+    close(slave);
+    close(master);
+
+    seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    switches = (ru1.ru_nvcsw - ru0.ru_nvcsw) + (ru1.ru_nivcsw - ru0.ru_nivcsw);
+
+    printf("ldisc=%s mode=%s crc=%d size=%u frames=%lu good=%lu bad=%lu time=%.3f frames/s=%.0f "
+           "reads=%lu reads/frame=%.2f ctxsw=%ld ctxsw/frame=%.2f\n",
+           cfg->n_tty ? "n_tty" : "n_frame", cfg->mode == FRAME_MODE_COBS ? "cobs" : "slip", cfg->crc,
+           cfg->size, cfg->frames, good, bad, seconds, good / seconds, reads,
+           good ? (double)reads / good : 0.0, switches, good ? (double)switches / good : 0.0);
+
+    return (good == cfg->frames) ? 0 : -1;
+}
+
+static int frame_dump(const char *tty, const struct frame_cfg *cfg)
+{
+    static uint8_t frame[FRAME_MAX];
+    struct frame_dec dec;
+    unsigned long reads = 0;
+    int fd = -1;
+    int len = 0;
+    int i = 0;
+
+    memset(&dec, 0, sizeof(dec));
+    dec.cfg = cfg;
+
+    fd = open(tty, O_RDWR | O_NOCTTY);
+    if (fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", tty, errno);
+        return -1;
+    }
+
+    if (frame_attach(fd, cfg))
+    {
+        close(fd);
+        return -1;
+    }
+
+    while ((len = frame_recv(fd, cfg, &dec, frame, &reads)) > 0)
+    {
+        printf("frame %d bytes:", len);
+        for (i = 0; i < len && i < 32; i++)
+        {
+            printf(" %02x", frame[i]);
+        }
+        printf("%s\n", len > 32 ? " ..." : "");
+    }
+
+    close(fd);
+
+    return len < 0 ? -1 : 0;
+}
+
+static void frame_usage(const char *name)
+{
+    printf("Usage:\n"
+           "\t%s [-m slip|cobs] [-c] [-N] tty\n"
+           "\t%s [-m slip|cobs] [-c] [-N] [-n frames] [-s size] pty\n",
+           name, name);
+}
+
+int main(int argc, char *argv[])
+{
+    struct frame_cfg cfg;
+    int opt = 0;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = FRAME_MODE_SLIP;
+    cfg.crc = 1;
+    cfg.frames = 100000;
+    cfg.size = 64;
+
+    while ((opt = getopt(argc, argv, "m:cNn:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            cfg.mode = !strcmp(optarg, "cobs") ? FRAME_MODE_COBS : FRAME_MODE_SLIP;
+            break;
+        case 'c':
+            cfg.crc = 0;
+            break;
+        case 'N':
+            cfg.n_tty = 1;
+            break;
+        case 'n':
+            cfg.frames = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            cfg.size = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            frame_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind != argc - 1 || cfg.size < 4 || cfg.size > FRAME_MAX)
+    {
+        frame_usage(argv[0]);
+        return -1;
+    }
+
+    if (!strcmp(argv[optind], "pty"))
+    {
+        return frame_self_test(&cfg) ? -1 : 0;
+    }
+
+    return frame_dump(argv[optind], &cfg) ? -1 : 0;
+}
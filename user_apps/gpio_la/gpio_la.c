@@ -0,0 +1,730 @@
+/**
+ * @file gpio_la.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief GPIO logic analyzer: samples the DATA_RO registers in a tight pinned loop.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details Usage:
+ *              gpio_la capture [-d dev] [-m banks] [-t sec] [-c cpu] [-k blocks] <file>
+ *              gpio_la vcd <file> <vcd file>
+ *              gpio_la bench [-m banks] [-t sec] [-c cpu] [-r toggles/s] [-k blocks] <file>
+ *          capture: dev is /dev/mem (default, GPIO block at 0xE000A000), /dev/uioN or a register
+ *          file, banks is a bank bitmask (default 0x3: MIO).
+ *          bench: same sampling loop on a simulated register block that a second thread toggles,
+ *          reports samples/s and bytes written per transition.
+ * @note HW:
+ *          - zynq 7020(正点原子领航者开发板)
+ *       OS: linux-xlnx-xilinx-v14.5.
+ *       Toolchain: arm-xilinx-linux-gnueabi-gcc (Sourcery CodeBench Lite 2012.09-104) 4.7.2
+ *                  (需安装Xilinx SDK 2013.1)
+ * @ref "ug585-Zynq-7000-TRM.pdf/Appendix B Register Details/B.19 General Purpose I/O (gpio)".
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "gpio_la.h"
+
+#define LA_DEFAULT_DEVICE   "/dev/mem"
+#define LA_DEFAULT_BANKS    0x3
+#define LA_DEFAULT_BLOCKS   256         /* 16MB ring */
+#define LA_CHECK_INTERVAL   0xFFFF      /* Samples between stop checks */
+
+struct la_capture {
+    struct la_file_header *hdr;
+    struct la_block_header *blk;        /* Block being written */
+    unsigned char *data;                /* Records of the current block */
+    unsigned char *map;
+    size_t map_size;
+    unsigned int banks[ZYNQ_GPIO_BANKS];
+    unsigned int offsets[ZYNQ_GPIO_BANKS];  /* DATA_RO offsets in words */
+    unsigned int nr_banks;
+    uint32_t block_data_size;
+    uint64_t bytes;                     /* Record bytes written */
+};
+
+struct la_generator {
+    volatile uint32_t *regs;
+    volatile int stop;
+    uint64_t rate;                      /* Toggles per second, 0: as fast as possible */
+    uint64_t toggles;
+    int cpu;
+};
+
+static volatile sig_atomic_t la_stop = 0;
+
+static void la_sig_handler(int sig)
+{
+    (void)sig;
+    la_stop = 1;
+}
+
+static uint64_t la_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void la_pin_cpu(int cpu)
+{
+    cpu_set_t set;
+
+    if (cpu < 0)
+    {
+        return;
+    }
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set))
+    {
+        fprintf(stderr, "Warn: sched_setaffinity(%d) failed, errno=%d!\n", cpu, errno);
+    }
+}
+
+static int la_capture_open(struct la_capture *cap, const char *path, uint32_t bank_mask, uint32_t nr_blocks)
+{
+    unsigned int bank = 0;
+    int fd = -1;
+
+    memset(cap, 0, sizeof(*cap));
+
+    for (bank = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+    {
+        if (bank_mask & (1U << bank))
+        {
+            cap->banks[cap->nr_banks] = bank;
+            cap->offsets[cap->nr_banks] = ZYNQ_GPIO_DATA_RO(bank) / 4;
+            cap->nr_banks++;
+        }
+    }
+
+    if (!cap->nr_banks || !nr_blocks)
+    {
+        fprintf(stderr, "Error: Invalid argument, banks=0x%x, blocks=%u!\n", bank_mask, nr_blocks);
+        return -1;
+    }
+
+    cap->map_size = LA_HEADER_SIZE + (size_t)nr_blocks * LA_BLOCK_SIZE;
+    cap->block_data_size = LA_BLOCK_SIZE - sizeof(struct la_block_header);
+
+    errno = 0;
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    if (ftruncate(fd, cap->map_size))
+    {
+        fprintf(stderr, "Error: ftruncate() failed, errno=%d!\n", errno);
+        close(fd);
+        return -1;
+    }
+
+    /* Fault the whole ring in now, not in the sampling loop. */
+    cap->map = mmap(NULL, cap->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (cap->map == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: mmap() failed, errno=%d!\n", errno);
+        cap->map = NULL;
+        return -1;
+    }
+
+    cap->hdr = (struct la_file_header *)cap->map;
+    cap->hdr->magic = LA_MAGIC;
+    cap->hdr->version = LA_VERSION;
+    cap->hdr->bank_mask = bank_mask;
+    cap->hdr->block_size = LA_BLOCK_SIZE;
+    cap->hdr->nr_blocks = nr_blocks;
+
+    return 0;
+}
+
+static void la_capture_close(struct la_capture *cap)
+{
+    if (cap->map)
+    {
+        msync(cap->map, cap->map_size, MS_ASYNC);
+        munmap(cap->map, cap->map_size);
+        cap->map = NULL;
+    }
+}
+
+/*
+ * Open the next block of the ring, the oldest one is overwritten.
+ */
+static void la_block_open(struct la_capture *cap, uint64_t first_sample, const uint32_t *keyframe,
+                          uint64_t sample)
+{
+    uint64_t seq = cap->hdr->next_seq++;
+    struct la_block_header *blk = (struct la_block_header *)
+        (cap->map + LA_HEADER_SIZE + (seq % cap->hdr->nr_blocks) * LA_BLOCK_SIZE);
+    unsigned int i = 0;
+
+    /* Invalid until the header is complete. */
+    blk->seq = 0;
+    blk->first_sample = first_sample;
+    blk->anchor_sample = sample;
+    blk->anchor_ns = la_now_ns();
+    memset(blk->keyframe, 0, sizeof(blk->keyframe));
+    for (i = 0; i < cap->nr_banks; i++)
+    {
+        blk->keyframe[cap->banks[i]] = keyframe[i];
+    }
+    blk->used = 0;
+    blk->records = 0;
+    blk->seq = seq + 1;
+
+    cap->blk = blk;
+    cap->data = (unsigned char *)(blk + 1);
+}
+
+static inline void la_put_record(struct la_capture *cap, uint64_t last, uint64_t sample,
+                                 const uint32_t *prev, const uint32_t *cur)
+{
+    unsigned char *p = NULL;
+    unsigned char *changed = NULL;
+    uint64_t delta = 0;
+    uint32_t x = 0;
+    unsigned int i = 0;
+
+    if (cap->blk->used + LA_RECORD_MAX > cap->block_data_size)
+    {
+        la_block_open(cap, last, prev, sample);
+    }
+
+    /* A new block starts at the previous record, so the delta is always from there. */
+    p = cap->data + cap->blk->used;
+    delta = sample - last;
+
+    while (delta >= 0x80)
+    {
+        *p++ = (unsigned char)(delta | 0x80);
+        delta >>= 7;
+    }
+    *p++ = (unsigned char)delta;
+
+    changed = p++;
+    *changed = 0;
+    for (i = 0; i < cap->nr_banks; i++)
+    {
+        x = prev[i] ^ cur[i];
+        if (x)
+        {
+            *changed |= 1U << cap->banks[i];
+            memcpy(p, &x, sizeof(x));
+            p += sizeof(x);
+        }
+    }
+
+    cap->bytes += p - (cap->data + cap->blk->used);
+    cap->blk->used = p - cap->data;
+    cap->blk->records++;
+}
+
+/*
+ * The hot loop: read every sampled DATA_RO register, store only transitions.
+ */
+static void la_sample_loop(struct la_capture *cap, volatile const uint32_t *regs,
+                           uint64_t duration_ns)
+{
+    uint32_t prev[ZYNQ_GPIO_BANKS];
+    uint32_t cur[ZYNQ_GPIO_BANKS];
+    uint64_t sample = 0;
+    uint64_t last = 0;
+    uint64_t transitions = 0;
+    uint64_t deadline = 0;
+    unsigned int nr = cap->nr_banks;
+    unsigned int i = 0;
+    int changed = 0;
+
+    for (i = 0; i < nr; i++)
+    {
+        prev[i] = regs[cap->offsets[i]];
+    }
+
+    cap->hdr->start_ns = la_now_ns();
+    deadline = duration_ns ? cap->hdr->start_ns + duration_ns : 0;
+    la_block_open(cap, 0, prev, 0);
+
+    while (1)
+    {
+        changed = 0;
+        for (i = 0; i < nr; i++)
+        {
+            cur[i] = regs[cap->offsets[i]];
+            changed |= cur[i] != prev[i];
+        }
+
+        sample++;
+
+        if (changed)
+        {
+            la_put_record(cap, last, sample, prev, cur);
+            memcpy(prev, cur, sizeof(prev[0]) * nr);
+            last = sample;
+            transitions++;
+        }
+
+        if (!(sample & LA_CHECK_INTERVAL))
+        {
+            if (la_stop || (deadline && la_now_ns() >= deadline))
+            {
+                break;
+            }
+        }
+    }
+
+    cap->hdr->end_ns = la_now_ns();
+    cap->hdr->samples = sample + 1;
+    cap->hdr->transitions = transitions;
+}
+
+static volatile uint32_t *la_map_regs(const char *dev, int *pfd)
+{
+    off_t offset = strcmp(dev, "/dev/mem") ? 0 : ZYNQ_GPIO_BASE;
+    void *addr = NULL;
+    int fd = -1;
+
+    errno = 0;
+    fd = open(dev, O_RDONLY | O_DSYNC);
+    if (fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", dev, errno);
+        return NULL;
+    }
+
+    addr = mmap(NULL, ZYNQ_GPIO_REGS_SIZE, PROT_READ, MAP_SHARED, fd, offset);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: mmap() failed, errno=%d!\n", errno);
+        close(fd);
+        return NULL;
+    }
+
+    *pfd = fd;
+
+    return (volatile uint32_t *)addr;
+}
+
+static void *la_generator_thread(void *arg)
+{
+    struct la_generator *gen = (struct la_generator *)arg;
+    volatile uint32_t *data_ro = gen->regs + ZYNQ_GPIO_DATA_RO(0) / 4;
+    uint64_t period = gen->rate ? 1000000000ULL / gen->rate : 0;
+    uint64_t next = la_now_ns();
+    uint32_t value = 0;
+
+    la_pin_cpu(gen->cpu);
+
+    while (!gen->stop)
+    {
+        if (period)
+        {
+            while (la_now_ns() < next)
+            {
+            }
+            next += period;
+        }
+
+        /* A binary counter on bank 0: bit n toggles at rate / 2^n. */
+        value++;
+        *data_ro = value;
+        gen->toggles++;
+    }
+
+    return NULL;
+}
+
+static void la_print_stats(struct la_capture *cap)
+{
+    struct la_file_header *hdr = cap->hdr;
+    double sec = (double)(hdr->end_ns - hdr->start_ns) / 1e9;
+
+    printf("samples: %llu, time: %.3f s, rate: %.0f samples/s\n",
+           (unsigned long long)hdr->samples, sec, sec > 0 ? hdr->samples / sec : 0.0);
+    printf("transitions: %llu, bytes: %llu, %.2f bytes/transition, blocks: %llu\n",
+           (unsigned long long)hdr->transitions, (unsigned long long)cap->bytes,
+           hdr->transitions ? (double)cap->bytes / hdr->transitions : 0.0,
+           (unsigned long long)hdr->next_seq);
+}
+
+static const char *la_signal_name(unsigned int bank, unsigned int bit, char *buf, size_t len)
+{
+    static const unsigned int base[ZYNQ_GPIO_BANKS] = {0, 32, 0, 32};
+
+    snprintf(buf, len, "%s%u", bank < 2 ? "MIO" : "EMIO", base[bank] + bit);
+
+    return buf;
+}
+
+static void la_vcd_id(unsigned int index, char id[4])
+{
+    id[0] = (char)('!' + index % 94);
+    id[1] = index >= 94 ? (char)('!' + index / 94) : '\0';
+    id[2] = '\0';
+}
+
+static int la_export_vcd(const char *path, const char *vcd_path)
+{
+    static const unsigned int bank_bits[ZYNQ_GPIO_BANKS] = {32, 22, 32, 32};
+    struct la_file_header *hdr = NULL;
+    struct la_block_header *blk = NULL;
+    unsigned char *map = NULL;
+    unsigned char *p = NULL;
+    unsigned char *end = NULL;
+    struct stat st;
+    FILE *vcd = NULL;
+    uint32_t state[ZYNQ_GPIO_BANKS];
+    uint32_t next[ZYNQ_GPIO_BANKS];
+    uint32_t x = 0;
+    uint64_t oldest = 0;
+    uint64_t seq = 0;
+    uint64_t sample = 0;
+    uint64_t t = 0;
+    uint64_t last_t = 0;
+    double period = 0;
+    unsigned int bank = 0;
+    unsigned int bit = 0;
+    unsigned int index = 0;
+    unsigned int shift = 0;
+    uint64_t delta = 0;
+    unsigned char changed = 0;
+    char name[16];
+    char id[4];
+    int first = 1;
+    int fd = -1;
+
+    errno = 0;
+    fd = open(path, O_RDONLY);
+    if (fd == -1 || fstat(fd, &st))
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: mmap() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    hdr = (struct la_file_header *)map;
+    if ((size_t)st.st_size < LA_HEADER_SIZE || hdr->magic != LA_MAGIC || hdr->version != LA_VERSION ||
+        (size_t)st.st_size < LA_HEADER_SIZE + (size_t)hdr->nr_blocks * hdr->block_size)
+    {
+        fprintf(stderr, "Error: <%s> is not a capture file!\n", path);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    vcd = fopen(vcd_path, "w");
+    if (!vcd)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", vcd_path, errno);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    if (hdr->samples > 1)
+    {
+        period = (double)(hdr->end_ns - hdr->start_ns) / (hdr->samples - 1);
+    }
+
+    fprintf(vcd, "$comment gpio_la, %llu samples, %.1f ns/sample $end\n",
+            (unsigned long long)hdr->samples, period);
+    fprintf(vcd, "$timescale 1ns $end\n$scope module gpio $end\n");
+    for (bank = 0, index = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+    {
+        if (!(hdr->bank_mask & (1U << bank)))
+        {
+            continue;
+        }
+
+        for (bit = 0; bit < bank_bits[bank]; bit++, index++)
+        {
+            la_vcd_id(index, id);
+            fprintf(vcd, "$var wire 1 %s %s $end\n", id, la_signal_name(bank, bit, name, sizeof(name)));
+        }
+    }
+    fprintf(vcd, "$upscope $end\n$enddefinitions $end\n");
+
+    oldest = hdr->next_seq > hdr->nr_blocks ? hdr->next_seq - hdr->nr_blocks : 0;
+    for (seq = oldest; seq < hdr->next_seq; seq++)
+    {
+        blk = (struct la_block_header *)(map + LA_HEADER_SIZE + (seq % hdr->nr_blocks) * hdr->block_size);
+        if (blk->seq != seq + 1)
+        {
+            continue;
+        }
+
+        p = (unsigned char *)(blk + 1);
+        end = p + blk->used;
+        sample = blk->first_sample;
+        memcpy(next, blk->keyframe, sizeof(next));
+
+        for (;;)
+        {
+            t = blk->anchor_ns - hdr->start_ns;
+            t = sample >= blk->anchor_sample ? t + (uint64_t)((sample - blk->anchor_sample) * period)
+                                             : t - (uint64_t)((blk->anchor_sample - sample) * period);
+            if (t < last_t || t > (uint64_t)1 << 62)
+            {
+                t = last_t;
+            }
+
+            /* Emit the bits that differ from the current state. */
+            for (bank = 0, x = 0; bank < ZYNQ_GPIO_BANKS && !first; bank++)
+            {
+                x |= state[bank] ^ next[bank];
+            }
+            if (first)
+            {
+                fprintf(vcd, "#%llu\n$dumpvars\n", (unsigned long long)t);
+            }
+            else if (x)
+            {
+                fprintf(vcd, "#%llu\n", (unsigned long long)t);
+            }
+            for (bank = 0, index = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+            {
+                if (!(hdr->bank_mask & (1U << bank)))
+                {
+                    continue;
+                }
+
+                x = first ? 0xFFFFFFFF : state[bank] ^ next[bank];
+                for (bit = 0; bit < bank_bits[bank]; bit++, index++)
+                {
+                    if (x & (1U << bit))
+                    {
+                        la_vcd_id(index, id);
+                        fprintf(vcd, "%u%s\n", (next[bank] >> bit) & 1, id);
+                    }
+                }
+            }
+            if (first)
+            {
+                fprintf(vcd, "$end\n");
+                first = 0;
+            }
+            memcpy(state, next, sizeof(state));
+            last_t = t;
+
+            if (p >= end)
+            {
+                break;
+            }
+
+            /* Next record. */
+            delta = 0;
+            shift = 0;
+            do
+            {
+                delta |= (uint64_t)(*p & 0x7F) << shift;
+                shift += 7;
+            } while (*p++ & 0x80 && p < end);
+
+            sample += delta;
+            changed = *p++;
+            for (bank = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+            {
+                if (changed & (1U << bank))
+                {
+                    memcpy(&x, p, sizeof(x));
+                    p += sizeof(x);
+                    next[bank] ^= x;
+                }
+            }
+        }
+    }
+
+    fclose(vcd);
+    munmap(map, st.st_size);
+
+    return 0;
+}
+
+static void la_usage(const char *name)
+{
+    printf("Usage:\n"
+           "\t%s capture [-d dev] [-m banks] [-t sec] [-c cpu] [-k blocks] <file>\n"
+           "\t%s vcd <file> <vcd file>\n"
+           "\t%s bench [-m banks] [-t sec] [-c cpu] [-r toggles/s] [-k blocks] <file>\n",
+           name, name, name);
+}
+
+int main(int argc, char *argv[])
+{
+    struct la_capture cap;
+    struct la_generator gen;
+    pthread_t gen_thread;
+    const char *dev = LA_DEFAULT_DEVICE;
+    const char *cmd = NULL;
+    volatile uint32_t *regs = NULL;
+    uint32_t bank_mask = LA_DEFAULT_BANKS;
+    uint32_t nr_blocks = LA_DEFAULT_BLOCKS;
+    double duration = 0;
+    uint64_t rate = 1000000;
+    int bench = 0;
+    int cpu = -1;
+    int fd = -1;
+    int opt = 0;
+
+    if (argc < 2)
+    {
+        la_usage(argv[0]);
+        return -1;
+    }
+
+    cmd = argv[1];
+    if (!strcmp(cmd, "vcd"))
+    {
+        if (argc != 4)
+        {
+            la_usage(argv[0]);
+            return -1;
+        }
+
+        return la_export_vcd(argv[2], argv[3]) ? -1 : 0;
+    }
+
+    if (!strcmp(cmd, "bench"))
+    {
+        bench = 1;
+        duration = 5;
+    }
+    else if (strcmp(cmd, "capture"))
+    {
+        la_usage(argv[0]);
+        return -1;
+    }
+
+    optind = 2;
+    while ((opt = getopt(argc, argv, "d:m:t:c:r:k:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            dev = optarg;
+            break;
+        case 'm':
+            bank_mask = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            duration = strtod(optarg, NULL);
+            break;
+        case 'c':
+            cpu = atoi(optarg);
+            break;
+        case 'r':
+            rate = strtoull(optarg, NULL, 0);
+            break;
+        case 'k':
+            nr_blocks = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            la_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind != argc - 1)
+    {
+        la_usage(argv[0]);
+        return -1;
+    }
+
+    if (la_capture_open(&cap, argv[optind], bank_mask, nr_blocks))
+    {
+        return -1;
+    }
+
+    if (bench)
+    {
+        /* Simulated register block. */
+        regs = mmap(NULL, ZYNQ_GPIO_REGS_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (regs == MAP_FAILED)
+        {
+            fprintf(stderr, "Error: mmap() failed, errno=%d!\n", errno);
+            la_capture_close(&cap);
+            return -1;
+        }
+
+        if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+        {
+            fprintf(stderr, "Warn: single CPU, the generator and the sampler time-share it!\n");
+        }
+
+        memset(&gen, 0, sizeof(gen));
+        gen.regs = regs;
+        gen.rate = rate;
+        gen.cpu = cpu < 0 ? -1 : (int)((cpu + 1) % sysconf(_SC_NPROCESSORS_ONLN));
+        if (pthread_create(&gen_thread, NULL, la_generator_thread, &gen))
+        {
+            fprintf(stderr, "Error: pthread_create() failed!\n");
+            la_capture_close(&cap);
+            return -1;
+        }
+    }
+    else
+    {
+        regs = la_map_regs(dev, &fd);
+        if (!regs)
+        {
+            la_capture_close(&cap);
+            return -1;
+        }
+    }
+
+    signal(SIGINT, la_sig_handler);
+    signal(SIGTERM, la_sig_handler);
+
+    mlockall(MCL_CURRENT | MCL_FUTURE);
+    la_pin_cpu(cpu);
+
+    la_sample_loop(&cap, regs, (uint64_t)(duration * 1e9));
+
+    if (bench)
+    {
+        gen.stop = 1;
+        pthread_join(gen_thread, NULL);
+        printf("generated: %llu toggles (%.0f toggles/s)\n", (unsigned long long)gen.toggles,
+               gen.toggles / ((double)(cap.hdr->end_ns - cap.hdr->start_ns) / 1e9));
+        munmap((void *)regs, ZYNQ_GPIO_REGS_SIZE);
+    }
+    else
+    {
+        munmap((void *)regs, ZYNQ_GPIO_REGS_SIZE);
+        close(fd);
+    }
+
+    la_print_stats(&cap);
+    la_capture_close(&cap);
+    munlockall();
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file gpio_la.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief GPIO logic analyzer capture file format.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details The capture file is a memory-mapped ring of fixed size blocks behind one header page.
+ *          Each block starts with a keyframe (all sampled banks) so it can be decoded on its
+ *          own once older blocks have been overwritten. Only transitions are stored:
+ *
+ *              record = varint(samples since previous record) | changed bank bitmap (1 byte)
+ *                       | XOR of each changed bank (4 bytes, little endian)
+ */
+
+#ifndef __GPIO_LA_H__
+#define __GPIO_LA_H__
+
+#include <stdint.h>
+
+#include "zynq_gpio.h"
+
+#define LA_MAGIC            0x4C414750  /* "PGAL" */
+#define LA_VERSION          1
+#define LA_HEADER_SIZE      4096
+#define LA_BLOCK_SIZE       (64 * 1024)
+#define LA_RECORD_MAX       (10 + 1 + 4 * ZYNQ_GPIO_BANKS)
+
+struct la_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t bank_mask;         /* Sampled banks, bit n: bank n */
+    uint32_t block_size;
+    uint32_t nr_blocks;
+    uint32_t reserved;
+    uint64_t start_ns;          /* CLOCK_MONOTONIC of the first sample */
+    uint64_t end_ns;            /* CLOCK_MONOTONIC of the last sample */
+    uint64_t samples;           /* Samples taken */
+    uint64_t transitions;       /* Records written */
+    uint64_t next_seq;          /* Sequence number of the next block */
+};
+
+struct la_block_header {
+    uint64_t seq;               /* Block sequence number + 1, 0: unused block */
+    uint64_t first_sample;      /* Sample index of the keyframe */
+    uint64_t anchor_sample;     /* Sample index when the block was opened */
+    uint64_t anchor_ns;         /* CLOCK_MONOTONIC when the block was opened */
+    uint32_t keyframe[ZYNQ_GPIO_BANKS];
+    uint32_t used;              /* Bytes of records after this header */
+    uint32_t records;
+};
+
+#endif /* __GPIO_LA_H__ */
@@ -0,0 +1,347 @@
+/**
+ * @file gpio_uio.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Zynq GPIO access from userspace through UIO (uio_pdrv_genirq).
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       Host mode on the zynq_sim model: same register accesses as on UIO.
+ * @date 2026-10-18
+ *       gpio_uio_irq_wait(): end of file on the interrupt source returns 0, not an error.
+ * @copyright Copyright (c) 2026
+ * @note HW:
+ *          - zynq 7020(正点原子领航者开发板)
+ *       OS: linux-xlnx-xilinx-v14.5, CONFIG_UIO_PDRV_GENIRQ=y.
+ *       Toolchain: arm-xilinx-linux-gnueabi-gcc (Sourcery CodeBench Lite 2012.09-104) 4.7.2
+ *                  (需安装Xilinx SDK 2013.1)
+ * @ref "ug585-Zynq-7000-TRM.pdf/Appendix B Register Details/B.19 General Purpose I/O (gpio)".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "gpio_uio.h"
+
+#define UIO_SYSFS_MAP0_SIZE "/sys/class/uio/%s/maps/map0/size"
+
+/*
+ * Size of the first memory region of a UIO device, from sysfs.
+ */
+static size_t gpio_uio_map_size(const char *dev)
+{
+    char path[128];
+    const char *name = strrchr(dev, '/');
+    unsigned long size = 0;
+    FILE *fp = NULL;
+
+    name = name ? name + 1 : dev;
+    snprintf(path, sizeof(path), UIO_SYSFS_MAP0_SIZE, name);
+
+    fp = fopen(path, "r");
+    if (!fp)
+    {
+        return ZYNQ_GPIO_REGS_SIZE;
+    }
+
+    if (fscanf(fp, "%lx", &size) != 1 || !size)
+    {
+        size = ZYNQ_GPIO_REGS_SIZE;
+    }
+
+    fclose(fp);
+
+    return size;
+}
+
+static int gpio_uio_map(struct gpio_uio *gpio)
+{
+    void *addr = NULL;
+
+    /* UIO: mmap offset N * page size selects memory region N. */
+    addr = mmap(NULL, gpio->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, gpio->fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: mmap() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    gpio->regs = (volatile uint32_t *)addr;
+
+    return 0;
+}
+
+int gpio_uio_open(struct gpio_uio *gpio, const char *dev)
+{
+    if (!gpio || !dev)
+    {
+        fprintf(stderr, "Error: Invalid argument!\n");
+        return -1;
+    }
+
+    memset(gpio, 0, sizeof(*gpio));
+
+    errno = 0;
+    gpio->fd = open(dev, O_RDWR | O_CLOEXEC);
+    if (gpio->fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", dev, errno);
+        return -1;
+    }
+
+    gpio->irq_fd = gpio->fd;
+    gpio->is_uio = 1;
+    gpio->map_size = gpio_uio_map_size(dev);
+
+    if (gpio_uio_map(gpio))
+    {
+        close(gpio->fd);
+        gpio->fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+int gpio_uio_open_host(struct gpio_uio *gpio, const char *path, int irq_fd)
+{
+    struct stat st;
+
+    if (!gpio || !path)
+    {
+        fprintf(stderr, "Error: Invalid argument!\n");
+        return -1;
+    }
+
+    memset(gpio, 0, sizeof(*gpio));
+
+    errno = 0;
+    gpio->fd = open(path, O_RDWR | O_CLOEXEC);
+    if (gpio->fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    /* The model file (user_apps/zynq_sim) starts with the whole register block. */
+    if (fstat(gpio->fd, &st) || st.st_size < ZYNQ_GPIO_REGS_SIZE)
+    {
+        fprintf(stderr, "Error: <%s> is not a register file, is zsim running?\n", path);
+        close(gpio->fd);
+        gpio->fd = -1;
+        return -1;
+    }
+
+    gpio->irq_fd = irq_fd;
+    gpio->is_uio = 0;
+    gpio->map_size = ZYNQ_GPIO_REGS_SIZE;
+
+    if (gpio_uio_map(gpio))
+    {
+        close(gpio->fd);
+        gpio->fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+void gpio_uio_close(struct gpio_uio *gpio)
+{
+    if (!gpio)
+    {
+        return;
+    }
+
+    if (gpio->regs)
+    {
+        munmap((void *)gpio->regs, gpio->map_size);
+        gpio->regs = NULL;
+    }
+
+    if (gpio->fd != -1)
+    {
+        close(gpio->fd);
+        gpio->fd = -1;
+    }
+
+    /* The host irq_fd belongs to the caller. */
+    gpio->irq_fd = -1;
+}
+
+void gpio_uio_set_output(struct gpio_uio *gpio, unsigned int pin, int output)
+{
+    unsigned int bank = ZYNQ_GPIO_PIN_BANK(pin);
+    uint32_t mask = ZYNQ_GPIO_PIN_MASK(pin);
+    uint32_t dirm = gpio_uio_reg_read(gpio, ZYNQ_GPIO_DIRM(bank));
+    uint32_t oen = gpio_uio_reg_read(gpio, ZYNQ_GPIO_OEN(bank));
+
+    if (output)
+    {
+        dirm |= mask;
+        oen |= mask;
+    }
+    else
+    {
+        dirm &= ~mask;
+        oen &= ~mask;
+    }
+
+    gpio_uio_reg_write(gpio, ZYNQ_GPIO_DIRM(bank), dirm);
+    gpio_uio_reg_write(gpio, ZYNQ_GPIO_OEN(bank), oen);
+}
+
+void gpio_uio_write_pin(struct gpio_uio *gpio, unsigned int pin, int value)
+{
+    unsigned int bank = ZYNQ_GPIO_PIN_BANK(pin);
+    unsigned int bit = ZYNQ_GPIO_PIN_BIT(pin);
+    unsigned int offset = bit < 16 ? ZYNQ_GPIO_MASK_DATA_LSW(bank) : ZYNQ_GPIO_MASK_DATA_MSW(bank);
+    uint32_t data = (value ? 1U : 0U) << (bit & 15);
+
+    /* Mask bits are active low: only the bit of this pin is written. */
+    gpio_uio_reg_write(gpio, offset, (~(1U << ((bit & 15) + 16)) & 0xFFFF0000) | data);
+}
+
+int gpio_uio_read_pin(struct gpio_uio *gpio, unsigned int pin)
+{
+    unsigned int bank = ZYNQ_GPIO_PIN_BANK(pin);
+
+    return (gpio_uio_reg_read(gpio, ZYNQ_GPIO_DATA_RO(bank)) & ZYNQ_GPIO_PIN_MASK(pin)) ? 1 : 0;
+}
+
+void gpio_uio_irq_config(struct gpio_uio *gpio, unsigned int pin, enum gpio_uio_irq_type type)
+{
+    unsigned int bank = ZYNQ_GPIO_PIN_BANK(pin);
+    uint32_t mask = ZYNQ_GPIO_PIN_MASK(pin);
+    uint32_t int_type = gpio_uio_reg_read(gpio, ZYNQ_GPIO_INT_TYPE(bank));
+    uint32_t polarity = gpio_uio_reg_read(gpio, ZYNQ_GPIO_INT_POLARITY(bank));
+    uint32_t any = gpio_uio_reg_read(gpio, ZYNQ_GPIO_INT_ANY(bank));
+
+    int_type &= ~mask;
+    polarity &= ~mask;
+    any &= ~mask;
+
+    switch (type)
+    {
+    case GPIO_UIO_IRQ_EDGE_RISING:
+        int_type |= mask;
+        polarity |= mask;
+        break;
+    case GPIO_UIO_IRQ_EDGE_FALLING:
+        int_type |= mask;
+        break;
+    case GPIO_UIO_IRQ_EDGE_BOTH:
+        int_type |= mask;
+        any |= mask;
+        break;
+    case GPIO_UIO_IRQ_LEVEL_HIGH:
+        polarity |= mask;
+        break;
+    case GPIO_UIO_IRQ_LEVEL_LOW:
+    default:
+        break;
+    }
+
+    gpio_uio_reg_write(gpio, ZYNQ_GPIO_INT_DIS(bank), mask);
+    gpio_uio_reg_write(gpio, ZYNQ_GPIO_INT_TYPE(bank), int_type);
+    gpio_uio_reg_write(gpio, ZYNQ_GPIO_INT_POLARITY(bank), polarity);
+    gpio_uio_reg_write(gpio, ZYNQ_GPIO_INT_ANY(bank), any);
+    /* Drop a stale edge latched while reconfiguring (write 1 to clear). */
+    gpio_uio_reg_write(gpio, ZYNQ_GPIO_INT_STAT(bank), mask);
+    gpio_uio_reg_write(gpio, ZYNQ_GPIO_INT_EN(bank), mask);
+}
+
+void gpio_uio_irq_mask(struct gpio_uio *gpio, unsigned int pin)
+{
+    gpio_uio_reg_write(gpio, ZYNQ_GPIO_INT_DIS(ZYNQ_GPIO_PIN_BANK(pin)), ZYNQ_GPIO_PIN_MASK(pin));
+}
+
+int gpio_uio_irq_enable(struct gpio_uio *gpio)
+{
+    uint32_t enable = 1;
+
+    /* Host: the zynq_sim irq FIFO has nothing to re-enable. */
+    if (!gpio->is_uio)
+    {
+        return 0;
+    }
+
+    errno = 0;
+    if (write(gpio->fd, &enable, sizeof(enable)) != sizeof(enable))
+    {
+        fprintf(stderr, "Error: write() irq enable failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+int gpio_uio_irq_wait(struct gpio_uio *gpio, uint32_t pending[ZYNQ_GPIO_BANKS])
+{
+    uint32_t uio_count = 0;
+    uint64_t evt_count = 0;
+    uint32_t stat = 0;
+    unsigned int bank = 0;
+    ssize_t ret = 0;
+    int count = 0;
+
+    errno = 0;
+    if (gpio->is_uio)
+    {
+        while ((ret = read(gpio->irq_fd, &uio_count, sizeof(uio_count))) == -1 && errno == EINTR)
+        {
+            errno = 0;
+        }
+        count = (int)uio_count;
+    }
+    else
+    {
+        while ((ret = read(gpio->irq_fd, &evt_count, sizeof(evt_count))) == -1 && errno == EINTR)
+        {
+            errno = 0;
+        }
+        count = (int)evt_count;
+    }
+
+    /* End of file: the writer of the host irq FIFO (zsim) has exited. */
+    if (ret == 0)
+    {
+        return 0;
+    }
+
+    if (ret < 0)
+    {
+        fprintf(stderr, "Error: read() irq failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    /* Clear the source before re-enabling the (level) interrupt line. */
+    for (bank = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+    {
+        stat = gpio_uio_reg_read(gpio, ZYNQ_GPIO_INT_STAT(bank)) &
+               ~gpio_uio_reg_read(gpio, ZYNQ_GPIO_INT_MASK(bank));
+        if (stat)
+        {
+            gpio_uio_reg_write(gpio, ZYNQ_GPIO_INT_STAT(bank), stat);
+        }
+
+        if (pending)
+        {
+            pending[bank] = stat;
+        }
+    }
+
+    if (gpio_uio_irq_enable(gpio))
+    {
+        return -1;
+    }
+
+    return count;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file gpio_uio.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Zynq GPIO access from userspace through UIO (uio_pdrv_genirq).
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       Host mode is the zynq_sim model, no register emulation in the library.
+ * @date 2026-10-18
+ *       gpio_uio_irq_wait() returns 0 at end of file of the interrupt source.
+ * @copyright Copyright (c) 2026
+ * @details The GPIO register block is mapped through /dev/uioN, no /dev/mem and no root
+ *          needed (only access to /dev/uioN). Interrupts are received with a blocking read()
+ *          on /dev/uioN and re-enabled with write().
+ *          On a host without the hardware, gpio_uio_open_host() maps the register file of
+ *          user_apps/zynq_sim instead and takes interrupts from its irq FIFO. The registers are
+ *          accessed exactly as on the hardware (MASK_DATA, INT_EN/INT_DIS, write-1-to-clear
+ *          INT_STAT), the model gives them their meaning; is_uio only selects the interrupt
+ *          source.
+ */
+
+#ifndef __GPIO_UIO_H__
+#define __GPIO_UIO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "zynq_gpio.h"
+
+struct gpio_uio {
+    int fd;                     /* /dev/uioN or register file */
+    int irq_fd;                 /* Interrupt source: fd for UIO, zynq_sim irq FIFO on host */
+    int is_uio;                 /* 1: real UIO device */
+    volatile uint32_t *regs;    /* Mapped register block */
+    size_t map_size;
+};
+
+enum gpio_uio_irq_type {
+    GPIO_UIO_IRQ_EDGE_RISING = 0,
+    GPIO_UIO_IRQ_EDGE_FALLING,
+    GPIO_UIO_IRQ_EDGE_BOTH,
+    GPIO_UIO_IRQ_LEVEL_HIGH,
+    GPIO_UIO_IRQ_LEVEL_LOW,
+};
+
+static inline uint32_t gpio_uio_reg_read(struct gpio_uio *gpio, unsigned int offset)
+{
+    return gpio->regs[offset / 4];
+}
+
+static inline void gpio_uio_reg_write(struct gpio_uio *gpio, unsigned int offset, uint32_t value)
+{
+    gpio->regs[offset / 4] = value;
+}
+
+/**
+ * @brief Open a UIO device (e.g. "/dev/uio0") and map its first memory region.
+ * @return 0 on success, -1 on error.
+ */
+int gpio_uio_open(struct gpio_uio *gpio, const char *dev);
+
+/**
+ * @brief Host: map the zynq_sim register file @p path (e.g. "/dev/shm/zynq_sim/regs"),
+ *        interrupts are read from @p irq_fd as 8 byte counts (the zynq_sim irq FIFO, or an
+ *        eventfd: a write of N counts as N interrupts).
+ * @return 0 on success, -1 on error.
+ */
+int gpio_uio_open_host(struct gpio_uio *gpio, const char *path, int irq_fd);
+
+void gpio_uio_close(struct gpio_uio *gpio);
+
+/**
+ * @brief Set pin direction, output enable follows direction.
+ */
+void gpio_uio_set_output(struct gpio_uio *gpio, unsigned int pin, int output);
+
+/**
+ * @brief Write an output pin through MASK_DATA, no read-modify-write of DATA.
+ */
+void gpio_uio_write_pin(struct gpio_uio *gpio, unsigned int pin, int value);
+
+int gpio_uio_read_pin(struct gpio_uio *gpio, unsigned int pin);
+
+/**
+ * @brief Configure the trigger of an input pin and unmask its interrupt.
+ */
+void gpio_uio_irq_config(struct gpio_uio *gpio, unsigned int pin, enum gpio_uio_irq_type type);
+
+void gpio_uio_irq_mask(struct gpio_uio *gpio, unsigned int pin);
+
+/**
+ * @brief (Re-)enable the interrupt line, UIO disables it each time it fires.
+ * @return 0 on success, -1 on error.
+ */
+int gpio_uio_irq_enable(struct gpio_uio *gpio);
+
+/**
+ * @brief Block until an interrupt arrives, then read and clear the pending (unmasked)
+ *        INT_STAT bits of every bank and re-enable the interrupt.
+ * @param[out] pending Pending bits per bank, may be NULL.
+ * @return Interrupt count reported by the source (UIO: running total, host: interrupts
+ *         since the previous wait), 0 when the source is closed (end of file, e.g. zsim
+ *         exited), -1 on error.
+ */
+int gpio_uio_irq_wait(struct gpio_uio *gpio, uint32_t pending[ZYNQ_GPIO_BANKS]);
+
+#endif /* __GPIO_UIO_H__ */
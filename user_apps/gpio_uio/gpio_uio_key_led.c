@@ -0,0 +1,121 @@
+/**
+ * @file gpio_uio_key_led.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Key/led demo in userspace through UIO, no /dev/mem and no key_irq.ko.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       -s with ZYNQ_GPIO_IRQ set: interrupts come from that FIFO (zynq_sim), no injector.
+ * @date 2026-10-18
+ *       LED_PIN/KEY_PIN from zynq_board.h (devicetree/dtgen).
+ * @date 2026-10-18
+ *       -s runs on zynq_sim only, the eventfd key injector is gone.
+ * @date 2026-10-18
+ *       Exit quietly when the interrupt source is closed.
+ * @copyright Copyright (c) 2026
+ * @details Every key press (interrupt on MIO12) toggles the led (MIO0).
+ *          Host: "-s <regs>" with ZYNQ_GPIO_IRQ=<fifo> runs on the register file and the irq
+ *          FIFO of user_apps/zynq_sim, whose script drives the key.
+ * @note HW:
+ *          - zynq 7020(正点原子领航者开发板)
+ *          - led: 核心板LED2(MIO0)
+ *          - key: PS_KEY0(MIO12)
+ *       OS: linux-xlnx-xilinx-v14.5, devicetree/gpio/gpio_uio/zynq-zc702-uio.dts.
+ *       Toolchain: arm-xilinx-linux-gnueabi-gcc (Sourcery CodeBench Lite 2012.09-104) 4.7.2
+ *                  (需安装Xilinx SDK 2013.1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "gpio_uio.h"
+#include "zynq_board.h"
+
+/* zynq-zc702-uio.dts删除了key节点，引脚取自同一块板的zynq-zc702.dts */
+#define LED_PIN BOARD_LED_GPIO
+#define KEY_PIN BOARD_KEY_GPIO
+
+int main(int argc, char *argv[])
+{
+    struct gpio_uio gpio;
+    uint32_t pending[ZYNQ_GPIO_BANKS];
+    unsigned int bank = ZYNQ_GPIO_PIN_BANK(KEY_PIN);
+    const char *irq_path = getenv("ZYNQ_GPIO_IRQ");
+    int irq_fd = -1;
+    int led = 0;
+    int ret = 0;
+
+    if (2 == argc)
+    {
+        ret = gpio_uio_open(&gpio, argv[1]);
+    }
+    else if (3 == argc && !strcmp(argv[1], "-s") && irq_path)
+    {
+        irq_fd = open(irq_path, O_RDONLY | O_CLOEXEC);
+        if (irq_fd == -1)
+        {
+            fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", irq_path, errno);
+            return -1;
+        }
+
+        ret = gpio_uio_open_host(&gpio, argv[2], irq_fd);
+    }
+    else
+    {
+        printf("Usage:\n\t%s /dev/uio0\n\tZYNQ_GPIO_IRQ=<zsim irq fifo> %s -s <zsim register file>\n",
+               argv[0], argv[0]);
+        return -1;
+    }
+
+    if (ret && irq_fd != -1)
+    {
+        close(irq_fd);
+    }
+
+    if (ret)
+    {
+        fprintf(stderr, "Error: gpio uio open failed!\n");
+        return -1;
+    }
+
+    gpio_uio_set_output(&gpio, LED_PIN, 1);
+    gpio_uio_write_pin(&gpio, LED_PIN, led);
+    gpio_uio_set_output(&gpio, KEY_PIN, 0);
+    gpio_uio_irq_config(&gpio, KEY_PIN, GPIO_UIO_IRQ_EDGE_FALLING);
+
+    if (gpio_uio_irq_enable(&gpio))
+    {
+        gpio_uio_close(&gpio);
+        return -1;
+    }
+
+    while (1)
+    {
+        ret = gpio_uio_irq_wait(&gpio, pending);
+        if (ret <= 0)
+        {
+            /* 0: zsim exited, its irq FIFO is closed. */
+            break;
+        }
+
+        if (pending[bank] & ZYNQ_GPIO_PIN_MASK(KEY_PIN))
+        {
+            led = !led;
+            gpio_uio_write_pin(&gpio, LED_PIN, led);
+            printf("Key Press, irq count: %d, led: %d\n", ret, led);
+        }
+    }
+
+    gpio_uio_close(&gpio);
+    if (irq_fd != -1)
+    {
+        close(irq_fd);
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file zynq_board.h
+ * @brief Board pins, registers and interrupts from zynq-zc702.dtb.
+ * @details Generated by devicetree/dtgen (-g 256 -s 0), do not edit.
+ */
+
+#ifndef __ZYNQ_BOARD_H__
+#define __ZYNQ_BOARD_H__
+
+/* strongly_order_mem: /reserved-memory/buffer0@0x09000000 */
+#define BOARD_STRONGLY_ORDER_MEM_BASE            0x09000000
+#define BOARD_STRONGLY_ORDER_MEM_SIZE            0x100000
+
+/* xdma_mem: /reserved-memory/buffer1@0x09100000 */
+#define BOARD_XDMA_MEM_BASE                      0x09100000
+#define BOARD_XDMA_MEM_SIZE                      0x100000
+
+/* ecat_recv_fifo_mem: /reserved-memory/buffer2@0x09200000 */
+#define BOARD_ECAT_RECV_FIFO_MEM_BASE            0x09200000
+#define BOARD_ECAT_RECV_FIFO_MEM_SIZE            0x1000
+
+/* ecat_send_fifo_mem: /reserved-memory/buffer2@0x09300000 */
+#define BOARD_ECAT_SEND_FIFO_MEM_BASE            0x09300000
+#define BOARD_ECAT_SEND_FIFO_MEM_SIZE            0x1000
+
+/* gic: /amba@0/intc@f8f01000, arm,cortex-a9-gic */
+#define BOARD_GIC_BASE                           0xf8f01000
+#define BOARD_GIC_SIZE                           0x1000
+
+/* ps7_ddrc_0: /amba@0/ps7-ddrc@f8006000, xlnx,ps7-ddrc-1.00.a */
+#define BOARD_PS7_DDRC_0_BASE                    0xf8006000
+#define BOARD_PS7_DDRC_0_SIZE                    0x1000
+
+/* ps7_ocm_0: /amba@0/ps7-ocm@0xfffc0000, xlnx,ps7-ocm */
+#define BOARD_PS7_OCM_0_BASE                     0xfffc0000
+#define BOARD_PS7_OCM_0_SIZE                     0x40000
+
+/* uart0: /amba@0/uart@e0000000, xlnx,ps7-uart-1.00.a */
+#define BOARD_UART0_BASE                         0xe0000000
+#define BOARD_UART0_SIZE                         0x1000
+#define BOARD_UART0_IRQ                          59           /* GIC SPI 27, IRQ_TYPE_LEVEL_HIGH */
+
+/* uart1: /amba@0/uart@e0001000, xlnx,ps7-uart-1.00.a */
+#define BOARD_UART1_BASE                         0xe0001000
+#define BOARD_UART1_SIZE                         0x1000
+#define BOARD_UART1_IRQ                          82           /* GIC SPI 50, IRQ_TYPE_LEVEL_HIGH */
+
+/* slcr: /amba@0/slcr@f8000000, xlnx,zynq-slcr */
+#define BOARD_SLCR_BASE                          0xf8000000
+#define BOARD_SLCR_SIZE                          0x1000
+
+/* i2c0: /amba@0/i2c@e0004000, xlnx,ps7-i2c-1.00.a */
+#define BOARD_I2C0_BASE                          0xe0004000
+#define BOARD_I2C0_SIZE                          0x1000
+#define BOARD_I2C0_IRQ                           57           /* GIC SPI 25, IRQ_TYPE_LEVEL_HIGH */
+
+/* gpio0: /amba@0/gpio@e000a000, xlnx,ps7-gpio-1.00.a */
+#define BOARD_GPIO0_BASE                         0xe000a000
+#define BOARD_GPIO0_SIZE                         0x1000
+#define BOARD_GPIO0_IRQ                          52           /* GIC SPI 20, IRQ_TYPE_LEVEL_HIGH */
+
+/* qspi0: /amba@0/spi@e000d000, xlnx,ps7-qspi-1.00.a */
+#define BOARD_QSPI0_BASE                         0xe000d000
+#define BOARD_QSPI0_SIZE                         0x1000
+#define BOARD_QSPI0_IRQ                          51           /* GIC SPI 19, IRQ_TYPE_LEVEL_HIGH */
+
+/* ps7_dma_s: /amba@0/ps7-dma@f8003000, xlnx,ps7-dma-1.00.a */
+#define BOARD_PS7_DMA_S_BASE                     0xf8003000
+#define BOARD_PS7_DMA_S_SIZE                     0x1000
+#define BOARD_PS7_DMA_S_IRQ                      45           /* GIC SPI 13, IRQ_TYPE_LEVEL_HIGH */
+#define BOARD_PS7_DMA_S_IRQ1                     46           /* GIC SPI 14, IRQ_TYPE_LEVEL_HIGH */
+#define BOARD_PS7_DMA_S_IRQ2                     47           /* GIC SPI 15, IRQ_TYPE_LEVEL_HIGH */
+#define BOARD_PS7_DMA_S_IRQ3                     48           /* GIC SPI 16, IRQ_TYPE_LEVEL_HIGH */
+#define BOARD_PS7_DMA_S_IRQ4                     49           /* GIC SPI 17, IRQ_TYPE_LEVEL_HIGH */
+#define BOARD_PS7_DMA_S_IRQ5                     72           /* GIC SPI 40, IRQ_TYPE_LEVEL_HIGH */
+#define BOARD_PS7_DMA_S_IRQ6                     73           /* GIC SPI 41, IRQ_TYPE_LEVEL_HIGH */
+#define BOARD_PS7_DMA_S_IRQ7                     74           /* GIC SPI 42, IRQ_TYPE_LEVEL_HIGH */
+#define BOARD_PS7_DMA_S_IRQ8                     75           /* GIC SPI 43, IRQ_TYPE_LEVEL_HIGH */
+
+/* /key, alientek,key */
+#define BOARD_KEY_IRQ                            268          /* gpio0 pin 12, IRQ_TYPE_EDGE_BOTH */
+#define BOARD_KEY_IRQ_TYPE                       3
+#define BOARD_KEY_GPIO                           12           /* gpio0 MIO12 */
+#define BOARD_KEY_GPIO_FLAGS                     1
+#define BOARD_KEY_GPIO_ACTIVE_LOW                1
+#define BOARD_KEY_GPIO_NUM                       12           /* sysfs/legacy GPIO number */
+#define BOARD_KEY_GPIO_STR                       "12"
+#define BOARD_KEY_GPIO_BANK                      0
+#define BOARD_KEY_GPIO_BIT                       12
+#define BOARD_KEY_GPIO_MASK                      0x00001000U
+
+/* /led, alientek,led */
+#define BOARD_LED_GPIO                           0            /* gpio0 MIO0 */
+#define BOARD_LED_GPIO_FLAGS                     0
+#define BOARD_LED_GPIO_ACTIVE_LOW                0
+#define BOARD_LED_GPIO_NUM                       0            /* sysfs/legacy GPIO number */
+#define BOARD_LED_GPIO_STR                       "0"
+#define BOARD_LED_GPIO_BANK                      0
+#define BOARD_LED_GPIO_BIT                       0
+#define BOARD_LED_GPIO_MASK                      0x00000001U
+
+#endif /* __ZYNQ_BOARD_H__ */
@@ -0,0 +1,47 @@
+/**
+ * @file zynq_gpio.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Zynq-7000 GPIO controller register map.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @ref "ug585-Zynq-7000-TRM.pdf/Appendix B Register Details/B.19 General Purpose I/O (gpio)".
+ */
+
+#ifndef __ZYNQ_GPIO_H__
+#define __ZYNQ_GPIO_H__
+
+#define ZYNQ_GPIO_BASE          0xE000A000
+#define ZYNQ_GPIO_REGS_SIZE     0x1000
+
+/*
+ * Bank 0: MIO[31:0], bank 1: MIO[53:32], bank 2/3: EMIO[31:0]/EMIO[63:32].
+ */
+#define ZYNQ_GPIO_BANKS         4
+#define ZYNQ_GPIO_PINS          118
+
+/*
+ * MASK_DATA_LSW/MSW: [31:16] mask (0: write), [15:0] data, for pins [15:0]/[31:16].
+ */
+#define ZYNQ_GPIO_MASK_DATA_LSW(bank)   (0x00000000 + 8 * (bank))
+#define ZYNQ_GPIO_MASK_DATA_MSW(bank)   (0x00000004 + 8 * (bank))
+#define ZYNQ_GPIO_DATA(bank)            (0x00000040 + 4 * (bank))
+#define ZYNQ_GPIO_DATA_RO(bank)         (0x00000060 + 4 * (bank))
+#define ZYNQ_GPIO_DIRM(bank)            (0x00000204 + 0x40 * (bank))
+#define ZYNQ_GPIO_OEN(bank)             (0x00000208 + 0x40 * (bank))
+#define ZYNQ_GPIO_INT_MASK(bank)        (0x0000020C + 0x40 * (bank))    /* RO, 1: masked */
+#define ZYNQ_GPIO_INT_EN(bank)          (0x00000210 + 0x40 * (bank))    /* WO, 1: unmask */
+#define ZYNQ_GPIO_INT_DIS(bank)         (0x00000214 + 0x40 * (bank))    /* WO, 1: mask */
+#define ZYNQ_GPIO_INT_STAT(bank)        (0x00000218 + 0x40 * (bank))    /* W1C */
+#define ZYNQ_GPIO_INT_TYPE(bank)        (0x0000021C + 0x40 * (bank))    /* 1: edge, 0: level */
+#define ZYNQ_GPIO_INT_POLARITY(bank)    (0x00000220 + 0x40 * (bank))    /* 1: high/rising */
+#define ZYNQ_GPIO_INT_ANY(bank)         (0x00000224 + 0x40 * (bank))    /* 1: both edges */
+
+/* Pin number -> bank, bit in bank. */
+#define ZYNQ_GPIO_PIN_BANK(pin)         ((pin) < 32 ? 0 : (pin) < 54 ? 1 : (pin) < 86 ? 2 : 3)
+#define ZYNQ_GPIO_PIN_BIT(pin)          ((pin) < 32 ? (pin) : (pin) < 54 ? (pin) - 32 : \
+                                         (pin) < 86 ? (pin) - 54 : (pin) - 86)
+#define ZYNQ_GPIO_PIN_MASK(pin)         (1U << ZYNQ_GPIO_PIN_BIT(pin))
+
+#endif /* __ZYNQ_GPIO_H__ */
@@ -5,6 +5,11 @@
  * @version 0.1
  * @date 2023-12-08
  *       Create this file.
+ * @date 2026-10-18
+ *       irq_server logs through the trace buffer instead of printf() (no mode switch per
+ *       interrupt), ./xenomai_userspace_irq [trace_file], read it with user_apps/trace/trace_dump.
+ * @date 2026-10-18
+ *       IRQ_NUMBER from zynq_board.h (devicetree/dtgen): key interrupt on gpio0, not a literal 268.
  * @copyright Copyright (c) 2023
  * @details Xenomai Interrupt management services API usage demo.
  * @note HW: 
@@ -17,14 +22,22 @@
  */
 
 #include <sys/mman.h>
+#include <signal.h>
+#include <unistd.h>
 #include <native/task.h>
 #include <native/intr.h>
+#include <native/timer.h>
 
-#define IRQ_NUMBER 268 /* GPIO 20(52 - 32). */
+#include "trace.h"
+#include "zynq_board.h"
+
+#define IRQ_NUMBER BOARD_KEY_IRQ /* gpio0中断号起始(256) + MIO12，见devicetree/dtgen */
 #define TASK_PRIO  99  /* Highest RT priority */
 #define TASK_MODE  0   /* No flags */
 #define TASK_STKSZ 0   /* Stack size (use default one) */
 
+#define TRACE_FILE "/tmp/irq_server.trc"
+
 RT_INTR intr_desc;
 RT_TASK server_desc;
 
@@ -45,19 +58,33 @@ void irq_server (void *cookie)
 
     printf("rt_intr_enable(), OK.\n");
 
+    /* Ring allocated here, the loop below only writes to memory (no mode switch). */
+    trace_thread_init();
+
     while (1)
     {
         cnt = rt_intr_wait(&intr_desc,TM_INFINITE);
 
         if (cnt < 0)
         {
-            fprintf(stderr, "Error:ret=%d !\n", err);
+            TRACE("Error:ret=%d !", cnt);
         }
 
-        printf("int cnt: %d.\n", cnt);
+        TRACE("int cnt: %d.", cnt);
     }
 }
 
+/* Nucleus time, readable from primary mode without a Linux syscall. */
+static uint64_t irq_trace_clock(void)
+{
+    return rt_timer_tsc2ns(rt_timer_tsc());
+}
+
+static void irq_signal(int signo)
+{
+    /* Only to wake up pause() */
+}
+
 void cleanup (void)
 {
     rt_intr_disable(&intr_desc);
@@ -69,9 +96,21 @@ int main (int argc, char *argv[])
 {
     int err;
     RT_TASK main_task;
+    const char *trace_file = argc > 1 ? argv[1] : TRACE_FILE;
 
     mlockall(MCL_CURRENT|MCL_FUTURE);
 
+    trace_set_clock(irq_trace_clock, "xenomai_tsc");
+    if (trace_init(trace_file, 0))
+    {
+        fprintf(stderr, "Error: trace_init() failed!\n");
+        return -1;
+    }
+    printf("Trace file: %s (trace_dump %s)\n", trace_file, trace_file);
+
+    signal(SIGINT, irq_signal);
+    signal(SIGTERM, irq_signal);
+
     err = rt_task_shadow(&main_task, "main", 0, 0);
     if (err)
     {
@@ -110,6 +149,7 @@ int main (int argc, char *argv[])
 
     pause();
     cleanup();
+    trace_exit();
     munlockall();
 
     return 0;
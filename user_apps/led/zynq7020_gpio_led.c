@@ -5,6 +5,14 @@
  * @version 0.1
  * @date 2023-12-06
  *       Create this file.
+ * @date 2026-10-18
+ *       Toggle from an evloop timer instead of sleep(), SIGINT/SIGTERM exit through gpio_cleanup().
+ * @date 2026-10-18
+ *       ZYNQ_GPIO_DEV: map a register file at offset 0 instead of /dev/mem (zynq_sim), mmap
+ *       failure check against MAP_FAILED.
+ * @date 2026-10-18
+ *       Register base, bank and pin mask from zynq_board.h (devicetree/dtgen) instead of hard-coded
+ *       GPIO_BASE/BANK0_* values.
  * @copyright Copyright (c) 2023
  * @note HW: 
  *          - zynq 7020(正点原子领航者开发板)
@@ -16,61 +24,70 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <signal.h>
 
-#define GPIO_BASE 0xE000A000
-#define GPIO_REGS_MAP_SIZE 1024
+#include "evloop.h"
+#include "zynq_gpio.h"
+#include "zynq_board.h"
 
-/*
- * MIO0
- */
-#define BANK0_DIRM_REG_OFFSET 0x00000204
-#define BANK0_OUTEN_REG_OFFSET 0x00000208
-#define BANK0_OUTPUT_DATA_TEG_OFFSET 0x00000040
+/* gpio0、led-gpio均来自设备树(zynq_board.h)，换板或换引脚只需重新生成头文件 */
+#define GPIO_BASE BOARD_GPIO0_BASE
+#define GPIO_REGS_MAP_SIZE BOARD_GPIO0_SIZE
+
+#define LED_DIRM_REG_OFFSET ZYNQ_GPIO_DIRM(BOARD_LED_GPIO_BANK)
+#define LED_OUTEN_REG_OFFSET ZYNQ_GPIO_OEN(BOARD_LED_GPIO_BANK)
+#define LED_OUTPUT_DATA_REG_OFFSET ZYNQ_GPIO_DATA(BOARD_LED_GPIO_BANK)
+#define LED_MASK BOARD_LED_GPIO_MASK
 
 static void *gpio_base = NULL;
-static volatile unsigned int *gpio_bank0_output_data_reg = NULL;
+static volatile unsigned int *gpio_led_data_reg = NULL;
 
 static int gpio_init()
 {
     unsigned int value;
     volatile unsigned int *addr = NULL;
+    /* 主机上用zynq_sim的寄存器文件代替/dev/mem，从文件偏移0开始映射 */
+    const char *dev = getenv("ZYNQ_GPIO_DEV");
+    off_t offset = dev ? 0 : GPIO_BASE;
 
-    int fd = open("/dev/mem", O_RDWR | O_DSYNC);
+    int fd = open(dev ? dev : "/dev/mem", O_RDWR | O_DSYNC);
     if (fd == -1)
     {
         perror("open '/dev/mem' error!");
         return -1;
     }
 
-    gpio_base = mmap(NULL, GPIO_REGS_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, GPIO_BASE);
-    if (gpio_base == NULL)
+    gpio_base = mmap(NULL, GPIO_REGS_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+    if (gpio_base == MAP_FAILED)
     {
         perror("mmap error!");
+        gpio_base = NULL;
         close(fd);
         return -1;
     }
     
-    gpio_bank0_output_data_reg = (volatile unsigned int *)((char *)gpio_base + BANK0_OUTPUT_DATA_TEG_OFFSET);
+    gpio_led_data_reg = (volatile unsigned int *)((char *)gpio_base + LED_OUTPUT_DATA_REG_OFFSET);
 
     /*
      * Set direction: output.
      */
-    addr = (volatile unsigned int *)((char *)gpio_base + BANK0_DIRM_REG_OFFSET);
+    addr = (volatile unsigned int *)((char *)gpio_base + LED_DIRM_REG_OFFSET);
     value = *addr;
-    value |= (1 << 0);
+    value |= LED_MASK;
     *addr = value;
     
     /*
      * Set output enable.
      */
-    addr = (volatile unsigned int *)((char *)gpio_base + BANK0_OUTEN_REG_OFFSET);
+    addr = (volatile unsigned int *)((char *)gpio_base + LED_OUTEN_REG_OFFSET);
     value = *addr;
-    value |= (1 << 0);
+    value |= LED_MASK;
     *addr = value;
 
     close(fd);
@@ -93,50 +110,89 @@ static int gpio_cleanup()
         gpio_base = NULL;
     }
 
-    gpio_bank0_output_data_reg = NULL;
+    gpio_led_data_reg = NULL;
 
     return 0;
 }
 
-static void gpio_pin0_output(unsigned int value)
+static void gpio_led_output(unsigned int value)
 {
     unsigned int cur_val = 0;
 
-    if (!gpio_bank0_output_data_reg)
+    if (!gpio_led_data_reg)
     {
         fprintf(stderr, "Error: reg is no mapped!\n");
         return;
     }
 
-    cur_val = *gpio_bank0_output_data_reg;
+    cur_val = *gpio_led_data_reg;
 
     if (!value)
     {
-        cur_val &= (~(1 << 0));
+        cur_val &= ~LED_MASK;
     }
     else
     {
-        cur_val |= (1 << 0);
+        cur_val |= LED_MASK;
     }
 
-    *gpio_bank0_output_data_reg = cur_val;
+    *gpio_led_data_reg = cur_val;
+}
+
+#define LED_TOGGLE_MS       1000
+#define LED_TOGGLES         20
+
+static unsigned int led_value = 1;
+static int led_toggles = 0;
+
+static void led_toggle(struct ev_loop *loop, struct ev_timer *timer)
+{
+    led_value = !led_value;
+    gpio_led_output(led_value);
+
+    if (++led_toggles >= LED_TOGGLES)
+    {
+        ev_loop_break(loop);
+    }
+}
+
+static void led_quit(struct ev_loop *loop, struct ev_signal *sig)
+{
+    ev_loop_break(loop);
 }
 
 int main()
 {
-    int i = 0;
+    struct ev_loop loop;
+    struct ev_timer timer;
+    struct ev_signal sigint;
+    struct ev_signal sigterm;
 
-    gpio_init();
+    if (ev_loop_init(&loop))
+    {
+        return -1;
+    }
 
-    while (i++ < 10)
+    if (ev_signal_start(&loop, &sigint, SIGINT, led_quit) ||
+        ev_signal_start(&loop, &sigterm, SIGTERM, led_quit))
     {
-        sleep(1);
-        gpio_pin0_output(0);
-        sleep(1);
-        gpio_pin0_output(1);
+        ev_loop_exit(&loop);
+        return -1;
     }
 
+    if (gpio_init())
+    {
+        ev_loop_exit(&loop);
+        return -1;
+    }
+
+    /* 与原先的sleep(1)循环一致：每秒翻转一次，共10个周期 */
+    ev_timer_init(&timer, led_toggle);
+    ev_timer_start(&loop, &timer, LED_TOGGLE_MS, LED_TOGGLE_MS);
+    ev_loop_run(&loop);
+
     gpio_cleanup();
+    ev_loop_exit(&loop);
 
     return 0;
 }
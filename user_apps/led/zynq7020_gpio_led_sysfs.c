@@ -5,6 +5,12 @@
  * @version 0.1
  * @date 2023-12-06
  *       Create this file.
+ * @date 2026-10-18
+ *       Toggle from an evloop timer instead of sleep(), SIGINT/SIGTERM exit through gpio_cleanup().
+ * @date 2026-10-18
+ *       ZYNQ_GPIO_SYSFS: directory used instead of /sys/class/gpio (zynq_sim).
+ * @date 2026-10-18
+ *       LED GPIO number from zynq_board.h (devicetree/dtgen) instead of hard-coded "0"/"gpio0".
  * @copyright Copyright (c) 2023
  * @note HW: 
  *          - zynq 7020(正点原子领航者开发板)
@@ -15,61 +21,85 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <signal.h>
 
-#define FILE_PATH_GPIO_EXPORT "/sys/class/gpio/export"
-#define FILE_PATH_GPIO_UNEXPORT "/sys/class/gpio/unexport"
-#define FILE_PATH_GPIO_PIN0_DIRECTION "/sys/class/gpio/gpio0/direction"
-#define FILE_PATH_GPIO_PIN0_VALUE "/sys/class/gpio/gpio0/value"
+#include "evloop.h"
+#include "zynq_board.h"
 
-static int gpio_pin0_value_fd = -1;
+#define FILE_PATH_GPIO_SYSFS "/sys/class/gpio"
+#define FILE_PATH_MAX 256
+
+/* 主机上由环境变量ZYNQ_GPIO_SYSFS指向zynq_sim的gpio目录 */
+static char gpio_export_path[FILE_PATH_MAX];
+static char gpio_unexport_path[FILE_PATH_MAX];
+static char gpio_led_direction_path[FILE_PATH_MAX];
+static char gpio_led_value_path[FILE_PATH_MAX];
+
+static void gpio_paths_init(void)
+{
+    const char *dir = getenv("ZYNQ_GPIO_SYSFS");
+
+    if (!dir)
+    {
+        dir = FILE_PATH_GPIO_SYSFS;
+    }
+
+    snprintf(gpio_export_path, FILE_PATH_MAX, "%s/export", dir);
+    snprintf(gpio_unexport_path, FILE_PATH_MAX, "%s/unexport", dir);
+    snprintf(gpio_led_direction_path, FILE_PATH_MAX, "%s/gpio" BOARD_LED_GPIO_STR "/direction", dir);
+    snprintf(gpio_led_value_path, FILE_PATH_MAX, "%s/gpio" BOARD_LED_GPIO_STR "/value", dir);
+}
+
+static int gpio_led_value_fd = -1;
 
 static int gpio_init()
 {
     int exportfd = -1;
-    int gpio_pin0_dir_fd = -1;
+    int gpio_led_dir_fd = -1;
     int ret = 0;
 
-    exportfd = open(FILE_PATH_GPIO_EXPORT, O_WRONLY);
+    exportfd = open(gpio_export_path, O_WRONLY);
     if (exportfd == -1)
     {
-        perror("open " FILE_PATH_GPIO_EXPORT " error!");
+        fprintf(stderr, "open %s error!: %m\n", gpio_export_path);
         goto err;
     }
 
-    ret = write(exportfd, "0", 2);
+    ret = write(exportfd, BOARD_LED_GPIO_STR, sizeof(BOARD_LED_GPIO_STR));
     if (ret == -1)
     {
-        perror("write " FILE_PATH_GPIO_EXPORT " error!");
+        fprintf(stderr, "write %s error!: %m\n", gpio_export_path);
         goto err;
     }
 
-    gpio_pin0_dir_fd = open(FILE_PATH_GPIO_PIN0_DIRECTION, O_RDWR);
-    if (gpio_pin0_dir_fd == -1)
+    gpio_led_dir_fd = open(gpio_led_direction_path, O_RDWR);
+    if (gpio_led_dir_fd == -1)
     {
-        perror("open " FILE_PATH_GPIO_PIN0_DIRECTION " error!");
+        fprintf(stderr, "open %s error!: %m\n", gpio_led_direction_path);
         goto err;
     }
 
-    ret = write(gpio_pin0_dir_fd, "out", 4);
+    ret = write(gpio_led_dir_fd, "out", 4);
     if (ret == -1)
     {
-        perror("write " FILE_PATH_GPIO_PIN0_DIRECTION " error!");
+        fprintf(stderr, "write %s error!: %m\n", gpio_led_direction_path);
         goto err;
     }
 
-    gpio_pin0_value_fd = open(FILE_PATH_GPIO_PIN0_VALUE, O_RDWR);
-    if (gpio_pin0_value_fd == -1)
+    gpio_led_value_fd = open(gpio_led_value_path, O_RDWR);
+    if (gpio_led_value_fd == -1)
     {
-        perror("open " FILE_PATH_GPIO_PIN0_VALUE " error!");
+        fprintf(stderr, "open %s error!: %m\n", gpio_led_value_path);
         goto err;
     }
 
     close(exportfd);
-    close(gpio_pin0_dir_fd);
+    close(gpio_led_dir_fd);
 
     return 0;
 
@@ -78,9 +108,9 @@ err:
     {
         close(exportfd);
     }
-    if (gpio_pin0_dir_fd != -1)
+    if (gpio_led_dir_fd != -1)
     {
-        close(gpio_pin0_dir_fd);
+        close(gpio_led_dir_fd);
     }
     
     return -1;
@@ -91,23 +121,23 @@ static int gpio_cleanup()
     int ret = 0;
     int unexportfd = -1;
     
-    if (gpio_pin0_value_fd != -1)
+    if (gpio_led_value_fd != -1)
     {
-        close(gpio_pin0_value_fd);
-        gpio_pin0_value_fd = -1;
+        close(gpio_led_value_fd);
+        gpio_led_value_fd = -1;
     }
 
-    unexportfd = open(FILE_PATH_GPIO_UNEXPORT, O_WRONLY);
+    unexportfd = open(gpio_unexport_path, O_WRONLY);
     if (unexportfd == -1)
     {
-        perror("open " FILE_PATH_GPIO_UNEXPORT " error!");
+        fprintf(stderr, "open %s error!: %m\n", gpio_unexport_path);
         return -1;
     }
 
-    ret = write(unexportfd, "0", 2);
+    ret = write(unexportfd, BOARD_LED_GPIO_STR, sizeof(BOARD_LED_GPIO_STR));
     if (ret == -1)
     {
-        perror("write " FILE_PATH_GPIO_UNEXPORT " error!");
+        fprintf(stderr, "write %s error!: %m\n", gpio_unexport_path);
         close(unexportfd);
         return -1;
     }
@@ -117,38 +147,74 @@ static int gpio_cleanup()
     return 0;
 }
 
-static void gpio_pin0_output(unsigned int value)
+static void gpio_led_output(unsigned int value)
 {
     int ret = 0;
 
-    if (gpio_pin0_value_fd == -1)
+    if (gpio_led_value_fd == -1)
     {
         fprintf(stderr, "Error: gpio output error!\n");
         return;
     }
 
-    ret = write(gpio_pin0_value_fd, value == 0 ? "0" : "1", 2);
+    ret = write(gpio_led_value_fd, value == 0 ? "0" : "1", 2);
     if (ret == -1)
     {
-        perror("write " FILE_PATH_GPIO_PIN0_VALUE " error!");
+        fprintf(stderr, "write %s error!: %m\n", gpio_led_value_path);
+    }
+}
+
+#define LED_TOGGLE_MS       1000
+#define LED_TOGGLES         20
+
+static unsigned int led_value = 1;
+static int led_toggles = 0;
+
+static void led_toggle(struct ev_loop *loop, struct ev_timer *timer)
+{
+    led_value = !led_value;
+    gpio_led_output(led_value);
+
+    if (++led_toggles >= LED_TOGGLES)
+    {
+        ev_loop_break(loop);
     }
 }
 
+static void led_quit(struct ev_loop *loop, struct ev_signal *sig)
+{
+    ev_loop_break(loop);
+}
+
 int main()
 {
-    int i = 0;
+    struct ev_loop loop;
+    struct ev_timer timer;
+    struct ev_signal sigint;
+    struct ev_signal sigterm;
 
-    gpio_init();
+    if (ev_loop_init(&loop))
+    {
+        return -1;
+    }
 
-    while (i++ < 10)
+    if (ev_signal_start(&loop, &sigint, SIGINT, led_quit) ||
+        ev_signal_start(&loop, &sigterm, SIGTERM, led_quit))
     {
-        sleep(1);
-        gpio_pin0_output(0);
-        sleep(1);
-        gpio_pin0_output(1);
+        ev_loop_exit(&loop);
+        return -1;
     }
 
+    gpio_paths_init();
+    gpio_init();
+
+    /* 与原先的sleep(1)循环一致：每秒翻转一次，共10个周期 */
+    ev_timer_init(&timer, led_toggle);
+    ev_timer_start(&loop, &timer, LED_TOGGLE_MS, LED_TOGGLE_MS);
+    ev_loop_run(&loop);
+
     gpio_cleanup();
+    ev_loop_exit(&loop);
 
     return 0;
 }
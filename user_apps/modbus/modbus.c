@@ -0,0 +1,548 @@
+/**
+ * @file modbus.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Modbus RTU master, slave simulator and pty benchmark.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details Usage:
+ *              modbus master [options] tty...   poll every port, one request in flight per port
+ *              modbus slave  [options] tty...   serve 256 holding registers (value = address)
+ *              modbus bench  [options]          master and slave simulator on pty pairs
+ *          Options:
+ *              -b baud     (115200)            -u unit     (1)
+ *              -f 3|4|6|16 function (3)        -a addr     (0)
+ *              -c count    registers (10)      -T ms       response timeout (100)
+ *              -t sec      run time            -n ports    pty pairs for bench (1)
+ *              -s          drop frames with a gap > t1.5
+ *              -v          print every response
+ *          All ports are polled from one epoll loop. Every port always has its next request
+ *          on the line as soon as the previous one completes, so N ports run N transactions
+ *          in parallel.
+ * @note OS: linux-xlnx-xilinx-v14.5.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "serial.h"
+#include "modbus_rtu.h"
+
+#define MB_PORTS_MAX    32
+#define MB_SLAVE_REGS   256
+
+struct mb_port_ctx {
+    struct mb_port port;
+    char name[64];
+    unsigned long ok;
+    unsigned long failed;
+    uint64_t req_ns;            /* Start of the current request */
+    uint64_t latency_ns;        /* Sum over successful transactions */
+    uint64_t latency_max_ns;
+    uint16_t seq;
+};
+
+struct mb_app {
+    struct mb_port_ctx ports[MB_PORTS_MAX];
+    unsigned int nr;
+    int master;
+    unsigned int baud;
+    unsigned int timeout_ms;
+    uint8_t unit;
+    uint8_t function;
+    uint16_t addr;
+    uint16_t count;
+    double duration;
+    unsigned int pairs;
+    int strict_t15;
+    int verbose;
+
+    struct mb_slave slave;
+    uint16_t slave_regs[MB_SLAVE_REGS];
+    uint16_t values[MB_REGS_MAX];
+};
+
+static volatile sig_atomic_t mb_stop = 0;
+
+static void mb_sig_handler(int sig)
+{
+    (void)sig;
+    mb_stop = 1;
+}
+
+static int mb_app_request(struct mb_app *app, struct mb_port_ctx *ctx)
+{
+    unsigned int i = 0;
+
+    ctx->req_ns = mb_now_ns();
+    ctx->seq++;
+
+    switch (app->function)
+    {
+    case MB_FC_WRITE_SINGLE:
+        return mb_master_write_reg(&ctx->port, app->unit, app->addr, ctx->seq);
+    case MB_FC_WRITE_MULTI:
+        for (i = 0; i < app->count; i++)
+        {
+            app->values[i] = ctx->seq + i;
+        }
+        return mb_master_write_regs(&ctx->port, app->unit, app->addr, app->count, app->values);
+    default:
+        return mb_master_read_regs(&ctx->port, app->unit, app->function, app->addr, app->count);
+    }
+}
+
+static int mb_app_master_event(struct mb_app *app, struct mb_port_ctx *ctx, int ev)
+{
+    uint16_t regs[MB_REGS_MAX];
+    uint64_t latency = 0;
+    int ret = 0;
+    int i = 0;
+
+    switch (ev)
+    {
+    case MB_EV_FRAME:
+        ret = mb_master_reply(&ctx->port, regs, MB_REGS_MAX);
+        if (ret < 0)
+        {
+            ctx->failed++;
+            if (app->verbose)
+            {
+                printf("%s: %s, exception=%u\n", ctx->name,
+                       ctx->port.exception ? "exception" : "bad response", ctx->port.exception);
+            }
+            break;
+        }
+
+        ctx->ok++;
+        latency = mb_now_ns() - ctx->req_ns;
+        ctx->latency_ns += latency;
+        if (latency > ctx->latency_max_ns)
+        {
+            ctx->latency_max_ns = latency;
+        }
+
+        if (app->verbose)
+        {
+            printf("%s: %.3f ms", ctx->name, latency / 1e6);
+            for (i = 0; i < ret; i++)
+            {
+                printf(" %u", regs[i]);
+            }
+            printf("\n");
+        }
+        break;
+
+    case MB_EV_TIMEOUT:
+    case MB_EV_ERROR:
+        /* Timeout, or a bad frame that ended the transaction. */
+        if (ctx->port.state != MB_STATE_IDLE)
+        {
+            return 0;
+        }
+        ctx->failed++;
+        if (app->verbose)
+        {
+            printf("%s: %s\n", ctx->name, ev == MB_EV_TIMEOUT ? "timeout" : "bad frame");
+        }
+        break;
+
+    default:
+        return 0;
+    }
+
+    return mb_app_request(app, ctx);
+}
+
+static int mb_app_loop(struct mb_app *app)
+{
+    struct epoll_event evs[MB_PORTS_MAX * 2];
+    struct epoll_event ev;
+    struct mb_port_ctx *ctx = NULL;
+    uint64_t deadline = app->duration > 0 ? mb_now_ns() + (uint64_t)(app->duration * 1e9) : 0;
+    unsigned int i = 0;
+    int epfd = -1;
+    int n = 0;
+    int j = 0;
+    int ret = 0;
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1)
+    {
+        perror("epoll_create1 error!");
+        return -1;
+    }
+
+    for (i = 0; i < app->nr; i++)
+    {
+        /* data.u32: port index << 1 | 1 for the timerfd. */
+        ev.events = EPOLLIN;
+        ev.data.u32 = i << 1;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, app->ports[i].port.fd, &ev);
+        ev.data.u32 = (i << 1) | 1;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, app->ports[i].port.tfd, &ev);
+
+        if (app->master && mb_app_request(app, &app->ports[i]))
+        {
+            close(epfd);
+            return -1;
+        }
+    }
+
+    while (!mb_stop && (!deadline || mb_now_ns() < deadline))
+    {
+        n = epoll_wait(epfd, evs, MB_PORTS_MAX * 2, 100);
+        if (n < 0 && errno != EINTR)
+        {
+            perror("epoll_wait error!");
+            ret = -1;
+            break;
+        }
+
+        for (j = 0; j < n; j++)
+        {
+            ctx = &app->ports[evs[j].data.u32 >> 1];
+
+            if (evs[j].data.u32 & 1)
+            {
+                ret = mb_port_timer(&ctx->port);
+            }
+            else
+            {
+                ret = mb_port_read(&ctx->port);
+                if (ret == MB_EV_ERROR)
+                {
+                    /* I/O error on the port itself, e.g. the other end of a pty went away. */
+                    goto out;
+                }
+            }
+
+            if (app->master)
+            {
+                ret = mb_app_master_event(app, ctx, ret);
+            }
+            else if (ret == MB_EV_FRAME)
+            {
+                ret = mb_slave_handle(&ctx->port, &app->slave);
+            }
+            else
+            {
+                ret = 0;
+            }
+
+            if (ret)
+            {
+                goto out;
+            }
+        }
+    }
+
+out:
+    close(epfd);
+
+    return ret > 0 ? 0 : ret;
+}
+
+/* Response length of one transaction, for the wire time estimate. */
+static unsigned int mb_app_rsp_len(const struct mb_app *app)
+{
+    return (app->function == MB_FC_READ_HOLDING || app->function == MB_FC_READ_INPUT) ?
+           5 + app->count * 2u : 8;
+}
+
+static unsigned int mb_app_req_len(const struct mb_app *app)
+{
+    return app->function == MB_FC_WRITE_MULTI ? 9 + app->count * 2u : 8;
+}
+
+static void mb_app_report(const struct mb_app *app, double seconds)
+{
+    const struct mb_port_ctx *ctx = NULL;
+    uint64_t wire_ns = 0;
+    unsigned int i = 0;
+
+    for (i = 0; i < app->nr; i++)
+    {
+        ctx = &app->ports[i];
+        wire_ns = mb_transaction_ns(&ctx->port, mb_app_req_len(app), mb_app_rsp_len(app));
+
+        printf("%s: baud=%u t3.5=%.3fms ok=%lu failed=%lu timeouts=%lu crc=%lu t1.5=%lu "
+               "exceptions=%lu tps=%.1f avg=%.3fms max=%.3fms wire_tps=%.1f\n",
+               ctx->name, ctx->port.baud, ctx->port.t35_ns / 1e6, ctx->ok, ctx->failed,
+               ctx->port.stats.timeouts, ctx->port.stats.crc_errors, ctx->port.stats.t15_errors,
+               ctx->port.stats.exceptions, ctx->ok / seconds,
+               ctx->ok ? ctx->latency_ns / 1e6 / ctx->ok : 0.0, ctx->latency_max_ns / 1e6,
+               1e9 / wire_ns);
+    }
+}
+
+static void mb_app_close(struct mb_app *app)
+{
+    unsigned int i = 0;
+
+    for (i = 0; i < app->nr; i++)
+    {
+        mb_port_close(&app->ports[i].port);
+    }
+    app->nr = 0;
+}
+
+static int mb_app_run(struct mb_app *app, int argc, char *argv[])
+{
+    uint64_t start = 0;
+    int ret = 0;
+    int i = 0;
+
+    if (argc > MB_PORTS_MAX)
+    {
+        fprintf(stderr, "Error: too many ports!\n");
+        return -1;
+    }
+
+    for (i = 0; i < argc; i++)
+    {
+        if (mb_port_open(&app->ports[i].port, argv[i], app->baud, app->timeout_ms))
+        {
+            mb_app_close(app);
+            return -1;
+        }
+        app->ports[i].port.strict_t15 = app->strict_t15;
+        snprintf(app->ports[i].name, sizeof(app->ports[i].name), "%s", argv[i]);
+        app->nr++;
+    }
+
+    start = mb_now_ns();
+    ret = mb_app_loop(app);
+    if (app->master)
+    {
+        mb_app_report(app, (mb_now_ns() - start) / 1e9);
+    }
+    mb_app_close(app);
+
+    return ret;
+}
+
+static int mb_open_pty(int *master, char *name, size_t size)
+{
+    *master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (*master == -1 || grantpt(*master) || unlockpt(*master) || ptsname_r(*master, name, size))
+    {
+        fprintf(stderr, "Error: posix_openpt() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    return serial_set_raw(*master);
+}
+
+/*
+ * The slave simulator runs in a child on the pty slave ends, the master polls the master ends.
+ */
+static int mb_app_bench(struct mb_app *app)
+{
+    char names[MB_PORTS_MAX][64];
+    char *slave_names[MB_PORTS_MAX];
+    int masters[MB_PORTS_MAX];
+    uint64_t start = 0;
+    unsigned int i = 0;
+    pid_t child = -1;
+    int ret = 0;
+
+    if (!app->pairs || app->pairs > MB_PORTS_MAX)
+    {
+        fprintf(stderr, "Error: Invalid argument, ports=%u!\n", app->pairs);
+        return -1;
+    }
+
+    for (i = 0; i < app->pairs; i++)
+    {
+        if (mb_open_pty(&masters[i], names[i], sizeof(names[i])))
+        {
+            return -1;
+        }
+        slave_names[i] = names[i];
+    }
+
+    child = fork();
+    if (child == -1)
+    {
+        perror("fork error!");
+        return -1;
+    }
+
+    if (child == 0)
+    {
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        for (i = 0; i < app->pairs; i++)
+        {
+            close(masters[i]);
+        }
+        app->master = 0;
+        app->duration = 0;
+        _exit(mb_app_run(app, app->pairs, slave_names) ? 1 : 0);
+    }
+
+    for (i = 0; i < app->pairs; i++)
+    {
+        if (mb_port_init(&app->ports[i].port, masters[i], app->baud, app->timeout_ms))
+        {
+            ret = -1;
+            break;
+        }
+        app->ports[i].port.strict_t15 = app->strict_t15;
+        snprintf(app->ports[i].name, sizeof(app->ports[i].name), "%s", names[i]);
+        app->nr++;
+    }
+
+    /* Let the simulator open and configure the slave ends. */
+    usleep(200000);
+
+    if (!ret)
+    {
+        app->master = 1;
+        start = mb_now_ns();
+        ret = mb_app_loop(app);
+        mb_app_report(app, (mb_now_ns() - start) / 1e9);
+    }
+
+    kill(child, SIGTERM);
+    waitpid(child, NULL, 0);
+    mb_app_close(app);
+
+    return ret;
+}
+
+static void mb_usage(const char *name)
+{
+    printf("Usage:\n"
+           "\t%s master [-b baud] [-u unit] [-f 3|4|6|16] [-a addr] [-c count] [-T ms] [-t sec] [-s] [-v] tty...\n"
+           "\t%s slave [-b baud] [-u unit] [-s] tty...\n"
+           "\t%s bench [-n ports] [-b baud] [-f 3|4|6|16] [-c count] [-t sec] [-s] [-v]\n",
+           name, name, name);
+}
+
+int main(int argc, char *argv[])
+{
+    static struct mb_app app;
+    const char *cmd = NULL;
+    unsigned int i = 0;
+    int opt = 0;
+
+    if (argc < 2)
+    {
+        mb_usage(argv[0]);
+        return -1;
+    }
+
+    cmd = argv[1];
+    app.baud = 115200;
+    app.timeout_ms = 100;
+    app.unit = 1;
+    app.function = MB_FC_READ_HOLDING;
+    app.count = 10;
+    app.pairs = 1;
+    app.duration = !strcmp(cmd, "bench") ? 5 : 0;
+
+    optind = 2;
+    while ((opt = getopt(argc, argv, "b:u:f:a:c:T:t:n:sv")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            app.baud = strtoul(optarg, NULL, 0);
+            break;
+        case 'u':
+            app.unit = strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            app.function = strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            app.addr = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            app.count = strtoul(optarg, NULL, 0);
+            break;
+        case 'T':
+            app.timeout_ms = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            app.duration = strtod(optarg, NULL);
+            break;
+        case 'n':
+            app.pairs = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            app.strict_t15 = 1;
+            break;
+        case 'v':
+            app.verbose = 1;
+            break;
+        default:
+            mb_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (app.function != MB_FC_READ_HOLDING && app.function != MB_FC_READ_INPUT &&
+        app.function != MB_FC_WRITE_SINGLE && app.function != MB_FC_WRITE_MULTI)
+    {
+        fprintf(stderr, "Error: Unsupported function %u!\n", app.function);
+        return -1;
+    }
+
+    if (!app.count || app.count > (app.function == MB_FC_WRITE_MULTI ? MB_WRITE_REGS_MAX : MB_REGS_MAX))
+    {
+        fprintf(stderr, "Error: Invalid argument, count=%u!\n", app.count);
+        return -1;
+    }
+
+    if (serial_speed(app.baud) == B0)
+    {
+        fprintf(stderr, "Error: Unsupported baud rate %u!\n", app.baud);
+        return -1;
+    }
+
+    for (i = 0; i < MB_SLAVE_REGS; i++)
+    {
+        app.slave_regs[i] = i;
+    }
+    app.slave.unit = app.unit;
+    app.slave.start = 0;
+    app.slave.count = MB_SLAVE_REGS;
+    app.slave.regs = app.slave_regs;
+
+    signal(SIGINT, mb_sig_handler);
+    signal(SIGTERM, mb_sig_handler);
+
+    if (!strcmp(cmd, "master") || !strcmp(cmd, "slave"))
+    {
+        if (optind >= argc)
+        {
+            mb_usage(argv[0]);
+            return -1;
+        }
+        app.master = !strcmp(cmd, "master");
+        return mb_app_run(&app, argc - optind, argv + optind) ? -1 : 0;
+    }
+
+    if (!strcmp(cmd, "bench"))
+    {
+        return mb_app_bench(&app) ? -1 : 0;
+    }
+
+    mb_usage(argv[0]);
+
+    return -1;
+}
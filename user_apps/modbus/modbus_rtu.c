@@ -0,0 +1,608 @@
+/**
+ * @file modbus_rtu.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Modbus RTU master/slave engine.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @note Timings follow the Modbus over serial line spec: 11 bits per character, t1.5/t3.5 from
+ *       the baud rate, fixed 750us/1750us above 19200 baud.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "serial.h"
+#include "modbus_rtu.h"
+
+#define MB_BITS_PER_CHAR    11
+#define MB_RX_T15           0x1
+#define MB_RX_OVERRUN       0x2
+
+#define MB_GET16(p)         ((uint16_t)(((p)[0] << 8) | (p)[1]))
+#define MB_PUT16(p, v)      do { (p)[0] = (uint8_t)((v) >> 8); (p)[1] = (uint8_t)(v); } while (0)
+
+/* CRC-16/MODBUS, polynomial 0xA001 (reflected 0x8005), one lookup per byte. */
+static const uint16_t mb_crc_table[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+
+uint16_t mb_crc16(const uint8_t *buf, unsigned int len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--)
+    {
+        crc = (crc >> 8) ^ mb_crc_table[(crc ^ *buf++) & 0xFF];
+    }
+
+    return crc;
+}
+
+uint64_t mb_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void mb_ns_to_timespec(uint64_t ns, struct timespec *ts)
+{
+    ts->tv_sec = ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+}
+
+static int mb_arm_timer(struct mb_port *port, uint64_t deadline_ns)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    mb_ns_to_timespec(deadline_ns, &its.it_value);
+
+    errno = 0;
+    if (timerfd_settime(port->tfd, TFD_TIMER_ABSTIME, &its, NULL))
+    {
+        fprintf(stderr, "Error: timerfd_settime() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+int mb_port_init(struct mb_port *port, int fd, unsigned int baud, unsigned int timeout_ms)
+{
+    int flags = 0;
+
+    if (!baud)
+    {
+        fprintf(stderr, "Error: Invalid argument, baud=%u!\n", baud);
+        return -1;
+    }
+
+    memset(port, 0, sizeof(*port));
+    port->fd = fd;
+    port->tfd = -1;
+    port->baud = baud;
+    port->char_ns = MB_BITS_PER_CHAR * 1000000000ULL / baud;
+    if (baud > 19200)
+    {
+        port->t15_ns = 750000;
+        port->t35_ns = 1750000;
+    }
+    else
+    {
+        port->t15_ns = port->char_ns * 3 / 2;
+        port->t35_ns = port->char_ns * 7 / 2;
+    }
+    port->timeout_ns = (uint64_t)timeout_ms * 1000000ULL;
+
+    flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK))
+    {
+        fprintf(stderr, "Error: fcntl() O_NONBLOCK failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    port->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (port->tfd == -1)
+    {
+        fprintf(stderr, "Error: timerfd_create() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+int mb_port_open(struct mb_port *port, const char *tty_name, unsigned int baud, unsigned int timeout_ms)
+{
+    speed_t speed = serial_speed(baud);
+    int fd = -1;
+
+    if (speed == B0)
+    {
+        fprintf(stderr, "Error: Unsupported baud rate %u!\n", baud);
+        return -1;
+    }
+
+    if (serial_init(tty_name, speed, &fd) || serial_set_raw(fd) ||
+        mb_port_init(port, fd, baud, timeout_ms))
+    {
+        serial_exit(fd);
+        port->fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+void mb_port_close(struct mb_port *port)
+{
+    if (port->tfd >= 0)
+    {
+        close(port->tfd);
+        port->tfd = -1;
+    }
+
+    serial_exit(port->fd);
+    port->fd = -1;
+}
+
+int mb_port_read(struct mb_port *port)
+{
+    uint8_t scratch[64];
+    ssize_t len = 0;
+    uint64_t now = 0;
+    int got = 0;
+
+    if (port->state != MB_STATE_RECEIVING)
+    {
+        port->rx_len = 0;
+        port->rx_bad = 0;
+    }
+
+    while (1)
+    {
+        if (port->rx_len < MB_ADU_MAX)
+        {
+            len = read(port->fd, port->rx + port->rx_len, MB_ADU_MAX - port->rx_len);
+        }
+        else
+        {
+            /* Keep draining so the frame end is still found, the frame is dropped. */
+            len = read(port->fd, scratch, sizeof(scratch));
+            if (len > 0)
+            {
+                port->rx_bad |= MB_RX_OVERRUN;
+            }
+        }
+
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN)
+            {
+                break;
+            }
+            fprintf(stderr, "Error: read() failed, fd=%d, errno=%d!\n", port->fd, errno);
+            return MB_EV_ERROR;
+        }
+
+        if (len == 0)
+        {
+            break;
+        }
+
+        if (port->rx_len < MB_ADU_MAX)
+        {
+            port->rx_len += len;
+        }
+        got = 1;
+    }
+
+    if (!got)
+    {
+        return MB_EV_NONE;
+    }
+
+    now = mb_now_ns();
+    if (port->state == MB_STATE_RECEIVING && now - port->last_rx_ns > port->t15_ns)
+    {
+        port->stats.t15_errors++;
+        if (port->strict_t15)
+        {
+            port->rx_bad |= MB_RX_T15;
+        }
+    }
+
+    port->state = MB_STATE_RECEIVING;
+    port->last_rx_ns = now;
+
+    return mb_arm_timer(port, now + port->t35_ns) ? MB_EV_ERROR : MB_EV_NONE;
+}
+
+int mb_port_timer(struct mb_port *port)
+{
+    uint64_t expirations = 0;
+    uint64_t last_rx_ns = port->last_rx_ns;
+
+    /* EAGAIN: the timer was re-armed after this expiry was queued. */
+    if (read(port->tfd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    {
+        return MB_EV_NONE;
+    }
+
+    if (port->state == MB_STATE_WAIT_REPLY)
+    {
+        port->state = MB_STATE_IDLE;
+        port->stats.timeouts++;
+        return MB_EV_TIMEOUT;
+    }
+
+    if (port->state != MB_STATE_RECEIVING)
+    {
+        return MB_EV_NONE;
+    }
+
+    /* Bytes that came in after the expiry but before this call continue the frame. */
+    if (mb_port_read(port) == MB_EV_ERROR)
+    {
+        return MB_EV_ERROR;
+    }
+    if (port->last_rx_ns != last_rx_ns)
+    {
+        return MB_EV_NONE;
+    }
+
+    port->state = MB_STATE_IDLE;
+    port->idle_ns = port->last_rx_ns + port->t35_ns;
+
+    if (port->rx_bad & MB_RX_OVERRUN)
+    {
+        port->stats.overruns++;
+        return MB_EV_ERROR;
+    }
+    if (port->rx_bad)
+    {
+        return MB_EV_ERROR;
+    }
+    if (port->rx_len < 4 ||
+        mb_crc16(port->rx, port->rx_len - 2) != (port->rx[port->rx_len - 2] | (port->rx[port->rx_len - 1] << 8)))
+    {
+        port->stats.crc_errors++;
+        return MB_EV_ERROR;
+    }
+
+    port->stats.rx_frames++;
+
+    return MB_EV_FRAME;
+}
+
+/*
+ * Append the CRC, wait for the bus to be idle (t3.5 after the last frame) and send port->tx.
+ */
+static int mb_port_send(struct mb_port *port, int expect_reply)
+{
+    struct pollfd pfd;
+    struct timespec ts;
+    unsigned int sent = 0;
+    uint16_t crc = mb_crc16(port->tx, port->tx_len);
+    uint64_t end_ns = 0;
+    ssize_t len = 0;
+
+    port->tx[port->tx_len++] = crc & 0xFF;
+    port->tx[port->tx_len++] = crc >> 8;
+
+    if (mb_now_ns() < port->idle_ns)
+    {
+        mb_ns_to_timespec(port->idle_ns, &ts);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        {
+        }
+    }
+
+    while (sent < port->tx_len)
+    {
+        len = write(port->fd, port->tx + sent, port->tx_len - sent);
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN)
+            {
+                pfd.fd = port->fd;
+                pfd.events = POLLOUT;
+                poll(&pfd, 1, -1);
+                continue;
+            }
+            fprintf(stderr, "Error: write() failed, fd=%d, errno=%d!\n", port->fd, errno);
+            return -1;
+        }
+        sent += len;
+    }
+
+    /* The characters are still shifting out of the UART FIFO. */
+    end_ns = mb_now_ns() + port->tx_len * port->char_ns;
+    port->idle_ns = end_ns + port->t35_ns;
+    port->stats.tx_frames++;
+
+    if (!expect_reply)
+    {
+        port->state = MB_STATE_IDLE;
+        return 0;
+    }
+
+    port->state = MB_STATE_WAIT_REPLY;
+
+    return mb_arm_timer(port, end_ns + port->timeout_ns);
+}
+
+int mb_master_read_regs(struct mb_port *port, uint8_t unit, uint8_t function,
+                        uint16_t addr, uint16_t count)
+{
+    if (port->state != MB_STATE_IDLE || !count || count > MB_REGS_MAX)
+    {
+        return -1;
+    }
+
+    port->tx[0] = unit;
+    port->tx[1] = function;
+    MB_PUT16(&port->tx[2], addr);
+    MB_PUT16(&port->tx[4], count);
+    port->tx_len = 6;
+
+    return mb_port_send(port, unit != 0);
+}
+
+int mb_master_write_reg(struct mb_port *port, uint8_t unit, uint16_t addr, uint16_t value)
+{
+    if (port->state != MB_STATE_IDLE)
+    {
+        return -1;
+    }
+
+    port->tx[0] = unit;
+    port->tx[1] = MB_FC_WRITE_SINGLE;
+    MB_PUT16(&port->tx[2], addr);
+    MB_PUT16(&port->tx[4], value);
+    port->tx_len = 6;
+
+    return mb_port_send(port, unit != 0);
+}
+
+int mb_master_write_regs(struct mb_port *port, uint8_t unit, uint16_t addr,
+                         uint16_t count, const uint16_t *values)
+{
+    unsigned int i = 0;
+
+    if (port->state != MB_STATE_IDLE || !count || count > MB_WRITE_REGS_MAX)
+    {
+        return -1;
+    }
+
+    port->tx[0] = unit;
+    port->tx[1] = MB_FC_WRITE_MULTI;
+    MB_PUT16(&port->tx[2], addr);
+    MB_PUT16(&port->tx[4], count);
+    port->tx[6] = count * 2;
+    for (i = 0; i < count; i++)
+    {
+        MB_PUT16(&port->tx[7 + i * 2], values[i]);
+    }
+    port->tx_len = 7 + count * 2;
+
+    return mb_port_send(port, unit != 0);
+}
+
+int mb_master_reply(struct mb_port *port, uint16_t *regs, unsigned int max)
+{
+    const uint8_t *rx = port->rx;
+    unsigned int count = 0;
+    unsigned int i = 0;
+
+    port->exception = 0;
+
+    if (port->rx_len < 5 || rx[0] != port->tx[0])
+    {
+        return -1;
+    }
+
+    if (rx[1] == (port->tx[1] | 0x80) && port->rx_len == 5)
+    {
+        port->exception = rx[2];
+        port->stats.exceptions++;
+        return -1;
+    }
+
+    if (rx[1] != port->tx[1])
+    {
+        return -1;
+    }
+
+    switch (rx[1])
+    {
+    case MB_FC_READ_HOLDING:
+    case MB_FC_READ_INPUT:
+        count = MB_GET16(&port->tx[4]);
+        if (rx[2] != count * 2 || port->rx_len != 5 + count * 2)
+        {
+            return -1;
+        }
+        for (i = 0; regs && i < count && i < max; i++)
+        {
+            regs[i] = MB_GET16(&rx[3 + i * 2]);
+        }
+        return count;
+
+    case MB_FC_WRITE_SINGLE:
+    case MB_FC_WRITE_MULTI:
+        /* Echo of unit, function, address and value/count. */
+        if (port->rx_len != 8 || memcmp(rx, port->tx, 6))
+        {
+            return -1;
+        }
+        return 0;
+
+    default:
+        return -1;
+    }
+}
+
+static int mb_slave_exception(struct mb_port *port, uint8_t code)
+{
+    port->tx[0] = port->rx[0];
+    port->tx[1] = port->rx[1] | 0x80;
+    port->tx[2] = code;
+    port->tx_len = 3;
+
+    return mb_port_send(port, 0);
+}
+
+int mb_slave_handle(struct mb_port *port, struct mb_slave *slave)
+{
+    const uint8_t *rx = port->rx;
+    unsigned int len = port->rx_len - 2;
+    uint8_t unit = rx[0];
+    uint16_t addr = 0;
+    uint16_t count = 0;
+    unsigned int i = 0;
+
+    if (unit != slave->unit && unit != 0)
+    {
+        return 0;
+    }
+
+    /* Function code first, the PDU length depends on it. */
+    switch (rx[1])
+    {
+    case MB_FC_READ_HOLDING:
+    case MB_FC_READ_INPUT:
+        if (!unit)
+        {
+            return 0;
+        }
+        if (len != 6)
+        {
+            return mb_slave_exception(port, MB_EX_ILLEGAL_VALUE);
+        }
+        addr = MB_GET16(&rx[2]);
+        count = MB_GET16(&rx[4]);
+        if (!count || count > MB_REGS_MAX)
+        {
+            return mb_slave_exception(port, MB_EX_ILLEGAL_VALUE);
+        }
+        if (addr < slave->start || addr + count > slave->start + slave->count)
+        {
+            return mb_slave_exception(port, MB_EX_ILLEGAL_ADDRESS);
+        }
+        port->tx[0] = unit;
+        port->tx[1] = rx[1];
+        port->tx[2] = count * 2;
+        for (i = 0; i < count; i++)
+        {
+            MB_PUT16(&port->tx[3 + i * 2], slave->regs[addr - slave->start + i]);
+        }
+        port->tx_len = 3 + count * 2;
+        return mb_port_send(port, 0);
+
+    case MB_FC_WRITE_SINGLE:
+        if (len != 6)
+        {
+            return unit ? mb_slave_exception(port, MB_EX_ILLEGAL_VALUE) : 0;
+        }
+        addr = MB_GET16(&rx[2]);
+        count = MB_GET16(&rx[4]);
+        if (addr < slave->start || addr >= slave->start + slave->count)
+        {
+            return unit ? mb_slave_exception(port, MB_EX_ILLEGAL_ADDRESS) : 0;
+        }
+        slave->regs[addr - slave->start] = count;
+        break;
+
+    case MB_FC_WRITE_MULTI:
+        if (len < 7)
+        {
+            return unit ? mb_slave_exception(port, MB_EX_ILLEGAL_VALUE) : 0;
+        }
+        addr = MB_GET16(&rx[2]);
+        count = MB_GET16(&rx[4]);
+        if (!count || count > MB_WRITE_REGS_MAX || rx[6] != count * 2 || len != 7 + count * 2u)
+        {
+            return unit ? mb_slave_exception(port, MB_EX_ILLEGAL_VALUE) : 0;
+        }
+        if (addr < slave->start || addr + count > slave->start + slave->count)
+        {
+            return unit ? mb_slave_exception(port, MB_EX_ILLEGAL_ADDRESS) : 0;
+        }
+        for (i = 0; i < count; i++)
+        {
+            slave->regs[addr - slave->start + i] = MB_GET16(&rx[7 + i * 2]);
+        }
+        break;
+
+    default:
+        return unit ? mb_slave_exception(port, MB_EX_ILLEGAL_FUNCTION) : 0;
+    }
+
+    /* Broadcast writes are not answered. */
+    if (!unit)
+    {
+        return 0;
+    }
+
+    memcpy(port->tx, rx, 6);
+    port->tx_len = 6;
+
+    return mb_port_send(port, 0);
+}
+
+uint64_t mb_transaction_ns(const struct mb_port *port, unsigned int req_len, unsigned int rsp_len)
+{
+    return (req_len + rsp_len) * port->char_ns + 2 * port->t35_ns;
+}
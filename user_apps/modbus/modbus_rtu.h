@@ -0,0 +1,152 @@
+/**
+ * @file modbus_rtu.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Modbus RTU master/slave engine.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details A frame ends after 3.5 character times of silence on the line. Each port owns a
+ *          timerfd that is re-armed (absolute, CLOCK_MONOTONIC) on every received chunk, so the
+ *          end of frame is seen t3.5 after the last byte instead of at the next poll. The
+ *          caller runs the event loop (epoll on mb_port.fd and mb_port.tfd) and calls
+ *          mb_port_read() / mb_port_timer(). Frames are built and parsed in the port's own
+ *          buffers, nothing is allocated per transaction.
+ */
+
+#ifndef __MODBUS_RTU_H__
+#define __MODBUS_RTU_H__
+
+#include <stdint.h>
+
+#define MB_ADU_MAX          256     /* unit + PDU (253) + CRC */
+#define MB_REGS_MAX         125     /* Registers per read request */
+#define MB_WRITE_REGS_MAX   123     /* Registers per write multiple request */
+
+#define MB_FC_READ_HOLDING  0x03
+#define MB_FC_READ_INPUT    0x04
+#define MB_FC_WRITE_SINGLE  0x06
+#define MB_FC_WRITE_MULTI   0x10
+
+#define MB_EX_ILLEGAL_FUNCTION  0x01
+#define MB_EX_ILLEGAL_ADDRESS   0x02
+#define MB_EX_ILLEGAL_VALUE     0x03
+
+enum mb_state {
+    MB_STATE_IDLE = 0,
+    MB_STATE_WAIT_REPLY,        /* Master: request sent, response timeout armed */
+    MB_STATE_RECEIVING,         /* Bytes seen, t3.5 armed */
+};
+
+enum mb_event {
+    MB_EV_NONE = 0,
+    MB_EV_FRAME,                /* mb_port.rx holds a frame with a valid CRC */
+    MB_EV_TIMEOUT,              /* Master: no response */
+    MB_EV_ERROR,                /* Bad CRC, short frame, t1.5 violation or I/O error */
+};
+
+struct mb_stats {
+    unsigned long tx_frames;
+    unsigned long rx_frames;
+    unsigned long crc_errors;
+    unsigned long t15_errors;   /* Gap > t1.5 inside a frame */
+    unsigned long overruns;     /* Frame longer than MB_ADU_MAX */
+    unsigned long timeouts;
+    unsigned long exceptions;
+};
+
+struct mb_port {
+    int fd;
+    int tfd;                    /* timerfd: t3.5 and response timeout */
+    unsigned int baud;
+    uint64_t char_ns;           /* 11 bits per character */
+    uint64_t t15_ns;
+    uint64_t t35_ns;
+    uint64_t timeout_ns;        /* Response timeout, from the end of the request */
+    int strict_t15;             /* Drop frames with a gap > t1.5 (unreliable on USB/pty) */
+
+    enum mb_state state;
+    uint64_t last_rx_ns;
+    uint64_t idle_ns;           /* Bus is idle from this time on (end of last frame + t3.5) */
+    int rx_bad;
+
+    uint8_t rx[MB_ADU_MAX];
+    unsigned int rx_len;
+    uint8_t tx[MB_ADU_MAX];
+    unsigned int tx_len;
+    uint8_t exception;          /* Exception code of the last response, 0: none */
+
+    struct mb_stats stats;
+};
+
+/* Register table served by the slave simulator. */
+struct mb_slave {
+    uint8_t unit;
+    uint16_t start;
+    uint16_t count;
+    uint16_t *regs;
+};
+
+uint16_t mb_crc16(const uint8_t *buf, unsigned int len);
+
+uint64_t mb_now_ns(void);
+
+/**
+ * @brief Use an already open fd (tty or pty) as a Modbus port: non-blocking, timings from
+ *        @p baud, response timeout @p timeout_ms.
+ * @return 0 on success, -1 on error.
+ */
+int mb_port_init(struct mb_port *port, int fd, unsigned int baud, unsigned int timeout_ms);
+
+/**
+ * @brief serial_init() + raw mode + mb_port_init().
+ */
+int mb_port_open(struct mb_port *port, const char *tty_name, unsigned int baud, unsigned int timeout_ms);
+
+void mb_port_close(struct mb_port *port);
+
+/**
+ * @brief Port fd is readable.
+ * @return MB_EV_NONE or MB_EV_ERROR.
+ */
+int mb_port_read(struct mb_port *port);
+
+/**
+ * @brief Port timerfd is readable.
+ * @return MB_EV_FRAME, MB_EV_TIMEOUT, MB_EV_ERROR or MB_EV_NONE (stale expiry).
+ */
+int mb_port_timer(struct mb_port *port);
+
+/*
+ * Master requests. Build the frame in port->tx, send it and arm the response timeout.
+ * Return 0 on success, -1 on error.
+ */
+int mb_master_read_regs(struct mb_port *port, uint8_t unit, uint8_t function,
+                        uint16_t addr, uint16_t count);
+
+int mb_master_write_reg(struct mb_port *port, uint8_t unit, uint16_t addr, uint16_t value);
+
+int mb_master_write_regs(struct mb_port *port, uint8_t unit, uint16_t addr,
+                         uint16_t count, const uint16_t *values);
+
+/**
+ * @brief Check the response in port->rx against the request in port->tx.
+ * @param[out] regs Registers of a read response, may be NULL for writes.
+ * @return Number of registers (0 for writes), -1 on a malformed response or an exception
+ *         (port->exception is set).
+ */
+int mb_master_reply(struct mb_port *port, uint16_t *regs, unsigned int max);
+
+/**
+ * @brief Serve the request in port->rx from @p slave and send the response (none for
+ *        broadcasts or other units).
+ * @return 0 on success, -1 on error.
+ */
+int mb_slave_handle(struct mb_port *port, struct mb_slave *slave);
+
+/**
+ * @brief Wire time of one transaction: request + response characters and two t3.5 gaps.
+ */
+uint64_t mb_transaction_ns(const struct mb_port *port, unsigned int req_len, unsigned int rsp_len);
+
+#endif /* __MODBUS_RTU_H__ */
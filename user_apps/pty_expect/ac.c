@@ -0,0 +1,215 @@
+/**
+ * @file ac.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Aho-Corasick multi-pattern matcher for byte streams.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ac.h"
+
+static int ac_grow(struct ac *ac)
+{
+    unsigned int max = ac->max_states ? ac->max_states * 2 : 64;
+    void *next = realloc(ac->next, max * sizeof(*ac->next));
+    void *fail = NULL;
+    void *out = NULL;
+    void *hit = NULL;
+
+    if (next)
+    {
+        ac->next = next;
+    }
+    fail = realloc(ac->fail, max * sizeof(*ac->fail));
+    if (fail)
+    {
+        ac->fail = fail;
+    }
+    out = realloc(ac->out, max * sizeof(*ac->out));
+    if (out)
+    {
+        ac->out = out;
+    }
+    hit = realloc(ac->hit, max * sizeof(*ac->hit));
+    if (hit)
+    {
+        ac->hit = hit;
+    }
+
+    if (!next || !fail || !out || !hit)
+    {
+        fprintf(stderr, "Error: out of memory!\n");
+        return -1;
+    }
+
+    ac->max_states = max;
+
+    return 0;
+}
+
+static int ac_new_state(struct ac *ac)
+{
+    int32_t s = 0;
+
+    if (ac->nr_states == ac->max_states && ac_grow(ac))
+    {
+        return -1;
+    }
+
+    s = ac->nr_states++;
+    memset(ac->next[s], 0xff, sizeof(ac->next[s]));
+    ac->fail[s] = 0;
+    ac->out[s] = -1;
+    ac->hit[s] = -1;
+
+    return s;
+}
+
+int ac_init(struct ac *ac)
+{
+    memset(ac, 0, sizeof(*ac));
+
+    return ac_new_state(ac) == 0 ? 0 : -1;
+}
+
+void ac_exit(struct ac *ac)
+{
+    free(ac->next);
+    free(ac->fail);
+    free(ac->out);
+    free(ac->hit);
+    memset(ac, 0, sizeof(*ac));
+}
+
+int ac_add(struct ac *ac, const uint8_t *pattern, size_t len)
+{
+    int32_t s = 0;
+    int32_t t = 0;
+    size_t i = 0;
+
+    if (ac->compiled || !len)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < len; i++)
+    {
+        t = ac->next[s][pattern[i]];
+        if (t < 0)
+        {
+            t = ac_new_state(ac);
+            if (t < 0)
+            {
+                return -1;
+            }
+            ac->next[s][pattern[i]] = t;
+        }
+        s = t;
+    }
+
+    if (ac->out[s] < 0)
+    {
+        ac->out[s] = ac->nr_patterns++;
+    }
+
+    return ac->out[s];
+}
+
+/*
+ * Breadth first: the fail state of a child is reached by following the parent's fail
+ * edges, which are already complete DFA rows by then.
+ */
+int ac_compile(struct ac *ac)
+{
+    int32_t *queue = NULL;
+    unsigned int head = 0;
+    unsigned int tail = 0;
+    int32_t s = 0;
+    int32_t t = 0;
+    int c = 0;
+
+    queue = malloc(ac->nr_states * sizeof(*queue));
+    if (!queue)
+    {
+        fprintf(stderr, "Error: out of memory!\n");
+        return -1;
+    }
+
+    for (c = 0; c < 256; c++)
+    {
+        t = ac->next[0][c];
+        if (t < 0)
+        {
+            ac->next[0][c] = 0;
+        }
+        else
+        {
+            ac->fail[t] = 0;
+            queue[tail++] = t;
+        }
+    }
+    ac->hit[0] = ac->out[0];
+
+    while (head < tail)
+    {
+        s = queue[head++];
+        ac->hit[s] = ac->out[s] >= 0 ? s : ac->hit[ac->fail[s]];
+
+        for (c = 0; c < 256; c++)
+        {
+            t = ac->next[s][c];
+            if (t < 0)
+            {
+                ac->next[s][c] = ac->next[ac->fail[s]][c];
+            }
+            else
+            {
+                ac->fail[t] = ac->next[ac->fail[s]][c];
+                queue[tail++] = t;
+            }
+        }
+    }
+
+    free(queue);
+    ac->compiled = 1;
+
+    return 0;
+}
+
+size_t ac_scan(const struct ac *ac, int32_t *state, const uint8_t *buf, size_t len, ac_match_cb cb, void *arg)
+{
+    int32_t s = *state;
+    int32_t m = 0;
+    int stop = 0;
+    size_t i = 0;
+
+    for (i = 0; i < len; i++)
+    {
+        s = ac->next[s][buf[i]];
+        if (ac->hit[s] < 0)
+        {
+            continue;
+        }
+
+        /* Longest first, then its suffixes, none after a stop (the text is consumed). */
+        for (m = ac->hit[s]; m >= 0 && !stop; m = ac->hit[ac->fail[m]])
+        {
+            stop = cb(ac->out[m], arg);
+        }
+        if (stop)
+        {
+            i++;
+            break;
+        }
+    }
+
+    *state = s;
+
+    return i;
+}
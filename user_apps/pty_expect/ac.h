@@ -0,0 +1,57 @@
+/**
+ * @file ac.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Aho-Corasick multi-pattern matcher for byte streams.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details Patterns are added once, ac_compile() turns the trie into a full DFA (256 next
+ *          states per state), so scanning is one table lookup per byte whatever the number of
+ *          patterns, and the matcher state is a single int: a stream can be fed in chunks of
+ *          any size (one read() each) without keeping a text buffer, and many streams share
+ *          one compiled table.
+ */
+
+#ifndef __AC_H__
+#define __AC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct ac {
+    int32_t (*next)[256];       /* Trie edges, full DFA after ac_compile() */
+    int32_t *fail;
+    int32_t *out;               /* Pattern ending in this state, -1: none */
+    int32_t *hit;               /* This state if out != -1, else nearest fail state with out, -1 */
+    unsigned int nr_states;
+    unsigned int max_states;
+    unsigned int nr_patterns;
+    int compiled;
+};
+
+/**
+ * @brief Called for every pattern ending at the current byte.
+ * @return Non-zero stops ac_scan() after this byte.
+ */
+typedef int (*ac_match_cb)(int pattern, void *arg);
+
+int ac_init(struct ac *ac);
+
+void ac_exit(struct ac *ac);
+
+/**
+ * @brief Add a pattern (before ac_compile()).
+ * @return Pattern id (the same id for a pattern added twice), -1 on error.
+ */
+int ac_add(struct ac *ac, const uint8_t *pattern, size_t len);
+
+int ac_compile(struct ac *ac);
+
+/**
+ * @brief Feed @p len bytes from matcher state @p *state (0 at the start of a stream).
+ * @return Bytes consumed: @p len, or fewer if @p cb asked to stop.
+ */
+size_t ac_scan(const struct ac *ac, int32_t *state, const uint8_t *buf, size_t len, ac_match_cb cb, void *arg);
+
+#endif /* __AC_H__ */
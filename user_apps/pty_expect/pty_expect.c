@@ -0,0 +1,1247 @@
+/**
+ * @file pty_expect.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Drive interactive programs through ptys, many sessions from one epoll loop.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details Usage: pty_expect [-s script] [-e line]... [-n sessions | -f list] [-j parallel]
+ *                            [-t timeout_ms] [-l logdir] [-E] [-v] [-q] -- command [args...]
+ *          Every session runs the command on its own pty (a real controlling terminal, so
+ *          "read -p", "cp -i", passwd, serial consoles through picocom etc. behave as with a
+ *          user) and walks the same script. Script lines (-s file, or -e, in order):
+ *              expect <str> [<str>...]     wait for any of the strings
+ *              send <str>                  write to the program
+ *              sleep <ms>
+ *              timeout <ms>                for the following expect/eof (default -t, 10000)
+ *              on <str> <reply>            any time <str> shows up, send <reply>
+ *              fail <str>                  the session fails as soon as <str> shows up
+ *              eof                         wait for the program to close the terminal
+ *          Strings are "quoted" (\n, \r, \t, \xHH, \\, \") or single words. In send/on replies
+ *          and in the command, $0 is the session number, $1..$9 the fields of its line in the
+ *          -f list (whitespace separated), $$ a '$'.
+ *          All expect/on/fail strings are compiled into one Aho-Corasick automaton (ac.h): each
+ *          read() is scanned once, one table lookup per byte, whatever the number of strings,
+ *          and a session keeps only its matcher state, no text buffer. Output that arrives
+ *          during a sleep is held (PX_HOLD bytes) and scanned when the next expect starts.
+ *          A session is ok when the script ran to its end and the program exited with 0.
+ *          Exit code: 0 if every session is ok, 1 otherwise.
+ */
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/ioctl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "evloop.h"
+#include "ac.h"
+
+#define PX_DEFAULT_TIMEOUT  10000
+#define PX_DEFAULT_JOBS     64
+#define PX_MAX_VARS         10      /* $0..$9 */
+#define PX_MAX_ARGS         64
+#define PX_STR_MAX          1024
+#define PX_BUF              4096    /* read() chunk */
+#define PX_HOLD             4096    /* Output kept while sleeping */
+#define PX_OUT              4096    /* Pending writes */
+
+enum px_op {
+    PX_EXPECT,
+    PX_SEND,
+    PX_SLEEP,
+    PX_EOF,
+};
+
+struct px_str {
+    uint8_t *data;
+    size_t len;
+};
+
+struct px_step {
+    enum px_op op;
+    unsigned int line;
+    uint32_t ms;                /* EXPECT/EOF: timeout (0: -t), SLEEP: delay */
+    unsigned int first;         /* EXPECT: px.alts[first, first + count) */
+    unsigned int count;
+    struct px_str text;         /* SEND */
+};
+
+struct px_rule {
+    int pattern;
+    int fail;                   /* 0: on, reply with text */
+    struct px_str text;
+};
+
+struct px_session {
+    struct px *px;
+    int active;
+    unsigned int id;            /* $0 */
+    char **vars;                /* $1..$9, NULL terminated */
+    pid_t pid;
+    int master;
+    int log_fd;
+    int status;
+    int reaped;
+    int eof;
+    int failed;
+    int done;                   /* Script at its end */
+    char why[160];
+    unsigned int step;
+    int32_t state;              /* Matcher */
+    uint64_t start_ns;
+    struct ev_io io;
+    struct ev_timer timer;
+    uint8_t buf[PX_BUF];
+    uint8_t hold[PX_HOLD];
+    size_t hold_len;
+    uint8_t out[PX_OUT];
+    size_t out_len;
+};
+
+struct px {
+    struct ev_loop loop;
+    struct ev_signal sigchld;
+    struct ev_signal sigint;
+    struct ev_signal sigterm;
+    struct ev_timer kick;       /* Starts sessions outside the callbacks of finished ones */
+
+    /* Script */
+    struct ac ac;
+    struct px_step *steps;
+    unsigned int nr_steps;
+    int *alts;                  /* Pattern ids of the expect steps */
+    unsigned int nr_alts;
+    struct px_rule *rules;
+    unsigned int nr_rules;
+    int *rule_of;               /* Pattern id -> first rule, -1: none */
+    struct px_str *patterns;    /* Pattern id -> text, for messages */
+    uint32_t script_timeout;    /* "timeout" line, 0: -t */
+    uint32_t timeout;           /* -t */
+
+    /* Sessions */
+    char **argv;
+    char ***lists;              /* -f: fields per line */
+    unsigned int nr_sessions;
+    unsigned int next_session;
+    unsigned int jobs;
+    unsigned int running;
+    unsigned int max_running;
+    unsigned int ok;
+    unsigned int nr_failed;
+    struct px_session *slots;
+    const char *log_dir;
+    int echo;
+    int verbose;
+    int quiet;
+    int stopping;
+
+    uint64_t start_ns;
+    unsigned long long bytes;
+    unsigned long long matches;
+};
+
+static uint64_t px_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *px_alloc(void *p, size_t size)
+{
+    p = realloc(p, size);
+    if (!p)
+    {
+        fprintf(stderr, "Error: out of memory!\n");
+        exit(1);
+    }
+
+    return p;
+}
+
+/*
+ * Script compiler.
+ */
+
+/* Next "quoted" or bare string of @p *pp, C escapes applied. */
+static int px_token(char **pp, struct px_str *str)
+{
+    uint8_t buf[PX_STR_MAX];
+    char *p = *pp + strspn(*pp, " \t");
+    size_t len = 0;
+    unsigned int hex = 0;
+    int quoted = (*p == '"');
+
+    if (!*p || *p == '#')
+    {
+        return -1;
+    }
+
+    if (quoted)
+    {
+        p++;
+    }
+
+    while (*p && len < sizeof(buf))
+    {
+        if (quoted ? *p == '"' : isspace((unsigned char)*p))
+        {
+            break;
+        }
+        if (*p != '\\' || !p[1])
+        {
+            buf[len++] = *p++;
+            continue;
+        }
+
+        p++;
+        switch (*p)
+        {
+        case 'n':
+            buf[len++] = '\n';
+            break;
+        case 'r':
+            buf[len++] = '\r';
+            break;
+        case 't':
+            buf[len++] = '\t';
+            break;
+        case 'x':
+            if (sscanf(p + 1, "%2x", &hex) == 1)
+            {
+                buf[len++] = hex;
+                p += isxdigit((unsigned char)p[2]) ? 2 : 1;
+            }
+            break;
+        default:
+            buf[len++] = *p;
+            break;
+        }
+        p++;
+    }
+
+    if (quoted)
+    {
+        if (*p != '"')
+        {
+            return -2;
+        }
+        p++;
+    }
+
+    *pp = p;
+    str->len = len;
+    str->data = px_alloc(NULL, len + 1);
+    memcpy(str->data, buf, len);
+    str->data[len] = '\0';
+
+    return 0;
+}
+
+static int px_pattern(struct px *px, struct px_str *str)
+{
+    unsigned int nr = px->ac.nr_patterns;
+    int id = ac_add(&px->ac, str->data, str->len);
+
+    if (id < 0)
+    {
+        return -1;
+    }
+
+    if (px->ac.nr_patterns != nr)
+    {
+        px->patterns = px_alloc(px->patterns, px->ac.nr_patterns * sizeof(*px->patterns));
+        px->patterns[id] = *str;
+    }
+    else
+    {
+        free(str->data);
+    }
+
+    return id;
+}
+
+static struct px_step *px_new_step(struct px *px, enum px_op op, unsigned int line)
+{
+    struct px_step *step = NULL;
+
+    px->steps = px_alloc(px->steps, (px->nr_steps + 1) * sizeof(*px->steps));
+    step = &px->steps[px->nr_steps++];
+    memset(step, 0, sizeof(*step));
+    step->op = op;
+    step->line = line;
+    step->ms = px->script_timeout;
+
+    return step;
+}
+
+static int px_compile_line(struct px *px, char *p, unsigned int line)
+{
+    struct px_step *step = NULL;
+    struct px_rule *rule = NULL;
+    struct px_str str;
+    char cmd[16];
+    int id = 0;
+    int ret = 0;
+    int ms = 0;
+
+    p += strspn(p, " \t");
+    if (!*p || *p == '#')
+    {
+        return 0;
+    }
+    if (sscanf(p, "%15s", cmd) != 1)
+    {
+        return 0;
+    }
+    p += strlen(cmd);
+
+    if (!strcmp(cmd, "expect"))
+    {
+        step = px_new_step(px, PX_EXPECT, line);
+        step->first = px->nr_alts;
+        while ((ret = px_token(&p, &str)) == 0)
+        {
+            id = px_pattern(px, &str);
+            if (id < 0)
+            {
+                goto bad;
+            }
+            px->alts = px_alloc(px->alts, (px->nr_alts + 1) * sizeof(*px->alts));
+            px->alts[px->nr_alts++] = id;
+            step->count++;
+        }
+        if (ret == -2 || !step->count)
+        {
+            goto bad;
+        }
+    }
+    else if (!strcmp(cmd, "send"))
+    {
+        step = px_new_step(px, PX_SEND, line);
+        if (px_token(&p, &step->text))
+        {
+            goto bad;
+        }
+    }
+    else if (!strcmp(cmd, "sleep") && sscanf(p, "%d", &ms) == 1 && ms >= 0)
+    {
+        step = px_new_step(px, PX_SLEEP, line);
+        step->ms = ms;
+    }
+    else if (!strcmp(cmd, "timeout") && sscanf(p, "%d", &ms) == 1 && ms > 0)
+    {
+        px->script_timeout = ms;
+    }
+    else if (!strcmp(cmd, "eof"))
+    {
+        px_new_step(px, PX_EOF, line);
+    }
+    else if (!strcmp(cmd, "on") || !strcmp(cmd, "fail"))
+    {
+        px->rules = px_alloc(px->rules, (px->nr_rules + 1) * sizeof(*px->rules));
+        rule = &px->rules[px->nr_rules];
+        memset(rule, 0, sizeof(*rule));
+        rule->fail = !strcmp(cmd, "fail");
+        if (px_token(&p, &str) || (rule->pattern = px_pattern(px, &str)) < 0)
+        {
+            goto bad;
+        }
+        if (!rule->fail && px_token(&p, &rule->text))
+        {
+            goto bad;
+        }
+        px->nr_rules++;
+    }
+    else
+    {
+        goto bad;
+    }
+
+    return 0;
+
+bad:
+    fprintf(stderr, "Error: script line %u: bad command <%s>!\n", line, cmd);
+    return -1;
+}
+
+static int px_compile_file(struct px *px, const char *path, unsigned int *line)
+{
+    char buf[PX_STR_MAX * 2];
+    FILE *fp = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    int ret = 0;
+
+    if (!fp)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    while (!ret && fgets(buf, sizeof(buf), fp))
+    {
+        buf[strcspn(buf, "\r\n")] = '\0';
+        ret = px_compile_line(px, buf, ++*line);
+    }
+
+    if (fp != stdin)
+    {
+        fclose(fp);
+    }
+
+    return ret;
+}
+
+static int px_compile(struct px *px)
+{
+    unsigned int i = 0;
+
+    if (ac_compile(&px->ac))
+    {
+        return -1;
+    }
+
+    px->rule_of = px_alloc(NULL, (px->ac.nr_patterns + 1) * sizeof(*px->rule_of));
+    memset(px->rule_of, 0xff, (px->ac.nr_patterns + 1) * sizeof(*px->rule_of));
+    for (i = px->nr_rules; i-- > 0;)
+    {
+        px->rule_of[px->rules[i].pattern] = i;
+    }
+
+    return 0;
+}
+
+/*
+ * Sessions.
+ */
+
+/* $0..$9 and $$ of @p s into @p dst. */
+static size_t px_expand(struct px_session *s, const uint8_t *src, size_t len, char *dst, size_t size)
+{
+    const char *var = NULL;
+    char num[16];
+    size_t n = 0;
+    size_t i = 0;
+    size_t k = 0;
+    int idx = 0;
+
+    for (i = 0; i < len && n + 1 < size; i++)
+    {
+        if (src[i] != '$' || i + 1 == len || !(isdigit(src[i + 1]) || src[i + 1] == '$'))
+        {
+            dst[n++] = src[i];
+            continue;
+        }
+
+        i++;
+        if (src[i] == '$')
+        {
+            dst[n++] = '$';
+            continue;
+        }
+
+        idx = src[i] - '0';
+        var = "";
+        if (!idx)
+        {
+            snprintf(num, sizeof(num), "%u", s->id);
+            var = num;
+        }
+        else if (s->vars)
+        {
+            for (k = 0; k < (size_t)idx && s->vars[k]; k++)
+            {
+                ;
+            }
+            if (k == (size_t)idx && s->vars[idx - 1])
+            {
+                var = s->vars[idx - 1];
+            }
+        }
+        for (k = 0; var[k] && n + 1 < size; k++)
+        {
+            dst[n++] = var[k];
+        }
+    }
+    dst[n] = '\0';
+
+    return n;
+}
+
+static void px_fail(struct px_session *s, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void px_finish(struct px_session *s);
+
+static void px_flush(struct px_session *s)
+{
+    ssize_t ret = 0;
+
+    while (s->out_len)
+    {
+        ret = write(s->master, s->out, s->out_len);
+        if (ret > 0)
+        {
+            memmove(s->out, s->out + ret, s->out_len - ret);
+            s->out_len -= ret;
+        }
+        else if (ret == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            /* EAGAIN: EPOLLOUT resumes. Other errors: the program is gone, eof follows. */
+            if (ret == -1 && errno != EAGAIN)
+            {
+                s->out_len = 0;
+            }
+            return;
+        }
+    }
+}
+
+static void px_send(struct px_session *s, const struct px_str *text)
+{
+    char buf[PX_OUT];
+    size_t len = px_expand(s, text->data, text->len, buf, sizeof(buf));
+
+    if (s->eof || s->failed)
+    {
+        return;
+    }
+
+    if (s->out_len + len > sizeof(s->out))
+    {
+        px_fail(s, "send buffer full");
+        return;
+    }
+
+    memcpy(s->out + s->out_len, buf, len);
+    s->out_len += len;
+    px_flush(s);
+}
+
+static void px_fail(struct px_session *s, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (s->failed)
+    {
+        return;
+    }
+
+    s->failed = 1;
+    va_start(ap, fmt);
+    vsnprintf(s->why, sizeof(s->why), fmt, ap);
+    va_end(ap);
+
+    /* The whole process group, setsid() in px_spawn() made the program its leader. */
+    if (!s->reaped)
+    {
+        kill(-s->pid, SIGKILL);
+    }
+    ev_timer_stop(&s->px->loop, &s->timer);
+    ev_io_stop(&s->px->loop, &s->io);
+    s->eof = 1;
+}
+
+static const char *px_printable(const struct px_str *str, char *buf, size_t size)
+{
+    size_t n = 0;
+    size_t i = 0;
+
+    for (i = 0; i < str->len && n + 5 < size; i++)
+    {
+        n += snprintf(buf + n, size - n, isprint(str->data[i]) ? "%c" : "\\x%02x", str->data[i]);
+    }
+    buf[n] = '\0';
+
+    return buf;
+}
+
+/*
+ * Run the script from the current step until it has to wait. Does not scan the hold
+ * buffer, px_resume() does.
+ */
+static void px_advance(struct px_session *s)
+{
+    struct px *px = s->px;
+    struct px_step *step = NULL;
+
+    while (!s->failed && s->step < px->nr_steps)
+    {
+        step = &px->steps[s->step];
+        switch (step->op)
+        {
+        case PX_SEND:
+            px_send(s, &step->text);
+            s->step++;
+            break;
+        case PX_SLEEP:
+            ev_timer_start(&px->loop, &s->timer, step->ms, 0);
+            return;
+        case PX_EXPECT:
+            ev_timer_start(&px->loop, &s->timer, step->ms ? step->ms : px->timeout, 0);
+            return;
+        case PX_EOF:
+            if (s->eof)
+            {
+                s->step++;
+                break;
+            }
+            ev_timer_start(&px->loop, &s->timer, step->ms ? step->ms : px->timeout, 0);
+            return;
+        }
+    }
+
+    if (!s->failed && !s->done)
+    {
+        /* Script over, the program still has to exit. */
+        s->done = 1;
+        ev_timer_start(&px->loop, &s->timer, px->timeout, 0);
+    }
+}
+
+static int px_match(int pattern, void *arg)
+{
+    struct px_session *s = arg;
+    struct px *px = s->px;
+    struct px_step *step = NULL;
+    struct px_rule *rule = NULL;
+    char buf[PX_STR_MAX];
+    unsigned int i = 0;
+    int r = 0;
+
+    px->matches++;
+
+    for (r = px->rule_of[pattern]; r >= 0 && (unsigned int)r < px->nr_rules; r++)
+    {
+        rule = &px->rules[r];
+        if (rule->pattern != pattern)
+        {
+            continue;
+        }
+        if (rule->fail)
+        {
+            px_fail(s, "\"%s\"", px_printable(&px->patterns[pattern], buf, sizeof(buf)));
+            return 1;
+        }
+        px_send(s, &rule->text);
+    }
+
+    if (s->failed || s->done || px->steps[s->step].op != PX_EXPECT)
+    {
+        return s->failed;
+    }
+
+    step = &px->steps[s->step];
+    for (i = 0; i < step->count; i++)
+    {
+        if (px->alts[step->first + i] == pattern)
+        {
+            ev_timer_stop(&px->loop, &s->timer);
+            s->step++;
+            px_advance(s);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int px_sleeping(struct px_session *s)
+{
+    return !s->done && s->step < s->px->nr_steps && s->px->steps[s->step].op == PX_SLEEP;
+}
+
+static void px_feed(struct px_session *s, const uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+
+    while (len && !s->failed)
+    {
+        if (px_sleeping(s))
+        {
+            /* Keep the newest PX_HOLD bytes for the next expect. */
+            if (len >= sizeof(s->hold))
+            {
+                memcpy(s->hold, buf + len - sizeof(s->hold), sizeof(s->hold));
+                s->hold_len = sizeof(s->hold);
+            }
+            else
+            {
+                if (s->hold_len + len > sizeof(s->hold))
+                {
+                    n = s->hold_len + len - sizeof(s->hold);
+                    memmove(s->hold, s->hold + n, s->hold_len - n);
+                    s->hold_len -= n;
+                }
+                memcpy(s->hold + s->hold_len, buf, len);
+                s->hold_len += len;
+            }
+            return;
+        }
+
+        n = ac_scan(&s->px->ac, &s->state, buf, len, px_match, s);
+        if (n < len)
+        {
+            /* An expect matched: what it matched is consumed, start over. */
+            s->state = 0;
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+/* End of a sleep: continue the script, then the output held meanwhile. */
+static void px_resume(struct px_session *s)
+{
+    uint8_t hold[PX_HOLD];
+    size_t len = s->hold_len;
+
+    s->step++;
+    px_advance(s);
+
+    memcpy(hold, s->hold, len);
+    s->hold_len = 0;
+    px_feed(s, hold, len);
+}
+
+static void px_check_eof(struct px_session *s)
+{
+    struct px *px = s->px;
+    struct px_step *step = NULL;
+    char buf[PX_STR_MAX];
+
+    if (!s->eof || s->failed || px_sleeping(s))
+    {
+        return;
+    }
+
+    if (!s->done)
+    {
+        step = &px->steps[s->step];
+        if (step->op == PX_EOF)
+        {
+            ev_timer_stop(&px->loop, &s->timer);
+            s->step++;
+            px_advance(s);
+        }
+        else if (step->op == PX_EXPECT)
+        {
+            px_fail(s, "eof, line %u expecting \"%s\"", step->line,
+                    px_printable(&px->patterns[px->alts[step->first]], buf, sizeof(buf)));
+        }
+    }
+}
+
+static void px_try_finish(struct px_session *s)
+{
+    px_check_eof(s);
+    if (s->eof && s->reaped && (s->done || s->failed))
+    {
+        px_finish(s);
+    }
+}
+
+static void px_io(struct ev_loop *loop, struct ev_io *io, uint32_t revents)
+{
+    struct px_session *s = io->data;
+    struct px *px = s->px;
+
+    if (revents & EPOLLOUT)
+    {
+        px_flush(s);
+        return;
+    }
+
+    if (revents != EPOLLIN)
+    {
+        /* EPOLLHUP (read 0) or EPOLLERR (EIO once the slave side is closed). */
+        ev_io_stop(loop, io);
+        s->eof = 1;
+        px_try_finish(s);
+        return;
+    }
+
+    px->bytes += io->len;
+    if (s->log_fd != -1 && write(s->log_fd, s->buf, io->len) < 0)
+    {
+        /* Transcript only */
+    }
+    if (px->verbose && fwrite(s->buf, 1, io->len, stdout) != io->len)
+    {
+        /* Transcript only */
+    }
+
+    px_feed(s, s->buf, io->len);
+    px_try_finish(s);
+}
+
+static void px_timer(struct ev_loop *loop, struct ev_timer *timer)
+{
+    struct px_session *s = timer->data;
+    struct px *px = s->px;
+    struct px_step *step = NULL;
+    char buf[PX_STR_MAX];
+
+    if (s->done)
+    {
+        px_fail(s, "timeout waiting for exit");
+    }
+    else
+    {
+        step = &px->steps[s->step];
+        switch (step->op)
+        {
+        case PX_SLEEP:
+            px_resume(s);
+            break;
+        case PX_EXPECT:
+            px_fail(s, "timeout, line %u expecting \"%s\"", step->line,
+                    px_printable(&px->patterns[px->alts[step->first]], buf, sizeof(buf)));
+            break;
+        default:
+            px_fail(s, "timeout, line %u waiting for eof", step->line);
+            break;
+        }
+    }
+
+    px_try_finish(s);
+}
+
+static int px_spawn(struct px *px, struct px_session *s, unsigned int id)
+{
+    char path[PATH_MAX];
+    char args[PX_MAX_ARGS][PX_STR_MAX];
+    char *argv[PX_MAX_ARGS + 1];
+    char name[64];
+    struct termios tio;
+    sigset_t mask;
+    int slave = -1;
+    int flags = 0;
+    int i = 0;
+
+    memset(s, 0, sizeof(*s));
+    s->px = px;
+    s->id = id;
+    s->vars = px->lists ? px->lists[id] : NULL;
+    s->master = -1;
+    s->log_fd = -1;
+    s->start_ns = px_now_ns();
+
+    for (i = 0; px->argv[i] && i < PX_MAX_ARGS; i++)
+    {
+        px_expand(s, (const uint8_t *)px->argv[i], strlen(px->argv[i]), args[i], sizeof(args[i]));
+        argv[i] = args[i];
+    }
+    argv[i] = NULL;
+
+    s->master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (s->master == -1 || grantpt(s->master) || unlockpt(s->master) || ptsname_r(s->master, name, sizeof(name)))
+    {
+        fprintf(stderr, "Error: posix_openpt() failed, errno=%d!\n", errno);
+        goto err;
+    }
+
+    slave = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slave == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", name, errno);
+        goto err;
+    }
+
+    /* No echo unless -E: sent text must not match the patterns, nor fill the transcript. */
+    if (!px->echo && !tcgetattr(slave, &tio))
+    {
+        tio.c_lflag &= ~(ECHO | ECHONL);
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+
+    if (px->log_dir)
+    {
+        snprintf(path, sizeof(path), "%s/%u.log", px->log_dir, id);
+        s->log_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (s->log_fd == -1)
+        {
+            fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+            goto err;
+        }
+    }
+
+    s->pid = fork();
+    if (s->pid == -1)
+    {
+        fprintf(stderr, "Error: fork() failed, errno=%d!\n", errno);
+        goto err;
+    }
+
+    if (!s->pid)
+    {
+        /* The loop blocks SIGCHLD/SIGINT/SIGTERM for its signalfd, the program must not inherit that. */
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, NULL);
+
+        if (setsid() == -1 || ioctl(slave, TIOCSCTTY, 0) == -1 ||
+            dup2(slave, STDIN_FILENO) == -1 || dup2(slave, STDOUT_FILENO) == -1 || dup2(slave, STDERR_FILENO) == -1)
+        {
+            _exit(126);
+        }
+        execvp(argv[0], argv);
+        fprintf(stderr, "Error: execvp() <%s> failed, errno=%d!\n", argv[0], errno);
+        _exit(127);
+    }
+
+    close(slave);
+    flags = fcntl(s->master, F_GETFL);
+    fcntl(s->master, F_SETFL, flags | O_NONBLOCK);
+
+    ev_io_init(&s->io, s->master, EPOLLIN | EPOLLOUT, px_io, s->buf, sizeof(s->buf));
+    s->io.data = s;
+    ev_timer_init(&s->timer, px_timer);
+    s->timer.data = s;
+    s->active = 1;
+
+    if (ev_io_start(&px->loop, &s->io))
+    {
+        px_fail(s, "epoll");
+        return 0;
+    }
+
+    px_advance(s);
+
+    return 0;
+
+err:
+    if (slave != -1)
+    {
+        close(slave);
+    }
+    if (s->master != -1)
+    {
+        close(s->master);
+    }
+    if (s->log_fd != -1)
+    {
+        close(s->log_fd);
+    }
+    s->master = s->log_fd = -1;
+
+    return -1;
+}
+
+/* Fill free slots while sessions are left. */
+static void px_start_next(struct ev_loop *loop, struct ev_timer *timer)
+{
+    struct px *px = timer->data;
+    unsigned int i = 0;
+
+    for (i = 0; i < px->jobs && !px->stopping && px->next_session < px->nr_sessions; i++)
+    {
+        if (px->slots[i].active)
+        {
+            continue;
+        }
+
+        if (px_spawn(px, &px->slots[i], px->next_session))
+        {
+            printf("session %u: failed (spawn)\n", px->next_session);
+            px->nr_failed++;
+            px->next_session++;
+            continue;
+        }
+
+        px->next_session++;
+        px->running++;
+        if (px->running > px->max_running)
+        {
+            px->max_running = px->running;
+        }
+    }
+
+    if (!px->running)
+    {
+        ev_loop_break(&px->loop);
+    }
+}
+
+static void px_finish(struct px_session *s)
+{
+    struct px *px = s->px;
+    uint64_t ms = (px_now_ns() - s->start_ns) / 1000000;
+    char status[32];
+
+    ev_timer_stop(&px->loop, &s->timer);
+    ev_io_stop(&px->loop, &s->io);
+    close(s->master);
+    if (s->log_fd != -1)
+    {
+        close(s->log_fd);
+    }
+    s->active = 0;
+    px->running--;
+    /* Not from here: the slot may be inside its own ev_io callback. */
+    ev_timer_start(&px->loop, &px->kick, 0, 0);
+
+    if (WIFEXITED(s->status))
+    {
+        snprintf(status, sizeof(status), "exit %d", WEXITSTATUS(s->status));
+        if (WEXITSTATUS(s->status) && !s->failed)
+        {
+            s->failed = 1;
+            snprintf(s->why, sizeof(s->why), "exit status");
+        }
+    }
+    else
+    {
+        snprintf(status, sizeof(status), "signal %d", WTERMSIG(s->status));
+        if (!s->failed)
+        {
+            s->failed = 1;
+            snprintf(s->why, sizeof(s->why), "killed");
+        }
+    }
+
+    if (s->failed)
+    {
+        px->nr_failed++;
+        printf("session %u: failed (%s), %s, %llu ms\n", s->id, s->why, status, (unsigned long long)ms);
+    }
+    else
+    {
+        px->ok++;
+        if (!px->quiet)
+        {
+            printf("session %u: ok, %s, %llu ms\n", s->id, status, (unsigned long long)ms);
+        }
+    }
+}
+
+static void px_sigchld(struct ev_loop *loop, struct ev_signal *sig)
+{
+    struct px *px = sig->data;
+    unsigned int i = 0;
+    pid_t pid = 0;
+    int status = 0;
+
+    /* signalfd coalesces SIGCHLD: reap everything. */
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        for (i = 0; i < px->jobs; i++)
+        {
+            if (px->slots[i].active && px->slots[i].pid == pid)
+            {
+                px->slots[i].reaped = 1;
+                px->slots[i].status = status;
+                px_try_finish(&px->slots[i]);
+                break;
+            }
+        }
+    }
+}
+
+static void px_quit(struct ev_loop *loop, struct ev_signal *sig)
+{
+    struct px *px = sig->data;
+    unsigned int i = 0;
+
+    /* Stop starting sessions, kill the running ones, SIGCHLD finishes them. */
+    px->stopping = 1;
+    for (i = 0; i < px->jobs; i++)
+    {
+        if (px->slots[i].active)
+        {
+            px_fail(&px->slots[i], "interrupted");
+        }
+    }
+}
+
+/* -f: one session per non-empty line, fields become $1..$9. */
+static int px_load_list(struct px *px, const char *path)
+{
+    char buf[PX_STR_MAX];
+    char *save = NULL;
+    char *field = NULL;
+    char **vars = NULL;
+    FILE *fp = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    int n = 0;
+
+    if (!fp)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    while (fgets(buf, sizeof(buf), fp))
+    {
+        buf[strcspn(buf, "\r\n")] = '\0';
+        if (!buf[strspn(buf, " \t")] || buf[strspn(buf, " \t")] == '#')
+        {
+            continue;
+        }
+
+        vars = px_alloc(NULL, PX_MAX_VARS * sizeof(*vars));
+        for (n = 0, field = strtok_r(buf, " \t", &save); field && n < PX_MAX_VARS - 1;
+             field = strtok_r(NULL, " \t", &save))
+        {
+            vars[n++] = strdup(field);
+        }
+        vars[n] = NULL;
+
+        px->lists = px_alloc(px->lists, (px->nr_sessions + 1) * sizeof(*px->lists));
+        px->lists[px->nr_sessions++] = vars;
+    }
+
+    if (fp != stdin)
+    {
+        fclose(fp);
+    }
+
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-s script] [-e line]... [-n sessions | -f list] [-j parallel] [-t timeout_ms]\n"
+                    "          [-l logdir] [-E] [-v] [-q] -- command [args...]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    struct px px;
+    char line[PX_STR_MAX * 2];
+    unsigned int lineno = 0;
+    uint64_t ms = 0;
+    int opt = 0;
+    int ret = 1;
+
+    memset(&px, 0, sizeof(px));
+    px.timeout = PX_DEFAULT_TIMEOUT;
+    px.jobs = PX_DEFAULT_JOBS;
+    px.nr_sessions = 1;
+    if (ac_init(&px.ac))
+    {
+        return 1;
+    }
+
+    /* "+": options end at the command, its own options are not ours. */
+    while ((opt = getopt(argc, argv, "+s:e:n:f:j:t:l:Evq")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            if (px_compile_file(&px, optarg, &lineno))
+            {
+                return 1;
+            }
+            break;
+        case 'e':
+            snprintf(line, sizeof(line), "%s", optarg);
+            if (px_compile_line(&px, line, ++lineno))
+            {
+                return 1;
+            }
+            break;
+        case 'n':
+            px.nr_sessions = strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            px.nr_sessions = 0;
+            if (px_load_list(&px, optarg))
+            {
+                return 1;
+            }
+            break;
+        case 'j':
+            px.jobs = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            px.timeout = strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            px.log_dir = optarg;
+            break;
+        case 'E':
+            px.echo = 1;
+            break;
+        case 'v':
+            px.verbose = 1;
+            break;
+        case 'q':
+            px.quiet = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind >= argc || !px.jobs || !px.timeout)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    px.argv = &argv[optind];
+
+    if (px_compile(&px))
+    {
+        return 1;
+    }
+    if (px.jobs > px.nr_sessions)
+    {
+        px.jobs = px.nr_sessions ? px.nr_sessions : 1;
+    }
+    px.slots = px_alloc(NULL, px.jobs * sizeof(*px.slots));
+    memset(px.slots, 0, px.jobs * sizeof(*px.slots));
+
+    if (ev_loop_init(&px.loop))
+    {
+        return 1;
+    }
+    px.sigchld.data = px.sigint.data = px.sigterm.data = &px;
+    if (ev_signal_start(&px.loop, &px.sigchld, SIGCHLD, px_sigchld) ||
+        ev_signal_start(&px.loop, &px.sigint, SIGINT, px_quit) ||
+        ev_signal_start(&px.loop, &px.sigterm, SIGTERM, px_quit))
+    {
+        goto out;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    ev_timer_init(&px.kick, px_start_next);
+    px.kick.data = &px;
+
+    px.start_ns = px_now_ns();
+    px_start_next(&px.loop, &px.kick);
+    if (px.running && ev_loop_run(&px.loop))
+    {
+        goto out;
+    }
+    ms = (px_now_ns() - px.start_ns) / 1000000;
+
+    printf("sessions %u, ok %u, failed %u, %llu ms, max parallel %u, %llu bytes, %llu matches, "
+           "%u patterns in %u states, %lu wakeups\n",
+           px.ok + px.nr_failed, px.ok, px.nr_failed, (unsigned long long)ms, px.max_running, px.bytes,
+           px.matches, px.ac.nr_patterns, px.ac.nr_states, px.loop.wakeups);
+    ret = (px.nr_failed || px.ok != px.nr_sessions) ? 1 : 0;
+
+out:
+    ev_loop_exit(&px.loop);
+    ac_exit(&px.ac);
+
+    return ret;
+}
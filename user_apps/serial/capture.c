@@ -0,0 +1,455 @@
+/**
+ * @file capture.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Serial traffic capture file: memory-mapped, append-only, indexed.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       Segment allocation and mmap()/munmap() moved to the preparer thread.
+ * @copyright Copyright (c) 2026
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "capture.h"
+
+#define CAP_ROUND(x, a)     (((x) + (a) - 1) / (a) * (a))
+
+static uint64_t cap_clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Allocate the blocks of segment @p seq and map it.
+ */
+static struct cap_segment *cap_map_segment(struct cap_writer *w, uint32_t seq)
+{
+    off_t off = CAP_HEADER_SIZE + (off_t)seq * w->seg_size;
+    void *map = NULL;
+    int ret = 0;
+
+    ret = posix_fallocate(w->fd, off, w->seg_size);
+    if (ret)
+    {
+        fprintf(stderr, "Error: posix_fallocate() segment %u failed, errno=%d!\n", seq, ret);
+        return NULL;
+    }
+
+    map = mmap(NULL, w->seg_size, PROT_READ | PROT_WRITE, MAP_SHARED, w->fd, off);
+    if (map == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: mmap() segment %u failed, errno=%d!\n", seq, errno);
+        return NULL;
+    }
+
+    return map;
+}
+
+static void cap_start_segment(struct cap_writer *w, struct cap_segment *seg, uint32_t seq)
+{
+    memset(seg, 0, sizeof(*seg));
+    seg->magic = CAP_SEG_MAGIC;
+    seg->seq = seq;
+    seg->first_record = w->hdr->records;
+    seg->used = sizeof(*seg);
+
+    w->hdr->index[seq].first_record = w->hdr->records;
+    w->hdr->nr_segments = seq + 1;
+    w->seg = seg;
+}
+
+/*
+ * Preparer: after each segment switch unmap the full segment and map the one after the new
+ * current segment, off the RX path. cap_append() takes w->next with an atomic exchange.
+ */
+static void *cap_preparer(void *arg)
+{
+    struct cap_writer *w = arg;
+    struct cap_segment *seg = NULL;
+    uint32_t seq = 0;
+
+    while (1)
+    {
+        while (sem_wait(&w->kick) && errno == EINTR)
+        {
+        }
+
+        if (__atomic_load_n(&w->prep_stop, __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+
+        seg = __atomic_exchange_n(&w->retired, NULL, __ATOMIC_ACQUIRE);
+        if (seg)
+        {
+            munmap(seg, w->seg_size);
+        }
+
+        seq = __atomic_load_n(&w->next_seq, __ATOMIC_ACQUIRE);
+        if (seq < CAP_INDEX_MAX && !__atomic_load_n(&w->next, __ATOMIC_ACQUIRE))
+        {
+            __atomic_store_n(&w->next, cap_map_segment(w, seq), __ATOMIC_RELEASE);
+        }
+    }
+
+    return NULL;
+}
+
+int cap_open(struct cap_writer *w, const char *path, uint32_t seg_size, const char *name, uint32_t baud)
+{
+    long page = sysconf(_SC_PAGESIZE);
+
+    sigset_t mask;
+    sigset_t old;
+    int ret = 0;
+
+    memset(w, 0, sizeof(*w));
+    w->seg_size = CAP_ROUND(seg_size ? seg_size : CAP_SEG_SIZE, (uint32_t)page);
+
+    w->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (w->fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    if (ftruncate(w->fd, CAP_HEADER_SIZE))
+    {
+        fprintf(stderr, "Error: ftruncate() failed, errno=%d!\n", errno);
+        goto err;
+    }
+
+    w->hdr = mmap(NULL, CAP_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, w->fd, 0);
+    if (w->hdr == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: mmap() header failed, errno=%d!\n", errno);
+        w->hdr = NULL;
+        goto err;
+    }
+
+    memset(w->hdr, 0, CAP_HEADER_SIZE);
+    w->hdr->magic = CAP_MAGIC;
+    w->hdr->version = CAP_VERSION;
+    w->hdr->seg_size = w->seg_size;
+    w->hdr->baud = baud;
+    w->hdr->start_realtime_ns = cap_clock_ns(CLOCK_REALTIME);
+    w->hdr->start_mono_ns = cap_clock_ns(CLOCK_MONOTONIC);
+    snprintf(w->hdr->name, sizeof(w->hdr->name), "%s", name ? name : "");
+
+    w->seg = cap_map_segment(w, 0);
+    if (!w->seg)
+    {
+        goto err;
+    }
+    cap_start_segment(w, w->seg, 0);
+
+    /* Segment 1 now, the following ones by the preparer after each switch. */
+    w->next = cap_map_segment(w, 1);
+    if (!w->next)
+    {
+        goto err;
+    }
+    w->next_seq = 2;
+
+    if (sem_init(&w->kick, 0, 0))
+    {
+        fprintf(stderr, "Error: sem_init() failed, errno=%d!\n", errno);
+        goto err;
+    }
+
+    /* Signals are for the caller's threads, as for the trace flusher. */
+    sigfillset(&mask);
+    pthread_sigmask(SIG_SETMASK, &mask, &old);
+    ret = pthread_create(&w->preparer, NULL, cap_preparer, w);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (ret)
+    {
+        fprintf(stderr, "Error: pthread_create() failed, ret=%d!\n", ret);
+        sem_destroy(&w->kick);
+        goto err;
+    }
+    w->prep_on = 1;
+
+    return 0;
+
+err:
+    cap_close(w);
+    return -1;
+}
+
+int cap_append(struct cap_writer *w, int dir, const void *data, uint32_t len)
+{
+    struct cap_segment *seg = w->seg;
+    struct cap_segment *next = NULL;
+    struct cap_record *rec = NULL;
+    uint32_t need = sizeof(*rec) + CAP_ROUND(len, CAP_ALIGN);
+    uint32_t seq = 0;
+    uint64_t ts = 0;
+
+    if (need > w->seg_size - sizeof(*seg))
+    {
+        w->dropped++;
+        return -1;
+    }
+
+    if (seg->used + need > w->seg_size)
+    {
+        /* No syscall but sem_post() here: the preparer maps and unmaps. */
+        next = __atomic_exchange_n(&w->next, NULL, __ATOMIC_ACQUIRE);
+        if (!next)
+        {
+            w->dropped++;
+            return -1;
+        }
+
+        seq = seg->seq + 1;
+        __atomic_store_n(&w->retired, seg, __ATOMIC_RELEASE);
+        cap_start_segment(w, next, seq);
+        seg = w->seg;
+
+        __atomic_store_n(&w->next_seq, seq + 1, __ATOMIC_RELEASE);
+        sem_post(&w->kick);
+    }
+
+    ts = cap_clock_ns(CLOCK_MONOTONIC) - w->hdr->start_mono_ns;
+
+    rec = (struct cap_record *)((uint8_t *)seg + seg->used);
+    rec->ts_ns = ts;
+    rec->len = len;
+    rec->dir = dir;
+    rec->reserved = 0;
+    memcpy(rec + 1, data, len);
+
+    if (!seg->records)
+    {
+        seg->first_ts_ns = ts;
+        w->hdr->index[seg->seq].first_ts_ns = ts;
+    }
+    seg->last_ts_ns = ts;
+    seg->records++;
+    w->hdr->records++;
+    w->hdr->bytes[dir & 1] += len;
+
+    /* Publish: readers only look at records below `used`. */
+    __atomic_store_n(&seg->used, seg->used + need, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+void cap_close(struct cap_writer *w)
+{
+    off_t size = CAP_HEADER_SIZE;
+
+    if (w->prep_on)
+    {
+        __atomic_store_n(&w->prep_stop, 1, __ATOMIC_RELEASE);
+        sem_post(&w->kick);
+        pthread_join(w->preparer, NULL);
+        sem_destroy(&w->kick);
+        w->prep_on = 0;
+    }
+
+    if (w->next)
+    {
+        munmap(w->next, w->seg_size);
+        w->next = NULL;
+    }
+
+    if (w->retired)
+    {
+        munmap(w->retired, w->seg_size);
+        w->retired = NULL;
+    }
+
+    if (w->seg)
+    {
+        /* Give back the unused tail of the last segment. */
+        size = CAP_HEADER_SIZE + (off_t)w->seg->seq * w->seg_size + w->seg->used;
+        munmap(w->seg, w->seg_size);
+        w->seg = NULL;
+    }
+
+    if (w->hdr)
+    {
+        munmap(w->hdr, CAP_HEADER_SIZE);
+        w->hdr = NULL;
+    }
+
+    if (w->fd != -1)
+    {
+        if (ftruncate(w->fd, size))
+        {
+            fprintf(stderr, "Error: ftruncate() failed, errno=%d!\n", errno);
+        }
+        close(w->fd);
+        w->fd = -1;
+    }
+}
+
+int cap_reader_open(struct cap_reader *r, const char *path)
+{
+    struct stat st;
+
+    memset(r, 0, sizeof(*r));
+
+    r->fd = open(path, O_RDONLY);
+    if (r->fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    if (fstat(r->fd, &st) || st.st_size < CAP_HEADER_SIZE)
+    {
+        fprintf(stderr, "Error: <%s> is not a capture file!\n", path);
+        goto err;
+    }
+
+    r->size = st.st_size;
+    r->map = mmap(NULL, r->size, PROT_READ, MAP_SHARED, r->fd, 0);
+    if (r->map == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: mmap() failed, errno=%d!\n", errno);
+        r->map = NULL;
+        goto err;
+    }
+
+    r->hdr = (const struct cap_header *)r->map;
+    if (r->hdr->magic != CAP_MAGIC || r->hdr->version != CAP_VERSION || !r->hdr->seg_size)
+    {
+        fprintf(stderr, "Error: <%s> is not a capture file!\n", path);
+        goto err;
+    }
+
+    return 0;
+
+err:
+    cap_reader_close(r);
+    return -1;
+}
+
+void cap_reader_close(struct cap_reader *r)
+{
+    if (r->map)
+    {
+        munmap((void *)r->map, r->size);
+        r->map = NULL;
+    }
+
+    if (r->fd != -1)
+    {
+        close(r->fd);
+        r->fd = -1;
+    }
+}
+
+static const struct cap_segment *cap_segment_at(const struct cap_reader *r, uint32_t seq)
+{
+    size_t off = CAP_HEADER_SIZE + (size_t)seq * r->hdr->seg_size;
+    const struct cap_segment *seg = NULL;
+
+    if (seq >= r->hdr->nr_segments || off + sizeof(*seg) > r->size)
+    {
+        return NULL;
+    }
+
+    seg = (const struct cap_segment *)(r->map + off);
+
+    return seg->magic == CAP_SEG_MAGIC ? seg : NULL;
+}
+
+const struct cap_record *cap_next(struct cap_reader *r)
+{
+    const struct cap_segment *seg = NULL;
+    const struct cap_record *rec = NULL;
+    size_t seg_off = 0;
+    uint32_t used = 0;
+
+    while ((seg = cap_segment_at(r, r->seg)))
+    {
+        seg_off = (const uint8_t *)seg - r->map;
+        used = __atomic_load_n(&seg->used, __ATOMIC_ACQUIRE);
+        if (seg_off + used > r->size)
+        {
+            used = r->size - seg_off;
+        }
+
+        if (!r->off)
+        {
+            r->off = sizeof(*seg);
+        }
+
+        if (r->off + sizeof(*rec) <= used)
+        {
+            rec = (const struct cap_record *)((const uint8_t *)seg + r->off);
+            if (r->off + sizeof(*rec) + rec->len > used)
+            {
+                return NULL;
+            }
+            r->off += sizeof(*rec) + CAP_ROUND(rec->len, CAP_ALIGN);
+            return rec;
+        }
+
+        r->seg++;
+        r->off = 0;
+    }
+
+    return NULL;
+}
+
+void cap_seek(struct cap_reader *r, uint64_t ts_ns)
+{
+    const struct cap_record *rec = NULL;
+    uint32_t lo = 0;
+    uint32_t hi = r->hdr->nr_segments;
+    uint32_t mid = 0;
+    uint32_t seg = 0;
+    uint32_t off = 0;
+
+    /* Last segment starting at or before ts_ns. */
+    while (hi - lo > 1)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (r->hdr->index[mid].first_ts_ns <= ts_ns)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    r->seg = lo;
+    r->off = 0;
+
+    while (1)
+    {
+        seg = r->seg;
+        off = r->off;
+        rec = cap_next(r);
+        if (!rec || rec->ts_ns >= ts_ns)
+        {
+            r->seg = seg;
+            r->off = off;
+            return;
+        }
+    }
+}
@@ -0,0 +1,143 @@
+/**
+ * @file capture.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Serial traffic capture file: memory-mapped, append-only, indexed.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       Next segment allocated and mapped by a preparer thread, not by cap_append().
+ * @copyright Copyright (c) 2026
+ * @details File layout:
+ *
+ *              header page (4096) | segment 0 | segment 1 | ...
+ *
+ *          Segments have a fixed size. A preparer thread preallocates (posix_fallocate) and maps
+ *          the next segment ahead of the writer and unmaps the full one, so appending a chunk is
+ *          a memcpy into the mapping: no malloc, no write(), no fsync, no mmap(). On a segment
+ *          switch cap_append() only takes the prepared segment and wakes the preparer
+ *          (sem_post()); if it is not ready yet the chunk is dropped (counted) rather than
+ *          waited for. A record never crosses a segment boundary. The header holds
+ *          the first timestamp of every segment as the seek index, each segment also repeats
+ *          it in its own header. Records become visible to readers when the segment's `used`
+ *          is updated, so a live capture can be dumped while it is written.
+ */
+
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#define CAP_MAGIC           0x50414353  /* "SCAP" */
+#define CAP_SEG_MAGIC       0x47455343  /* "CSEG" */
+#define CAP_VERSION         1
+#define CAP_HEADER_SIZE     4096
+#define CAP_SEG_SIZE        (4 * 1024 * 1024)
+#define CAP_ALIGN           8
+
+#define CAP_RX              0
+#define CAP_TX              1
+
+struct cap_index {
+    uint64_t first_ts_ns;       /* Timestamp of the first record in the segment */
+    uint64_t first_record;      /* Number of the first record in the segment */
+};
+
+#define CAP_INDEX_MAX       ((CAP_HEADER_SIZE - 128) / sizeof(struct cap_index))
+
+struct cap_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seg_size;
+    uint32_t nr_segments;       /* Segments in use */
+    uint64_t start_realtime_ns; /* CLOCK_REALTIME at cap_open() */
+    uint64_t start_mono_ns;     /* CLOCK_MONOTONIC at cap_open(), record timestamps are relative */
+    uint64_t records;
+    uint64_t bytes[2];          /* CAP_RX, CAP_TX */
+    uint32_t baud;
+    uint32_t reserved;
+    char name[64];              /* Device */
+    struct cap_index index[CAP_INDEX_MAX];
+};
+
+struct cap_segment {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t used;              /* Bytes, including this header */
+    uint32_t records;
+    uint64_t first_ts_ns;
+    uint64_t last_ts_ns;
+    uint64_t first_record;
+    uint64_t reserved[3];
+};
+
+struct cap_record {
+    uint64_t ts_ns;             /* Since start_mono_ns */
+    uint32_t len;               /* Data bytes following the record, padded to CAP_ALIGN */
+    uint16_t dir;               /* CAP_RX or CAP_TX */
+    uint16_t reserved;
+};
+
+struct cap_writer {
+    int fd;
+    struct cap_header *hdr;
+    struct cap_segment *seg;    /* Current segment */
+    struct cap_segment *next;   /* Mapped ahead by the preparer, NULL while not ready */
+    struct cap_segment *retired; /* Full segment, unmapped by the preparer */
+    uint32_t next_seq;          /* Segment the preparer maps next */
+    uint32_t seg_size;
+    unsigned long dropped;      /* Chunks lost: capture full, or next segment not ready */
+    pthread_t preparer;
+    sem_t kick;                 /* Posted by cap_append() after a segment switch */
+    int prep_on;
+    int prep_stop;
+};
+
+struct cap_reader {
+    int fd;
+    const uint8_t *map;
+    size_t size;
+    const struct cap_header *hdr;
+    uint32_t seg;               /* Current segment */
+    uint32_t off;               /* Offset of the next record in the segment */
+};
+
+/**
+ * @brief Create @p path. @p seg_size is rounded up to the page size, 0 selects CAP_SEG_SIZE.
+ * @return 0 on success, -1 on error.
+ */
+int cap_open(struct cap_writer *w, const char *path, uint32_t seg_size, const char *name, uint32_t baud);
+
+/**
+ * @brief Append one chunk, timestamped now.
+ * @return 0 on success, -1 if the capture is full, the next segment is not prepared yet or
+ *         the chunk is larger than a segment.
+ */
+int cap_append(struct cap_writer *w, int dir, const void *data, uint32_t len);
+
+void cap_close(struct cap_writer *w);
+
+int cap_reader_open(struct cap_reader *r, const char *path);
+
+void cap_reader_close(struct cap_reader *r);
+
+/**
+ * @brief Next record, NULL at the end. The data follows the record.
+ */
+const struct cap_record *cap_next(struct cap_reader *r);
+
+/**
+ * @brief Position the reader on the first record with ts_ns >= @p ts_ns (index lookup, then a
+ *        scan of one segment).
+ */
+void cap_seek(struct cap_reader *r, uint64_t ts_ns);
+
+static inline const uint8_t *cap_data(const struct cap_record *rec)
+{
+    return (const uint8_t *)(rec + 1);
+}
+
+#endif /* __CAPTURE_H__ */
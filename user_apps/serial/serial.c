@@ -0,0 +1,188 @@
+/**
+ * @file serial.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Serial port setup, shared by the serial applications.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file, serial_init()/serial_exit() moved from serial_rw.c.
+ *       Add serial_set_raw() and serial_speed().
+ * @copyright Copyright (c) 2026
+ * @note OS: linux-xlnx-xilinx-v14.5.
+ *       Toolchain: arm-xilinx-linux-gnueabi-gcc (Sourcery CodeBench Lite 2012.09-104) 4.7.2
+ *                  (需安装Xilinx SDK 2013.1)
+ */
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+#include "serial.h"
+
+int serial_init(const char *tty_name, speed_t speed, int *pfd)
+{
+    int fd = -1;
+    struct termios config;
+
+    if (!tty_name)
+    {
+        fprintf(stderr, "Error: Invalid argument, tty_name is null!\n");
+        return -1;
+    }
+
+    if (!pfd)
+    {
+        fprintf(stderr, "Error: Invalid argument, pfd is null!\n");
+        return -1;
+    }
+
+    errno = 0;
+    fd = open(tty_name, O_RDWR | O_NOCTTY);
+    if(-1 == fd)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", tty_name, errno);
+        return -1;
+    }
+
+    *pfd = fd;
+
+    errno = 0;
+    /*  Retrieve a termios structure containing a copy of the current settings. */
+    if (tcgetattr(fd, &config))
+    {
+        fprintf(stderr, "Error: tcgetattr(), errno=%d!\n", errno);
+        return -1;
+    }
+
+    /* IXON: Enable start/stop output flow control. */
+    config.c_iflag &= ~IXON;
+
+    /*
+     * CSIZE: Character-size mask (5 to 8 bits: CS5, CS6, CS7, CS8).
+     * PARENB: Parity enable.
+     */
+    config.c_cflag &= ~CSIZE;
+    config.c_cflag |= CS8;
+    config.c_cflag &= ~PARENB;
+
+    errno = 0;
+    if (cfsetspeed(&config, speed))
+    {
+        fprintf(stderr, "Error: cfsetspeed(), errno=%d!\n", errno);
+        return -1;
+    }
+
+    /*
+     * CLOCAL: Ignore modem status lines (don’t check carrier signal).
+     * CREAD: Allow input to be received.
+     */
+    config.c_cflag |= CLOCAL | CREAD;
+
+    /* CSTOPB: Use 2 stop bits per character; otherwise 1. */
+    config.c_cflag &= ~CSTOPB;
+
+    /*
+     * TIME=0,MIN=0:
+     * If data is available at the time of the call, then read() returns immediately with the
+     * lesser of the number of bytes available or the number of bytes requested. If no
+     * bytes are available, read() completes immediately, returning 0.
+     */
+    config.c_cc[VTIME] = 0;
+    config.c_cc[VMIN] = 0;
+
+    /*
+     * The tcflush() function flushes (discards) the data in the terminal input queue,
+     * the terminal output queue, or both queues.
+     */
+    errno = 0;
+    /* TCIFLUSH: Flush the input queue. */
+    if (tcflush (fd, TCIFLUSH))
+    {
+        fprintf(stderr, "Error: tcflush(), TCIFLUSH, errno=%d!\n", errno);
+        return -1;
+    }
+    errno = 0;
+    /* TCOFLUSH: Flush the output queue. */
+    if (tcflush (fd, TCOFLUSH))
+    {
+        fprintf(stderr, "Error: tcflush(), TCOFLUSH, errno=%d!\n", errno);
+        return -1;
+    }
+
+    /* 
+     * Push the updated structure back to the driver. 
+     * TCSANOW: The change is carried out immediately.
+     */
+    errno = 0;
+    if (tcsetattr(fd, TCSANOW, &config))
+    {
+        fprintf(stderr, "Error: tcsetattr(), errno=%d!\n", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+int serial_set_raw(int fd)
+{
+    struct termios config;
+
+    errno = 0;
+    if (tcgetattr(fd, &config))
+    {
+        fprintf(stderr, "Error: tcgetattr(), errno=%d!\n", errno);
+        return -1;
+    }
+
+    cfmakeraw(&config);
+    config.c_cflag |= CLOCAL | CREAD;
+    config.c_cc[VMIN] = 1;
+    config.c_cc[VTIME] = 0;
+
+    errno = 0;
+    if (tcsetattr(fd, TCSANOW, &config))
+    {
+        fprintf(stderr, "Error: tcsetattr(), errno=%d!\n", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+speed_t serial_speed(unsigned int baud)
+{
+    static const struct {
+        unsigned int baud;
+        speed_t speed;
+    } speeds[] = {
+        { 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 }, { 9600, B9600 },
+        { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 }, { 115200, B115200 },
+        { 230400, B230400 }, { 460800, B460800 }, { 921600, B921600 },
+    };
+    unsigned int i = 0;
+
+    for (i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++)
+    {
+        if (speeds[i].baud == baud)
+        {
+            return speeds[i].speed;
+        }
+    }
+
+    return B0;
+}
+
+void serial_exit(int fd)
+{
+    if (fd != -1)
+    {
+        errno = 0;
+        if (close(fd))
+        {
+            fprintf(stderr, "Error: close() failed, fd=%d, errno=%d!\n", fd, errno);
+        }
+    }
+}
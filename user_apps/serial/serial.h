@@ -0,0 +1,39 @@
+/**
+ * @file serial.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Serial port setup, shared by the serial applications.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ */
+
+#ifndef __SERIAL_H__
+#define __SERIAL_H__
+
+#include <termios.h>
+
+/**
+ * @brief Open @p tty_name and configure it: 8N1, no XON/XOFF, VMIN=0/VTIME=0.
+ * @param[out] pfd Set to the opened fd as soon as it is open, also on later errors, so the
+ *                 caller can always serial_exit() it.
+ * @return 0 on success, -1 on error.
+ */
+int serial_init(const char *tty_name, speed_t speed, int *pfd);
+
+/**
+ * @brief Raw mode: no line editing, echo or character translation, read() blocks until at
+ *        least one byte is there (VMIN=1/VTIME=0), O_NONBLOCK still applies.
+ * @return 0 on success, -1 on error.
+ */
+int serial_set_raw(int fd);
+
+/**
+ * @brief termios speed of @p baud (e.g. 9600 -> B9600).
+ * @return B0 if the baud rate is not supported.
+ */
+speed_t serial_speed(unsigned int baud);
+
+void serial_exit(int fd);
+
+#endif /* __SERIAL_H__ */
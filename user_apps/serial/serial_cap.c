@@ -0,0 +1,472 @@
+/**
+ * @file serial_cap.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Serial traffic recorder, replayer and dumper.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details Usage:
+ *              serial_cap record [-b baud] [-S seg_kb] [-e] -o file tty
+ *                  RX: everything read from tty. TX: everything typed on stdin, also sent to tty.
+ *                  -e echoes RX to stdout.
+ *              serial_cap replay [-x speed] [-d rx|tx] [-s start_sec] [-l link] [-w] file
+ *                  Writes the chunks of one direction (default rx) into a new pty at the
+ *                  recorded timing divided by speed (0: as fast as possible). -l creates a
+ *                  symlink to the pty slave, -w waits for Enter before starting.
+ *              serial_cap dump [-s start_sec] [-n records] file
+ *              serial_cap info file
+ * @note OS: linux-xlnx-xilinx-v14.5.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+
+#include "serial.h"
+#include "capture.h"
+
+static volatile sig_atomic_t cap_stop = 0;
+
+static void cap_sig_handler(int sig)
+{
+    (void)sig;
+    cap_stop = 1;
+}
+
+static uint64_t cap_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cap_record(const char *tty, const char *path, unsigned int baud, uint32_t seg_size, int echo)
+{
+    static uint8_t buf[4096];
+    struct cap_writer w;
+    struct pollfd pfds[2];
+    speed_t speed = serial_speed(baud);
+    ssize_t len = 0;
+    int fd = -1;
+    int ret = 0;
+
+    if (speed == B0)
+    {
+        fprintf(stderr, "Error: Unsupported baud rate %u!\n", baud);
+        return -1;
+    }
+
+    if (serial_init(tty, speed, &fd) || serial_set_raw(fd))
+    {
+        serial_exit(fd);
+        return -1;
+    }
+
+    if (cap_open(&w, path, seg_size, tty, baud))
+    {
+        serial_exit(fd);
+        return -1;
+    }
+
+    pfds[0].fd = fd;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = STDIN_FILENO;
+    pfds[1].events = POLLIN;
+
+    while (!cap_stop)
+    {
+        if (poll(pfds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("poll error!");
+            ret = -1;
+            break;
+        }
+
+        if (pfds[0].revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            len = read(fd, buf, sizeof(buf));
+            if (len <= 0)
+            {
+                if (len < 0 && (errno == EINTR || errno == EAGAIN))
+                {
+                    continue;
+                }
+                break;
+            }
+            cap_append(&w, CAP_RX, buf, len);
+            if (echo)
+            {
+                fwrite(buf, 1, len, stdout);
+                fflush(stdout);
+            }
+        }
+
+        if (pfds[1].revents & (POLLIN | POLLHUP))
+        {
+            len = read(STDIN_FILENO, buf, sizeof(buf));
+            if (len <= 0)
+            {
+                /* stdin closed: keep recording RX only. */
+                pfds[1].fd = -1;
+                continue;
+            }
+            if (write(fd, buf, len) != len)
+            {
+                fprintf(stderr, "Error: write() failed, errno=%d!\n", errno);
+            }
+            cap_append(&w, CAP_TX, buf, len);
+        }
+    }
+
+    fprintf(stderr, "records=%llu rx=%llu tx=%llu segments=%u dropped=%lu\n",
+            (unsigned long long)w.hdr->records, (unsigned long long)w.hdr->bytes[CAP_RX],
+            (unsigned long long)w.hdr->bytes[CAP_TX], w.hdr->nr_segments, w.dropped);
+
+    cap_close(&w);
+    serial_exit(fd);
+
+    return ret;
+}
+
+static int cap_replay(const char *path, double speed, int dir, double start, const char *link_path, int wait)
+{
+    const struct cap_record *rec = NULL;
+    struct cap_reader r;
+    struct timespec ts;
+    char name[64];
+    uint64_t base_ts = 0;
+    uint64_t t0 = 0;
+    uint64_t due = 0;
+    uint64_t now = 0;
+    uint64_t lag = 0;
+    uint64_t lag_max = 0;
+    unsigned long long bytes = 0;
+    unsigned long chunks = 0;
+    uint32_t pos = 0;
+    ssize_t len = 0;
+    int pending = 0;
+    int idle = 0;
+    int master = -1;
+    int slave = -1;
+    int i = 0;
+    int ret = 0;
+
+    if (cap_reader_open(&r, path))
+    {
+        return -1;
+    }
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master == -1 || grantpt(master) || unlockpt(master) || ptsname_r(master, name, sizeof(name)))
+    {
+        fprintf(stderr, "Error: posix_openpt() failed, errno=%d!\n", errno);
+        ret = -1;
+        goto out;
+    }
+
+    /* Hold the slave open in raw mode: no echo, and data is kept until the consumer opens it. */
+    slave = open(name, O_RDWR | O_NOCTTY);
+    if (slave == -1 || serial_set_raw(slave))
+    {
+        ret = -1;
+        goto out;
+    }
+
+    if (link_path)
+    {
+        unlink(link_path);
+        if (symlink(name, link_path))
+        {
+            fprintf(stderr, "Error: symlink() <%s> failed, errno=%d!\n", link_path, errno);
+            ret = -1;
+            goto out;
+        }
+    }
+
+    printf("pty: %s\n", link_path ? link_path : name);
+    fflush(stdout);
+
+    if (wait)
+    {
+        printf("Press Enter to start.\n");
+        getchar();
+    }
+
+    cap_seek(&r, (uint64_t)(start * 1e9));
+    t0 = cap_now_ns();
+
+    while (!cap_stop && (rec = cap_next(&r)))
+    {
+        if (rec->dir != dir)
+        {
+            continue;
+        }
+
+        if (!chunks)
+        {
+            base_ts = rec->ts_ns;
+        }
+
+        if (speed > 0)
+        {
+            due = t0 + (uint64_t)((rec->ts_ns - base_ts) / speed);
+            now = cap_now_ns();
+            if (now < due)
+            {
+                ts.tv_sec = due / 1000000000ULL;
+                ts.tv_nsec = due % 1000000000ULL;
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR && !cap_stop)
+                {
+                }
+            }
+            else
+            {
+                lag = now - due;
+                if (lag > lag_max)
+                {
+                    lag_max = lag;
+                }
+            }
+        }
+
+        for (pos = 0; pos < rec->len; pos += len)
+        {
+            len = write(master, cap_data(rec) + pos, rec->len - pos);
+            if (len < 0)
+            {
+                if (errno == EINTR)
+                {
+                    len = 0;
+                    continue;
+                }
+                fprintf(stderr, "Error: write() failed, errno=%d!\n", errno);
+                ret = -1;
+                goto out;
+            }
+        }
+
+        bytes += rec->len;
+        chunks++;
+    }
+
+    /*
+     * Closing the master hangs up the slave and drops what the consumer has not read yet.
+     * Wait until the slave input queue stays empty (data may still sit in the flip buffers).
+     */
+    for (i = 0; i < 500 && idle < 3 && !cap_stop; i++)
+    {
+        usleep(10000);
+        if (ioctl(slave, FIONREAD, &pending))
+        {
+            break;
+        }
+        idle = pending ? 0 : idle + 1;
+    }
+
+    now = cap_now_ns();
+    printf("chunks=%lu bytes=%llu time=%.3f MB/s=%.2f max_lag=%.3fms\n", chunks, bytes, (now - t0) / 1e9,
+           bytes / 1e6 / ((now - t0) / 1e9), lag_max / 1e6);
+
+    if (!cap_stop && wait)
+    {
+        printf("Done, press Enter to close the pty.\n");
+        getchar();
+    }
+
+out:
+    if (link_path)
+    {
+        unlink(link_path);
+    }
+    if (slave != -1)
+    {
+        close(slave);
+    }
+    if (master != -1)
+    {
+        close(master);
+    }
+    cap_reader_close(&r);
+
+    return ret;
+}
+
+static int cap_dump(const char *path, double start, unsigned long max)
+{
+    const struct cap_record *rec = NULL;
+    struct cap_reader r;
+    unsigned long n = 0;
+    uint32_t i = 0;
+
+    if (cap_reader_open(&r, path))
+    {
+        return -1;
+    }
+
+    cap_seek(&r, (uint64_t)(start * 1e9));
+    while ((!max || n < max) && (rec = cap_next(&r)))
+    {
+        printf("%14.6f %s %5u:", rec->ts_ns / 1e9, rec->dir == CAP_TX ? "TX" : "RX", rec->len);
+        for (i = 0; i < rec->len && i < 32; i++)
+        {
+            printf(" %02x", cap_data(rec)[i]);
+        }
+        printf("%s\n", rec->len > 32 ? " ..." : "");
+        n++;
+    }
+
+    cap_reader_close(&r);
+
+    return 0;
+}
+
+static int cap_info(const char *path)
+{
+    const struct cap_header *hdr = NULL;
+    struct cap_reader r;
+    uint32_t i = 0;
+
+    if (cap_reader_open(&r, path))
+    {
+        return -1;
+    }
+
+    hdr = r.hdr;
+    printf("device: %s, baud: %u\n", hdr->name, hdr->baud);
+    printf("start: %llu.%09llu (realtime)\n", (unsigned long long)(hdr->start_realtime_ns / 1000000000ULL),
+           (unsigned long long)(hdr->start_realtime_ns % 1000000000ULL));
+    printf("records: %llu, rx: %llu bytes, tx: %llu bytes\n", (unsigned long long)hdr->records,
+           (unsigned long long)hdr->bytes[CAP_RX], (unsigned long long)hdr->bytes[CAP_TX]);
+    printf("segments: %u x %u bytes\n", hdr->nr_segments, hdr->seg_size);
+    for (i = 0; i < hdr->nr_segments; i++)
+    {
+        printf("  [%u] first record %llu at %.6f s\n", i, (unsigned long long)hdr->index[i].first_record,
+               hdr->index[i].first_ts_ns / 1e9);
+    }
+
+    cap_reader_close(&r);
+
+    return 0;
+}
+
+static void cap_usage(const char *name)
+{
+    printf("Usage:\n"
+           "\t%s record [-b baud] [-S seg_kb] [-e] -o file tty\n"
+           "\t%s replay [-x speed] [-d rx|tx] [-s start_sec] [-l link] [-w] file\n"
+           "\t%s dump [-s start_sec] [-n records] file\n"
+           "\t%s info file\n",
+           name, name, name, name);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *cmd = NULL;
+    const char *out = NULL;
+    const char *link_path = NULL;
+    unsigned int baud = 115200;
+    unsigned long max = 0;
+    uint32_t seg_size = 0;
+    double speed = 1.0;
+    double start = 0;
+    int dir = CAP_RX;
+    int echo = 0;
+    int wait = 0;
+    int opt = 0;
+
+    if (argc < 2)
+    {
+        cap_usage(argv[0]);
+        return -1;
+    }
+
+    cmd = argv[1];
+    optind = 2;
+    while ((opt = getopt(argc, argv, "b:S:eo:x:d:s:l:wn:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            baud = strtoul(optarg, NULL, 0);
+            break;
+        case 'S':
+            seg_size = strtoul(optarg, NULL, 0) * 1024;
+            break;
+        case 'e':
+            echo = 1;
+            break;
+        case 'o':
+            out = optarg;
+            break;
+        case 'x':
+            speed = strtod(optarg, NULL);
+            break;
+        case 'd':
+            dir = !strcmp(optarg, "tx") ? CAP_TX : CAP_RX;
+            break;
+        case 's':
+            start = strtod(optarg, NULL);
+            break;
+        case 'l':
+            link_path = optarg;
+            break;
+        case 'w':
+            wait = 1;
+            break;
+        case 'n':
+            max = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            cap_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind != argc - 1)
+    {
+        cap_usage(argv[0]);
+        return -1;
+    }
+
+    signal(SIGINT, cap_sig_handler);
+    signal(SIGTERM, cap_sig_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!strcmp(cmd, "record") && out)
+    {
+        return cap_record(argv[optind], out, baud, seg_size, echo) ? -1 : 0;
+    }
+    if (!strcmp(cmd, "replay"))
+    {
+        return cap_replay(argv[optind], speed, dir, start, link_path, wait) ? -1 : 0;
+    }
+    if (!strcmp(cmd, "dump"))
+    {
+        return cap_dump(argv[optind], start, max) ? -1 : 0;
+    }
+    if (!strcmp(cmd, "info"))
+    {
+        return cap_info(argv[optind]) ? -1 : 0;
+    }
+
+    cap_usage(argv[0]);
+
+    return -1;
+}
@@ -5,6 +5,12 @@
  * @version 0.1
  * @date 2023-12-23
  *       Create this file.
+ * @date 2026-10-18
+ *       serial_rw [capture_file]: record RX/TX chunks (see serial_cap.c).
+ *       Wait for RX on user_apps/evloop instead of select(): edge-triggered source with
+ *       a fixed buffer, 5 s timer, SIGINT.
+ *       -t trace_file: the RX dump goes to the trace buffer (user_apps/trace).
+ *       ZYNQ_SERIAL_DEV overrides /dev/ttyPS0 (e.g. a zynq_sim pty).
  * @copyright Copyright (c) 2023
  * @note HW: 
  *          - zynq 7020(正点原子领航者开发板)
@@ -22,137 +28,84 @@
 #include <termios.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/select.h>
 #include <sys/time.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
 
-#define SERIAL_DEVICE_NAME "/dev/ttyPS0"
-
-static int serial_init(char *tty_name, int *pfd)
-{
-    int fd = -1;
-    struct termios config;
-
-    if (!tty_name)
-    {
-        fprintf(stderr, "Error: Invalid argument, tty_name is null!\n");
-        return -1;
-    }
-
-    if (!pfd)
-    {
-        fprintf(stderr, "Error: Invalid argument, pfd is null!\n");
-        return -1;
-    }
-
-    errno = 0;
-    fd = open(tty_name, O_RDWR | O_NOCTTY);
-    if(-1 == fd)
-    {
-        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", tty_name, errno);
-        return -1;
-    }
+#include "serial.h"
+#include "capture.h"
+#include "evloop.h"
+#include "trace.h"
 
-    *pfd = fd;
+#define SERIAL_DEVICE_NAME "/dev/ttyPS0"
 
-    errno = 0;
-    /*  Retrieve a termios structure containing a copy of the current settings. */
-    if (tcgetattr(fd, &config))
-    {
-        fprintf(stderr, "Error: tcgetattr(), errno=%d!\n", errno);
-        return -1;
-    }
+static struct cap_writer capture = { .fd = -1 };
+static int serial_trace = 0;
 
-    /* IXON: Enable start/stop output flow control. */
-    config.c_iflag &= ~IXON;
+struct serial_rx {
+    char buff[128];
+    int ret;
+    struct ev_io io;
+    struct ev_timer timeout;
+    struct ev_signal sigint;
+};
 
-    /*
-     * CSIZE: Character-size mask (5 to 8 bits: CS5, CS6, CS7, CS8).
-     * PARENB: Parity enable.
-     */
-    config.c_cflag &= ~CSIZE;
-    config.c_cflag |= CS8;
-    config.c_cflag &= ~PARENB;
+static void serial_rx_data(struct ev_loop *loop, struct ev_io *io, uint32_t revents)
+{
+    struct serial_rx *rx = io->data;
+    int to_read_len = sizeof(rx->buff) - 1;
 
-    errno = 0;
-    if (cfsetspeed(&config, B115200))
+    if (revents == EPOLLIN)
     {
-        fprintf(stderr, "Error: cfsetspeed(), errno=%d!\n", errno);
-        return -1;
+        if (serial_trace)
+        {
+            TRACE_DATA(rx->buff, io->len, "read msg: %s, read len: %d, to read len: %d.", (int)io->len, to_read_len);
+        }
+        else
+        {
+            rx->buff[io->len] = '\0';
+            printf("read msg: %s, read len: %d, to read len: %d.\n", &rx->buff[0], (int)io->len, to_read_len);
+        }
+        if (capture.hdr)
+        {
+            cap_append(&capture, CAP_RX, rx->buff, io->len);
+        }
+        rx->ret = 0;
     }
-
-    /*
-     * CLOCAL: Ignore modem status lines (don’t check carrier signal).
-     * CREAD: Allow input to be received.
-     */
-    config.c_cflag |= CLOCAL | CREAD;
-
-    /* CSTOPB: Use 2 stop bits per character; otherwise 1. */
-    config.c_cflag &= ~CSTOPB;
-
-    /*
-     * TIME=0,MIN=0:
-     * If data is available at the time of the call, then read() returns immediately with the
-     * lesser of the number of bytes available or the number of bytes requested. If no
-     * bytes are available, read() completes immediately, returning 0.
-     */
-    config.c_cc[VTIME] = 0;
-    config.c_cc[VMIN] = 0;
-
-    /*
-     * The tcflush() function flushes (discards) the data in the terminal input queue,
-     * the terminal output queue, or both queues.
-     */
-    errno = 0;
-    /* TCIFLUSH: Flush the input queue. */
-    if (tcflush (fd, TCIFLUSH))
+    else if (revents == EPOLLHUP)
     {
-        fprintf(stderr, "Error: tcflush(), TCIFLUSH, errno=%d!\n", errno);
-        return -1;
+        printf("No valid data.\n");
+        rx->ret = 0;
     }
-    errno = 0;
-    /* TCOFLUSH: Flush the output queue. */
-    if (tcflush (fd, TCOFLUSH))
+    else
     {
-        fprintf(stderr, "Error: tcflush(), TCOFLUSH, errno=%d!\n", errno);
-        return -1;
+        fprintf(stderr, "Error: read() failed, revents=0x%x!\n", revents);
     }
 
-    /* 
-     * Push the updated structure back to the driver. 
-     * TCSANOW: The change is carried out immediately.
-     */
-    errno = 0;
-    if (tcsetattr(fd, TCSANOW, &config))
-    {
-        fprintf(stderr, "Error: tcsetattr(), errno=%d!\n", errno);
-        return -1;
-    }
+    /* One read, as before: the rest stays in the tty buffer. */
+    ev_io_stop(loop, io);
+    ev_loop_break(loop);
+}
 
-    return 0;
+static void serial_rx_timeout(struct ev_loop *loop, struct ev_timer *timer)
+{
+    fprintf(stderr, "Error: Timedout, 5s!\n");
+    ev_loop_break(loop);
 }
 
-static void serial_exit(int fd)
+static void serial_rx_quit(struct ev_loop *loop, struct ev_signal *sig)
 {
-    if (fd != -1)
-    {
-        errno = 0;
-        if (close(fd))
-        {
-            fprintf(stderr, "Error: close() failed, fd=%d, errno=%d!\n", fd, errno);
-        }
-    }
+    fprintf(stderr, "Warn: Interrupted!\n");
+    ev_loop_break(loop);
 }
 
 static int serial_read(int fd)
 {
-    fd_set rset;
-    struct timeval tv;
-    char buff[128] = {0};
-    int to_read_len = sizeof(buff) - 1;
-    int ret = 0;
+    struct serial_rx rx;
+    struct ev_loop loop;
+    int flags = 0;
 
     if (fd == -1)
     {
@@ -160,58 +113,41 @@ static int serial_read(int fd)
         return -1;
     }
 
-    /* Add a file descriptor to the set */
-    FD_ZERO(&rset);
-    FD_SET(fd, &rset);
-
-    /*
-     * Timeout: 5s.
-     */
-    tv.tv_sec = 5;
-    tv.tv_usec = 0;
-
-    errno = 0;
-    while ((ret = select(fd+1, &rset, NULL, NULL, &tv)) == -1)
+    /* Edge-triggered source: the loop reads until EAGAIN. */
+    flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK))
     {
-        if (errno == EINTR)
-        {
-            errno = 0;
-            fprintf(stderr, "Warn: A non blocked signal was caught!\n");
-
-            /* Necessary after an error */
-            FD_ZERO(&rset);
-            FD_SET(fd, &rset);
-        }
-        else
-        {
-            fprintf(stderr, "Error: select() failed, error=%d!\n", errno);
-            return -1;
-        }
+        fprintf(stderr, "Error: fcntl() failed, errno=%d!\n", errno);
+        return -1;
     }
 
-    if (!ret)
+    if (ev_loop_init(&loop))
     {
-        fprintf(stderr, "Error: Timedout, 5s!\n");
         return -1;
     }
 
-    errno = 0;
-    ret = read(fd, buff, to_read_len);
-    if (ret > 0)
-    {
-        printf("read msg: %s, read len: %d, to read len: %d.\n", &buff[0], ret, to_read_len);
-    }
-    else if (ret == 0)
-    {
-        printf("No valid data.\n");
-    }
-    else
+    memset(&rx, 0, sizeof(rx));
+    rx.ret = -1;
+
+    ev_io_init(&rx.io, fd, EPOLLIN, serial_rx_data, rx.buff, sizeof(rx.buff) - 1);
+    rx.io.data = &rx;
+    ev_timer_init(&rx.timeout, serial_rx_timeout);
+
+    /*
+     * Timeout: 5s.
+     */
+    if (ev_io_start(&loop, &rx.io) ||
+        ev_timer_start(&loop, &rx.timeout, 5000, 0) ||
+        ev_signal_start(&loop, &rx.sigint, SIGINT, serial_rx_quit) ||
+        ev_loop_run(&loop))
     {
-        fprintf(stderr, "Error: read() failed, errno=%d!\n", errno);
-        return -1;
+        rx.ret = -1;
     }
 
-    return 0;
+    ev_loop_exit(&loop);
+    fcntl(fd, F_SETFL, flags);
+
+    return rx.ret;
 }
 
 static int serial_write(int fd)
@@ -232,6 +168,10 @@ static int serial_write(int fd)
     if (ret > 0)
     {
         printf("Write msg: %s, write len: %d, to write len: %d\n", &buff[0], ret, to_write_len);
+        if (capture.hdr)
+        {
+            cap_append(&capture, CAP_TX, buff, ret);
+        }
     }
     else if (ret == 0)
     {
@@ -246,16 +186,42 @@ static int serial_write(int fd)
     return 0;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    const char *dev = getenv("ZYNQ_SERIAL_DEV");
     int fd = -1;
+    int opt = 0;
 
-    printf("Seiral test, device:%s\n", SERIAL_DEVICE_NAME);
+    if (!dev)
+    {
+        dev = SERIAL_DEVICE_NAME;
+    }
+
+    while ((opt = getopt(argc, argv, "t:")) != -1)
+    {
+        if (opt != 't' || trace_init(optarg, 0))
+        {
+            fprintf(stderr, "Usage: %s [-t trace_file] [capture_file]\n", argv[0]);
+            return -1;
+        }
+        serial_trace = 1;
+    }
+
+    printf("Seiral test, device:%s\n", dev);
+
+    if (optind < argc && cap_open(&capture, argv[optind], 0, dev, 115200))
+    {
+        fprintf(stderr, "Error: Capture open failed!\n");
+        trace_exit();
+        return -1;
+    }
 
-    if (serial_init(SERIAL_DEVICE_NAME, &fd))
+    if (serial_init(dev, B115200, &fd))
     {
         fprintf(stderr, "Error: Serial init failed!\n");
         serial_exit(fd);
+        cap_close(&capture);
+        trace_exit();
         return -1;
     }
 
@@ -263,6 +229,8 @@ int main()
     {
         fprintf(stderr, "Error: Serial read failed!\n");
         serial_exit(fd);
+        cap_close(&capture);
+        trace_exit();
         return -1;
     }
 
@@ -270,10 +238,14 @@ int main()
     {
         fprintf(stderr, "Error: Serial write failed!\n");
         serial_exit(fd);
+        cap_close(&capture);
+        trace_exit();
         return -1;
     }
 
     serial_exit(fd);
+    cap_close(&capture);
+    trace_exit();
 
     return 0;
 }
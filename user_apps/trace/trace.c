@@ -0,0 +1,451 @@
+/**
+ * @file trace.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Binary trace buffer for hot paths: per-thread rings, background flusher.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       Flusher thread created with all signals blocked: Ctrl+C goes to the app's signalfd,
+ *       not to the flusher (default action, trace_exit() never ran).
+ * @copyright Copyright (c) 2026
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/prctl.h>
+
+#include "trace.h"
+
+#define TRACE_ALIGN(x)          (((x) + 7) & ~7U)
+#define TRACE_OUT_SIZE          (64 * 1024)
+
+/*
+ * Producer and consumer indices are free running byte counts, on their own cache lines.
+ */
+struct trace_ring {
+    struct trace_ring *next;
+    uint32_t tid;
+    uint64_t head __attribute__((aligned(64)));     /* Written by the owner thread */
+    unsigned long dropped;
+    uint64_t tail __attribute__((aligned(64)));     /* Written by the flusher */
+    unsigned long dropped_seen;
+    uint8_t data[TRACE_RING_SIZE] __attribute__((aligned(64)));
+};
+
+/* Descriptors of all TRACE() sites, placed by the linker. */
+extern const struct trace_fmt __start_trace_fmt[] __attribute__((weak));
+extern const struct trace_fmt __stop_trace_fmt[] __attribute__((weak));
+
+static struct trace_ring *rings = NULL;            /* Pushed lock-free, freed by trace_exit() */
+static __thread struct trace_ring *ring = NULL;
+
+static int trace_fd = -1;
+static volatile int trace_on = 0;
+static volatile int flusher_stop = 0;
+static pthread_t flusher;
+static unsigned int flusher_ms = TRACE_FLUSH_MS;
+static uint8_t out[TRACE_OUT_SIZE];                /* Flusher staging buffer */
+static unsigned int out_len = 0;
+
+static uint64_t trace_clock_mono(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static trace_clock_t trace_clock = trace_clock_mono;
+static const char *trace_clock_name = "monotonic";
+
+void trace_set_clock(trace_clock_t clock, const char *name)
+{
+    trace_clock = clock ? clock : trace_clock_mono;
+    trace_clock_name = clock ? name : "monotonic";
+}
+
+int trace_thread_init(void)
+{
+    struct trace_ring *r = NULL;
+
+    if (ring)
+    {
+        return 0;
+    }
+
+    if (posix_memalign((void **)&r, 64, sizeof(*r)))
+    {
+        return -1;
+    }
+    memset(r, 0, sizeof(*r) - sizeof(r->data));
+    r->tid = syscall(SYS_gettid);
+
+    r->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&rings, &r->next, r, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+        ;
+    }
+    ring = r;
+
+    return 0;
+}
+
+void trace_emit(const struct trace_fmt *fmt, const uint64_t *args, unsigned int nargs,
+                const void *data, unsigned int data_len)
+{
+    struct trace_ring *r = ring;
+    struct trace_rec *rec = NULL;
+    uint32_t need = 0;
+    uint32_t off = 0;
+    uint32_t pad = 0;
+    uint64_t head = 0;
+
+    if (!trace_on)
+    {
+        return;
+    }
+
+    if (!r)
+    {
+        if (trace_thread_init())
+        {
+            return;
+        }
+        r = ring;
+    }
+
+    if (nargs > TRACE_MAX_ARGS)
+    {
+        nargs = TRACE_MAX_ARGS;
+    }
+    if (data_len > TRACE_MAX_DATA)
+    {
+        data_len = TRACE_MAX_DATA;
+    }
+
+    need = TRACE_ALIGN(sizeof(*rec) + nargs * sizeof(uint64_t) + data_len);
+    head = r->head;
+    off = head & (TRACE_RING_SIZE - 1);
+
+    /* A record never wraps: fill the end of the ring and start over. */
+    if (off + need > TRACE_RING_SIZE)
+    {
+        pad = TRACE_RING_SIZE - off;
+    }
+
+    if (head + pad + need - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) > TRACE_RING_SIZE)
+    {
+        r->dropped++;
+        return;
+    }
+
+    if (pad)
+    {
+        if (pad >= sizeof(*rec))
+        {
+            rec = (struct trace_rec *)&r->data[off];
+            rec->fmt = TRACE_FMT_PAD;
+            rec->size = pad;
+        }
+        head += pad;
+        off = 0;
+    }
+
+    rec = (struct trace_rec *)&r->data[off];
+    rec->ts_ns = trace_clock();
+    rec->fmt = fmt - __start_trace_fmt;
+    rec->nargs = nargs;
+    rec->reserved = 0;
+    rec->data_len = data_len;
+    rec->size = need;
+    memcpy(rec + 1, args, nargs * sizeof(uint64_t));
+    if (data_len)
+    {
+        memcpy((uint64_t *)(rec + 1) + nargs, data, data_len);
+    }
+
+    __atomic_store_n(&r->head, head + need, __ATOMIC_RELEASE);
+}
+
+static void trace_out_flush(void)
+{
+    unsigned int done = 0;
+    ssize_t ret = 0;
+
+    while (done < out_len)
+    {
+        ret = write(trace_fd, out + done, out_len - done);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "Error: trace write() failed, errno=%d!\n", errno);
+            break;
+        }
+        done += ret;
+    }
+
+    out_len = 0;
+}
+
+/*
+ * Copy the records of @p r into one chunk of the staging buffer.
+ */
+static void trace_drain(struct trace_ring *r)
+{
+    const struct trace_rec *rec = NULL;
+    struct trace_chunk *chunk = NULL;
+    uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = r->tail;
+    unsigned long dropped = r->dropped;
+    uint32_t off = 0;
+
+    if (head == tail && dropped == r->dropped_seen)
+    {
+        return;
+    }
+
+    while (1)
+    {
+        if (out_len + sizeof(*chunk) + TRACE_ALIGN(sizeof(*rec) + TRACE_MAX_ARGS * 8 + TRACE_MAX_DATA) > sizeof(out))
+        {
+            trace_out_flush();
+        }
+
+        chunk = (struct trace_chunk *)(out + out_len);
+        chunk->magic = TRACE_CHUNK_MAGIC;
+        chunk->tid = r->tid;
+        chunk->bytes = 0;
+        chunk->dropped = dropped - r->dropped_seen;
+        r->dropped_seen = dropped;
+        out_len += sizeof(*chunk);
+
+        while (tail < head)
+        {
+            off = tail & (TRACE_RING_SIZE - 1);
+            if (TRACE_RING_SIZE - off < sizeof(*rec))
+            {
+                tail += TRACE_RING_SIZE - off;
+                continue;
+            }
+
+            rec = (const struct trace_rec *)&r->data[off];
+            if (rec->fmt == TRACE_FMT_PAD)
+            {
+                tail += rec->size;
+                continue;
+            }
+
+            if (out_len + rec->size > sizeof(out))
+            {
+                break;
+            }
+
+            memcpy(out + out_len, rec, rec->size);
+            out_len += rec->size;
+            chunk->bytes += rec->size;
+            tail += rec->size;
+        }
+
+        __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+        if (tail >= head)
+        {
+            return;
+        }
+    }
+}
+
+static void trace_drain_all(void)
+{
+    struct trace_ring *r = NULL;
+
+    for (r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next)
+    {
+        trace_drain(r);
+    }
+    trace_out_flush();
+}
+
+static void *trace_flusher(void *arg)
+{
+    struct timespec ts;
+
+    (void)arg;
+    prctl(PR_SET_NAME, "trace_flush");
+
+    ts.tv_sec = flusher_ms / 1000;
+    ts.tv_nsec = (flusher_ms % 1000) * 1000000L;
+
+    while (!flusher_stop)
+    {
+        nanosleep(&ts, NULL);
+        trace_drain_all();
+    }
+
+    return NULL;
+}
+
+static int trace_write_header(void)
+{
+    const struct trace_fmt *f = NULL;
+    struct trace_file_header hdr;
+    struct trace_file_fmt ff;
+    uint64_t mono = 0;
+    uint64_t now = 0;
+    size_t fmt_len = 0;
+    size_t file_len = 0;
+    size_t pad = 0;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = TRACE_MAGIC;
+    hdr.version = TRACE_VERSION;
+    hdr.pid = getpid();
+    hdr.nr_fmts = __start_trace_fmt ? __stop_trace_fmt - __start_trace_fmt : 0;
+    now = trace_clock();
+    mono = trace_clock_mono();
+    hdr.mono_offset_ns = (int64_t)(mono - now);
+    hdr.start_ns = now;
+    prctl(PR_GET_NAME, hdr.comm);
+    snprintf(hdr.clock, sizeof(hdr.clock), "%s", trace_clock_name ? trace_clock_name : "");
+
+    memcpy(out + out_len, &hdr, sizeof(hdr));
+    out_len += sizeof(hdr);
+
+    for (f = __start_trace_fmt; f && f < __stop_trace_fmt; f++)
+    {
+        fmt_len = strlen(f->fmt) + 1;
+        file_len = strlen(f->file) + 1;
+        if (fmt_len > 0xffff || file_len > 0xffff)
+        {
+            return -1;
+        }
+
+        ff.line = f->line;
+        ff.fmt_len = fmt_len;
+        ff.file_len = file_len;
+        pad = TRACE_ALIGN(sizeof(ff) + fmt_len + file_len) - (sizeof(ff) + fmt_len + file_len);
+        if (out_len + sizeof(ff) + fmt_len + file_len + pad > sizeof(out))
+        {
+            trace_out_flush();
+        }
+
+        memcpy(out + out_len, &ff, sizeof(ff));
+        out_len += sizeof(ff);
+        memcpy(out + out_len, f->fmt, fmt_len);
+        out_len += fmt_len;
+        memcpy(out + out_len, f->file, file_len);
+        out_len += file_len;
+        memset(out + out_len, 0, pad);
+        out_len += pad;
+    }
+
+    trace_out_flush();
+
+    return 0;
+}
+
+int trace_init(const char *path, unsigned int flush_ms)
+{
+    sigset_t mask;
+    sigset_t old;
+    int ret = 0;
+
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (trace_fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    if (trace_write_header())
+    {
+        fprintf(stderr, "Error: trace format table too large!\n");
+        goto err;
+    }
+
+    flusher_ms = flush_ms ? flush_ms : TRACE_FLUSH_MS;
+    flusher_stop = 0;
+    /*
+     * The flusher inherits the mask: with everything blocked, process signals (SIGINT/SIGTERM
+     * for an evloop signalfd blocked only later in the main thread) never pick this thread.
+     */
+    sigfillset(&mask);
+    pthread_sigmask(SIG_SETMASK, &mask, &old);
+    ret = pthread_create(&flusher, NULL, trace_flusher, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (ret)
+    {
+        fprintf(stderr, "Error: pthread_create() failed, ret=%d!\n", ret);
+        goto err;
+    }
+
+    trace_on = 1;
+
+    return 0;
+
+err:
+    close(trace_fd);
+    trace_fd = -1;
+    return -1;
+}
+
+void trace_exit(void)
+{
+    struct trace_ring *r = NULL;
+    struct trace_ring *next = NULL;
+
+    if (trace_fd == -1)
+    {
+        return;
+    }
+
+    trace_on = 0;
+    flusher_stop = 1;
+    pthread_join(flusher, NULL);
+    trace_drain_all();
+
+    if (trace_dropped())
+    {
+        fprintf(stderr, "Warn: %lu trace records dropped!\n", trace_dropped());
+    }
+
+    close(trace_fd);
+    trace_fd = -1;
+
+    /* Threads still running would write into freed rings: call after they stopped. */
+    r = __atomic_exchange_n(&rings, NULL, __ATOMIC_ACQ_REL);
+    while (r)
+    {
+        next = r->next;
+        free(r);
+        r = next;
+    }
+    ring = NULL;
+}
+
+unsigned long trace_dropped(void)
+{
+    struct trace_ring *r = NULL;
+    unsigned long dropped = 0;
+
+    for (r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next)
+    {
+        dropped += r->dropped;
+    }
+
+    return dropped;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file trace.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Binary trace buffer for hot paths: per-thread rings, background flusher.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       Pointer arguments converted through uintptr_t (TRACE_ARG()).
+ * @copyright Copyright (c) 2026
+ * @details TRACE("int cnt: %d.", cnt) stores a timestamp, the format ID and the raw arguments in
+ *          the calling thread's ring: no formatting, no lock, no syscall (with a vDSO clock).
+ *          A flusher thread moves the records to the trace file, trace_dump formats them
+ *          offline and merges several files (processes) by time.
+ *
+ *          - Formats are static: each TRACE() site puts a descriptor into the "trace_fmt"
+ *            section, its index is the format ID. The whole table is written to the file
+ *            header by trace_init(), nothing is registered at run time.
+ *          - Arguments are integers or pointers (stored as 64 bits). Use %d/%u/%x/%ld/%lld/%c/%p.
+ *            TRACE_DATA() adds one byte string, printed by the %s of the format.
+ *          - One single-producer ring per thread, allocated by trace_thread_init() or on the
+ *            first record. A full ring drops the record (counted), the producer never waits.
+ *          - Timestamps come from the trace clock (CLOCK_MONOTONIC by default). The file
+ *            header stores the offset to CLOCK_MONOTONIC so files of different processes,
+ *            even with different clocks, are merged on one time base.
+ *
+ *          Under Xenomai call trace_set_clock() with the nucleus clock and trace_thread_init()
+ *          before the RT loop, then recording makes no Linux syscall (no mode switch).
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TRACE_MAGIC             0x31435254  /* "TRC1" */
+#define TRACE_CHUNK_MAGIC       0x4b4e4843  /* "CHNK" */
+#define TRACE_VERSION           1
+
+#define TRACE_RING_SIZE         (64 * 1024) /* Bytes per thread, power of 2 */
+#define TRACE_MAX_ARGS          8
+#define TRACE_MAX_DATA          256         /* TRACE_DATA() bytes, longer data is cut */
+#define TRACE_FLUSH_MS          100
+#define TRACE_FMT_PAD           0xffff      /* Ring filler up to the end, never in the file */
+
+struct trace_fmt {
+    const char *fmt;
+    const char *file;
+    uint32_t line;
+    uint32_t reserved;
+};
+
+/*
+ * Record, 8 byte aligned: header, args[nargs], data[data_len] padded.
+ */
+struct trace_rec {
+    uint64_t ts_ns;
+    uint16_t fmt;
+    uint8_t nargs;
+    uint8_t reserved;
+    uint16_t data_len;
+    uint16_t size;              /* Whole record */
+};
+
+/*
+ * File: header, format table, then chunks (one ring drain each) until the end:
+ *
+ *      trace_file_header | nr_fmts x (trace_file_fmt + fmt + file) | chunk | chunk | ...
+ *
+ * Strings are NUL terminated, entries are padded to 8 bytes.
+ */
+struct trace_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pid;
+    uint32_t nr_fmts;
+    int64_t mono_offset_ns;     /* CLOCK_MONOTONIC - trace clock */
+    uint64_t start_ns;          /* Trace clock at trace_init() */
+    char comm[16];
+    char clock[16];             /* Trace clock name */
+};
+
+struct trace_file_fmt {
+    uint32_t line;
+    uint16_t fmt_len;           /* With NUL */
+    uint16_t file_len;
+};
+
+struct trace_chunk {
+    uint32_t magic;
+    uint32_t tid;
+    uint32_t bytes;             /* Records following */
+    uint32_t dropped;           /* Records lost in this ring since the previous chunk */
+};
+
+typedef uint64_t (*trace_clock_t)(void);
+
+/**
+ * @brief Use @p clock for timestamps, named @p name in the file. Call before trace_init().
+ */
+void trace_set_clock(trace_clock_t clock, const char *name);
+
+/**
+ * @brief Create @p path, write the format table and start the flusher.
+ * @param flush_ms Flusher period, 0 selects TRACE_FLUSH_MS.
+ * @return 0 on success, -1 on error (TRACE() then does nothing).
+ */
+int trace_init(const char *path, unsigned int flush_ms);
+
+/**
+ * @brief Stop the flusher, write what is left and close the file.
+ */
+void trace_exit(void);
+
+/**
+ * @brief Allocate the calling thread's ring now instead of on its first record.
+ * @return 0 on success, -1 on error.
+ */
+int trace_thread_init(void);
+
+/**
+ * @brief Records lost because a ring was full, all threads.
+ */
+unsigned long trace_dropped(void);
+
+void trace_emit(const struct trace_fmt *fmt, const uint64_t *args, unsigned int nargs,
+                const void *data, unsigned int data_len);
+
+#define TRACE_SECTION           __attribute__((used, section("trace_fmt"), aligned(8)))
+
+/*
+ * One argument as uint64_t: a pointer through uintptr_t, an integer directly (signed values
+ * are sign extended, trace_dump relies on it for %d/%ld). __builtin_choose_expr() picks the
+ * operand, not the cast, so neither branch casts a pointer to a wider integer.
+ */
+#define TRACE_ARG_IS_PTR(x)     (__builtin_classify_type(x) == 5)
+#define TRACE_ARG(x)                                                                        \
+    ((uint64_t)(uintptr_t)__builtin_choose_expr(TRACE_ARG_IS_PTR(x), (x), 0) +              \
+     (uint64_t)__builtin_choose_expr(TRACE_ARG_IS_PTR(x), 0, (x)))
+
+#define TRACE_MAP0(...)
+#define TRACE_MAP1(a)                                   , TRACE_ARG(a)
+#define TRACE_MAP2(a, b)                                TRACE_MAP1(a) TRACE_MAP1(b)
+#define TRACE_MAP3(a, b, c)                             TRACE_MAP2(a, b) TRACE_MAP1(c)
+#define TRACE_MAP4(a, b, c, d)                          TRACE_MAP3(a, b, c) TRACE_MAP1(d)
+#define TRACE_MAP5(a, b, c, d, e)                       TRACE_MAP4(a, b, c, d) TRACE_MAP1(e)
+#define TRACE_MAP6(a, b, c, d, e, f)                    TRACE_MAP5(a, b, c, d, e) TRACE_MAP1(f)
+#define TRACE_MAP7(a, b, c, d, e, f, g)                 TRACE_MAP6(a, b, c, d, e, f) TRACE_MAP1(g)
+#define TRACE_MAP8(a, b, c, d, e, f, g, h)              TRACE_MAP7(a, b, c, d, e, f, g) TRACE_MAP1(h)
+#define TRACE_MAP_N(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...)  TRACE_MAP##n
+/* ", TRACE_ARG(a1), ..., TRACE_ARG(an)" for up to TRACE_MAX_ARGS arguments */
+#define TRACE_MAP(...)                                                                      \
+    TRACE_MAP_N(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)(__VA_ARGS__)
+
+#define TRACE_DATA(data, len, fmt, ...)                                                     \
+    do {                                                                                    \
+        static const struct trace_fmt __trace_fmt TRACE_SECTION = { fmt, __FILE__, __LINE__, 0 }; \
+        const uint64_t __trace_args[] = { 0 TRACE_MAP(__VA_ARGS__) };                        \
+        trace_emit(&__trace_fmt, __trace_args + 1,                                          \
+                   sizeof(__trace_args) / sizeof(__trace_args[0]) - 1, data, len);          \
+    } while (0)
+
+#define TRACE(fmt, ...)         TRACE_DATA(NULL, 0, fmt, ##__VA_ARGS__)
+
+#endif /* __TRACE_H__ */
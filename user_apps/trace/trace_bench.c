@@ -0,0 +1,146 @@
+/**
+ * @file trace_bench.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Cost of TRACE() against printf() in a hot loop.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details trace_bench [-n records] [-T threads] [-o trace_file]
+ *          Each thread logs n records of "int cnt: %d." with TRACE(), then n with fprintf() to
+ *          /dev/null (line buffered, like a terminal), and prints ns per record. The records
+ *          are paced in bursts of 256 so the flusher keeps up, as in a real event stream.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "trace.h"
+
+#define BENCH_BURST         256
+
+static unsigned long nr = 100000;
+static FILE *null_fp = NULL;
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_pause(void)
+{
+    struct timespec ts = { 0, 2000000 };
+
+    nanosleep(&ts, NULL);
+}
+
+static void *bench_thread(void *arg)
+{
+    long id = (long)arg;
+    uint64_t busy = 0;
+    uint64_t t0 = 0;
+    unsigned long i = 0;
+    unsigned long j = 0;
+
+    trace_thread_init();
+
+    for (i = 0; i < nr; i += BENCH_BURST)
+    {
+        t0 = bench_now_ns();
+        for (j = i; j < i + BENCH_BURST && j < nr; j++)
+        {
+            TRACE("int cnt: %d.", (int)j);
+        }
+        busy += bench_now_ns() - t0;
+        bench_pause();
+    }
+    printf("thread %ld: TRACE()   %6.1f ns/record\n", id, (double)busy / nr);
+
+    busy = 0;
+    for (i = 0; i < nr; i += BENCH_BURST)
+    {
+        t0 = bench_now_ns();
+        for (j = i; j < i + BENCH_BURST && j < nr; j++)
+        {
+            fprintf(null_fp, "int cnt: %d.\n", (int)j);
+        }
+        busy += bench_now_ns() - t0;
+        bench_pause();
+    }
+    printf("thread %ld: fprintf() %6.1f ns/record\n", id, (double)busy / nr);
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t threads[16];
+    const char *path = "/tmp/trace_bench.trc";
+    long nr_threads = 1;
+    long i = 0;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "n:T:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            nr = strtoul(optarg, NULL, 0);
+            break;
+        case 'T':
+            nr_threads = strtol(optarg, NULL, 0);
+            break;
+        case 'o':
+            path = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n records] [-T threads] [-o trace_file]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (!nr || nr_threads < 1 || nr_threads > 16)
+    {
+        fprintf(stderr, "Error: Invalid argument!\n");
+        return -1;
+    }
+
+    null_fp = fopen("/dev/null", "w");
+    if (!null_fp)
+    {
+        fprintf(stderr, "Error: failed to open /dev/null!\n");
+        return -1;
+    }
+    setvbuf(null_fp, NULL, _IOLBF, BUFSIZ);
+
+    if (trace_init(path, 10))
+    {
+        fclose(null_fp);
+        return -1;
+    }
+
+    for (i = 0; i < nr_threads; i++)
+    {
+        pthread_create(&threads[i], NULL, bench_thread, (void *)i);
+    }
+    for (i = 0; i < nr_threads; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    printf("dropped: %lu, trace file: %s\n", trace_dropped(), path);
+    trace_exit();
+    fclose(null_fp);
+
+    return 0;
+}
@@ -0,0 +1,484 @@
+/**
+ * @file trace_dump.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Offline decoder for trace files, merges several files by time.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details trace_dump [-d] [-f text] [-l] file...
+ *          Records of all files are put on CLOCK_MONOTONIC (mono_offset_ns of each header),
+ *          sorted and printed as: time since the first record, comm:pid/tid, message.
+ *          -d  add the time since the previous printed record (us), for latency chains across
+ *              threads and processes
+ *          -f  only records whose format contains text
+ *          -l  list the format table of each file
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+
+#define DUMP_MAX_FILES      32
+
+struct dump_fmt {
+    const char *fmt;
+    const char *file;
+    uint32_t line;
+};
+
+struct dump_file {
+    const char *path;
+    uint8_t *buf;
+    size_t size;
+    const struct trace_file_header *hdr;
+    struct dump_fmt *fmts;
+};
+
+struct dump_ent {
+    uint64_t ts;                /* CLOCK_MONOTONIC */
+    uint64_t seq;               /* Order of appearance, keeps sorting stable */
+    uint32_t file;
+    uint32_t tid;
+    const struct trace_rec *rec;
+};
+
+static struct dump_file files[DUMP_MAX_FILES];
+static struct dump_ent *ents = NULL;
+static size_t nr_ents = 0;
+static size_t max_ents = 0;
+
+static int dump_load(struct dump_file *f)
+{
+    struct stat st;
+    ssize_t ret = 0;
+    size_t done = 0;
+    int fd = -1;
+
+    fd = open(f->path, O_RDONLY);
+    if (fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", f->path, errno);
+        return -1;
+    }
+
+    if (fstat(fd, &st))
+    {
+        fprintf(stderr, "Error: fstat() failed, errno=%d!\n", errno);
+        close(fd);
+        return -1;
+    }
+
+    f->size = st.st_size;
+    f->buf = malloc(f->size + 1);
+    if (!f->buf)
+    {
+        fprintf(stderr, "Error: malloc() failed!\n");
+        close(fd);
+        return -1;
+    }
+
+    while (done < f->size)
+    {
+        ret = read(fd, f->buf + done, f->size - done);
+        if (ret <= 0)
+        {
+            break;
+        }
+        done += ret;
+    }
+    close(fd);
+    f->size = done;
+
+    return 0;
+}
+
+static int dump_add(uint32_t file, uint32_t tid, const struct trace_rec *rec)
+{
+    struct dump_ent *tmp = NULL;
+
+    if (nr_ents == max_ents)
+    {
+        max_ents = max_ents ? max_ents * 2 : 4096;
+        tmp = realloc(ents, max_ents * sizeof(*ents));
+        if (!tmp)
+        {
+            fprintf(stderr, "Error: realloc() failed!\n");
+            return -1;
+        }
+        ents = tmp;
+    }
+
+    ents[nr_ents].ts = rec->ts_ns + files[file].hdr->mono_offset_ns;
+    ents[nr_ents].seq = nr_ents;
+    ents[nr_ents].file = file;
+    ents[nr_ents].tid = tid;
+    ents[nr_ents].rec = rec;
+    nr_ents++;
+
+    return 0;
+}
+
+/*
+ * Check the header, index the format table and collect the records of file @p idx.
+ */
+static int dump_parse(uint32_t idx, unsigned long *dropped)
+{
+    struct dump_file *f = &files[idx];
+    const struct trace_file_fmt *ff = NULL;
+    const struct trace_chunk *chunk = NULL;
+    const struct trace_rec *rec = NULL;
+    size_t off = sizeof(*f->hdr);
+    size_t end = 0;
+    uint32_t i = 0;
+
+    f->hdr = (const struct trace_file_header *)f->buf;
+    if (f->size < sizeof(*f->hdr) || f->hdr->magic != TRACE_MAGIC || f->hdr->version != TRACE_VERSION)
+    {
+        fprintf(stderr, "Error: <%s> is not a trace file!\n", f->path);
+        return -1;
+    }
+
+    f->fmts = calloc(f->hdr->nr_fmts + 1, sizeof(*f->fmts));
+    if (!f->fmts)
+    {
+        fprintf(stderr, "Error: calloc() failed!\n");
+        return -1;
+    }
+
+    for (i = 0; i < f->hdr->nr_fmts; i++)
+    {
+        ff = (const struct trace_file_fmt *)(f->buf + off);
+        if (off + sizeof(*ff) > f->size ||
+            off + sizeof(*ff) + ff->fmt_len + ff->file_len > f->size ||
+            !ff->fmt_len || !ff->file_len)
+        {
+            fprintf(stderr, "Error: <%s> format table truncated!\n", f->path);
+            return -1;
+        }
+        f->fmts[i].line = ff->line;
+        f->fmts[i].fmt = (const char *)(ff + 1);
+        f->fmts[i].file = f->fmts[i].fmt + ff->fmt_len;
+        off += (sizeof(*ff) + ff->fmt_len + ff->file_len + 7) & ~(size_t)7;
+    }
+
+    while (off + sizeof(*chunk) <= f->size)
+    {
+        chunk = (const struct trace_chunk *)(f->buf + off);
+        if (chunk->magic != TRACE_CHUNK_MAGIC)
+        {
+            fprintf(stderr, "Warn: <%s> bad chunk at %zu, rest ignored!\n", f->path, off);
+            break;
+        }
+        off += sizeof(*chunk);
+        end = off + chunk->bytes;
+        if (end > f->size)
+        {
+            /* Flusher killed in the middle of a write. */
+            end = f->size;
+        }
+        *dropped += chunk->dropped;
+
+        while (off + sizeof(*rec) <= end)
+        {
+            rec = (const struct trace_rec *)(f->buf + off);
+            if (rec->size < sizeof(*rec) || off + rec->size > end)
+            {
+                break;
+            }
+            if (dump_add(idx, chunk->tid, rec))
+            {
+                return -1;
+            }
+            off += rec->size;
+        }
+        off = end;
+    }
+
+    return 0;
+}
+
+static int dump_cmp(const void *a, const void *b)
+{
+    const struct dump_ent *x = a;
+    const struct dump_ent *y = b;
+
+    if (x->ts != y->ts)
+    {
+        return x->ts < y->ts ? -1 : 1;
+    }
+
+    return x->seq < y->seq ? -1 : 1;
+}
+
+/*
+ * printf() with the record's arguments, one conversion at a time. %s takes the record data.
+ */
+static void dump_format(char *dst, size_t size, const char *fmt, const struct trace_rec *rec)
+{
+    const uint64_t *args = (const uint64_t *)(rec + 1);
+    const uint8_t *data = (const uint8_t *)(args + rec->nargs);
+    char spec[32];
+    char text[TRACE_MAX_DATA * 4 + 1];
+    const char *p = fmt;
+    const char *s = NULL;
+    size_t len = 0;
+    size_t n = 0;
+    unsigned int arg = 0;
+    unsigned int i = 0;
+    int lng = 0;
+    uint64_t v = 0;
+
+    while (*p && len + 1 < size)
+    {
+        if (*p != '%')
+        {
+            dst[len++] = *p++;
+            continue;
+        }
+
+        if (p[1] == '%')
+        {
+            dst[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        /* Flags, width, precision, length, conversion. */
+        s = p++;
+        while (*p && strchr("-+ #0", *p))
+        {
+            p++;
+        }
+        while (*p && (isdigit((unsigned char)*p) || *p == '.'))
+        {
+            p++;
+        }
+        lng = 0;
+        while (*p && strchr("hlqjzt", *p))
+        {
+            if (*p == 'l' || *p == 'q' || *p == 'j' || *p == 'z' || *p == 't')
+            {
+                lng++;
+            }
+            p++;
+        }
+        if (!*p)
+        {
+            break;
+        }
+
+        n = p - s + 1;
+        if (n + 3 > sizeof(spec))
+        {
+            break;
+        }
+
+        if (*p == 's')
+        {
+            /* Escape the raw bytes, precision/width of the spec still apply. */
+            for (i = 0, n = 0; i < rec->data_len; i++)
+            {
+                if (isprint(data[i]) && data[i] != '\\')
+                {
+                    text[n++] = data[i];
+                }
+                else if (data[i] == '\n')
+                {
+                    n += sprintf(text + n, "\\n");
+                }
+                else if (data[i] == '\r')
+                {
+                    n += sprintf(text + n, "\\r");
+                }
+                else
+                {
+                    n += sprintf(text + n, "\\x%02x", data[i]);
+                }
+            }
+            text[n] = '\0';
+            memcpy(spec, s, p - s + 1);
+            spec[p - s + 1] = '\0';
+            len += snprintf(dst + len, size - len, spec, text);
+        }
+        else
+        {
+            v = arg < rec->nargs ? args[arg] : 0;
+            arg++;
+
+            /* Rebuild the spec with ll so every integer is passed as 64 bits. */
+            memcpy(spec, s, p - s);
+            n = p - s;
+            while (n > 1 && strchr("hlqjzt", spec[n - 1]))
+            {
+                n--;
+            }
+
+            if (*p == 'p')
+            {
+                spec[n++] = 'p';
+                spec[n] = '\0';
+                len += snprintf(dst + len, size - len, spec, (void *)(uintptr_t)v);
+            }
+            else if (strchr("diouxXc", *p))
+            {
+                if (*p == 'c')
+                {
+                    spec[n++] = 'c';
+                    spec[n] = '\0';
+                    len += snprintf(dst + len, size - len, spec, (int)v);
+                }
+                else
+                {
+                    /* Without l the argument was an int: sign extend from 32 bits. */
+                    if (!lng && (*p == 'd' || *p == 'i'))
+                    {
+                        v = (uint64_t)(int64_t)(int32_t)v;
+                    }
+                    else if (!lng)
+                    {
+                        v = (uint32_t)v;
+                    }
+                    spec[n++] = 'l';
+                    spec[n++] = 'l';
+                    spec[n++] = *p;
+                    spec[n] = '\0';
+                    len += snprintf(dst + len, size - len, spec, (unsigned long long)v);
+                }
+            }
+            else
+            {
+                len += snprintf(dst + len, size - len, "<%%%c?>", *p);
+            }
+        }
+
+        if (len >= size)
+        {
+            len = size - 1;
+        }
+        p++;
+    }
+
+    dst[len] = '\0';
+}
+
+static void dump_list(uint32_t idx)
+{
+    struct dump_file *f = &files[idx];
+    uint32_t i = 0;
+
+    printf("%s: pid %u, comm %s, clock %s, %u formats\n", f->path, f->hdr->pid, f->hdr->comm,
+           f->hdr->clock, f->hdr->nr_fmts);
+    for (i = 0; i < f->hdr->nr_fmts; i++)
+    {
+        printf("  %4u  %s:%u  \"%s\"\n", i, f->fmts[i].file, f->fmts[i].line, f->fmts[i].fmt);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const struct trace_file_header *hdr = NULL;
+    const struct dump_fmt *fmt = NULL;
+    const char *filter = NULL;
+    char msg[1024];
+    unsigned long dropped = 0;
+    uint64_t first = 0;
+    uint64_t prev = 0;
+    uint32_t nr_files = 0;
+    size_t i = 0;
+    int delta = 0;
+    int list = 0;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "df:l")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            delta = 1;
+            break;
+        case 'f':
+            filter = optarg;
+            break;
+        case 'l':
+            list = 1;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-d] [-f text] [-l] file...\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind >= argc || argc - optind > DUMP_MAX_FILES)
+    {
+        fprintf(stderr, "Usage: %s [-d] [-f text] [-l] file... (at most %d files)\n", argv[0], DUMP_MAX_FILES);
+        return -1;
+    }
+
+    for (nr_files = 0; optind < argc; optind++, nr_files++)
+    {
+        files[nr_files].path = argv[optind];
+        if (dump_load(&files[nr_files]) || dump_parse(nr_files, &dropped))
+        {
+            return -1;
+        }
+        if (list)
+        {
+            dump_list(nr_files);
+        }
+    }
+
+    if (list)
+    {
+        return 0;
+    }
+
+    qsort(ents, nr_ents, sizeof(*ents), dump_cmp);
+
+    first = nr_ents ? ents[0].ts : 0;
+    prev = first;
+    for (i = 0; i < nr_ents; i++)
+    {
+        hdr = files[ents[i].file].hdr;
+        if (ents[i].rec->fmt >= hdr->nr_fmts)
+        {
+            printf("%llu.%09llu  %s:%u/%u  <bad format %u>\n",
+                   (unsigned long long)((ents[i].ts - first) / 1000000000ULL),
+                   (unsigned long long)((ents[i].ts - first) % 1000000000ULL),
+                   hdr->comm, hdr->pid, ents[i].tid, ents[i].rec->fmt);
+            continue;
+        }
+
+        fmt = &files[ents[i].file].fmts[ents[i].rec->fmt];
+        if (filter && !strstr(fmt->fmt, filter))
+        {
+            continue;
+        }
+
+        dump_format(msg, sizeof(msg), fmt->fmt, ents[i].rec);
+        printf("%llu.%09llu  ", (unsigned long long)((ents[i].ts - first) / 1000000000ULL),
+               (unsigned long long)((ents[i].ts - first) % 1000000000ULL));
+        if (delta)
+        {
+            printf("%+12.3f  ", (ents[i].ts - prev) / 1e3);
+        }
+        printf("%s:%u/%u  %s\n", hdr->comm, hdr->pid, ents[i].tid, msg);
+        prev = ents[i].ts;
+    }
+
+    if (dropped)
+    {
+        fprintf(stderr, "Warn: %lu records dropped while tracing!\n", dropped);
+    }
+
+    return 0;
+}
@@ -0,0 +1,282 @@
+/**
+ * @file uring.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Minimal io_uring wrapper on the raw system calls (no liburing on the target).
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @note OS: Linux >= 5.6 (IORING_FEAT_SINGLE_MMAP, IORING_OP_READ_FIXED on current position).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "uring.h"
+
+#define uring_load_acquire(p)       __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define uring_store_release(p, v)   __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+static int uring_setup(unsigned int entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(struct uring *ring, unsigned int to_submit, unsigned int min_complete,
+                       unsigned int flags)
+{
+    ring->enters++;
+
+    return (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_register(struct uring *ring, unsigned int opcode, const void *arg, unsigned int nr)
+{
+    return (int)syscall(__NR_io_uring_register, ring->fd, opcode, arg, nr);
+}
+
+int uring_init(struct uring *ring, unsigned int entries, unsigned int flags)
+{
+    struct io_uring_params p;
+    unsigned char *sq = NULL;
+    unsigned char *cq = NULL;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&p, 0, sizeof(p));
+    p.flags = flags;
+    if (flags & IORING_SETUP_SQPOLL)
+    {
+        p.sq_thread_idle = 1000;   /* ms before the poller thread sleeps */
+    }
+
+    errno = 0;
+    ring->fd = uring_setup(entries, &p);
+    if (ring->fd < 0)
+    {
+        fprintf(stderr, "Error: io_uring_setup() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    ring->flags = flags;
+    ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    /* SQ and CQ rings share one mapping on every kernel with IORING_FEAT_SINGLE_MMAP. */
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cq_ring_size > ring->sq_ring_size)
+        {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = 0;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED)
+    {
+        goto err;
+    }
+
+    if (ring->cq_ring_size)
+    {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED)
+        {
+            goto err;
+        }
+    }
+    else
+    {
+        ring->cq_ring = ring->sq_ring;
+    }
+
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+    {
+        goto err;
+    }
+
+    sq = (unsigned char *)ring->sq_ring;
+    ring->sq_head = (unsigned int *)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned int *)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned int *)(sq + p.sq_off.ring_mask);
+    ring->sq_flags = (unsigned int *)(sq + p.sq_off.flags);
+    ring->sq_array = (unsigned int *)(sq + p.sq_off.array);
+    ring->sq_local_tail = *ring->sq_tail;
+
+    cq = (unsigned char *)ring->cq_ring;
+    ring->cq_head = (unsigned int *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned int *)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned int *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    return 0;
+
+err:
+    fprintf(stderr, "Error: mmap() io_uring failed, errno=%d!\n", errno);
+    if (ring->sq_ring && ring->sq_ring != MAP_FAILED)
+    {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->cq_ring_size && ring->cq_ring && ring->cq_ring != MAP_FAILED)
+    {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    close(ring->fd);
+    ring->fd = -1;
+
+    return -1;
+}
+
+void uring_exit(struct uring *ring)
+{
+    if (ring->fd < 0)
+    {
+        return;
+    }
+
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring_size)
+    {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+    ring->fd = -1;
+}
+
+int uring_register_buffers(struct uring *ring, const struct iovec *iovs, unsigned int nr)
+{
+    errno = 0;
+    if (uring_register(ring, IORING_REGISTER_BUFFERS, iovs, nr))
+    {
+        fprintf(stderr, "Error: IORING_REGISTER_BUFFERS failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+int uring_register_files(struct uring *ring, const int *fds, unsigned int nr)
+{
+    errno = 0;
+    if (uring_register(ring, IORING_REGISTER_FILES, fds, nr))
+    {
+        fprintf(stderr, "Error: IORING_REGISTER_FILES failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+struct io_uring_sqe *uring_get_sqe(struct uring *ring)
+{
+    unsigned int head = uring_load_acquire(ring->sq_head);
+    struct io_uring_sqe *sqe = NULL;
+    unsigned int index = 0;
+
+    if (ring->sq_local_tail - head > *ring->sq_mask)
+    {
+        return NULL;
+    }
+
+    index = ring->sq_local_tail & *ring->sq_mask;
+    sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->sq_local_tail++;
+
+    return sqe;
+}
+
+int uring_submit(struct uring *ring)
+{
+    unsigned int tail = *ring->sq_tail;
+    unsigned int to_submit = ring->sq_local_tail - tail;
+
+    if (!to_submit)
+    {
+        return 0;
+    }
+
+    uring_store_release(ring->sq_tail, ring->sq_local_tail);
+
+    if (ring->flags & IORING_SETUP_SQPOLL)
+    {
+        /* The poller thread picks the SQEs up by itself unless it went to sleep. */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (uring_load_acquire(ring->sq_flags) & IORING_SQ_NEED_WAKEUP)
+        {
+            if (uring_enter(ring, 0, 0, IORING_ENTER_SQ_WAKEUP) < 0)
+            {
+                fprintf(stderr, "Error: io_uring_enter() wakeup failed, errno=%d!\n", errno);
+                return -1;
+            }
+        }
+
+        return (int)to_submit;
+    }
+
+    errno = 0;
+    if (uring_enter(ring, to_submit, 0, 0) < 0)
+    {
+        fprintf(stderr, "Error: io_uring_enter() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    return (int)to_submit;
+}
+
+struct io_uring_cqe *uring_peek_cqe(struct uring *ring)
+{
+    unsigned int head = *ring->cq_head;
+
+    if (head == uring_load_acquire(ring->cq_tail))
+    {
+        return NULL;
+    }
+
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+struct io_uring_cqe *uring_wait_cqe(struct uring *ring)
+{
+    struct io_uring_cqe *cqe = NULL;
+    unsigned int to_submit = 0;
+
+    while (!(cqe = uring_peek_cqe(ring)))
+    {
+        /* Without SQPOLL pending SQEs go in with the same call. */
+        if (!(ring->flags & IORING_SETUP_SQPOLL))
+        {
+            to_submit = ring->sq_local_tail - *ring->sq_tail;
+            uring_store_release(ring->sq_tail, ring->sq_local_tail);
+        }
+
+        errno = 0;
+        if (uring_enter(ring, to_submit, 1, IORING_ENTER_GETEVENTS) < 0)
+        {
+            /* Let the caller look at its signal flags. */
+            if (errno != EINTR)
+            {
+                fprintf(stderr, "Error: io_uring_enter() wait failed, errno=%d!\n", errno);
+            }
+            return NULL;
+        }
+    }
+
+    return cqe;
+}
+
+void uring_cqe_seen(struct uring *ring)
+{
+    uring_store_release(ring->cq_head, *ring->cq_head + 1);
+}
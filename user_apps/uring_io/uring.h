@@ -0,0 +1,95 @@
+/**
+ * @file uring.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Minimal io_uring wrapper on the raw system calls (no liburing on the target).
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ */
+
+#ifndef __URING_H__
+#define __URING_H__
+
+#include <stddef.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+struct uring {
+    int fd;
+    unsigned int flags;             /* IORING_SETUP_* */
+
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_flags;
+    unsigned int *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned int sq_local_tail;     /* SQEs prepared, not yet published */
+
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+
+    unsigned long enters;           /* io_uring_enter() calls, for statistics */
+};
+
+/**
+ * @brief Set up a ring of @p entries SQEs, @p flags is IORING_SETUP_* (e.g. IORING_SETUP_SQPOLL).
+ * @return 0 on success, -1 on error.
+ */
+int uring_init(struct uring *ring, unsigned int entries, unsigned int flags);
+
+void uring_exit(struct uring *ring);
+
+int uring_register_buffers(struct uring *ring, const struct iovec *iovs, unsigned int nr);
+
+int uring_register_files(struct uring *ring, const int *fds, unsigned int nr);
+
+/**
+ * @brief Next free SQE, zeroed, or NULL if the SQ is full.
+ */
+struct io_uring_sqe *uring_get_sqe(struct uring *ring);
+
+/**
+ * @brief Publish the prepared SQEs and, if needed, tell the kernel.
+ *        With SQPOLL no system call is made while the poller thread is awake.
+ * @return Number of SQEs published, -1 on error.
+ */
+int uring_submit(struct uring *ring);
+
+/**
+ * @brief Next completion, NULL if none is ready. Does not block.
+ */
+struct io_uring_cqe *uring_peek_cqe(struct uring *ring);
+
+/**
+ * @brief Next completion, blocks (one io_uring_enter()) until one is ready.
+ * @return NULL on error or when interrupted by a signal (errno EINTR).
+ */
+struct io_uring_cqe *uring_wait_cqe(struct uring *ring);
+
+void uring_cqe_seen(struct uring *ring);
+
+static inline void uring_prep_read_fixed(struct io_uring_sqe *sqe, int file_index, void *buf,
+                                         unsigned int len, unsigned short buf_index,
+                                         unsigned long long user_data)
+{
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = file_index;
+    sqe->addr = (unsigned long)buf;
+    sqe->len = len;
+    sqe->off = (unsigned long long)-1;     /* Current position: ttys and char devices */
+    sqe->buf_index = buf_index;
+    sqe->user_data = user_data;
+}
+
+#endif /* __URING_H__ */
@@ -0,0 +1,665 @@
+/**
+ * @file uring_rx.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief io_uring receive backend for serial ports and /dev/key.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details Usage:
+ *              uring_rx [-S] [-q] dev...
+ *              uring_rx -B [-S] [-n pairs] [-t sec] [-s chunk] epoll|uring
+ *          Every tty and /dev/key fd is a registered (fixed) file and every read goes to a
+ *          registered buffer, reads are re-armed on completion. /dev/key devices share one
+ *          eventfd (KEY_IOC_SET_EVENTFD), on each wakeup the key fds are read with a linked
+ *          chain of reads. With -S (SQPOLL) submissions take no system call while the kernel
+ *          poller thread is awake.
+ *          -B benchmarks the epoll + read() path against io_uring on pty pairs and prints
+ *          throughput, system calls/s and CPU time per MB.
+ * @note OS: Linux >= 5.6.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "uring.h"
+#include "serial.h"
+#include "key_irq.h"
+
+#define RX_MAX_FDS      64
+#define RX_BUF_SIZE     4096
+#define RX_RING_ENTRIES 256
+
+/* user_data of the eventfd read and of the key reads. */
+#define RX_TAG_EVENTFD  0x10000ULL
+#define RX_TAG_KEY      0x20000ULL
+
+struct rx_ctx {
+    struct uring ring;
+    int fds[RX_MAX_FDS];            /* Fixed file table: ttys, then key fds, then the eventfd */
+    const char *names[RX_MAX_FDS];
+    unsigned int nr_tty;
+    unsigned int nr_key;
+    int efd;
+    int key_vals[RX_MAX_FDS];
+    uint64_t efd_count;
+    unsigned char (*bufs)[RX_BUF_SIZE];
+    unsigned long long bytes;
+    int quiet;
+};
+
+static volatile sig_atomic_t rx_stop = 0;
+
+static void rx_sig_handler(int sig)
+{
+    (void)sig;
+    rx_stop = 1;
+}
+
+static double rx_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int rx_arm_tty(struct rx_ctx *ctx, unsigned int i)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(&ctx->ring);
+
+    if (!sqe)
+    {
+        return -1;
+    }
+
+    uring_prep_read_fixed(sqe, i, ctx->bufs[i], RX_BUF_SIZE, i, i);
+
+    return 0;
+}
+
+static int rx_arm_eventfd(struct rx_ctx *ctx)
+{
+    unsigned int index = ctx->nr_tty + ctx->nr_key;
+    struct io_uring_sqe *sqe = uring_get_sqe(&ctx->ring);
+
+    if (!sqe)
+    {
+        return -1;
+    }
+
+    uring_prep_read_fixed(sqe, index, ctx->bufs[index], sizeof(ctx->efd_count), index, RX_TAG_EVENTFD);
+
+    return 0;
+}
+
+/*
+ * One linked chain: a read of every key device, the last read carries the chain's completion.
+ */
+static int rx_arm_keys(struct rx_ctx *ctx)
+{
+    struct io_uring_sqe *sqe = NULL;
+    unsigned int i = 0;
+
+    for (i = 0; i < ctx->nr_key; i++)
+    {
+        sqe = uring_get_sqe(&ctx->ring);
+        if (!sqe)
+        {
+            return -1;
+        }
+
+        uring_prep_read_fixed(sqe, ctx->nr_tty + i, ctx->bufs[ctx->nr_tty + i], sizeof(int),
+                              ctx->nr_tty + i, RX_TAG_KEY | i);
+        if (i + 1 < ctx->nr_key)
+        {
+            sqe->flags |= IOSQE_IO_LINK;
+        }
+    }
+
+    return 0;
+}
+
+static int rx_setup_ring(struct rx_ctx *ctx, unsigned int nr_files, unsigned int flags)
+{
+    struct iovec iovs[RX_MAX_FDS];
+    unsigned int i = 0;
+
+    ctx->bufs = calloc(nr_files, RX_BUF_SIZE);
+    if (!ctx->bufs)
+    {
+        fprintf(stderr, "Error: calloc() failed!\n");
+        return -1;
+    }
+
+    if (uring_init(&ctx->ring, RX_RING_ENTRIES, flags))
+    {
+        return -1;
+    }
+
+    for (i = 0; i < nr_files; i++)
+    {
+        iovs[i].iov_base = ctx->bufs[i];
+        iovs[i].iov_len = RX_BUF_SIZE;
+    }
+
+    if (uring_register_buffers(&ctx->ring, iovs, nr_files) ||
+        uring_register_files(&ctx->ring, ctx->fds, nr_files))
+    {
+        uring_exit(&ctx->ring);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int rx_handle_cqe(struct rx_ctx *ctx, struct io_uring_cqe *cqe)
+{
+    unsigned long long tag = cqe->user_data;
+    unsigned int i = tag & 0xFFFF;
+    int key_val = 0;
+
+    if (tag & RX_TAG_EVENTFD)
+    {
+        if (cqe->res < 0)
+        {
+            fprintf(stderr, "Error: eventfd read failed, res=%d!\n", cqe->res);
+            return -1;
+        }
+
+        return rx_arm_keys(ctx);
+    }
+
+    if (tag & RX_TAG_KEY)
+    {
+        memcpy(&key_val, ctx->bufs[ctx->nr_tty + i], sizeof(key_val));
+        if (cqe->res == sizeof(int) || cqe->res == 0)
+        {
+            /* key_read() reports the copy_to_user() result, the value is in the buffer. */
+            ctx->key_vals[i] = key_val;
+            if (!ctx->quiet && key_val != KEY_KEEP)
+            {
+                printf("%s: key event %d\n", ctx->names[ctx->nr_tty + i], key_val);
+            }
+        }
+        else
+        {
+            /* Failed read: no event, a stale value would keep re-arming the chain below. */
+            ctx->key_vals[i] = KEY_KEEP;
+            if (cqe->res != -ECANCELED)
+            {
+                /* The rest of a linked chain completes with -ECANCELED after a failed read. */
+                fprintf(stderr, "Error: %s read failed, res=%d!\n", ctx->names[ctx->nr_tty + i], cqe->res);
+            }
+        }
+
+        if (i + 1 < ctx->nr_key)
+        {
+            return 0;
+        }
+
+        /* End of the chain: read again while any device still had an event queued. */
+        for (i = 0; i < ctx->nr_key; i++)
+        {
+            if (ctx->key_vals[i] != KEY_KEEP)
+            {
+                return rx_arm_keys(ctx);
+            }
+        }
+
+        return rx_arm_eventfd(ctx);
+    }
+
+    if (cqe->res < 0)
+    {
+        fprintf(stderr, "Error: %s read failed, res=%d!\n", ctx->names[i], cqe->res);
+        return -1;
+    }
+
+    ctx->bytes += cqe->res;
+    if (!ctx->quiet && cqe->res > 0)
+    {
+        printf("%s: %d bytes\n", ctx->names[i], cqe->res);
+    }
+
+    return rx_arm_tty(ctx, i);
+}
+
+static int rx_loop(struct rx_ctx *ctx, double deadline)
+{
+    struct io_uring_cqe *cqe = NULL;
+
+    while (!rx_stop && (!deadline || rx_now() < deadline))
+    {
+        if (uring_submit(&ctx->ring) < 0)
+        {
+            return -1;
+        }
+
+        cqe = uring_wait_cqe(&ctx->ring);
+        if (!cqe)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        /* Drain everything that is ready, then submit the re-armed reads as one batch. */
+        do
+        {
+            if (rx_handle_cqe(ctx, cqe))
+            {
+                uring_cqe_seen(&ctx->ring);
+                return -1;
+            }
+            uring_cqe_seen(&ctx->ring);
+        } while ((cqe = uring_peek_cqe(&ctx->ring)));
+    }
+
+    return 0;
+}
+
+static int rx_run(int argc, char *argv[], unsigned int flags, int quiet)
+{
+    struct rx_ctx ctx;
+    int key_fds[RX_MAX_FDS];
+    unsigned int nr_files = 0;
+    unsigned int i = 0;
+    int fd = -1;
+    int ret = -1;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.efd = -1;
+    ctx.quiet = quiet;
+
+    if (argc > RX_MAX_FDS - 1)
+    {
+        fprintf(stderr, "Error: too many devices!\n");
+        return -1;
+    }
+
+    for (i = 0; i < (unsigned int)argc; i++)
+    {
+        fd = open(argv[i], O_RDWR | O_NOCTTY);
+        if (fd == -1)
+        {
+            fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", argv[i], errno);
+            goto out;
+        }
+
+        if (isatty(fd))
+        {
+            close(fd);
+            fd = -1;
+            if (serial_init(argv[i], B115200, &fd) || serial_set_raw(fd))
+            {
+                serial_exit(fd);
+                goto out;
+            }
+            ctx.names[ctx.nr_tty] = argv[i];
+            ctx.fds[ctx.nr_tty++] = fd;
+        }
+        else
+        {
+            key_fds[ctx.nr_key] = fd;
+            ctx.names[RX_MAX_FDS - 1 - ctx.nr_key] = argv[i];
+            ctx.nr_key++;
+        }
+    }
+
+    /* Key fds follow the ttys in the fixed file table, then the shared eventfd. */
+    for (i = 0; i < ctx.nr_key; i++)
+    {
+        ctx.fds[ctx.nr_tty + i] = key_fds[i];
+        ctx.names[ctx.nr_tty + i] = ctx.names[RX_MAX_FDS - 1 - i];
+    }
+    nr_files = ctx.nr_tty + ctx.nr_key;
+
+    if (ctx.nr_key)
+    {
+        ctx.efd = eventfd(0, EFD_CLOEXEC);
+        if (ctx.efd == -1)
+        {
+            perror("eventfd error!");
+            goto out;
+        }
+
+        for (i = 0; i < ctx.nr_key; i++)
+        {
+            if (ioctl(key_fds[i], KEY_IOC_SET_EVENTFD, &ctx.efd))
+            {
+                fprintf(stderr, "Error: KEY_IOC_SET_EVENTFD <%s>, errno=%d!\n", ctx.names[ctx.nr_tty + i], errno);
+                goto out;
+            }
+        }
+
+        ctx.fds[nr_files++] = ctx.efd;
+    }
+
+    if (rx_setup_ring(&ctx, nr_files, flags))
+    {
+        goto out;
+    }
+
+    for (i = 0; i < ctx.nr_tty; i++)
+    {
+        rx_arm_tty(&ctx, i);
+    }
+    if (ctx.nr_key)
+    {
+        /* Events queued before the eventfd was registered. */
+        rx_arm_keys(&ctx);
+    }
+
+    ret = rx_loop(&ctx, 0);
+    printf("received: %llu bytes, io_uring_enter: %lu\n", ctx.bytes, ctx.ring.enters);
+    uring_exit(&ctx.ring);
+
+out:
+    for (i = 0; i < ctx.nr_tty; i++)
+    {
+        serial_exit(ctx.fds[i]);
+    }
+    for (i = 0; i < ctx.nr_key; i++)
+    {
+        close(key_fds[i]);
+    }
+    if (ctx.efd != -1)
+    {
+        close(ctx.efd);
+    }
+    free(ctx.bufs);
+
+    return ret;
+}
+
+/*
+ * Benchmark: a child process writes into the pty masters, this process reads the slaves.
+ */
+static int bench_open_pty(int *master, int *slave)
+{
+    char name[64];
+
+    *master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (*master == -1 || grantpt(*master) || unlockpt(*master) || ptsname_r(*master, name, sizeof(name)))
+    {
+        fprintf(stderr, "Error: posix_openpt() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    *slave = open(name, O_RDWR | O_NOCTTY);
+    if (*slave == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", name, errno);
+        return -1;
+    }
+
+    return serial_set_raw(*slave) || serial_set_raw(*master);
+}
+
+static void bench_writer(const int *masters, unsigned int nr, size_t chunk)
+{
+    unsigned char *buf = malloc(chunk);
+    unsigned int i = 0;
+
+    if (!buf)
+    {
+        _exit(1);
+    }
+
+    memset(buf, 0x55, chunk);
+    signal(SIGTERM, SIG_DFL);
+
+    while (1)
+    {
+        for (i = 0; i < nr; i++)
+        {
+            if (write(masters[i], buf, chunk) < 0 && errno != EINTR && errno != EAGAIN)
+            {
+                _exit(0);
+            }
+        }
+    }
+}
+
+static int bench_epoll(const int *slaves, unsigned int nr, double deadline,
+                       unsigned long long *bytes, unsigned long *syscalls)
+{
+    struct epoll_event evs[RX_MAX_FDS];
+    struct epoll_event ev;
+    unsigned char buf[RX_BUF_SIZE];
+    unsigned int i = 0;
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    int n = 0;
+    ssize_t len = 0;
+
+    if (epfd == -1)
+    {
+        perror("epoll_create1 error!");
+        return -1;
+    }
+
+    for (i = 0; i < nr; i++)
+    {
+        ev.events = EPOLLIN;
+        ev.data.fd = slaves[i];
+        epoll_ctl(epfd, EPOLL_CTL_ADD, slaves[i], &ev);
+    }
+
+    while (!rx_stop && rx_now() < deadline)
+    {
+        n = epoll_wait(epfd, evs, RX_MAX_FDS, 100);
+        (*syscalls)++;
+        for (i = 0; i < (unsigned int)n; i++)
+        {
+            len = read(evs[i].data.fd, buf, sizeof(buf));
+            (*syscalls)++;
+            if (len > 0)
+            {
+                *bytes += len;
+            }
+        }
+    }
+
+    close(epfd);
+
+    return 0;
+}
+
+static int bench_uring(const int *slaves, unsigned int nr, unsigned int flags, double deadline,
+                       unsigned long long *bytes, unsigned long *syscalls)
+{
+    struct rx_ctx ctx;
+    unsigned int i = 0;
+    int ret = 0;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.quiet = 1;
+    ctx.nr_tty = nr;
+    for (i = 0; i < nr; i++)
+    {
+        ctx.fds[i] = slaves[i];
+        ctx.names[i] = "pty";
+    }
+
+    if (rx_setup_ring(&ctx, nr, flags))
+    {
+        free(ctx.bufs);
+        return -1;
+    }
+
+    for (i = 0; i < nr; i++)
+    {
+        rx_arm_tty(&ctx, i);
+    }
+
+    ret = rx_loop(&ctx, deadline);
+    *bytes = ctx.bytes;
+    *syscalls = ctx.ring.enters;
+
+    uring_exit(&ctx.ring);
+    free(ctx.bufs);
+
+    return ret;
+}
+
+static int rx_bench(const char *mode, unsigned int nr, double duration, size_t chunk, unsigned int flags)
+{
+    int masters[RX_MAX_FDS];
+    int slaves[RX_MAX_FDS];
+    struct rusage ru0;
+    struct rusage ru1;
+    unsigned long long bytes = 0;
+    unsigned long syscalls = 0;
+    double t0 = 0;
+    double t1 = 0;
+    double cpu = 0;
+    double mb = 0;
+    unsigned int i = 0;
+    pid_t writer = -1;
+    int ret = 0;
+
+    if (!nr || nr > RX_MAX_FDS)
+    {
+        fprintf(stderr, "Error: Invalid argument, pairs=%u!\n", nr);
+        return -1;
+    }
+
+    for (i = 0; i < nr; i++)
+    {
+        if (bench_open_pty(&masters[i], &slaves[i]))
+        {
+            return -1;
+        }
+    }
+
+    writer = fork();
+    if (writer == 0)
+    {
+        bench_writer(masters, nr, chunk);
+        _exit(0);
+    }
+
+    getrusage(RUSAGE_SELF, &ru0);
+    t0 = rx_now();
+
+    if (!strcmp(mode, "epoll"))
+    {
+        ret = bench_epoll(slaves, nr, t0 + duration, &bytes, &syscalls);
+    }
+    else
+    {
+        ret = bench_uring(slaves, nr, flags, t0 + duration, &bytes, &syscalls);
+    }
+
+    t1 = rx_now();
+    getrusage(RUSAGE_SELF, &ru1);
+
+    kill(writer, SIGTERM);
+    waitpid(writer, NULL, 0);
+    for (i = 0; i < nr; i++)
+    {
+        close(masters[i]);
+        close(slaves[i]);
+    }
+
+    cpu = (ru1.ru_utime.tv_sec - ru0.ru_utime.tv_sec) + (ru1.ru_utime.tv_usec - ru0.ru_utime.tv_usec) / 1e6 +
+          (ru1.ru_stime.tv_sec - ru0.ru_stime.tv_sec) + (ru1.ru_stime.tv_usec - ru0.ru_stime.tv_usec) / 1e6;
+    mb = bytes / 1e6;
+
+    printf("mode=%s%s pairs=%u chunk=%zu time=%.3f bytes=%llu MB/s=%.2f syscalls=%lu syscalls/s=%.0f "
+           "syscalls/MB=%.1f cpu=%.3f cpu_s/MB=%.6f\n",
+           mode, (flags & IORING_SETUP_SQPOLL) && strcmp(mode, "epoll") ? "+sqpoll" : "", nr, chunk,
+           t1 - t0, bytes, mb / (t1 - t0), syscalls, syscalls / (t1 - t0), mb > 0 ? syscalls / mb : 0.0,
+           cpu, mb > 0 ? cpu / mb : 0.0);
+
+    return ret;
+}
+
+static void rx_usage(const char *name)
+{
+    printf("Usage:\n"
+           "\t%s [-S] [-q] dev...\n"
+           "\t%s -B [-S] [-n pairs] [-t sec] [-s chunk] epoll|uring\n",
+           name, name);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int flags = 0;
+    unsigned int pairs = 4;
+    double duration = 5;
+    size_t chunk = 256;
+    int bench = 0;
+    int quiet = 0;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "SqBn:t:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'S':
+            flags |= IORING_SETUP_SQPOLL;
+            break;
+        case 'q':
+            quiet = 1;
+            break;
+        case 'B':
+            bench = 1;
+            break;
+        case 'n':
+            pairs = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            duration = strtod(optarg, NULL);
+            break;
+        case 's':
+            chunk = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            rx_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    signal(SIGINT, rx_sig_handler);
+    signal(SIGTERM, rx_sig_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (bench)
+    {
+        if (optind != argc - 1 || (strcmp(argv[optind], "epoll") && strcmp(argv[optind], "uring")) || !chunk)
+        {
+            rx_usage(argv[0]);
+            return -1;
+        }
+
+        return rx_bench(argv[optind], pairs, duration, chunk, flags) ? -1 : 0;
+    }
+
+    if (optind >= argc)
+    {
+        rx_usage(argv[0]);
+        return -1;
+    }
+
+    return rx_run(argc - optind, argv + optind, flags, quiet) ? -1 : 0;
+}
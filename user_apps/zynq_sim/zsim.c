@@ -0,0 +1,1084 @@
+/**
+ * @file zsim.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Zynq GPIO/UART simulator for running the apps on a host.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @copyright Copyright (c) 2026
+ * @details Usage:
+ *              zsim run [-D dir] [-u uarts] [-E] [-G pins] [-p step_ms] [-s script] [-q]
+ *              zsim inject [-D dir] <script|->
+ *              zsim dump [-D dir]
+ *          run creates in dir (default /dev/shm/zynq_sim):
+ *          - regs: GPIO register model (zynq_sim.h), map it instead of /dev/mem or /dev/uioN
+ *          - irq: FIFO, 8 bytes (eventfd format) per GPIO interrupt
+ *          - ttyPS<n>, ttyPS<n>.peer: pty pair per UART, bytes are forwarded between the app
+ *            side and the peer side (-E: echoed back to the app instead) and logged
+ *          - gpio/: sysfs GPIO stand-in (export, unexport, gpio<N>/direction, gpio<N>/value) for
+ *            the pins listed with -G (default 0), watched with inotify
+ *          and logs output pin changes, interrupts and UART traffic with timestamps.
+ *          Script lines (run -s, or inject against a running simulator):
+ *              set <pin> <0|1>             drive an input
+ *              pulse <pin> <ms>            invert an input for ms
+ *              toggle <pin> <n> <us>       n edges, one every us (blocking, for load runs)
+ *              sleep <ms>
+ *              expect <pin> <0|1> <ms>     wait for a pin, fail (exit 1) after ms
+ *              uart <n> <text>             send text to the app on ttyPS<n> (\n, \r, \t, \xHH)
+ *              irq                         raise the GPIO interrupt
+ *              quit                        stop the simulator (run)
+ */
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "zynq_sim.h"
+#include "evloop.h"
+#include "serial.h"
+
+#define ZSIM_DEFAULT_DIR    "/dev/shm/zynq_sim"
+#define ZSIM_MAX_UARTS      8
+#define ZSIM_MAX_SYSFS      16
+#define ZSIM_UART_BUF       4096
+
+struct zsim_uart {
+    unsigned int idx;
+    int app_master;
+    int app_slave;              /* Held open: the app may close and reopen ttyPS<n> */
+    int peer_master;
+    int peer_slave;
+    struct ev_io app_io;
+    struct ev_io peer_io;
+    uint8_t app_buf[ZSIM_UART_BUF];
+    uint8_t peer_buf[ZSIM_UART_BUF];
+    unsigned long tx;           /* Bytes from the app */
+    unsigned long rx;           /* Bytes to the app */
+    unsigned long dropped;
+};
+
+struct zsim_sysfs {
+    unsigned int pin;
+    int wd;
+    char path[PATH_MAX];        /* gpio/gpio<N> */
+};
+
+struct zsim_script {
+    FILE *fp;
+    const char *dir;
+    unsigned int line;
+    int restore_pin;            /* pulse: input to restore, -1: none */
+    int restore_level;
+    uint64_t deadline_ns;       /* expect: 0 when not waiting */
+    int quit;
+};
+
+struct zsim_daemon {
+    struct zsim sim;
+    struct ev_loop loop;
+    struct ev_timer step_timer;
+    struct ev_timer script_timer;
+    struct ev_signal sigint;
+    struct ev_signal sigterm;
+    struct ev_io inotify_io;
+    struct zsim_uart uarts[ZSIM_MAX_UARTS];
+    struct zsim_sysfs sysfs[ZSIM_MAX_SYSFS];
+    struct zsim_script script;
+    uint8_t inotify_buf[4096] __attribute__((aligned(8)));
+    const char *dir;
+    unsigned int nr_uarts;
+    unsigned int nr_sysfs;
+    int inotify_fd;
+    int echo;
+    int quiet;
+    int ret;
+    uint64_t irqs;              /* Last logged interrupt count */
+    uint64_t t0;
+};
+
+/* First pin of each bank. */
+static const unsigned int zsim_bank_base[ZYNQ_GPIO_BANKS] = { 0, 32, 54, 86 };
+
+static uint64_t zsim_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void zsim_pin_name(unsigned int pin, char *name, size_t size)
+{
+    if (pin < 54)
+    {
+        snprintf(name, size, "MIO%u", pin);
+    }
+    else
+    {
+        snprintf(name, size, "EMIO%u", pin - 54);
+    }
+}
+
+static void zsim_log(struct zsim_daemon *d, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void zsim_log(struct zsim_daemon *d, const char *fmt, ...)
+{
+    uint64_t t = zsim_now_ns() - d->t0;
+    va_list ap;
+
+    printf("%4llu.%06llu ", (unsigned long long)(t / 1000000000ULL),
+           (unsigned long long)(t % 1000000000ULL / 1000));
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    fflush(stdout);
+}
+
+/*
+ * Script interpreter, shared by "run -s" (timers) and "inject" (sleeps).
+ */
+
+/* C escapes of @p src into @p dst. */
+static size_t zsim_unescape(const char *src, uint8_t *dst, size_t size)
+{
+    size_t len = 0;
+    unsigned int hex = 0;
+
+    while (*src && len < size)
+    {
+        if (*src != '\\' || !src[1])
+        {
+            dst[len++] = *src++;
+            continue;
+        }
+
+        src++;
+        switch (*src)
+        {
+        case 'n':
+            dst[len++] = '\n';
+            break;
+        case 'r':
+            dst[len++] = '\r';
+            break;
+        case 't':
+            dst[len++] = '\t';
+            break;
+        case 'x':
+            if (sscanf(src + 1, "%2x", &hex) == 1)
+            {
+                dst[len++] = hex;
+                src += (src[2] && src[2] != ' ' && isxdigit((unsigned char)src[2])) ? 2 : 1;
+            }
+            break;
+        default:
+            dst[len++] = *src;
+            break;
+        }
+        src++;
+    }
+
+    return len;
+}
+
+static int zsim_uart_send(const char *dir, unsigned int idx, const char *text)
+{
+    char path[PATH_MAX];
+    uint8_t buf[1024];
+    size_t len = zsim_unescape(text, buf, sizeof(buf));
+    int fd = -1;
+    int ret = 0;
+
+    /* Through the peer side, exactly as a test tool on ttyPS<n>.peer would. */
+    snprintf(path, sizeof(path), "%s/ttyPS%u.peer", dir, idx);
+    fd = open(path, O_WRONLY | O_NOCTTY);
+    if (fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    if (write(fd, buf, len) != (ssize_t)len)
+    {
+        fprintf(stderr, "Error: write() <%s> failed, errno=%d!\n", path, errno);
+        ret = -1;
+    }
+    close(fd);
+
+    return ret;
+}
+
+/**
+ * @brief Run script lines until one has to wait.
+ * @return Milliseconds to wait before the next call, -1 at the end (or quit), -2 on failure.
+ */
+static int zsim_script_next(struct zsim *sim, struct zsim_script *sc)
+{
+    char buf[1100];
+    char cmd[16];
+    char *p = NULL;
+    unsigned int pin = 0;
+    unsigned int n = 0;
+    unsigned int arg = 0;
+    unsigned int i = 0;
+    int level = 0;
+    int ms = 0;
+
+    if (sc->restore_pin >= 0)
+    {
+        zsim_set_input(sim, sc->restore_pin, sc->restore_level);
+        sc->restore_pin = -1;
+    }
+
+    if (sc->deadline_ns)
+    {
+        /* Re-check the pending expect. */
+        if (zsim_get_pin(sim, sc->restore_level >> 1) == (sc->restore_level & 1))
+        {
+            sc->deadline_ns = 0;
+            sc->restore_level = 0;
+        }
+        else if (zsim_now_ns() > sc->deadline_ns)
+        {
+            fprintf(stderr, "Error: script line %u: expect timed out!\n", sc->line);
+            return -2;
+        }
+        else
+        {
+            return 1;
+        }
+    }
+
+    while (fgets(buf, sizeof(buf), sc->fp))
+    {
+        sc->line++;
+        buf[strcspn(buf, "\r\n")] = '\0';
+        p = buf + strspn(buf, " \t");
+        if (!*p || *p == '#')
+        {
+            continue;
+        }
+
+        if (sscanf(p, "%15s", cmd) != 1)
+        {
+            continue;
+        }
+        p += strlen(cmd);
+        p += strspn(p, " \t");
+
+        if (!strcmp(cmd, "set") && sscanf(p, "%u %d", &pin, &level) == 2 && pin < ZYNQ_GPIO_PINS)
+        {
+            zsim_set_input(sim, pin, level);
+        }
+        else if (!strcmp(cmd, "pulse") && sscanf(p, "%u %d", &pin, &ms) == 2 && pin < ZYNQ_GPIO_PINS)
+        {
+            level = !!(sim->ctl->ext[ZYNQ_GPIO_PIN_BANK(pin)] & ZYNQ_GPIO_PIN_MASK(pin));
+            zsim_set_input(sim, pin, !level);
+            sc->restore_pin = pin;
+            sc->restore_level = level;
+            return ms;
+        }
+        else if (!strcmp(cmd, "toggle") && sscanf(p, "%u %u %u", &pin, &n, &arg) == 3 && pin < ZYNQ_GPIO_PINS)
+        {
+            struct timespec ts = { arg / 1000000, (arg % 1000000) * 1000L };
+
+            level = !!(sim->ctl->ext[ZYNQ_GPIO_PIN_BANK(pin)] & ZYNQ_GPIO_PIN_MASK(pin));
+            for (i = 0; i < n; i++)
+            {
+                level = !level;
+                zsim_set_input(sim, pin, level);
+                if (arg)
+                {
+                    nanosleep(&ts, NULL);
+                }
+            }
+        }
+        else if (!strcmp(cmd, "sleep") && sscanf(p, "%d", &ms) == 1)
+        {
+            return ms;
+        }
+        else if (!strcmp(cmd, "expect") && sscanf(p, "%u %d %d", &pin, &level, &ms) == 3 && pin < ZYNQ_GPIO_PINS)
+        {
+            /* restore_level carries pin and level while waiting. */
+            sc->restore_level = (pin << 1) | !!level;
+            sc->deadline_ns = zsim_now_ns() + (uint64_t)ms * 1000000ULL;
+            return 0;
+        }
+        else if (!strcmp(cmd, "uart") && sscanf(p, "%u", &n) == 1)
+        {
+            p += strspn(p, "0123456789");
+            p += strspn(p, " \t");
+            if (zsim_uart_send(sc->dir, n, p))
+            {
+                return -2;
+            }
+        }
+        else if (!strcmp(cmd, "irq"))
+        {
+            zsim_raise_irq(sim);
+        }
+        else if (!strcmp(cmd, "quit"))
+        {
+            sc->quit = 1;
+            return -1;
+        }
+        else
+        {
+            fprintf(stderr, "Error: script line %u: bad command <%s>!\n", sc->line, buf);
+            return -2;
+        }
+    }
+
+    return -1;
+}
+
+static int zsim_script_open(struct zsim_script *sc, const char *path, const char *dir)
+{
+    memset(sc, 0, sizeof(*sc));
+    sc->dir = dir;
+    sc->restore_pin = -1;
+
+    sc->fp = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!sc->fp)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void zsim_script_close(struct zsim_script *sc)
+{
+    if (sc->fp && sc->fp != stdin)
+    {
+        fclose(sc->fp);
+    }
+    sc->fp = NULL;
+}
+
+/*
+ * run: GPIO model step, sysfs stand-in, UART bridges.
+ */
+
+static void zsim_sysfs_write(const char *path, const char *text)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+    if (fd == -1)
+    {
+        return;
+    }
+    if (write(fd, text, strlen(text)) < 0)
+    {
+        ;
+    }
+    close(fd);
+}
+
+/* Pin level into gpio<N>/value of an input. */
+static void zsim_sysfs_update(struct zsim_daemon *d)
+{
+    struct zsim_sysfs *s = NULL;
+    char path[PATH_MAX + 8];
+    char text[4];
+    char old[4];
+    unsigned int i = 0;
+    int fd = -1;
+    ssize_t n = 0;
+
+    for (i = 0; i < d->nr_sysfs; i++)
+    {
+        s = &d->sysfs[i];
+        if (zsim_reg_read(&d->sim, ZYNQ_GPIO_DIRM(ZYNQ_GPIO_PIN_BANK(s->pin))) & ZYNQ_GPIO_PIN_MASK(s->pin))
+        {
+            continue;
+        }
+
+        snprintf(text, sizeof(text), "%d\n", zsim_get_pin(&d->sim, s->pin));
+        snprintf(path, sizeof(path), "%s/value", s->path);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        n = fd == -1 ? 0 : read(fd, old, sizeof(old));
+        if (fd != -1)
+        {
+            close(fd);
+        }
+        if (n != 2 || memcmp(old, text, 2))
+        {
+            zsim_sysfs_write(path, text);
+        }
+    }
+}
+
+static void zsim_sysfs_changed(struct zsim_daemon *d, struct zsim_sysfs *s, const char *name)
+{
+    unsigned int bank = ZYNQ_GPIO_PIN_BANK(s->pin);
+    uint32_t mask = ZYNQ_GPIO_PIN_MASK(s->pin);
+    char path[PATH_MAX + 16];
+    char buf[256];
+    ssize_t n = 0;
+    int fd = -1;
+    int i = 0;
+
+    snprintf(path, sizeof(path), "%s/%s", s->path, name);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return;
+    }
+
+    /* The app writes without lseek(): the file grows, the last value counts. */
+    n = lseek(fd, 0, SEEK_END);
+    n = pread(fd, buf, sizeof(buf) - 1, n > (ssize_t)sizeof(buf) - 1 ? n - (sizeof(buf) - 1) : 0);
+    close(fd);
+    if (n <= 0)
+    {
+        return;
+    }
+    buf[n] = '\0';
+
+    if (!strcmp(name, "direction"))
+    {
+        if (!strncmp(buf, "out", 3) || !strncmp(buf, "high", 4) || !strncmp(buf, "low", 3))
+        {
+            if (buf[0] != 'o')
+            {
+                if (buf[0] == 'h')
+                {
+                    __atomic_fetch_or(&d->sim.regs[ZYNQ_GPIO_DATA(bank) / 4], mask, __ATOMIC_SEQ_CST);
+                }
+                else
+                {
+                    __atomic_fetch_and(&d->sim.regs[ZYNQ_GPIO_DATA(bank) / 4], ~mask, __ATOMIC_SEQ_CST);
+                }
+            }
+            __atomic_fetch_or(&d->sim.regs[ZYNQ_GPIO_DIRM(bank) / 4], mask, __ATOMIC_SEQ_CST);
+            __atomic_fetch_or(&d->sim.regs[ZYNQ_GPIO_OEN(bank) / 4], mask, __ATOMIC_SEQ_CST);
+        }
+        else if (!strncmp(buf, "in", 2))
+        {
+            __atomic_fetch_and(&d->sim.regs[ZYNQ_GPIO_DIRM(bank) / 4], ~mask, __ATOMIC_SEQ_CST);
+            __atomic_fetch_and(&d->sim.regs[ZYNQ_GPIO_OEN(bank) / 4], ~mask, __ATOMIC_SEQ_CST);
+        }
+        return;
+    }
+
+    if (strcmp(name, "value") || !(zsim_reg_read(&d->sim, ZYNQ_GPIO_DIRM(bank)) & mask))
+    {
+        return;
+    }
+
+    for (i = n - 1; i >= 0; i--)
+    {
+        if (buf[i] == '0' || buf[i] == '1')
+        {
+            if (buf[i] == '1')
+            {
+                __atomic_fetch_or(&d->sim.regs[ZYNQ_GPIO_DATA(bank) / 4], mask, __ATOMIC_SEQ_CST);
+            }
+            else
+            {
+                __atomic_fetch_and(&d->sim.regs[ZYNQ_GPIO_DATA(bank) / 4], ~mask, __ATOMIC_SEQ_CST);
+            }
+            break;
+        }
+    }
+}
+
+static void zsim_inotify(struct ev_loop *loop, struct ev_io *io, uint32_t revents)
+{
+    struct zsim_daemon *d = io->data;
+    const struct inotify_event *ev = NULL;
+    size_t off = 0;
+    unsigned int i = 0;
+
+    if (revents != EPOLLIN)
+    {
+        return;
+    }
+
+    while (off + sizeof(*ev) <= io->len)
+    {
+        ev = (const struct inotify_event *)(d->inotify_buf + off);
+        for (i = 0; i < d->nr_sysfs; i++)
+        {
+            if (d->sysfs[i].wd == ev->wd && ev->len)
+            {
+                zsim_sysfs_changed(d, &d->sysfs[i], ev->name);
+            }
+        }
+        off += sizeof(*ev) + ev->len;
+    }
+}
+
+static int zsim_sysfs_init(struct zsim_daemon *d, const char *pins)
+{
+    struct zsim_sysfs *s = NULL;
+    char path[PATH_MAX];
+    const char *p = pins;
+    char *end = NULL;
+    unsigned long pin = 0;
+
+    snprintf(path, sizeof(path), "%s/gpio", d->dir);
+    mkdir(path, 0777);
+    snprintf(path, sizeof(path), "%s/gpio/export", d->dir);
+    zsim_sysfs_write(path, "");
+    snprintf(path, sizeof(path), "%s/gpio/unexport", d->dir);
+    zsim_sysfs_write(path, "");
+
+    d->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (d->inotify_fd == -1)
+    {
+        fprintf(stderr, "Error: inotify_init1() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    /* Every listed pin is exported from the start, export/unexport are accepted and ignored. */
+    while (*p && d->nr_sysfs < ZSIM_MAX_SYSFS)
+    {
+        pin = strtoul(p, &end, 0);
+        if (end == p || pin >= ZYNQ_GPIO_PINS)
+        {
+            fprintf(stderr, "Error: Invalid argument, pins <%s>!\n", pins);
+            return -1;
+        }
+        p = *end ? end + 1 : end;
+
+        s = &d->sysfs[d->nr_sysfs++];
+        s->pin = pin;
+        snprintf(s->path, sizeof(s->path), "%s/gpio/gpio%lu", d->dir, pin);
+        mkdir(s->path, 0777);
+        snprintf(path, sizeof(path), "%s/direction", s->path);
+        zsim_sysfs_write(path, "in\n");
+        snprintf(path, sizeof(path), "%s/value", s->path);
+        zsim_sysfs_write(path, "0\n");
+
+        s->wd = inotify_add_watch(d->inotify_fd, s->path, IN_MODIFY | IN_CLOSE_WRITE);
+        if (s->wd == -1)
+        {
+            fprintf(stderr, "Error: inotify_add_watch() <%s> failed, errno=%d!\n", s->path, errno);
+            return -1;
+        }
+    }
+
+    ev_io_init(&d->inotify_io, d->inotify_fd, EPOLLIN, zsim_inotify, d->inotify_buf, sizeof(d->inotify_buf));
+    d->inotify_io.data = d;
+
+    return ev_io_start(&d->loop, &d->inotify_io);
+}
+
+static void zsim_log_data(struct zsim_daemon *d, unsigned int idx, const char *dir, const uint8_t *buf, size_t len)
+{
+    char text[ZSIM_UART_BUF * 4 + 1];
+    size_t n = 0;
+    size_t i = 0;
+
+    for (i = 0; i < len; i++)
+    {
+        if (buf[i] >= 0x20 && buf[i] < 0x7f && buf[i] != '\\')
+        {
+            text[n++] = buf[i];
+        }
+        else
+        {
+            n += sprintf(text + n, "\\x%02x", buf[i]);
+        }
+    }
+    text[n] = '\0';
+
+    zsim_log(d, "uart%u %s %zu: %s", idx, dir, len, text);
+}
+
+static void zsim_uart_forward(struct zsim_daemon *d, struct zsim_uart *u, int to, const uint8_t *buf, size_t len)
+{
+    ssize_t ret = write(to, buf, len);
+
+    /* Like a UART FIFO overrun: what the other side does not take is lost. */
+    if (ret < (ssize_t)len)
+    {
+        u->dropped += len - (ret > 0 ? ret : 0);
+    }
+}
+
+static void zsim_uart_app(struct ev_loop *loop, struct ev_io *io, uint32_t revents)
+{
+    struct zsim_uart *u = io->data;
+    struct zsim_daemon *d = (struct zsim_daemon *)((char *)loop - offsetof(struct zsim_daemon, loop));
+
+    if (revents != EPOLLIN)
+    {
+        return;
+    }
+
+    u->tx += io->len;
+    if (!d->quiet)
+    {
+        zsim_log_data(d, u->idx, "app->", u->app_buf, io->len);
+    }
+    zsim_uart_forward(d, u, d->echo ? u->app_master : u->peer_master, u->app_buf, io->len);
+}
+
+static void zsim_uart_peer(struct ev_loop *loop, struct ev_io *io, uint32_t revents)
+{
+    struct zsim_uart *u = io->data;
+    struct zsim_daemon *d = (struct zsim_daemon *)((char *)loop - offsetof(struct zsim_daemon, loop));
+
+    if (revents != EPOLLIN)
+    {
+        return;
+    }
+
+    u->rx += io->len;
+    if (!d->quiet)
+    {
+        zsim_log_data(d, u->idx, "->app", u->peer_buf, io->len);
+    }
+    zsim_uart_forward(d, u, u->app_master, u->peer_buf, io->len);
+}
+
+/*
+ * One pty, slave held open in raw mode and linked as @p link.
+ */
+static int zsim_pty(const char *link, int *pmaster, int *pslave)
+{
+    char name[64];
+    int flags = 0;
+
+    *pmaster = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (*pmaster == -1 || grantpt(*pmaster) || unlockpt(*pmaster) || ptsname_r(*pmaster, name, sizeof(name)))
+    {
+        fprintf(stderr, "Error: posix_openpt() failed, errno=%d!\n", errno);
+        return -1;
+    }
+
+    flags = fcntl(*pmaster, F_GETFL);
+    fcntl(*pmaster, F_SETFL, flags | O_NONBLOCK);
+
+    *pslave = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (*pslave == -1 || serial_set_raw(*pslave))
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", name, errno);
+        return -1;
+    }
+
+    unlink(link);
+    if (symlink(name, link))
+    {
+        fprintf(stderr, "Error: symlink() <%s> failed, errno=%d!\n", link, errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int zsim_uart_init(struct zsim_daemon *d, struct zsim_uart *u, unsigned int idx)
+{
+    char path[PATH_MAX];
+
+    u->idx = idx;
+    u->app_master = u->app_slave = u->peer_master = u->peer_slave = -1;
+
+    snprintf(path, sizeof(path), "%s/ttyPS%u", d->dir, idx);
+    if (zsim_pty(path, &u->app_master, &u->app_slave))
+    {
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/ttyPS%u.peer", d->dir, idx);
+    if (zsim_pty(path, &u->peer_master, &u->peer_slave))
+    {
+        return -1;
+    }
+
+    ev_io_init(&u->app_io, u->app_master, EPOLLIN, zsim_uart_app, u->app_buf, sizeof(u->app_buf));
+    u->app_io.data = u;
+    ev_io_init(&u->peer_io, u->peer_master, EPOLLIN, zsim_uart_peer, u->peer_buf, sizeof(u->peer_buf));
+    u->peer_io.data = u;
+
+    if (ev_io_start(&d->loop, &u->app_io) || ev_io_start(&d->loop, &u->peer_io))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void zsim_uart_exit(struct zsim_daemon *d, struct zsim_uart *u)
+{
+    char path[PATH_MAX];
+
+    snprintf(path, sizeof(path), "%s/ttyPS%u", d->dir, u->idx);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/ttyPS%u.peer", d->dir, u->idx);
+    unlink(path);
+
+    if (u->app_master != -1)
+    {
+        close(u->app_master);
+    }
+    if (u->app_slave != -1)
+    {
+        close(u->app_slave);
+    }
+    if (u->peer_master != -1)
+    {
+        close(u->peer_master);
+    }
+    if (u->peer_slave != -1)
+    {
+        close(u->peer_slave);
+    }
+}
+
+static void zsim_step_timer(struct ev_loop *loop, struct ev_timer *timer)
+{
+    struct zsim_daemon *d = timer->data;
+    uint32_t changed[ZYNQ_GPIO_BANKS];
+    unsigned int bank = 0;
+    unsigned int bit = 0;
+    uint64_t irqs = 0;
+    char name[16];
+
+    if (zsim_step(&d->sim, changed))
+    {
+        for (bank = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+        {
+            for (bit = 0; bit < 32; bit++)
+            {
+                if (changed[bank] & (1U << bit))
+                {
+                    zsim_pin_name(zsim_bank_base[bank] + bit, name, sizeof(name));
+                    zsim_log(d, "gpio %s -> %d", name, !!(d->sim.ro[bank] & (1U << bit)));
+                }
+            }
+        }
+    }
+
+    irqs = __atomic_load_n(&d->sim.ctl->irqs, __ATOMIC_RELAXED);
+    if (irqs != d->irqs)
+    {
+        zsim_log(d, "irq x%llu (total %llu)", (unsigned long long)(irqs - d->irqs), (unsigned long long)irqs);
+        d->irqs = irqs;
+    }
+
+    if (d->nr_sysfs)
+    {
+        zsim_sysfs_update(d);
+    }
+}
+
+static void zsim_script_timer(struct ev_loop *loop, struct ev_timer *timer)
+{
+    struct zsim_daemon *d = timer->data;
+    int ms = zsim_script_next(&d->sim, &d->script);
+
+    if (ms >= 0)
+    {
+        ev_timer_start(loop, timer, ms, 0);
+        return;
+    }
+
+    if (ms == -2)
+    {
+        d->ret = 1;
+    }
+    zsim_script_close(&d->script);
+
+    if (ms == -2 || d->script.quit)
+    {
+        ev_loop_break(loop);
+    }
+}
+
+static void zsim_quit(struct ev_loop *loop, struct ev_signal *sig)
+{
+    ev_loop_break(loop);
+}
+
+static int zsim_run(int argc, char *argv[])
+{
+    static struct zsim_daemon d;
+    char path[PATH_MAX];
+    const char *script = NULL;
+    const char *pins = "0";
+    unsigned int step_ms = 1;
+    unsigned int i = 0;
+    int opt = 0;
+
+    memset(&d, 0, sizeof(d));
+    d.dir = ZSIM_DEFAULT_DIR;
+    d.nr_uarts = 2;
+    d.inotify_fd = -1;
+
+    while ((opt = getopt(argc, argv, "D:u:EG:p:s:q")) != -1)
+    {
+        switch (opt)
+        {
+        case 'D':
+            d.dir = optarg;
+            break;
+        case 'u':
+            d.nr_uarts = strtoul(optarg, NULL, 0);
+            break;
+        case 'E':
+            d.echo = 1;
+            break;
+        case 'G':
+            pins = optarg;
+            break;
+        case 'p':
+            step_ms = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            script = optarg;
+            break;
+        case 'q':
+            d.quiet = 1;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    if (d.nr_uarts > ZSIM_MAX_UARTS || !step_ms)
+    {
+        fprintf(stderr, "Error: Invalid argument!\n");
+        return -1;
+    }
+
+    if (mkdir(d.dir, 0777) && errno != EEXIST)
+    {
+        fprintf(stderr, "Error: mkdir() <%s> failed, errno=%d!\n", d.dir, errno);
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/regs", d.dir);
+    if (zsim_open(&d.sim, path, 1))
+    {
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/irq", d.dir);
+    if (zsim_irq_create(&d.sim, path) || ev_loop_init(&d.loop))
+    {
+        zsim_close(&d.sim);
+        return -1;
+    }
+
+    d.ret = -1;
+    if (ev_signal_start(&d.loop, &d.sigint, SIGINT, zsim_quit) ||
+        ev_signal_start(&d.loop, &d.sigterm, SIGTERM, zsim_quit))
+    {
+        goto out;
+    }
+
+    for (i = 0; i < d.nr_uarts; i++)
+    {
+        if (zsim_uart_init(&d, &d.uarts[i], i))
+        {
+            goto out;
+        }
+    }
+
+    if (*pins && zsim_sysfs_init(&d, pins))
+    {
+        goto out;
+    }
+
+    ev_timer_init(&d.step_timer, zsim_step_timer);
+    d.step_timer.data = &d;
+    ev_timer_start(&d.loop, &d.step_timer, step_ms, step_ms);
+
+    if (script)
+    {
+        if (zsim_script_open(&d.script, script, d.dir))
+        {
+            goto out;
+        }
+        ev_timer_init(&d.script_timer, zsim_script_timer);
+        d.script_timer.data = &d;
+        ev_timer_start(&d.loop, &d.script_timer, 0, 0);
+    }
+
+    printf("zynq_sim: regs %s/regs, irq %s/irq, %u uart(s) %s/ttyPS<n>[.peer], %u sysfs pin(s) %s/gpio\n",
+           d.dir, d.dir, d.nr_uarts, d.dir, d.nr_sysfs, d.dir);
+    fflush(stdout);
+
+    d.t0 = zsim_now_ns();
+    d.ret = 0;
+    if (ev_loop_run(&d.loop))
+    {
+        d.ret = -1;
+    }
+
+    zsim_log(&d, "steps %llu, irqs %llu, edges %llu",
+             (unsigned long long)d.sim.ctl->steps, (unsigned long long)d.sim.ctl->irqs,
+             (unsigned long long)d.sim.ctl->edges);
+    for (i = 0; i < d.nr_uarts; i++)
+    {
+        zsim_log(&d, "uart%u: from app %lu, to app %lu, dropped %lu",
+                 i, d.uarts[i].tx, d.uarts[i].rx, d.uarts[i].dropped);
+    }
+
+out:
+    zsim_script_close(&d.script);
+    for (i = 0; i < d.nr_uarts; i++)
+    {
+        if (d.uarts[i].app_master || d.uarts[i].peer_master)
+        {
+            zsim_uart_exit(&d, &d.uarts[i]);
+        }
+    }
+    if (d.inotify_fd != -1)
+    {
+        close(d.inotify_fd);
+    }
+    ev_loop_exit(&d.loop);
+
+    /* Stale model: inject/apps fail instead of talking to nobody. */
+    d.sim.ctl->magic = 0;
+    snprintf(path, sizeof(path), "%s/irq", d.dir);
+    unlink(path);
+    zsim_close(&d.sim);
+
+    return d.ret;
+}
+
+static int zsim_open_dir(struct zsim *sim, const char *dir)
+{
+    char path[PATH_MAX];
+
+    snprintf(path, sizeof(path), "%s/regs", dir);
+
+    return zsim_open(sim, path, 0);
+}
+
+static int zsim_inject(int argc, char *argv[])
+{
+    struct zsim_script sc;
+    struct zsim sim;
+    struct timespec ts;
+    const char *dir = ZSIM_DEFAULT_DIR;
+    int ms = 0;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "D:")) != -1)
+    {
+        if (opt != 'D')
+        {
+            return -1;
+        }
+        dir = optarg;
+    }
+
+    if (optind >= argc)
+    {
+        fprintf(stderr, "Usage: zsim inject [-D dir] <script|->\n");
+        return -1;
+    }
+
+    if (zsim_open_dir(&sim, dir))
+    {
+        return -1;
+    }
+
+    if (zsim_script_open(&sc, argv[optind], dir))
+    {
+        zsim_close(&sim);
+        return -1;
+    }
+
+    while ((ms = zsim_script_next(&sim, &sc)) >= 0)
+    {
+        ts.tv_sec = ms / 1000;
+        ts.tv_nsec = (ms % 1000) * 1000000L;
+        nanosleep(&ts, NULL);
+    }
+
+    if (sc.quit && sim.ctl->daemon_pid)
+    {
+        kill(sim.ctl->daemon_pid, SIGTERM);
+    }
+
+    zsim_script_close(&sc);
+    zsim_close(&sim);
+
+    return ms == -2 ? 1 : 0;
+}
+
+static int zsim_dump(int argc, char *argv[])
+{
+    struct zsim sim;
+    const char *dir = ZSIM_DEFAULT_DIR;
+    unsigned int bank = 0;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "D:")) != -1)
+    {
+        if (opt != 'D')
+        {
+            return -1;
+        }
+        dir = optarg;
+    }
+
+    if (zsim_open_dir(&sim, dir))
+    {
+        return -1;
+    }
+
+    printf("pid %u, steps %llu, irqs %llu, edges %llu, irq fifo %s\n", sim.ctl->daemon_pid,
+           (unsigned long long)sim.ctl->steps, (unsigned long long)sim.ctl->irqs,
+           (unsigned long long)sim.ctl->edges, sim.ctl->irq_path);
+    printf("bank  DIRM      OEN       DATA      DATA_RO   ext       INT_MASK  INT_STAT  TYPE      POLARITY  ANY\n");
+    for (bank = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+    {
+        printf("%-4u  %08x  %08x  %08x  %08x  %08x  %08x  %08x  %08x  %08x  %08x\n", bank,
+               zsim_reg_read(&sim, ZYNQ_GPIO_DIRM(bank)), zsim_reg_read(&sim, ZYNQ_GPIO_OEN(bank)),
+               zsim_reg_read(&sim, ZYNQ_GPIO_DATA(bank)), zsim_reg_read(&sim, ZYNQ_GPIO_DATA_RO(bank)),
+               sim.ctl->ext[bank], zsim_reg_read(&sim, ZYNQ_GPIO_INT_MASK(bank)),
+               zsim_reg_read(&sim, ZYNQ_GPIO_INT_STAT(bank)), zsim_reg_read(&sim, ZYNQ_GPIO_INT_TYPE(bank)),
+               zsim_reg_read(&sim, ZYNQ_GPIO_INT_POLARITY(bank)), zsim_reg_read(&sim, ZYNQ_GPIO_INT_ANY(bank)));
+    }
+
+    zsim_close(&sim);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 2 && !strcmp(argv[1], "run"))
+    {
+        return zsim_run(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && !strcmp(argv[1], "inject"))
+    {
+        return zsim_inject(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && !strcmp(argv[1], "dump"))
+    {
+        return zsim_dump(argc - 1, argv + 1);
+    }
+
+    printf("Usage:\n"
+           "\t%s run [-D dir] [-u uarts] [-E] [-G pins] [-p step_ms] [-s script] [-q]\n"
+           "\t%s inject [-D dir] <script|->\n"
+           "\t%s dump [-D dir]\n", argv[0], argv[0], argv[0]);
+
+    return -1;
+}
@@ -0,0 +1,400 @@
+/**
+ * @file zynq_sim.c
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Host model of the Zynq-7000 GPIO block on a shared-memory file.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       INT_STAT write-1-to-clear: app stores applied by zsim_step().
+ * @copyright Copyright (c) 2026
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "zynq_sim.h"
+
+/* Pins per bank: MIO 32 + 22, EMIO 32 + 32. */
+static const uint32_t zsim_bank_mask[ZYNQ_GPIO_BANKS] = {
+    0xFFFFFFFF, 0x003FFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+};
+
+static inline uint32_t zsim_reg_or(struct zsim *sim, unsigned int offset, uint32_t bits)
+{
+    return __atomic_fetch_or(&sim->regs[offset / 4], bits, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t zsim_reg_xchg(struct zsim *sim, unsigned int offset, uint32_t value)
+{
+    return __atomic_exchange_n(&sim->regs[offset / 4], value, __ATOMIC_SEQ_CST);
+}
+
+int zsim_open(struct zsim *sim, const char *path, int create)
+{
+    unsigned int bank = 0;
+    void *addr = NULL;
+
+    memset(sim, 0, sizeof(*sim));
+    sim->irq_fd = -1;
+
+    sim->fd = open(path, O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0666);
+    if (sim->fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    if (create && ftruncate(sim->fd, ZSIM_FILE_SIZE))
+    {
+        fprintf(stderr, "Error: ftruncate() failed, errno=%d!\n", errno);
+        goto err;
+    }
+
+    addr = mmap(NULL, ZSIM_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, sim->fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: mmap() failed, errno=%d!\n", errno);
+        goto err;
+    }
+
+    sim->regs = (volatile uint32_t *)addr;
+    sim->ctl = (struct zsim_ctl *)((char *)addr + ZSIM_CTL_OFFSET);
+
+    if (create)
+    {
+        zsim_reset(sim);
+    }
+    else if (sim->ctl->magic != ZSIM_MAGIC || sim->ctl->version != ZSIM_VERSION)
+    {
+        fprintf(stderr, "Error: <%s> is not a zynq_sim model, is zsim running?\n", path);
+        goto err;
+    }
+
+    if (!create && sim->ctl->irq_path[0])
+    {
+        /* O_RDWR: opening never blocks and a write never fails for lack of a reader. */
+        sim->irq_fd = open(sim->ctl->irq_path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    }
+
+    memcpy(sim->ro, (const void *)&sim->regs[ZYNQ_GPIO_DATA_RO(0) / 4], sizeof(sim->ro));
+    for (bank = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+    {
+        sim->stat[bank] = zsim_reg_read(sim, ZYNQ_GPIO_INT_STAT(bank));
+    }
+
+    return 0;
+
+err:
+    zsim_close(sim);
+    return -1;
+}
+
+void zsim_close(struct zsim *sim)
+{
+    if (sim->regs)
+    {
+        munmap((void *)sim->regs, ZSIM_FILE_SIZE);
+        sim->regs = NULL;
+        sim->ctl = NULL;
+    }
+
+    if (sim->irq_fd != -1)
+    {
+        close(sim->irq_fd);
+        sim->irq_fd = -1;
+    }
+
+    if (sim->fd != -1)
+    {
+        close(sim->fd);
+        sim->fd = -1;
+    }
+}
+
+void zsim_reset(struct zsim *sim)
+{
+    unsigned int bank = 0;
+
+    memset((void *)sim->regs, 0, ZSIM_FILE_SIZE);
+
+    for (bank = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+    {
+        zsim_reg_write(sim, ZYNQ_GPIO_MASK_DATA_LSW(bank), ZSIM_MASK_DATA_IDLE);
+        zsim_reg_write(sim, ZYNQ_GPIO_MASK_DATA_MSW(bank), ZSIM_MASK_DATA_IDLE);
+        zsim_reg_write(sim, ZYNQ_GPIO_INT_TYPE(bank), zsim_bank_mask[bank]);
+        /* Masked, as the Linux driver leaves them after probe. */
+        zsim_reg_write(sim, ZYNQ_GPIO_INT_MASK(bank), zsim_bank_mask[bank]);
+    }
+
+    sim->ctl->magic = ZSIM_MAGIC;
+    sim->ctl->version = ZSIM_VERSION;
+    sim->ctl->daemon_pid = getpid();
+    memset(sim->ro, 0, sizeof(sim->ro));
+    memset(sim->stat, 0, sizeof(sim->stat));
+    sim->irqs = 0;
+    sim->irq_empty = 0;
+}
+
+int zsim_irq_create(struct zsim *sim, const char *path)
+{
+    unlink(path);
+    if (mkfifo(path, 0666))
+    {
+        fprintf(stderr, "Error: mkfifo() <%s> failed, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    sim->irq_fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (sim->irq_fd == -1)
+    {
+        fprintf(stderr, "Error: failed to open file <%s>, errno=%d!\n", path, errno);
+        return -1;
+    }
+
+    snprintf(sim->ctl->irq_path, sizeof(sim->ctl->irq_path), "%s", path);
+
+    return 0;
+}
+
+void zsim_raise_irq(struct zsim *sim)
+{
+    uint64_t one = 1;
+
+    __atomic_add_fetch(&sim->ctl->irqs, 1, __ATOMIC_RELAXED);
+
+    /* A full FIFO (nobody reading) drops the notification, the count is kept. */
+    if (sim->irq_fd != -1 && write(sim->irq_fd, &one, sizeof(one)) != sizeof(one))
+    {
+        ;
+    }
+}
+
+/*
+ * DATA_RO of @p bank from the outputs and the external levels.
+ */
+static uint32_t zsim_data_ro(struct zsim *sim, unsigned int bank)
+{
+    uint32_t out = zsim_reg_read(sim, ZYNQ_GPIO_DIRM(bank)) & zsim_reg_read(sim, ZYNQ_GPIO_OEN(bank));
+    uint32_t ext = __atomic_load_n(&sim->ctl->ext[bank], __ATOMIC_ACQUIRE);
+
+    return ((zsim_reg_read(sim, ZYNQ_GPIO_DATA(bank)) & out) | (ext & ~out)) & zsim_bank_mask[bank];
+}
+
+void zsim_set_input(struct zsim *sim, unsigned int pin, int level)
+{
+    unsigned int bank = ZYNQ_GPIO_PIN_BANK(pin);
+    uint32_t mask = ZYNQ_GPIO_PIN_MASK(pin);
+    uint32_t old = 0;
+    uint32_t out = 0;
+    uint32_t hit = 0;
+
+    if (pin >= ZYNQ_GPIO_PINS)
+    {
+        return;
+    }
+
+    if (level)
+    {
+        old = __atomic_fetch_or(&sim->ctl->ext[bank], mask, __ATOMIC_ACQ_REL);
+    }
+    else
+    {
+        old = __atomic_fetch_and(&sim->ctl->ext[bank], ~mask, __ATOMIC_ACQ_REL);
+    }
+
+    if (!!(old & mask) == !!level)
+    {
+        return;
+    }
+
+    __atomic_add_fetch(&sim->ctl->edges, 1, __ATOMIC_RELAXED);
+    zsim_reg_write(sim, ZYNQ_GPIO_DATA_RO(bank), zsim_data_ro(sim, bank));
+
+    /* A driven output ignores the external level. */
+    out = zsim_reg_read(sim, ZYNQ_GPIO_DIRM(bank)) & zsim_reg_read(sim, ZYNQ_GPIO_OEN(bank));
+    if (out & mask)
+    {
+        return;
+    }
+
+    if (zsim_reg_read(sim, ZYNQ_GPIO_INT_TYPE(bank)) & mask)
+    {
+        /* Edge: both, or rising/falling as selected by INT_POLARITY. */
+        hit = (zsim_reg_read(sim, ZYNQ_GPIO_INT_ANY(bank)) & mask) ||
+              (!!(zsim_reg_read(sim, ZYNQ_GPIO_INT_POLARITY(bank)) & mask) == !!level);
+    }
+    else
+    {
+        /* Level: latched while active, zsim_step() re-latches after a clear. */
+        hit = !!(zsim_reg_read(sim, ZYNQ_GPIO_INT_POLARITY(bank)) & mask) == !!level;
+    }
+
+    if (!hit)
+    {
+        return;
+    }
+
+    /* Latch word first: a bit in INT_STAT but not in it would look like an app store. */
+    __atomic_fetch_or(&sim->ctl->latch[bank], mask, __ATOMIC_SEQ_CST);
+    zsim_reg_or(sim, ZYNQ_GPIO_INT_STAT(bank), mask);
+    if (!(zsim_reg_read(sim, ZYNQ_GPIO_INT_MASK(bank)) & mask))
+    {
+        zsim_raise_irq(sim);
+    }
+}
+
+int zsim_get_pin(struct zsim *sim, unsigned int pin)
+{
+    unsigned int bank = ZYNQ_GPIO_PIN_BANK(pin);
+
+    return (zsim_reg_read(sim, ZYNQ_GPIO_DATA_RO(bank)) & ZYNQ_GPIO_PIN_MASK(pin)) ? 1 : 0;
+}
+
+/*
+ * The app took every notification at least one step ago: the irq FIFO is empty now, was
+ * empty at the previous step and nothing was raised since.
+ */
+static int zsim_irq_idle(struct zsim *sim)
+{
+    uint64_t irqs = __atomic_load_n(&sim->ctl->irqs, __ATOMIC_SEQ_CST);
+    int empty = 0;
+    int queued = 0;
+    int idle = 0;
+
+    empty = sim->irq_fd != -1 && !ioctl(sim->irq_fd, FIONREAD, &queued) && !queued;
+    idle = empty && sim->irq_empty && irqs == sim->irqs;
+    sim->irq_empty = empty;
+    sim->irqs = irqs;
+
+    return idle;
+}
+
+/*
+ * INT_STAT of @p bank after the latches and app stores since the previous step, with level
+ * inputs @p active latched again. Returns the newly latched level bits.
+ */
+static uint32_t zsim_int_stat(struct zsim *sim, unsigned int bank, uint32_t active, int idle)
+{
+    volatile uint32_t *reg = &sim->regs[ZYNQ_GPIO_INT_STAT(bank) / 4];
+    uint32_t latch = __atomic_exchange_n(&sim->ctl->latch[bank], 0, __ATOMIC_SEQ_CST);
+    uint32_t prev = sim->stat[bank];
+    uint32_t value = 0;
+    uint32_t late = 0;
+    uint32_t keep = 0;
+    uint32_t clear = 0;
+    uint32_t stat = 0;
+    uint32_t relatch = 0;
+
+    do
+    {
+        value = __atomic_load_n(reg, __ATOMIC_SEQ_CST);
+        /* Latched after the exchange above: already in INT_STAT, folded at the next step. */
+        late = __atomic_load_n(&sim->ctl->latch[bank], __ATOMIC_SEQ_CST);
+        keep = ~(latch | late);
+
+        if ((value & keep) != (prev & keep))
+        {
+            /* The app stored value: write-1-to-clear. */
+            clear = value & prev;
+        }
+        else if (idle)
+        {
+            /* Nothing seen: no store, or the value read stored back after the irq. */
+            clear = prev & ~zsim_reg_read(sim, ZYNQ_GPIO_INT_MASK(bank));
+        }
+        else
+        {
+            clear = 0;
+        }
+
+        stat = (prev & ~clear) | latch | late;
+        relatch = active & ~stat;
+        stat |= relatch;
+    } while (!__atomic_compare_exchange_n(reg, &value, stat, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+    sim->stat[bank] = stat;
+
+    return relatch;
+}
+
+int zsim_step(struct zsim *sim, uint32_t changed[ZYNQ_GPIO_BANKS])
+{
+    unsigned int bank = 0;
+    uint32_t data = 0;
+    uint32_t mask = 0;
+    uint32_t value = 0;
+    uint32_t out = 0;
+    uint32_t ro = 0;
+    uint32_t active = 0;
+    uint32_t enabled = 0;
+    uint32_t relatch = 0;
+    int idle = zsim_irq_idle(sim);
+    int irq = 0;
+    int any = 0;
+
+    for (bank = 0; bank < ZYNQ_GPIO_BANKS; bank++)
+    {
+        /* INT_EN/INT_DIS: 1 unmasks/masks, a pending unmasked bit interrupts below. */
+        value = zsim_reg_xchg(sim, ZYNQ_GPIO_INT_DIS(bank), 0);
+        if (value)
+        {
+            zsim_reg_write(sim, ZYNQ_GPIO_INT_MASK(bank), zsim_reg_read(sim, ZYNQ_GPIO_INT_MASK(bank)) | value);
+        }
+        enabled = zsim_reg_xchg(sim, ZYNQ_GPIO_INT_EN(bank), 0);
+        if (enabled)
+        {
+            zsim_reg_write(sim, ZYNQ_GPIO_INT_MASK(bank), zsim_reg_read(sim, ZYNQ_GPIO_INT_MASK(bank)) & ~enabled);
+        }
+
+        /* MASK_DATA: [31:16] mask (0: write), [15:0] data. DATA is only rewritten when a
+         * mailbox was used, so a read-modify-write of DATA by the app is never undone. */
+        value = zsim_reg_xchg(sim, ZYNQ_GPIO_MASK_DATA_LSW(bank), ZSIM_MASK_DATA_IDLE);
+        mask = ~(value >> 16) & 0xFFFF;
+        data = value & mask;
+        value = zsim_reg_xchg(sim, ZYNQ_GPIO_MASK_DATA_MSW(bank), ZSIM_MASK_DATA_IDLE);
+        mask |= (~(value >> 16) & 0xFFFF) << 16;
+        data |= (value << 16) & mask & 0xFFFF0000;
+        if (mask)
+        {
+            value = zsim_reg_read(sim, ZYNQ_GPIO_DATA(bank));
+            zsim_reg_write(sim, ZYNQ_GPIO_DATA(bank), ((value & ~mask) | data) & zsim_bank_mask[bank]);
+        }
+
+        out = zsim_reg_read(sim, ZYNQ_GPIO_DIRM(bank)) & zsim_reg_read(sim, ZYNQ_GPIO_OEN(bank));
+        ro = zsim_data_ro(sim, bank);
+        zsim_reg_write(sim, ZYNQ_GPIO_DATA_RO(bank), ro);
+
+        changed[bank] = (ro ^ sim->ro[bank]) & out;
+        any |= !!changed[bank];
+        sim->ro[bank] = ro;
+
+        /* Level inputs: active and cleared by the app -> latch again. */
+        active = ~(ro ^ zsim_reg_read(sim, ZYNQ_GPIO_INT_POLARITY(bank))) &
+                 ~zsim_reg_read(sim, ZYNQ_GPIO_INT_TYPE(bank)) & ~out & zsim_bank_mask[bank];
+        relatch = zsim_int_stat(sim, bank, active, idle);
+        /* Newly latched level bits, or pending bits just unmasked by INT_EN. */
+        if ((relatch | (sim->stat[bank] & enabled)) & ~zsim_reg_read(sim, ZYNQ_GPIO_INT_MASK(bank)))
+        {
+            irq = 1;
+        }
+    }
+
+    if (irq)
+    {
+        zsim_raise_irq(sim);
+    }
+
+    sim->ctl->steps++;
+
+    return any;
+}
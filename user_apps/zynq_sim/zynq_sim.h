@@ -0,0 +1,124 @@
+/**
+ * @file zynq_sim.h
+ * @author panxingyuan (panxingyuan1@163.com)
+ * @brief Host model of the Zynq-7000 GPIO block on a shared-memory file.
+ * @version 0.1
+ * @date 2026-10-18
+ *       Create this file.
+ * @date 2026-10-18
+ *       INT_STAT write-1-to-clear, as on the hardware (latch word in the control page).
+ * @copyright Copyright (c) 2026
+ * @details The file has two pages:
+ *
+ *              0x0000 register block, same offsets as 0xE000A000 (zynq_gpio.h)
+ *              0x1000 struct zsim_ctl: external pin levels, irq counter, daemon pid
+ *
+ *          Apps map the first page instead of /dev/mem or /dev/uioN and access it like the
+ *          hardware. Plain memory cannot see a write, so the register semantics are split:
+ *          - DIRM, OEN, DATA, INT_MASK, INT_TYPE, INT_POLARITY, INT_ANY: plain registers.
+ *          - MASK_DATA_LSW/MSW, INT_EN, INT_DIS: write-only, used as mailboxes. zsim_step()
+ *            takes and applies them (MASK_DATA idles at 0xFFFF0000, INT_EN/DIS at 0). Several
+ *            writes between two steps merge into the last one.
+ *          - DATA_RO: computed, outputs (DIRM & OEN) from DATA, inputs from the external level.
+ *          - INT_STAT: write-1-to-clear. Latched bits are also ORed into ctl->latch, so
+ *            zsim_step() tells them from an app store: a store that changes INT_STAT clears the
+ *            pending bits it wrote as 1. Storing back exactly the value read changes nothing
+ *            in plain memory; those (unmasked) bits are cleared once the irq FIFO has been
+ *            empty for a whole step with no new interrupt, i.e. the app took the notification
+ *            at least one step earlier.
+ *          Input changes (zsim_set_input()) are edge-detected at once by the caller, from any
+ *          process, so injected edges are never lost between steps. An interrupt is counted
+ *          in the control page and written as an 8 byte count (eventfd format) to the irq FIFO.
+ */
+
+#ifndef __ZYNQ_SIM_H__
+#define __ZYNQ_SIM_H__
+
+#include <stdint.h>
+
+#include "zynq_gpio.h"
+
+#define ZSIM_MAGIC              0x4d49535a  /* "ZSIM" */
+#define ZSIM_VERSION            2
+#define ZSIM_CTL_OFFSET         ZYNQ_GPIO_REGS_SIZE
+#define ZSIM_FILE_SIZE          (ZSIM_CTL_OFFSET + 0x1000)
+#define ZSIM_MASK_DATA_IDLE     0xFFFF0000  /* All mask bits set: writes nothing */
+
+struct zsim_ctl {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ext[ZYNQ_GPIO_BANKS];  /* External level of every pin */
+    uint32_t latch[ZYNQ_GPIO_BANKS]; /* INT_STAT bits latched since the last step */
+    uint32_t daemon_pid;
+    uint32_t reserved;
+    uint64_t irqs;                  /* Interrupts raised */
+    uint64_t edges;                 /* Input transitions injected */
+    uint64_t steps;                 /* zsim_step() runs */
+    char irq_path[256];             /* Irq FIFO, empty: none */
+};
+
+struct zsim {
+    int fd;
+    int irq_fd;
+    volatile uint32_t *regs;
+    struct zsim_ctl *ctl;
+    uint32_t ro[ZYNQ_GPIO_BANKS];   /* DATA_RO seen by the previous step */
+    uint32_t stat[ZYNQ_GPIO_BANKS]; /* INT_STAT as the previous step left it */
+    uint64_t irqs;                  /* ctl->irqs at the previous step */
+    int irq_empty;                  /* Irq FIFO was empty at the previous step */
+};
+
+/**
+ * @brief Map the model file @p path, create and reset it if @p create.
+ * @return 0 on success, -1 on error.
+ */
+int zsim_open(struct zsim *sim, const char *path, int create);
+
+void zsim_close(struct zsim *sim);
+
+/**
+ * @brief Register values after reset (ug585 B.19), all inputs low.
+ */
+void zsim_reset(struct zsim *sim);
+
+/**
+ * @brief Create the irq FIFO @p path and publish it in the control page.
+ * @return 0 on success, -1 on error.
+ */
+int zsim_irq_create(struct zsim *sim, const char *path);
+
+/**
+ * @brief Drive input @p pin to @p level: updates DATA_RO, latches INT_STAT per INT_TYPE,
+ *        INT_POLARITY and INT_ANY and raises the interrupt if the pin is unmasked.
+ */
+void zsim_set_input(struct zsim *sim, unsigned int pin, int level);
+
+/**
+ * @brief Level of @p pin as DATA_RO shows it.
+ */
+int zsim_get_pin(struct zsim *sim, unsigned int pin);
+
+/**
+ * @brief Raise the GPIO interrupt regardless of the registers.
+ */
+void zsim_raise_irq(struct zsim *sim);
+
+/**
+ * @brief Apply the mailboxes and INT_STAT stores, recompute DATA_RO and service level
+ *        interrupts.
+ * @param[out] changed Output pins that changed since the previous step, per bank.
+ * @return Nonzero if any output pin changed.
+ */
+int zsim_step(struct zsim *sim, uint32_t changed[ZYNQ_GPIO_BANKS]);
+
+static inline uint32_t zsim_reg_read(struct zsim *sim, unsigned int offset)
+{
+    return sim->regs[offset / 4];
+}
+
+static inline void zsim_reg_write(struct zsim *sim, unsigned int offset, uint32_t value)
+{
+    sim->regs[offset / 4] = value;
+}
+
+#endif /* __ZYNQ_SIM_H__ */